@@ -0,0 +1,176 @@
+/********************************************************
+ * alarm.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file implements the alarm functions declared in alarm.h,
+ * replacing the library implementation.  The library opened socket 3
+ * in multicast mode for every alarm, sent the datagram and then waited
+ * 500 ms before closing it - stalling the caller, and taking the socket
+ * from the Modbus server.  Here alarm_send() writes the uart line at
+ * once and queues the event with its rtc time.  alarm_update() sends
+ * the queued alarms on the dhcp socket while the dhcp client is between
+ * exchanges (the socket is closed), then closes it again without
+ * waiting.
+ *
+ * The datagram is unchanged: the date and time of the event, the device
+ * serial number and the event number as two hexadecimal digits,
+ * separated by spaces, to ALARM_PORT of the ALARM_GROUP multicast group.
+ *
+ * Functions:
+ *
+ * alarm_init()
+ *  Empties the alarm queue
+ *
+ * alarm_send()
+ *  Reports an alarm to the uart and queues it for the network
+ *
+ * alarm_update()
+ *  Sends the queued alarms when the dhcp socket is free
+ *
+ * add_text()
+ *  Adds a string to the datagram being built
+ */
+
+ #include <string.h>
+ #include <avr/pgmspace.h>
+ #include "alarm.h"
+ #include "vpd.h"
+ #include "rtc.h"
+ #include "socket.h"
+ #include "netboot.h"
+ #include "fmt.h"
+ #include "uart.h"
+ #include "serial.h"
+ #include "ulog.h"
+ #include "crash.h"
+
+ /* the socket is shared with the dhcp client (netboot.h) */
+ #define ALARM_SOCKET        NETBOOT_SOCKET
+ #define ALARM_PORT          8888
+
+ /* alarms waiting for the socket (the temperature state machine raises
+ * at most one per state change)
+ */
+ #define ALARM_QUEUE_SIZE    4
+
+ static unsigned char alarm_group[4] = {239, 1, 1, 1};
+
+ static unsigned char queue_event[ALARM_QUEUE_SIZE];
+ static unsigned long queue_time[ALARM_QUEUE_SIZE];
+ static unsigned char queue_head;
+ static unsigned char queue_count;
+
+ /**********************************
+ * alarm_init()
+ *
+ * Empties the alarm queue
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  queue_head, queue_count
+ */
+ void alarm_init(){
+    queue_head = 0;
+    queue_count = 0;
+ }
+
+ /**********************************
+ * alarm_send()
+ *
+ * Writes the alarm to the uart and queues it, with the current rtc
+ * time, to be sent by alarm_update().  If the queue is full the alarm is
+ * only reported to the uart.
+ *
+ * arguments:
+ *  eventnum - the event number (EVENT_*, log.h)
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the alarm queue
+ */
+ void alarm_send(unsigned eventnum){
+    unsigned char tail;
+
+    serial_writestr_P(PSTR("\r\nALARM: "));
+    uart_writedec32(eventnum);
+    serial_writestr_P(PSTR("\r\n"));
+
+    if(queue_count == ALARM_QUEUE_SIZE){
+        ULOG(ULOG_WARN, serial_writestr_P(PSTR("alarm: queue full, not sent\r\n")));
+        return;
+    }
+    tail = (queue_head + queue_count) % ALARM_QUEUE_SIZE;
+    queue_event[tail] = eventnum;
+    queue_time[tail] = rtc_get_date();
+    queue_count++;
+ }
+
+ /**********************************
+ * add_text()
+ *
+ * Adds a string to the datagram being built on the alarm socket
+ *
+ * arguments:
+ *  offset - offset of the string in the datagram
+ *  str - the string
+ *
+ * returns:
+ *  the offset after the string
+ *
+ * changes:
+ *  the alarm socket transmit buffer
+ */
+ static unsigned int add_text(unsigned int offset, const char *str){
+    return offset + udpsocket_add_to_datagram(ALARM_SOCKET, offset,
+                                              (const unsigned char*)str, strlen(str));
+ }
+
+ /**********************************
+ * alarm_update()
+ *
+ * Sends the queued alarms if the dhcp client is not using the socket.
+ * The socket is opened on the multicast group, one datagram is sent
+ * per alarm and the socket is closed again.  Call from the main loop.
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the alarm queue, the alarm socket
+ */
+ void alarm_update(){
+    char hex[FMT_HEX8_SIZE];
+    unsigned int len;
+
+    if(queue_count == 0 || !udpsocket_is_closed(ALARM_SOCKET)){
+        return;
+    }
+    CRASH_SOCKOP(ALARM_SOCKET, SOCKOP_OPEN);
+    udpsocket_open_multicast(ALARM_SOCKET, alarm_group, ALARM_PORT);
+    while(queue_count){
+        fmt_hex8(hex, queue_event[queue_head]);
+        udpsocket_start_datagram(ALARM_SOCKET, alarm_group, ALARM_PORT);
+        len = add_text(0, rtc_num2datestr(queue_time[queue_head]));
+        len = add_text(len, " ");
+        len = add_text(len, vpd.serial_number);
+        len = add_text(len, " ");
+        add_text(len, hex);
+        CRASH_SOCKOP(ALARM_SOCKET, SOCKOP_SEND);
+        udpsocket_send_datagram(ALARM_SOCKET);
+        queue_head = (queue_head + 1) % ALARM_QUEUE_SIZE;
+        queue_count--;
+    }
+    udpsocket_close(ALARM_SOCKET);
+ }
@@ -25,4 +25,10 @@ void alarm_init();
 */
 void alarm_send(unsigned eventnum);
 
+/* send the queued alarms to the network.  The alarms use the dhcp socket
+* (netboot.h) while it is closed between dhcp exchanges.  Call from the
+* main loop.
+*/
+void alarm_update();
+
 #endif // ALARM_H_INCLUDED
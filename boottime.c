@@ -0,0 +1,84 @@
+/********************************************************
+ * boottime.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file implements boot phase timestamps so that the time to the
+ * first temperature sample and the first HTTP response can be measured.
+ * Times are taken from clock_ms() (clock.h).
+ *
+ * Functions:
+ *
+ * boottime_mark()
+ *  Records the time at which a boot phase was reached
+ *
+ * boottime_get()
+ *  Returns the time at which a boot phase was reached
+ */
+
+ #include <avr/pgmspace.h>
+ #include "boottime.h"
+ #include "clock.h"
+ #include "uart.h"
+ #include "serial.h"
+ #include "ulog.h"
+
+ static unsigned long phase_time[BOOT_NUM_PHASES];
+ static unsigned char phase_reached;
+
+ /* phase names, in program memory */
+ #define PHASE_NAME_SIZE     20
+
+ static const char phase_name[BOOT_NUM_PHASES][PHASE_NAME_SIZE] PROGMEM = {
+    "init done", "network up", "time sync", "first sample", "first http response"
+ };
+
+ /**********************************
+ * boottime_mark()
+ *
+ * Records the time (ms since startup) at which the specified boot phase
+ * was reached and reports it on the uart.  Only the first call for each
+ * phase is recorded.
+ *
+ * arguments:
+ *  phase - the boot phase that was reached
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  phase_time, phase_reached
+ */
+ void boottime_mark(enum boot_phase phase){
+    if(phase_reached & (1 << phase)){
+        return;
+    }
+    phase_reached |= (1 << phase);
+    phase_time[phase] = clock_ms();
+
+    ULOG(ULOG_INFO,
+        serial_writestr_P(PSTR("boot: "));
+        serial_writestr_P(phase_name[phase]);
+        serial_writestr_P(PSTR(" at "));
+        uart_writedec32(phase_time[phase]);
+        serial_writestr_P(PSTR(" ms\r\n")));
+ }
+
+ /**********************************
+ * boottime_get()
+ *
+ * Returns the time (ms since startup) at which the specified phase was reached
+ *
+ * arguments:
+ *  phase - the boot phase
+ *
+ * returns:
+ *  the time of the phase, or 0 if it has not been reached yet
+ *
+ * changes:
+ *  none
+ */
+ unsigned long boottime_get(enum boot_phase phase){
+    return phase_time[phase];
+ }
@@ -0,0 +1,33 @@
+/********************************************************
+ * boottime.h
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file provides declarations for the boot phase
+ * timestamps used to measure startup latency.
+ */
+
+#ifndef BOOTTIME_H_INCLUDED
+#define BOOTTIME_H_INCLUDED
+
+enum boot_phase {BOOT_INIT_DONE, BOOT_NET_UP, BOOT_TIME_SYNC, BOOT_FIRST_SAMPLE, BOOT_FIRST_HTTP, BOOT_NUM_PHASES};
+
+/**********************************
+ * boottime_mark()
+ *
+ * Records the time (ms since startup) at which the specified boot phase
+ * was reached and reports it on the uart.  Only the first call for each
+ * phase is recorded.
+ */
+void boottime_mark(enum boot_phase phase);
+
+/**********************************
+ * boottime_get()
+ *
+ * Returns the time (ms since startup) at which the specified phase was
+ * reached, or 0 if it has not been reached yet
+ */
+unsigned long boottime_get(enum boot_phase phase);
+
+#endif // BOOTTIME_H_INCLUDED
@@ -0,0 +1,118 @@
+/********************************************************
+ * clock.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file implements the time source declared in clock.h.  The
+ * millisecond count is kept by the delay library (timer0), and the rtc
+ * seconds by the rtc library (timer1) - this file extends the first past
+ * its wrap and reads the second to the millisecond.
+ *
+ * Functions:
+ *
+ * clock_ms()
+ *  Returns the milliseconds since startup
+ *
+ * clock_uptime()
+ *  Returns the seconds since startup
+ *
+ * clock_read_rtc()
+ *  Reads the rtc with millisecond resolution
+ */
+
+ #include <avr/io.h>
+ #include <avr/interrupt.h>
+ #include "clock.h"
+ #include "delay.h"
+ #include "rtc.h"
+
+ /* 2^32 ms = WRAP_SEC s + WRAP_MS ms */
+ #define WRAP_SEC            4294967UL
+ #define WRAP_MS             296UL
+
+ static unsigned long last_ms;
+ static unsigned int wraps;
+
+ /**********************************
+ * clock_ms()
+ *
+ * Returns the milliseconds since startup, and counts the wraps of the
+ * count (seen as a value lower than the one of the previous call)
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  the milliseconds since startup (wraps at 2^32)
+ *
+ * changes:
+ *  last_ms, wraps
+ */
+ unsigned long clock_ms(){
+    unsigned long now = millis();
+
+    if(now < last_ms){
+        wraps++;
+    }
+    last_ms = now;
+    return now;
+ }
+
+ /**********************************
+ * clock_uptime()
+ *
+ * Returns the seconds since startup.  The wrapped count is divided in
+ * parts so that no 64-bit arithmetic is needed.
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  the seconds since startup
+ *
+ * changes:
+ *  last_ms, wraps
+ */
+ unsigned long clock_uptime(){
+    unsigned long now = clock_ms();
+
+    return wraps * WRAP_SEC + now / 1000 + (wraps * WRAP_MS + now % 1000) / 1000;
+ }
+
+ /**********************************
+ * clock_read_rtc()
+ *
+ * Reads the rtc with millisecond resolution.  The fraction of the current
+ * second is taken from the timer1 count.  The count is read before and after
+ * the rtc so that a tick in between can be detected (and the read repeated).
+ *
+ * arguments:
+ *  sec - pointer to where the rtc date/time number is placed
+ *  ms - pointer to where the milliseconds into the current second are placed
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  none
+ */
+ void clock_read_rtc(unsigned long *sec, unsigned int *ms){
+    unsigned int before;
+    unsigned int after;
+    unsigned char sreg;
+
+    do{
+        sreg = SREG;
+        cli();
+        before = TCNT1;
+        SREG = sreg;
+        *sec = rtc_get_date();
+        sreg = SREG;
+        cli();
+        after = TCNT1;
+        SREG = sreg;
+    } while(after < before);
+
+    *ms = ((unsigned long)after * 2) / 125;
+ }
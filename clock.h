@@ -0,0 +1,47 @@
+/********************************************************
+ * clock.h
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file provides declarations for the time source of the project.
+ * clock_ms() is the monotonic millisecond clock (the timer0 compare
+ * match tick of the delay library) used for every delay, timeout,
+ * release time and execution time, and clock_read_rtc() gives the rtc
+ * date/time with the millisecond into the current second (from the
+ * timer1 count) for timestamps.  The 32-bit millisecond count wraps
+ * after 49.7 days: intervals are taken as differences, which are not
+ * affected, and the wraps are counted for clock_uptime().
+ */
+
+#ifndef CLOCK_H_INCLUDED
+#define CLOCK_H_INCLUDED
+
+/* timer1 generates the 1 second rtc tick: 16MHz/256, count 0..62499 */
+#define CLOCK_TIMER1_TOP    62499U
+
+/**********************************
+ * clock_ms()
+ *
+ * Returns the milliseconds since startup (wraps at 2^32).  Call from the
+ * main loop only - the calls count the wraps of the millisecond count,
+ * which needs at least one call every 49 days.
+ */
+unsigned long clock_ms();
+
+/**********************************
+ * clock_uptime()
+ *
+ * Returns the seconds since startup, including the wraps of clock_ms()
+ */
+unsigned long clock_uptime();
+
+/**********************************
+ * clock_read_rtc()
+ *
+ * Reads the rtc date/time number and the milliseconds into the current
+ * rtc second
+ */
+void clock_read_rtc(unsigned long *sec, unsigned int *ms);
+
+#endif // CLOCK_H_INCLUDED
@@ -0,0 +1,1088 @@
+/********************************************************
+ * coap.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file implements the CoAP (RFC 7252) server.  Each request is
+ * parsed in one pass over its options straight from the received
+ * datagram, and answered with one datagram: a piggybacked ACK for a
+ * confirmable request, a non confirmable response otherwise.
+ *
+ * The response is written into the transmit buffer of the shared socket
+ * by the same json writers as the http server (devapi.c).  The
+ * representation is first rendered with an empty window to measure it,
+ * then the header (with the Block2 option if it does not fit a block) is
+ * written and it is rendered again with a window over the requested
+ * block, so no RAM buffer is needed for the payload.  Since every block
+ * is rendered from the live values, each 2.05 response carries an ETag
+ * computed from the values the representation is made of (temperature,
+ * config crc and log records added) - a client reassembling the blocks
+ * restarts the transfer when the ETag changes between them.
+ *
+ * A confirmable PUT or DELETE that is retransmitted (its ACK was lost)
+ * is answered with the code of the first response without applying it
+ * again.  Observers are identified by their address and port - a reset
+ * from an observer ends its observation.
+ *
+ * The whole file is compiled out unless COAP_ENABLE is 1.
+ *
+ * Functions:
+ *
+ * coap_receive()
+ *  Handles a datagram received on the server port
+ *
+ * coap_update()
+ *  Notifies the observers when the alarm state changes
+ *
+ * option_is()
+ *  Compares an option value with a program memory string
+ *
+ * get_uint()
+ *  Returns the value of an unsigned integer option
+ *
+ * parse_ulong()
+ *  Parses a decimal number in a query
+ *
+ * query_value()
+ *  Returns the value of a query parameter
+ *
+ * path_segment()
+ *  Resolves the next Uri-Path segment
+ *
+ * parse_options()
+ *  Parses the options of a request
+ *
+ * parse_device_query()
+ *  Parses the query of GET /device
+ *
+ * parse_log_query()
+ *  Parses the query of GET /device/log
+ *
+ * apply_config()
+ *  Applies the query of PUT /device/config
+ *
+ * begin_message()
+ *  Starts a message with the header and token
+ *
+ * put_option()
+ *  Adds an option to the message
+ *
+ * put_uint_option()
+ *  Adds an unsigned integer option to the message
+ *
+ * send_code()
+ *  Sends a response without a payload
+ *
+ * render()
+ *  Writes the representation of a resource
+ *
+ * get_etag()
+ *  Returns the ETag of the current representation of a resource
+ *
+ * send_content()
+ *  Sends a 2.05 response with one block of the representation
+ *
+ * find_observer()
+ *  Returns the observer slot of an endpoint
+ *
+ * handle_request()
+ *  Handles a request and sends the response
+ */
+
+ #include <string.h>
+ #include <avr/pgmspace.h>
+ #include "coap.h"
+ #include "udpmux.h"
+ #include "socket.h"
+ #include "devapi.h"
+ #include "devstate.h"
+ #include "log.h"
+ #include "logindex.h"
+ #include "crc16.h"
+ #include "eecrc.h"
+ #include "temp.h"
+
+ #if COAP_ENABLE
+
+ #define COAP_VERSION        1
+ #define COAP_HEADER_SIZE    4
+ #define TOKEN_MAX           8
+ #define PAYLOAD_MARKER      0xFF
+
+ /* message types */
+ #define TYPE_CON            0
+ #define TYPE_NON            1
+ #define TYPE_ACK            2
+ #define TYPE_RST            3
+
+ /* codes (class << 5 | detail) */
+ #define CODE_EMPTY          0x00
+ #define CODE_GET            0x01
+ #define CODE_PUT            0x03
+ #define CODE_DELETE         0x04
+ #define CODE_DELETED        0x42    /* 2.02 */
+ #define CODE_CHANGED        0x44    /* 2.04 */
+ #define CODE_CONTENT        0x45    /* 2.05 */
+ #define CODE_BAD_REQUEST    0x80    /* 4.00 */
+ #define CODE_BAD_OPTION     0x82    /* 4.02 */
+ #define CODE_NOT_FOUND      0x84    /* 4.04 */
+ #define CODE_NOT_ALLOWED    0x85    /* 4.05 */
+ #define CODE_NOT_ACCEPTABLE 0x86    /* 4.06 */
+
+ /* option numbers */
+ #define OPT_URI_HOST        3
+ #define OPT_ETAG            4
+ #define OPT_OBSERVE         6
+ #define OPT_URI_PORT        7
+ #define OPT_URI_PATH        11
+ #define OPT_CONTENT_FORMAT  12
+ #define OPT_URI_QUERY       15
+ #define OPT_ACCEPT          17
+ #define OPT_BLOCK2          23
+
+ /* content formats */
+ #define FORMAT_LINK         40
+ #define FORMAT_JSON         50
+
+ /* Observe option values of a request */
+ #define OBSERVE_REGISTER    0
+ #define OBSERVE_DEREGISTER  1
+
+ #define MAX_QUERIES         3
+ #define NONE                0xFF
+ #define NO_ACCEPT           0xFFFF
+
+ enum coap_resource {RES_NONE, RES_DEVICE, RES_LOG, RES_CONFIG, RES_WELLKNOWN, RES_CORE};
+
+ typedef struct {
+    unsigned char type;                 /* type of the response */
+    unsigned int  mid;                  /* message id of the response */
+    unsigned char tkl;
+    unsigned char token[TOKEN_MAX];
+    unsigned char resource;
+    unsigned char observe;              /* Observe option (NONE if absent) */
+    unsigned char observing;            /* 1 if the response carries Observe */
+    unsigned int  accept;               /* Accept option (NO_ACCEPT if absent) */
+    unsigned int  block_num;
+    unsigned char block_szx;            /* NONE if there is no Block2 option */
+    unsigned char queries;
+    const unsigned char *query[MAX_QUERIES];
+    unsigned char query_len[MAX_QUERIES];
+    unsigned char fields;               /* GET /device */
+    unsigned char event;                /* GET /device/log */
+    unsigned long from;
+    unsigned long to;
+ } coap_request;
+
+ typedef struct {
+    unsigned char addr[4];
+    unsigned int  port;                 /* 0 for a free slot */
+    unsigned char tkl;
+    unsigned char token[TOKEN_MAX];
+    unsigned char fields;
+ } coap_observer;
+
+ /* links of GET /.well-known/core */
+ static const char core_links[] PROGMEM =
+    "</device>;ct=50;obs,</device/log>;ct=50,</device/config>";
+
+ static coap_observer observers[COAP_MAX_OBSERVERS];
+ static unsigned int observe_seq;
+ static unsigned char notified_state = NONE;
+ static unsigned int next_mid;
+
+ /* number of the last option added to the message being built */
+ static unsigned int last_option;
+
+ /* last confirmable PUT/DELETE handled and the code it was answered with */
+ static unsigned char last_addr[4];
+ static unsigned int last_port;
+ static unsigned int last_mid;
+ static unsigned char last_code;
+
+ extern int current_temperature;
+
+ /**********************************
+ * option_is()
+ *
+ * Compares an option value with a program memory string
+ *
+ * arguments:
+ *  value - the option value
+ *  len - its length
+ *  str - the program memory string
+ *
+ * returns:
+ *  1 if they are equal, otherwise 0
+ *
+ * changes:
+ *  none
+ */
+ static unsigned char option_is(const unsigned char *value, unsigned int len, const char *str){
+    return strlen_P(str) == len && strncmp_P((const char*)value, str, len) == 0;
+ }
+
+ /**********************************
+ * get_uint()
+ *
+ * Returns the value of an unsigned integer option (big endian, leading
+ * zero bytes omitted)
+ *
+ * arguments:
+ *  value - the option value
+ *  len - its length (at most 4)
+ *
+ * returns:
+ *  the value
+ *
+ * changes:
+ *  none
+ */
+ static unsigned long get_uint(const unsigned char *value, unsigned int len){
+    unsigned long n = 0;
+
+    while(len-- > 0){
+        n = (n << 8) | *value++;
+    }
+    return n;
+ }
+
+ /**********************************
+ * parse_ulong()
+ *
+ * Parses a decimal number that makes up the rest of a query
+ *
+ * arguments:
+ *  str - the digits
+ *  len - number of characters
+ *  n - where the value is placed
+ *
+ * returns:
+ *  1 if there are 1 to 10 digits and nothing else, otherwise 0
+ *
+ * changes:
+ *  n
+ */
+ static unsigned char parse_ulong(const unsigned char *str, unsigned char len, unsigned long *n){
+    if(len == 0 || len > 10){
+        return 0;
+    }
+    *n = 0;
+    while(len-- > 0){
+        if(*str < '0' || *str > '9'){
+            return 0;
+        }
+        *n = *n * 10 + (*str++ - '0');
+    }
+    return 1;
+ }
+
+ /**********************************
+ * query_value()
+ *
+ * Returns the value of a query that has the form <name>=<value>
+ *
+ * arguments:
+ *  req - the request
+ *  i - index of the query
+ *  name - program memory string with the name and '='
+ *  len - where the length of the value is placed
+ *
+ * returns:
+ *  the value, or 0 if the query does not start with name
+ *
+ * changes:
+ *  len
+ */
+ static const unsigned char *query_value(const coap_request *req, unsigned char i, const char *name, unsigned char *len){
+    unsigned char n = strlen_P(name);
+
+    if(req->query_len[i] < n || strncmp_P((const char*)req->query[i], name, n) != 0){
+        return 0;
+    }
+    *len = req->query_len[i] - n;
+    return req->query[i] + n;
+ }
+
+ /**********************************
+ * path_segment()
+ *
+ * Resolves the next Uri-Path segment of a request
+ *
+ * arguments:
+ *  resource - the resource of the segments so far
+ *  segment - index of the segment
+ *  value - the segment
+ *  len - its length
+ *
+ * returns:
+ *  the resource (RES_NONE if there is none)
+ *
+ * changes:
+ *  none
+ */
+ static unsigned char path_segment(unsigned char resource, unsigned char segment,
+                                   const unsigned char *value, unsigned int len){
+    if(segment == 0){
+        if(option_is(value, len, PSTR("device"))){
+            return RES_DEVICE;
+        }
+        if(option_is(value, len, PSTR(".well-known"))){
+            return RES_WELLKNOWN;
+        }
+    }
+    else if(segment == 1){
+        if(resource == RES_DEVICE && option_is(value, len, PSTR("log"))){
+            return RES_LOG;
+        }
+        if(resource == RES_DEVICE && option_is(value, len, PSTR("config"))){
+            return RES_CONFIG;
+        }
+        if(resource == RES_WELLKNOWN && option_is(value, len, PSTR("core"))){
+            return RES_CORE;
+        }
+    }
+    return RES_NONE;
+ }
+
+ /**********************************
+ * parse_options()
+ *
+ * Parses the options of a request in one pass, resolving the path as
+ * it goes and keeping pointers to the queries.  Unknown elective options
+ * are skipped, unknown critical (odd) options are rejected.
+ *
+ * arguments:
+ *  msg - the request
+ *  len - its length
+ *  req - the request being parsed (tkl set)
+ *
+ * returns:
+ *  0 if the options are valid, otherwise the error response code
+ *
+ * changes:
+ *  req
+ */
+ static unsigned char parse_options(const unsigned char *msg, unsigned int len, coap_request *req){
+    unsigned int pos = COAP_HEADER_SIZE + req->tkl;
+    unsigned int number = 0;
+    unsigned int delta;
+    unsigned int olen;
+    unsigned char segment = 0;
+    unsigned long value;
+
+    req->resource = RES_NONE;
+    req->observe = NONE;
+    req->observing = 0;
+    req->accept = NO_ACCEPT;
+    req->block_szx = NONE;
+    req->queries = 0;
+
+    while(pos < len && msg[pos] != PAYLOAD_MARKER){
+        delta = msg[pos] >> 4;
+        olen = msg[pos] & 0x0F;
+        pos++;
+        /* extended delta and length */
+        if(delta == 13 && pos < len){
+            delta = 13 + msg[pos++];
+        }
+        else if(delta == 14 && pos + 1 < len){
+            delta = 269 + ((unsigned int)msg[pos] << 8 | msg[pos + 1]);
+            pos += 2;
+        }
+        else if(delta >= 13){
+            return CODE_BAD_REQUEST;
+        }
+        if(olen == 13 && pos < len){
+            olen = 13 + msg[pos++];
+        }
+        else if(olen >= 13){
+            return CODE_BAD_REQUEST;
+        }
+        if(pos + olen > len){
+            return CODE_BAD_REQUEST;
+        }
+        number += delta;
+
+        switch(number){
+        case OPT_URI_PATH:
+            req->resource = path_segment(req->resource, segment, msg + pos, olen);
+            if(segment < NONE){
+                segment++;
+            }
+            break;
+        case OPT_URI_QUERY:
+            if(req->queries == MAX_QUERIES || olen > 0xFF){
+                return CODE_BAD_REQUEST;
+            }
+            req->query[req->queries] = msg + pos;
+            req->query_len[req->queries++] = olen;
+            break;
+        case OPT_OBSERVE:
+            value = get_uint(msg + pos, olen > 3 ? 3 : olen);
+            if(value <= OBSERVE_DEREGISTER){
+                req->observe = value;
+            }
+            break;
+        case OPT_ACCEPT:
+            req->accept = get_uint(msg + pos, olen > 2 ? 2 : olen);
+            break;
+        case OPT_BLOCK2:
+            value = get_uint(msg + pos, olen > 3 ? 3 : olen);
+            req->block_szx = value & 0x07;
+            req->block_num = (value >> 4 > 0xFFFF) ? 0xFFFF : value >> 4;
+            if(req->block_szx == 7){
+                return CODE_BAD_REQUEST;
+            }
+            break;
+        case OPT_URI_HOST:
+        case OPT_URI_PORT:
+        case OPT_CONTENT_FORMAT:
+            break;
+        default:
+            if(number & 1){
+                return CODE_BAD_OPTION;
+            }
+            break;
+        }
+        pos += olen;
+    }
+    if(segment == 0){
+        req->resource = RES_NONE;
+    }
+    return 0;
+ }
+
+ /**********************************
+ * parse_device_query()
+ *
+ * Parses the (optional) fields= query of GET /device, a comma separated
+ * list of device object members as for http
+ *
+ * arguments:
+ *  req - the request
+ *
+ * returns:
+ *  1 if the query is valid, otherwise 0
+ *
+ * changes:
+ *  req->fields
+ */
+ static unsigned char parse_device_query(coap_request *req){
+    const unsigned char *names;
+    unsigned char len;
+    unsigned char n;
+    unsigned char field;
+
+    req->fields = DEVICE_FIELDS_ALL;
+    if(req->queries == 0){
+        return 1;
+    }
+    names = query_value(req, 0, PSTR("fields="), &len);
+    if(req->queries > 1 || names == 0){
+        return 0;
+    }
+    req->fields = 0;
+    do{
+        for(n = 0; n < len && names[n] != ','; n++);
+        field = devapi_find_name(device_fields[0], DEVICE_FIELD_NAME_SIZE, DEVICE_FIELD_COUNT,
+                                 (const char*)names, n);
+        if(field == DEVICE_FIELD_COUNT){
+            return 0;
+        }
+        req->fields |= 1 << field;
+        n = (n < len) ? n + 1 : n;
+        names += n;
+        len -= n;
+    } while(len > 0);
+    return 1;
+ }
+
+ /**********************************
+ * parse_log_query()
+ *
+ * Parses the (optional) event=, from= and to= queries of GET /device/log
+ *
+ * arguments:
+ *  req - the request
+ *
+ * returns:
+ *  1 if the queries are valid, otherwise 0
+ *
+ * changes:
+ *  req->event, req->from, req->to
+ */
+ static unsigned char parse_log_query(coap_request *req){
+    const unsigned char *value;
+    unsigned char len;
+    unsigned char i;
+    unsigned long n;
+
+    req->event = EVENT_UNK;
+    req->from = 0;
+    req->to = 0xFFFFFFFFUL;
+    for(i = 0; i < req->queries; i++){
+        if((value = query_value(req, i, PSTR("event="), &len)) != 0){
+            if(!parse_ulong(value, len, &n) || n >= LOGINDEX_NUM_EVENTS){
+                return 0;
+            }
+            req->event = n;
+        }
+        else if((value = query_value(req, i, PSTR("from="), &len)) != 0){
+            if(!parse_ulong(value, len, &req->from)){
+                return 0;
+            }
+        }
+        else if((value = query_value(req, i, PSTR("to="), &len)) != 0){
+            if(!parse_ulong(value, len, &req->to)){
+                return 0;
+            }
+        }
+        else{
+            return 0;
+        }
+    }
+    return 1;
+ }
+
+ /**********************************
+ * apply_config()
+ *
+ * Applies the <name>=<value> query of PUT /device/config.  As for http,
+ * one parameter is set per request.
+ *
+ * arguments:
+ *  req - the request
+ *
+ * returns:
+ *  CODE_CHANGED if applied, otherwise CODE_BAD_REQUEST
+ *
+ * changes:
+ *  config
+ */
+ static unsigned char apply_config(const coap_request *req){
+    const unsigned char *query = req->query[0];
+    unsigned char len = req->query_len[0];
+    unsigned char n;
+    unsigned char param;
+    unsigned char negative;
+    unsigned long value;
+
+    if(req->queries != 1){
+        return CODE_BAD_REQUEST;
+    }
+    for(n = 0; n < len && query[n] != '='; n++);
+    param = devapi_find_name(device_configs[0], DEVICE_CONFIG_NAME_SIZE, DEVICE_CONFIG_COUNT,
+                             (const char*)query, n);
+    if(param == DEVICE_CONFIG_COUNT || n == len){
+        return CODE_BAD_REQUEST;
+    }
+    n++;
+    negative = (n < len && query[n] == '-');
+    n += negative;
+    if(!parse_ulong(query + n, len - n, &value) || value > 0x7FFF){
+        return CODE_BAD_REQUEST;
+    }
+    return devapi_set_config(param, negative ? -(int)value : (int)value) ? CODE_CHANGED : CODE_BAD_REQUEST;
+ }
+
+ /**********************************
+ * begin_message()
+ *
+ * Starts a message to a remote endpoint with the header and token
+ *
+ * arguments:
+ *  addr, port - the remote endpoint
+ *  type - the message type
+ *  code - the code
+ *  mid - the message id
+ *  token - the token
+ *  tkl - the token length
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  last_option, the socket transmit buffer
+ */
+ static void begin_message(const unsigned char *addr, unsigned int port, unsigned char type,
+                           unsigned char code, unsigned int mid, const unsigned char *token, unsigned char tkl){
+    unsigned char header[COAP_HEADER_SIZE];
+
+    header[0] = (COAP_VERSION << 6) | (type << 4) | tkl;
+    header[1] = code;
+    header[2] = mid >> 8;
+    header[3] = mid & 0xFF;
+    udpsocket_start_datagram(UDPMUX_SOCKET, (unsigned char*)addr, port);
+    socket_send(UDPMUX_SOCKET, header, COAP_HEADER_SIZE);
+    socket_send(UDPMUX_SOCKET, token, tkl);
+    last_option = 0;
+ }
+
+ /**********************************
+ * put_option()
+ *
+ * Adds an option to the message being built (options must be added in
+ * increasing order)
+ *
+ * arguments:
+ *  number - the option number
+ *  value - the value
+ *  len - its length (at most 12)
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  last_option, the socket transmit buffer
+ */
+ static void put_option(unsigned int number, const unsigned char *value, unsigned char len){
+    unsigned char head[2];
+    unsigned int delta = number - last_option;
+
+    if(delta < 13){
+        head[0] = (delta << 4) | len;
+        socket_send(UDPMUX_SOCKET, head, 1);
+    }
+    else{
+        head[0] = (13 << 4) | len;
+        head[1] = delta - 13;
+        socket_send(UDPMUX_SOCKET, head, 2);
+    }
+    socket_send(UDPMUX_SOCKET, value, len);
+    last_option = number;
+ }
+
+ /**********************************
+ * put_uint_option()
+ *
+ * Adds an unsigned integer option in the fewest bytes
+ *
+ * arguments:
+ *  number - the option number
+ *  value - the value
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  last_option, the socket transmit buffer
+ */
+ static void put_uint_option(unsigned int number, unsigned long value){
+    unsigned char bytes[4];
+    unsigned char len = 0;
+
+    while(value != 0){
+        len++;
+        bytes[4 - len] = value & 0xFF;
+        value >>= 8;
+    }
+    put_option(number, bytes + 4 - len, len);
+ }
+
+ /**********************************
+ * send_code()
+ *
+ * Sends a response without options or payload
+ *
+ * arguments:
+ *  req - the request
+ *  addr, port - the remote endpoint
+ *  code - the response code
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the socket transmit buffer
+ */
+ static void send_code(const coap_request *req, const unsigned char *addr, unsigned int port, unsigned char code){
+    begin_message(addr, port, req->type, code, req->mid, req->token, req->tkl);
+    udpsocket_send_datagram(UDPMUX_SOCKET);
+ }
+
+ /**********************************
+ * render()
+ *
+ * Writes the representation of a resource to the datagram (through the
+ * current window)
+ *
+ * arguments:
+ *  req - the request
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the socket transmit buffer
+ */
+ static void render(const coap_request *req){
+    switch(req->resource){
+    case RES_DEVICE:
+        devapi_send_device(UDPMUX_SOCKET, req->fields);
+        break;
+    case RES_LOG:
+        devapi_send_log(UDPMUX_SOCKET, req->event, req->from, req->to);
+        break;
+    case RES_CORE:
+        socket_writestr_P(UDPMUX_SOCKET, core_links);
+        break;
+    default:
+        break;
+    }
+ }
+
+ /**********************************
+ * get_etag()
+ *
+ * Returns the ETag of the current representation of a resource - a crc
+ * of the resource, the fields and the values the representation is made
+ * of, so it changes when any of them does
+ *
+ * arguments:
+ *  req - the request
+ *
+ * returns:
+ *  the ETag
+ *
+ * changes:
+ *  none
+ */
+ static unsigned int get_etag(const coap_request *req){
+    unsigned char values[8];
+    int temperature = temp_get();
+    unsigned int config_crc = eecrc_get_config_crc();
+    unsigned int added = logindex_get_added();
+
+    values[0] = req->resource;
+    values[1] = req->fields;
+    values[2] = temperature >> 8;
+    values[3] = temperature & 0xFF;
+    values[4] = config_crc >> 8;
+    values[5] = config_crc & 0xFF;
+    values[6] = added >> 8;
+    values[7] = added & 0xFF;
+    return crc16(values, sizeof(values));
+ }
+
+ /**********************************
+ * send_content()
+ *
+ * Sends a 2.05 response with the requested block of the representation
+ * (block 0 if none was requested).  The Block2 option is added when the
+ * client asked for a block or the representation does not fit in one,
+ * and the ETag identifies the representation the block was cut from.
+ *
+ * arguments:
+ *  req - the request
+ *  addr, port - the remote endpoint
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the socket transmit buffer
+ */
+ static void send_content(const coap_request *req, const unsigned char *addr, unsigned int port){
+    unsigned char format = (req->resource == RES_CORE) ? FORMAT_LINK : FORMAT_JSON;
+    unsigned int tag;
+    unsigned char etag[2];
+    unsigned char szx = req->block_szx;
+    unsigned long num = req->block_num;
+    unsigned long offset;
+    unsigned int size;
+    unsigned int total;
+    unsigned char more;
+
+    if(req->accept != NO_ACCEPT && req->accept != format){
+        send_code(req, addr, port, CODE_NOT_ACCEPTABLE);
+        return;
+    }
+    if(szx == NONE){
+        szx = COAP_MAX_SZX;
+        num = 0;
+    }
+    else if(szx > COAP_MAX_SZX){
+        /* a smaller block than requested - the same offset in smaller blocks */
+        num <<= szx - COAP_MAX_SZX;
+        szx = COAP_MAX_SZX;
+    }
+    size = 16 << szx;
+    offset = num << (szx + 4);
+
+    /* measure the representation */
+    udpsocket_set_window(UDPMUX_SOCKET, 0xFFFF, 0);
+    render(req);
+    total = udpsocket_get_window_count();
+    udpsocket_set_window(UDPMUX_SOCKET, 0, 0xFFFF);
+    if(offset > 0 && offset >= total){
+        send_code(req, addr, port, CODE_BAD_OPTION);
+        return;
+    }
+    more = (offset + size < total);
+    tag = get_etag(req);
+    etag[0] = tag >> 8;
+    etag[1] = tag & 0xFF;
+
+    begin_message(addr, port, req->type, CODE_CONTENT, req->mid, req->token, req->tkl);
+    put_option(OPT_ETAG, etag, sizeof(etag));
+    if(req->observing){
+        put_uint_option(OPT_OBSERVE, observe_seq);
+    }
+    put_uint_option(OPT_CONTENT_FORMAT, format);
+    if(req->block_szx != NONE || more){
+        put_uint_option(OPT_BLOCK2, (num << 4) | (more << 3) | szx);
+    }
+    if(total > 0){
+        socket_writechar(UDPMUX_SOCKET, PAYLOAD_MARKER);
+        udpsocket_set_window(UDPMUX_SOCKET, offset, size);
+        render(req);
+    }
+    udpsocket_send_datagram(UDPMUX_SOCKET);
+ }
+
+ /**********************************
+ * find_observer()
+ *
+ * Returns the observer slot of a remote endpoint
+ *
+ * arguments:
+ *  addr, port - the remote endpoint (port 0 to find a free slot)
+ *
+ * returns:
+ *  the slot, or COAP_MAX_OBSERVERS if there is none
+ *
+ * changes:
+ *  none
+ */
+ static unsigned char find_observer(const unsigned char *addr, unsigned int port){
+    unsigned char i;
+
+    for(i = 0; i < COAP_MAX_OBSERVERS; i++){
+        if(observers[i].port == port && (port == 0 || memcmp(observers[i].addr, addr, 4) == 0)){
+            break;
+        }
+    }
+    return i;
+ }
+
+ /**********************************
+ * handle_request()
+ *
+ * Handles a request and sends the response
+ *
+ * arguments:
+ *  req - the request (header and token set)
+ *  msg - the request datagram
+ *  len - its length
+ *  addr, port - the remote endpoint
+ *  code - the request method
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  observers, last_* (the duplicate check), config, the log
+ */
+ static void handle_request(coap_request *req, const unsigned char *msg, unsigned int len,
+                            const unsigned char *addr, unsigned int port, unsigned char code){
+    unsigned char error = parse_options(msg, len, req);
+    unsigned char slot;
+    unsigned char duplicate;
+
+    if(error){
+        send_code(req, addr, port, error);
+        return;
+    }
+
+    /* a retransmitted confirmable PUT/DELETE is answered but not applied */
+    duplicate = (req->type == TYPE_ACK && code != CODE_GET && req->mid == last_mid &&
+                 port == last_port && memcmp(addr, last_addr, 4) == 0);
+    if(duplicate){
+        send_code(req, addr, port, last_code);
+        return;
+    }
+
+    switch(req->resource){
+    case RES_DEVICE:
+        if(code != CODE_GET){
+            error = CODE_NOT_ALLOWED;
+        }
+        else if(!parse_device_query(req)){
+            error = CODE_BAD_REQUEST;
+        }
+        else{
+            slot = find_observer(addr, port);
+            if(req->observe == OBSERVE_DEREGISTER && slot < COAP_MAX_OBSERVERS){
+                observers[slot].port = 0;
+            }
+            else if(req->observe == OBSERVE_REGISTER){
+                if(slot == COAP_MAX_OBSERVERS){
+                    slot = find_observer(addr, 0);
+                }
+                if(slot < COAP_MAX_OBSERVERS){
+                    /* (re)register - without a free slot the response has no Observe */
+                    memcpy(observers[slot].addr, addr, 4);
+                    observers[slot].port = port;
+                    observers[slot].tkl = req->tkl;
+                    memcpy(observers[slot].token, req->token, req->tkl);
+                    observers[slot].fields = req->fields;
+                    req->observing = 1;
+                }
+            }
+            send_content(req, addr, port);
+            return;
+        }
+        break;
+    case RES_LOG:
+        if(code == CODE_GET){
+            if(!parse_log_query(req)){
+                error = CODE_BAD_REQUEST;
+                break;
+            }
+            send_content(req, addr, port);
+            return;
+        }
+        if(code == CODE_DELETE){
+            logindex_clear();
+            error = CODE_DELETED;
+        }
+        else{
+            error = CODE_NOT_ALLOWED;
+        }
+        break;
+    case RES_CONFIG:
+        error = (code == CODE_PUT) ? apply_config(req) : CODE_NOT_ALLOWED;
+        break;
+    case RES_CORE:
+        if(code == CODE_GET){
+            send_content(req, addr, port);
+            return;
+        }
+        error = CODE_NOT_ALLOWED;
+        break;
+    default:
+        error = CODE_NOT_FOUND;
+        break;
+    }
+
+    if(req->type == TYPE_ACK && code != CODE_GET){
+        memcpy(last_addr, addr, 4);
+        last_port = port;
+        last_mid = req->mid;
+        last_code = error;
+    }
+    send_code(req, addr, port, error);
+ }
+
+ /**********************************
+ * coap_receive()
+ *
+ * Handles a datagram received on the server port.  Requests are
+ * answered, an empty confirmable message (ping) is answered with a
+ * reset, and a reset from an observer ends its observation.  Responses
+ * and malformed messages are dropped.
+ *
+ * arguments:
+ *  msg - the received datagram
+ *  len - its length
+ *  addr, port - the remote endpoint
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  observers, config, the log
+ */
+ void coap_receive(const unsigned char *msg, unsigned int len, const unsigned char *addr, unsigned int port){
+    coap_request req;
+    unsigned char type;
+    unsigned char code;
+    unsigned char slot;
+
+    if(len < COAP_HEADER_SIZE || (msg[0] >> 6) != COAP_VERSION){
+        return;
+    }
+    type = (msg[0] >> 4) & 0x03;
+    code = msg[1];
+    req.tkl = msg[0] & 0x0F;
+    req.mid = (unsigned int)msg[2] << 8 | msg[3];
+    if(req.tkl > TOKEN_MAX || len < COAP_HEADER_SIZE + (unsigned int)req.tkl){
+        return;
+    }
+
+    if(type == TYPE_RST){
+        slot = find_observer(addr, port);
+        if(slot < COAP_MAX_OBSERVERS){
+            observers[slot].port = 0;
+        }
+        return;
+    }
+    if(type == TYPE_ACK || (code >> 5) != 0){
+        return;
+    }
+    if(code == CODE_EMPTY){
+        if(type == TYPE_CON){
+            begin_message(addr, port, TYPE_RST, CODE_EMPTY, req.mid, 0, 0);
+            udpsocket_send_datagram(UDPMUX_SOCKET);
+        }
+        return;
+    }
+
+    /* a piggybacked ACK for a confirmable request, a NON response otherwise */
+    if(type == TYPE_CON){
+        req.type = TYPE_ACK;
+    }
+    else{
+        req.type = TYPE_NON;
+        req.mid = ++next_mid;
+    }
+    memcpy(req.token, msg + COAP_HEADER_SIZE, req.tkl);
+    handle_request(&req, msg, len, addr, port, code);
+ }
+
+ /**********************************
+ * coap_update()
+ *
+ * Sends each observer of GET /device a non confirmable notification
+ * (with the fields it asked for) when the alarm state changes
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  notified_state, observe_seq, next_mid
+ */
+ void coap_update(){
+    coap_request req;
+    unsigned char state = devstate_classify(current_temperature);
+    unsigned char i;
+
+    if(state == notified_state || udpmux_is_closed()){
+        return;
+    }
+    notified_state = state;
+    observe_seq++;
+
+    req.type = TYPE_NON;
+    req.resource = RES_DEVICE;
+    req.observing = 1;
+    req.accept = NO_ACCEPT;
+    req.block_szx = NONE;
+    req.block_num = 0;
+    for(i = 0; i < COAP_MAX_OBSERVERS; i++){
+        if(observers[i].port != 0){
+            req.mid = ++next_mid;
+            req.tkl = observers[i].tkl;
+            memcpy(req.token, observers[i].token, req.tkl);
+            req.fields = observers[i].fields;
+            send_content(&req, observers[i].addr, observers[i].port);
+        }
+    }
+ }
+
+ #endif // COAP_ENABLE
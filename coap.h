@@ -0,0 +1,63 @@
+/********************************************************
+ * coap.h
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file provides declarations for the CoAP (RFC 7252) server, which
+ * serves the device resources over udp so that a fleet sweep costs one
+ * datagram each way instead of a TCP connection and an http request:
+ *
+ *  GET    /device[?fields=a,b]          device object (devapi.c)
+ *  GET    /device/log[?event=&from=&to=] matching log records
+ *  DELETE /device/log                   clears the log
+ *  PUT    /device/config?<name>=<value> sets one threshold
+ *  GET    /.well-known/core             resource links
+ *
+ * The json is the same as the http server sends.  Responses larger than
+ * a block are sent with block-wise transfer (Block2, RFC 7959).  GET
+ * /device may be observed (RFC 7641): the observers are sent a non
+ * confirmable notification whenever the alarm state changes.
+ *
+ * The server takes about 5K of flash, so it is only built when
+ * COAP_ENABLE is defined as 1.
+ */
+
+#ifndef COAP_H_INCLUDED
+#define COAP_H_INCLUDED
+
+#ifndef COAP_ENABLE
+#define COAP_ENABLE 0
+#endif
+
+/* server port (the server uses the shared udp socket, udpmux.h) */
+#define COAP_PORT           5683
+
+/* largest block (SZX 5 = 512 bytes), which fits the 1K transmit buffer of
+* the shared socket with the header
+*/
+#define COAP_MAX_SZX        5
+
+/* number of observers of GET /device */
+#define COAP_MAX_OBSERVERS  2
+
+#if COAP_ENABLE
+
+/**********************************
+ * coap_receive()
+ *
+ * Handles a datagram received on COAP_PORT (called by udpmux_update())
+ */
+void coap_receive(const unsigned char *msg, unsigned int len, const unsigned char *addr, unsigned int port);
+
+/**********************************
+ * coap_update()
+ *
+ * Notifies the observers when the alarm state changes.  Call from the
+ * main loop.
+ */
+void coap_update();
+
+#endif // COAP_ENABLE
+
+#endif // COAP_H_INCLUDED
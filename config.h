@@ -43,6 +43,11 @@
     /* set the modified flag for the configuration data */
     void config_set_modified();
 
+    /* write the default configuration to the eeprom.  The in-memory config is
+    * not changed, so it must be read back from the eeprom once the write completes.
+    */
+    void config_write_defaults();
+
     /* debug code */
     void config_dump();
 
@@ -0,0 +1,172 @@
+/********************************************************
+ * crash.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file implements the watchdog crash record.  A watchdog
+ * timeout only leaves an EVENT_WDT log record, which does not say
+ * what the main loop was doing.  The watchdog interrupt (which fires
+ * one timeout before the reset) calls crash_capture() to record the
+ * running scheduler task and latency stage, the time already spent
+ * in that stage, the longest stage run so far, the http parser state,
+ * the last socket operation and the stack pointer.  The record is
+ * protected with a crc16 and read back by crash_init() after the
+ * restart.
+ *
+ * Functions:
+ *
+ * crash_init()
+ *  Reads the crash record of a previous watchdog reset
+ *
+ * crash_capture()
+ *  Captures the main loop state and writes the crash record
+ *
+ * crash_get_record()
+ *  Returns the last crash record
+ *
+ * crash_get_sockop_name()
+ *  Returns the name of a socket operation
+ *
+ * record_is_valid()
+ *  Checks the token and crc of the crash record
+ */
+
+ #include <avr/pgmspace.h>
+ #include "crash.h"
+ #include "eeprom.h"
+ #include "crc16.h"
+ #include "rtc.h"
+ #include "sched.h"
+ #include "latency.h"
+ #include "httpparser.h"
+
+ volatile unsigned char crash_last_sockop;
+
+ static crash_struct record;
+
+ /* socket operation names, in program memory */
+ #define SOCKOP_NAME_SIZE    11
+
+ static const char sockop_names[SOCKOP_NUM_OPS][SOCKOP_NAME_SIZE] PROGMEM = {
+    "none", "open", "listen", "recv", "send", "disconnect", "flush", "dhcp"
+ };
+
+ /**********************************
+ * record_is_valid()
+ *
+ * Checks the token and crc of the crash record in memory
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  1 if the record is valid, otherwise 0
+ *
+ * changes:
+ *  none
+ */
+ static int record_is_valid(){
+    if(record.token[0] != 'W' || record.token[1] != 'D' || record.token[2] != 'T' || record.token[3] != '1'){
+        return 0;
+    }
+    return crc16((unsigned char*)&record, sizeof(record) - sizeof(record.crc)) == record.crc;
+ }
+
+ /**********************************
+ * crash_init()
+ *
+ * Reads the crash record of a previous watchdog reset from the eeprom
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  record
+ */
+ void crash_init(){
+    while(eeprom_isbusy()){}
+    eeprom_readbuf(CRASH_EEPROM_ADDR, (unsigned char*)&record, sizeof(record));
+ }
+
+ /**********************************
+ * crash_capture()
+ *
+ * Captures the main loop state and writes the crash record to the eeprom
+ * without using the eeprom interrupt.  Called from the watchdog interrupt,
+ * so interrupts are disabled and the write must finish before the reset.
+ *
+ * arguments:
+ *  sp - stack pointer at the time of the watchdog interrupt
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  record, the crash record in the eeprom
+ */
+ void crash_capture(unsigned int sp){
+    unsigned char count = record_is_valid() ? record.count + 1 : 1;
+
+    record.token[0] = 'W';
+    record.token[1] = 'D';
+    record.token[2] = 'T';
+    record.token[3] = '1';
+    record.count = count ? count : 0xFF;
+    record.time = rtc_get_date();
+    record.task = sched_get_current();
+ #if LATENCY_ENABLE
+    record.stage = latency_get_current(&record.stage_ticks);
+    record.max_stage = latency_get_max(&record.max_ticks);
+ #else
+    record.stage = 0xFF;
+    record.stage_ticks = 0;
+    record.max_stage = 0xFF;
+    record.max_ticks = 0;
+ #endif
+    record.parser_state = parser_state;
+    record.sockop = crash_last_sockop;
+    record.sp = sp;
+    record.crc = crc16((unsigned char*)&record, sizeof(record) - sizeof(record.crc));
+
+    eeprom_writebuf_noisr(CRASH_EEPROM_ADDR, (unsigned char*)&record, sizeof(record));
+ }
+
+ /**********************************
+ * crash_get_record()
+ *
+ * Returns the last crash record read from the eeprom
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  pointer to the record, or 0 if no watchdog reset has been captured
+ *
+ * changes:
+ *  none
+ */
+ const crash_struct *crash_get_record(){
+    return record_is_valid() ? &record : 0;
+ }
+
+ /**********************************
+ * crash_get_sockop_name()
+ *
+ * Returns the name of a socket operation
+ *
+ * arguments:
+ *  op - the operation (enum crash_sockop)
+ *
+ * returns:
+ *  the name of the operation (in program memory)
+ *
+ * changes:
+ *  none
+ */
+ const char *crash_get_sockop_name(unsigned char op){
+    return (op < SOCKOP_NUM_OPS) ? sockop_names[op] : PSTR("unknown");
+ }
@@ -0,0 +1,84 @@
+/********************************************************
+ * crash.h
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file provides declarations for the watchdog crash
+ * record.  When the watchdog interrupt fires (just before the
+ * watchdog reset) the state of the main loop is captured and
+ * written to the eeprom, so that it can be read back after the
+ * restart.
+ */
+
+#ifndef CRASH_H_INCLUDED
+#define CRASH_H_INCLUDED
+
+/* location of the crash record in the eeprom (after the lease cache) */
+#define CRASH_EEPROM_ADDR   0x0130
+
+/* socket operations recorded with CRASH_SOCKOP() */
+enum crash_sockop {
+    SOCKOP_NONE,
+    SOCKOP_OPEN,
+    SOCKOP_LISTEN,
+    SOCKOP_RECV,
+    SOCKOP_SEND,
+    SOCKOP_DISCONNECT,
+    SOCKOP_FLUSH,
+    SOCKOP_DHCP,
+    SOCKOP_NUM_OPS
+};
+
+typedef struct {
+    char          token[4];
+    unsigned char count;        /* number of watchdog resets captured */
+    unsigned long time;         /* rtc time of the capture */
+    unsigned char task;         /* running scheduler task (SCHED_NO_TASK if none) */
+    unsigned char stage;        /* running latency stage (LAT_NO_STAGE if none) */
+    unsigned long stage_ticks;  /* time spent in that stage (4us ticks) */
+    unsigned char max_stage;    /* stage with the longest run */
+    unsigned long max_ticks;    /* longest run of any stage (4us ticks) */
+    unsigned char parser_state; /* http parser state */
+    unsigned char sockop;       /* last socket operation (socket << 4 | operation) */
+    unsigned int  sp;           /* stack pointer in the watchdog interrupt */
+    unsigned int  crc;
+} crash_struct;
+
+/* last socket operation - written by CRASH_SOCKOP() */
+extern volatile unsigned char crash_last_sockop;
+
+/* records the socket operation about to be performed */
+#define CRASH_SOCKOP(socket, op)    (crash_last_sockop = ((socket) << 4) | (op))
+
+/**********************************
+ * crash_init()
+ *
+ * Reads the crash record of a previous watchdog reset from the eeprom
+ */
+void crash_init();
+
+/**********************************
+ * crash_capture()
+ *
+ * Captures the main loop state and writes the crash record to the eeprom
+ * without interrupts.  Called from the watchdog interrupt.
+ */
+void crash_capture(unsigned int sp);
+
+/**********************************
+ * crash_get_record()
+ *
+ * Returns the last crash record, or 0 if there is none
+ */
+const crash_struct *crash_get_record();
+
+/**********************************
+ * crash_get_sockop_name()
+ *
+ * Returns the name of a socket operation (enum crash_sockop), in
+ * program memory
+ */
+const char *crash_get_sockop_name(unsigned char op);
+
+#endif // CRASH_H_INCLUDED
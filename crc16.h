@@ -0,0 +1,43 @@
+/********************************************************
+ * crc16.h
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file provides declarations for the table-driven
+ * CRC-16 (CCITT polynomial 0x1021, initial value 0xFFFF)
+ * functions used to protect the EEPROM images.
+ */
+
+#ifndef CRC16_H_INCLUDED
+#define CRC16_H_INCLUDED
+
+/* initial value of a crc computation */
+#define CRC16_INIT 0xFFFF
+
+/**********************************
+ * crc16()
+ *
+ * Returns the crc of the specified data
+ */
+unsigned int crc16(const unsigned char *data, unsigned int len);
+
+/**********************************
+ * crc16_update()
+ *
+ * Continues a crc computation over the specified data
+ */
+unsigned int crc16_update(unsigned int crc, const unsigned char *data, unsigned int len);
+
+/**********************************
+ * crc16_adjust()
+ *
+ * Returns the crc of a message after a run of len bytes within it has
+ * changed from old_data to new_data, given the crc of the original message.
+ * trailing is the number of message bytes that follow the changed run.
+ * Only the changed and trailing bytes are processed.
+ */
+unsigned int crc16_adjust(unsigned int crc, const unsigned char *old_data,
+                          const unsigned char *new_data, unsigned int len, unsigned int trailing);
+
+#endif // CRC16_H_INCLUDED
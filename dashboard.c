@@ -0,0 +1,104 @@
+/********************************************************
+ * dashboard.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * Generated by tools/gen_dashboard.py from tools/dashboard.html - do not
+ * edit.  The gzip compressed web dashboard (1778 bytes, 1012 compressed).
+ */
+
+ #include <avr/pgmspace.h>
+ #include "dashboard.h"
+
+ #if DASHBOARD_ENABLE
+
+ const unsigned char dashboard_gz[DASHBOARD_GZ_SIZE] PROGMEM = {
+    0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x65, 0x55,
+    0x6D, 0x6F, 0xA3, 0x46, 0x10, 0xFE, 0xCE, 0xAF, 0xA0, 0x4E, 0xDA, 0x85,
+    0x82, 0x31, 0xB8, 0xB9, 0xEA, 0x64, 0xC0, 0x55, 0x2E, 0x77, 0x92, 0x2D,
+    0xE5, 0xA5, 0x4A, 0x23, 0x55, 0x55, 0x74, 0x3A, 0xAD, 0x61, 0x0D, 0xDB,
+    0x2C, 0xBB, 0xDC, 0xEE, 0x1A, 0x3B, 0x45, 0xFC, 0xF7, 0xCE, 0x02, 0x76,
+    0xDC, 0x54, 0x11, 0x61, 0x5E, 0x9E, 0x99, 0x9D, 0x79, 0x66, 0x58, 0x27,
+    0x3F, 0x7C, 0x7E, 0xB8, 0x79, 0xFA, 0xEB, 0xF7, 0x2F, 0x76, 0xA9, 0x2B,
+    0xB6, 0xB4, 0x92, 0xE3, 0x8B, 0xE0, 0x1C, 0x5E, 0x15, 0xD1, 0xD8, 0xCE,
+    0x4A, 0x2C, 0x15, 0xD1, 0xE9, 0x64, 0xA7, 0xB7, 0xD3, 0x8F, 0x93, 0xA3,
+    0x99, 0xE3, 0x8A, 0xA4, 0x93, 0x86, 0x92, 0x7D, 0x2D, 0xA4, 0x9E, 0xD8,
+    0x99, 0xE0, 0x9A, 0x70, 0x80, 0xED, 0x69, 0xAE, 0xCB, 0x34, 0x27, 0x0D,
+    0xCD, 0xC8, 0xB4, 0x57, 0x7C, 0xCA, 0xA9, 0xA6, 0x98, 0x4D, 0x55, 0x86,
+    0x19, 0x49, 0x23, 0x93, 0x43, 0x53, 0xCD, 0xC8, 0x72, 0xBD, 0x16, 0x4F,
+    0xF6, 0x1F, 0x84, 0x2B, 0x21, 0x93, 0xD9, 0x60, 0xB2, 0x12, 0xA5, 0x5F,
+    0xCD, 0x7B, 0x23, 0xF2, 0xD7, 0x76, 0x0B, 0x59, 0x17, 0xD1, 0x55, 0x7D,
+    0xB0, 0x15, 0xE6, 0x6A, 0xAA, 0x88, 0xA4, 0xDB, 0xB8, 0xC2, 0xB2, 0xA0,
+    0x7C, 0x11, 0x91, 0x0A, 0xC4, 0xC3, 0x70, 0xC6, 0xE2, 0x2A, 0x04, 0x35,
+    0x13, 0x4C, 0xC8, 0xC5, 0xC5, 0x7C, 0x3E, 0xEF, 0xAC, 0x32, 0xEA, 0xA3,
+    0xA7, 0x8A, 0xFE, 0x43, 0x16, 0x51, 0xF0, 0x0B, 0xA9, 0x3A, 0x4B, 0xE3,
+    0x0D, 0x23, 0xED, 0x46, 0xC8, 0x9C, 0xC8, 0x29, 0x80, 0x19, 0xAE, 0x15,
+    0x59, 0x1C, 0x05, 0xF0, 0xE7, 0x6D, 0x8D, 0xF3, 0x9C, 0xF2, 0x62, 0x31,
+    0x87, 0x33, 0x23, 0xF3, 0xCF, 0x3C, 0x61, 0x67, 0x5D, 0xE8, 0xB3, 0x74,
+    0x90, 0x2C, 0xEE, 0xB5, 0x3D, 0xA1, 0x45, 0xA9, 0x17, 0x1B, 0xC1, 0xF2,
+    0xCE, 0x0A, 0xEE, 0x1F, 0x1E, 0xEF, 0xAE, 0x6F, 0xDB, 0xB1, 0x8A, 0xF0,
+    0x63, 0xD8, 0x05, 0x7F, 0x5E, 0x3F, 0xDE, 0x7F, 0x5B, 0xAD, 0xFD, 0x41,
+    0xB8, 0x7D, 0x38, 0x3A, 0x33, 0xE3, 0xBC, 0x79, 0x5C, 0x3F, 0xF5, 0xCE,
+    0x5E, 0x38, 0x73, 0x86, 0x70, 0xA0, 0x6A, 0x8A, 0x76, 0x68, 0x2D, 0x0A,
+    0xC3, 0x1F, 0xE3, 0x72, 0x38, 0x29, 0x9A, 0x87, 0xF5, 0x21, 0xDE, 0xE0,
+    0xEC, 0xA5, 0x90, 0x62, 0xC7, 0xF3, 0xC5, 0xC5, 0xF6, 0xCA, 0xFC, 0x75,
+    0x56, 0x2D, 0xD8, 0x2B, 0xA3, 0x9C, 0xB4, 0x5B, 0xCA, 0xD8, 0x82, 0x0B,
+    0x4E, 0x62, 0xA5, 0xA5, 0x78, 0x21, 0x50, 0xC9, 0xAF, 0xD9, 0x28, 0x8F,
+    0x64, 0x45, 0xC1, 0x87, 0xCE, 0x4A, 0x66, 0x23, 0xD3, 0xC9, 0x6C, 0x9C,
+    0xB7, 0xA1, 0xDC, 0x4C, 0x3F, 0x3A, 0x1F, 0x8C, 0x9D, 0xA8, 0x1A, 0x73,
+    0x9B, 0xE6, 0xE9, 0xA4, 0x9A, 0x2C, 0x21, 0x08, 0x34, 0x78, 0x01, 0xC8,
+    0x4A, 0x72, 0xDA, 0x2C, 0xDF, 0xDC, 0x7A, 0xB2, 0x9C, 0x4E, 0x47, 0x80,
+    0xFD, 0x53, 0x4E, 0x8A, 0xF8, 0xE6, 0x2C, 0x58, 0x9D, 0x05, 0x9B, 0x38,
+    0x18, 0x74, 0x53, 0xD8, 0x66, 0x81, 0x3E, 0x89, 0x43, 0x3A, 0x09, 0xED,
+    0x10, 0xF8, 0x86, 0x27, 0x0C, 0x27, 0x76, 0x2D, 0x09, 0x8C, 0xBA, 0x21,
+    0xD7, 0xAA, 0x26, 0x99, 0x7E, 0xC4, 0x9A, 0x8A, 0x74, 0x62, 0x5A, 0x82,
+    0x1C, 0xC7, 0x3E, 0xFB, 0xA4, 0xF5, 0x64, 0x66, 0xB2, 0x36, 0x85, 0x29,
+    0x7B, 0xBE, 0x7C, 0x2A, 0x21, 0xB0, 0x84, 0x61, 0x28, 0x28, 0x70, 0xBE,
+    0x4C, 0xFA, 0x79, 0x0F, 0xB5, 0x95, 0xE6, 0xF8, 0x5E, 0x1F, 0xA0, 0x9F,
+    0xFB, 0x05, 0x7D, 0x0F, 0x6B, 0xDE, 0xA1, 0x6E, 0x45, 0xF1, 0x1E, 0xC2,
+    0xCE, 0x21, 0x2A, 0x93, 0xB4, 0xD6, 0x4B, 0xAB, 0xC1, 0xD2, 0x5E, 0xA5,
+    0xCF, 0x5F, 0xFD, 0xFB, 0x14, 0x9A, 0xF0, 0x2F, 0xD3, 0xED, 0x8E, 0x67,
+    0x50, 0x35, 0x77, 0xA8, 0xDB, 0x4A, 0xA2, 0x77, 0x92, 0xDB, 0xB9, 0xC8,
+    0x76, 0x15, 0x7C, 0x22, 0x41, 0x41, 0xF4, 0x17, 0x46, 0x8C, 0xF8, 0xE9,
+    0x75, 0x9D, 0x03, 0xA2, 0x8B, 0xAD, 0x23, 0xDE, 0x96, 0x62, 0xAF, 0x1C,
+    0x9A, 0xFB, 0xC2, 0x6D, 0x4D, 0xD2, 0x32, 0x45, 0x08, 0x56, 0x4D, 0x3A,
+    0x46, 0x79, 0xB1, 0x29, 0xB7, 0x85, 0x5B, 0x7A, 0x29, 0x4A, 0xB4, 0x84,
+    0xA2, 0xF2, 0x25, 0xF2, 0x5E, 0x3C, 0x04, 0xF5, 0xE4, 0xA3, 0x26, 0x9E,
+    0x5F, 0xBE, 0x1E, 0x0D, 0x33, 0xC0, 0xA0, 0xF8, 0x12, 0xB2, 0xB9, 0x01,
+    0xE5, 0x9C, 0xC8, 0xD5, 0xD3, 0xDD, 0x6D, 0x5A, 0x76, 0x6F, 0x87, 0x01,
+    0x57, 0x7B, 0x27, 0x77, 0x5B, 0xEB, 0xD2, 0x41, 0x1A, 0xB9, 0x81, 0x26,
+    0x07, 0x7D, 0x33, 0x7E, 0xC8, 0x39, 0x68, 0x55, 0x4D, 0x24, 0x86, 0xE2,
+    0x49, 0x6C, 0x10, 0xEA, 0x7F, 0x08, 0xA5, 0xB1, 0x26, 0xF1, 0xE8, 0xCA,
+    0x18, 0x56, 0xEA, 0xDE, 0x5C, 0x0B, 0x47, 0x87, 0xB5, 0x0A, 0xEA, 0x9D,
+    0x2A, 0x9D, 0xFF, 0xA4, 0x72, 0x63, 0xBA, 0x75, 0x56, 0x01, 0x23, 0xBC,
+    0xD0, 0xE5, 0xF2, 0xDE, 0x5D, 0x05, 0xAA, 0xA4, 0x5B, 0xED, 0xB8, 0x71,
+    0xCF, 0x22, 0x13, 0xE9, 0x1D, 0xD6, 0x65, 0x50, 0x51, 0x1E, 0xE0, 0xBA,
+    0x66, 0xAF, 0x4E, 0xE8, 0xAF, 0xDC, 0x69, 0xE4, 0x97, 0x74, 0x74, 0xE0,
+    0xC3, 0x99, 0xC3, 0x8B, 0xFC, 0xDA, 0x50, 0x64, 0x1D, 0x39, 0xA2, 0x69,
+    0x18, 0xD3, 0xE4, 0x98, 0x3F, 0xA6, 0x9E, 0xE7, 0xD6, 0x5E, 0x4A, 0x3D,
+    0xE4, 0x23, 0xCF, 0x81, 0xE5, 0x9A, 0x3A, 0xAB, 0x67, 0xFA, 0x75, 0xCA,
+    0x84, 0xFB, 0x33, 0x68, 0x33, 0xA7, 0xA4, 0x46, 0x76, 0x3D, 0x64, 0xA3,
+    0xBE, 0xC9, 0x1A, 0x3A, 0x81, 0xEB, 0xEE, 0x5A, 0x6B, 0x49, 0x37, 0x3B,
+    0x4D, 0xC0, 0x22, 0x28, 0xD7, 0x0A, 0xF9, 0x35, 0x54, 0x78, 0xC6, 0x1D,
+    0x4C, 0xD1, 0xF9, 0xEE, 0x6F, 0xDD, 0x76, 0x4B, 0x74, 0x56, 0x3A, 0x68,
+    0x36, 0x5C, 0x79, 0xC8, 0xFB, 0x0E, 0x2C, 0x95, 0x84, 0x3B, 0xA7, 0x15,
+    0x90, 0xA7, 0x15, 0x90, 0xC1, 0xDF, 0x0A, 0x0C, 0x6E, 0x77, 0x84, 0x00,
+    0x6B, 0xD8, 0x44, 0x9F, 0xB0, 0x6E, 0xDB, 0xB9, 0x9D, 0x65, 0x72, 0x23,
+    0xE4, 0x9F, 0xAC, 0x66, 0x44, 0xA6, 0xB9, 0x06, 0xA8, 0x6D, 0xEA, 0xDC,
+    0x30, 0x5E, 0xBD, 0x1B, 0x46, 0x13, 0x54, 0x22, 0x27, 0x2C, 0xEE, 0xF7,
+    0x07, 0x35, 0xC8, 0x6F, 0xA0, 0xDC, 0x41, 0xD1, 0x25, 0xF2, 0x5B, 0x0D,
+    0x9B, 0xAA, 0xBF, 0x95, 0x74, 0x01, 0xC3, 0x18, 0x45, 0x5F, 0xEF, 0xB1,
+    0xE4, 0xA3, 0x6D, 0x14, 0x47, 0x1B, 0x13, 0x27, 0x1B, 0x13, 0xFE, 0x10,
+    0x30, 0xD8, 0x46, 0xB1, 0x3B, 0x65, 0x67, 0xC8, 0xCF, 0x03, 0x26, 0x0A,
+    0x18, 0x4C, 0xFD, 0xD6, 0x07, 0x39, 0xF5, 0x4C, 0x02, 0x4D, 0x2B, 0x02,
+    0x0B, 0x51, 0xD5, 0x40, 0x32, 0x69, 0xA0, 0x58, 0x1B, 0x79, 0x24, 0xE8,
+    0xA5, 0xCE, 0x85, 0x3C, 0xE3, 0x16, 0x82, 0x40, 0xF4, 0x1A, 0xBA, 0x91,
+    0x0D, 0x66, 0xE7, 0x8C, 0xF4, 0x6C, 0xFC, 0xB6, 0xA5, 0x04, 0xBE, 0xEB,
+    0xF4, 0x6C, 0x93, 0xFC, 0x7E, 0xCB, 0x90, 0x6F, 0xE2, 0xDD, 0xCE, 0xFF,
+    0x10, 0x86, 0xA1, 0x19, 0x11, 0x3C, 0x70, 0x25, 0x8C, 0x1F, 0x66, 0x32,
+    0x1B, 0x2F, 0xB5, 0xD9, 0xF0, 0xD3, 0xF6, 0x2F, 0x0F, 0xED, 0x39, 0xAC,
+    0xF2, 0x06, 0x00, 0x00
+ };
+
+ #endif // DASHBOARD_ENABLE
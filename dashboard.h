@@ -0,0 +1,35 @@
+/********************************************************
+ * dashboard.h
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file declares the web dashboard served at GET /.  The page
+ * (tools/dashboard.html) is gzip compressed by tools/gen_dashboard.py,
+ * which generates dashboard.c and the size below, and is sent as is
+ * with Content-Encoding: gzip.  It fetches /device once and then polls
+ * /device?fields=temperature,state, doing all formatting in the browser.
+ *
+ * The page takes about 1K of flash, so it is only built when
+ * DASHBOARD_ENABLE is defined as 1 (otherwise GET / is an invalid
+ * endpoint).
+ */
+
+#ifndef DASHBOARD_H_INCLUDED
+#define DASHBOARD_H_INCLUDED
+
+#ifndef DASHBOARD_ENABLE
+#define DASHBOARD_ENABLE 0
+#endif
+
+/* size of the compressed page (updated by tools/gen_dashboard.py) */
+#define DASHBOARD_GZ_SIZE   1012
+
+#if DASHBOARD_ENABLE
+
+/* the compressed page, in program memory */
+extern const unsigned char dashboard_gz[DASHBOARD_GZ_SIZE];
+
+#endif // DASHBOARD_ENABLE
+
+#endif // DASHBOARD_H_INCLUDED
@@ -25,4 +25,8 @@ void     delay_set(unsigned int num, unsigned int msec);
 * limit, otherwise, return 0 */
 unsigned delay_isdone(unsigned int num);
 
+/* return the number of milliseconds since the delay timer was started.
+* The timer is started by the first call to any delay function. */
+unsigned long millis();
+
 #endif // DELAY_H_INCLUDED
@@ -0,0 +1,454 @@
+/********************************************************
+ * devapi.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file implements the device resources shared by the http and
+ * CoAP servers.  The json is written with the socket_write functions,
+ * so the same code fills a TCP stream or a udp datagram.
+ *
+ * Functions:
+ *
+ * devapi_find_name()
+ *  Returns the row of a field or config parameter name
+ *
+ * devapi_send_device()
+ *  Sends the device object, limited to the selected fields
+ *
+ * devapi_send_log()
+ *  Sends the matching log records and the record counts
+ *
+ * devapi_set_config()
+ *  Applies a config parameter through the update rules
+ *
+ * devapi_get_thresholds()
+ *  Copies the config thresholds
+ *
+ * devapi_set_thresholds()
+ *  Sets all the config thresholds or none of them
+ *
+ * thresholds_valid()
+ *  Checks the order of a set of thresholds
+ *
+ * send_json_log_entry()
+ *  Sends a single log record as a json object
+ *
+ * send_json_field()
+ *  Starts a selected member of the device object
+ */
+
+ #include <avr/pgmspace.h>
+ #include "devapi.h"
+ #include "devstate.h"
+ #include "socket.h"
+ #include "vpd.h"
+ #include "config.h"
+ #include "temp.h"
+ #include "log.h"
+ #include "logindex.h"
+ #include "rtc.h"
+ #include "util.h"
+
+ /* field names (GET /device?fields=) */
+ const char device_fields[DEVICE_FIELD_COUNT][DEVICE_FIELD_NAME_SIZE] PROGMEM = {
+    "vpd", "tcrit_hi", "twarn_hi", "tcrit_lo", "twarn_lo", "temperature", "state", "log"
+ };
+
+ /* config parameter names (PUT /device/config?) */
+ const char device_configs[DEVICE_CONFIG_COUNT][DEVICE_CONFIG_NAME_SIZE] PROGMEM = {
+    "tcrit_hi", "twarn_hi", "tcrit_lo", "twarn_lo"
+ };
+
+ /* config thresholds and the functions that validate and apply them */
+ static int *const thresholds[DEVICE_CONFIG_COUNT] = {
+    &config.hi_alarm, &config.hi_warn, &config.lo_alarm, &config.lo_warn
+ };
+ static int (*const update[DEVICE_CONFIG_COUNT])(int) = {
+    update_tcrit_hi, update_twarn_hi, update_tcrit_lo, update_twarn_lo
+ };
+
+ /**********************************
+ * thresholds_valid()
+ *
+ * Checks that a set of thresholds keeps the order the update functions
+ * enforce (tcrit_lo < twarn_lo < twarn_hi < tcrit_hi <= 0x3FF)
+ *
+ * arguments:
+ *  t - the thresholds, in DEVICE_CONFIG_* order
+ *
+ * returns:
+ *  1 if the set is valid, 0 otherwise
+ *
+ * changes:
+ *  none
+ */
+ static unsigned char thresholds_valid(const int *t){
+    return t[DEVICE_CONFIG_TCRIT_LO] < t[DEVICE_CONFIG_TWARN_LO] &&
+           t[DEVICE_CONFIG_TWARN_LO] < t[DEVICE_CONFIG_TWARN_HI] &&
+           t[DEVICE_CONFIG_TWARN_HI] < t[DEVICE_CONFIG_TCRIT_HI] &&
+           t[DEVICE_CONFIG_TCRIT_HI] <= 0x3FF;
+ }
+
+ /**********************************
+ * send_json_log_entry()
+ *
+ * Sends a single log record as a json object.  The milliseconds of the
+ * timestamp are added as "ms" when they are known.
+ *
+ * arguments:
+ *  socket - unsigned char represents an instance of a server socket
+ *  index - index of the log record to send
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  none
+ */
+ static void send_json_log_entry(unsigned char socket, unsigned char index){
+    unsigned long time;
+    unsigned char event_num;
+    unsigned int ms = logindex_get_ms(index);
+    log_get_record(index, &time, &event_num);
+
+    socket_writechar(socket, '{'); //open log object
+
+    socket_writequotedstring_P(socket, PSTR("timestamp"));
+    socket_writechar(socket, ':');
+    socket_writequotedstring(socket, rtc_num2datestr(time));
+    socket_writechar(socket, ',');
+    if(ms != LOGINDEX_NO_MS){
+        socket_writequotedstring_P(socket, PSTR("ms"));
+        socket_writechar(socket, ':');
+        socket_writedec32(socket, ms);
+        socket_writechar(socket, ',');
+    }
+    socket_writequotedstring_P(socket, PSTR("event"));
+    socket_writechar(socket, ':');
+    socket_writedec32(socket, (int)event_num);
+
+    socket_writechar(socket, '}'); //close log object
+ }
+
+ /**********************************
+ * send_json_field()
+ *
+ * Starts a member of the device object if its field is selected,
+ * preceded by a comma if an earlier field was selected (fields are sent
+ * in the order of their bits)
+ *
+ * arguments:
+ *  socket - unsigned char represents an instance of a server socket
+ *  fields - mask of the selected fields
+ *  field - the field (DEVICE_FIELD_*)
+ *
+ * returns:
+ *  1 if the field is selected and its value should follow, 0 otherwise
+ *
+ * changes:
+ *  none
+ */
+ static unsigned char send_json_field(unsigned char socket, unsigned char fields, unsigned char field){
+    if(!(fields & (1 << field))){
+        return 0;
+    }
+    if(fields & ((1 << field) - 1)){
+        socket_writechar(socket, ',');
+    }
+    socket_writequotedstring_P(socket, device_fields[field]);
+    socket_writechar(socket, ':');
+    return 1;
+ }
+
+ /**********************************
+ * devapi_find_name()
+ *
+ * Looks a name up in a table of program memory strings
+ *
+ * arguments:
+ *  table - the table (device_fields or device_configs)
+ *  size - size of each row
+ *  count - number of rows
+ *  name - the name (need not be null terminated)
+ *  len - number of characters in the name
+ *
+ * returns:
+ *  the row of the name, or count if it is not found
+ *
+ * changes:
+ *  none
+ */
+ unsigned char devapi_find_name(const char *table, unsigned char size, unsigned char count,
+                                const char *name, unsigned char len){
+    unsigned char i;
+
+    for(i = 0; i < count; i++, table += size){
+        if(strlen_P(table) == len && strncmp_P(name, table, len) == 0){
+            return i;
+        }
+    }
+    return count;
+ }
+
+ /**********************************
+ * devapi_send_device()
+ *
+ * Prepares and sends a json string which represents a
+ * status summary of the device, limited to the selected fields
+ *
+ * arguments:
+ *  socket - unsigned char represents an instance of a server socket
+ *  fields - mask of the fields to send (DEVICE_FIELDS_ALL for all)
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  none
+ */
+ void devapi_send_device(unsigned char socket, unsigned char fields){
+     //TODO: FIX TIMESTAMP ISSUE
+
+    socket_writechar(socket, '{'); //open outer object
+
+    //VPD Object
+    if(send_json_field(socket, fields, DEVICE_FIELD_VPD)){
+        socket_writechar(socket, '{'); //open vpd object
+        socket_writequotedstring_P(socket, PSTR("model"));
+        socket_writechar(socket, ':');
+        socket_writequotedstring(socket, vpd.model);
+        socket_writechar(socket, ',');
+        socket_writequotedstring_P(socket, PSTR("manufacturer"));
+        socket_writechar(socket, ':');
+        socket_writequotedstring(socket, vpd.manufacturer);
+        socket_writechar(socket, ',');
+        socket_writequotedstring_P(socket, PSTR("serial_number"));
+        socket_writechar(socket, ':');
+        socket_writequotedstring(socket, vpd.serial_number);
+        socket_writechar(socket, ',');
+        socket_writequotedstring_P(socket, PSTR("manufacture_date"));
+        socket_writechar(socket, ':');
+        socket_writedate(socket, vpd.manufacture_date);
+        socket_writechar(socket, ',');
+        socket_writequotedstring_P(socket, PSTR("mac_address"));
+        socket_writechar(socket, ':');
+        socket_write_macaddress(socket, vpd.mac_address);
+        socket_writechar(socket, ',');
+        socket_writequotedstring_P(socket, PSTR("country_code"));
+        socket_writechar(socket, ':');
+        socket_writequotedstring(socket, vpd.country_of_origin);
+        socket_writechar(socket, '}'); //close vpd object
+    }
+
+    //general info
+    if(send_json_field(socket, fields, DEVICE_FIELD_TCRIT_HI)){
+        socket_writedec32(socket, config.hi_alarm);
+    }
+    if(send_json_field(socket, fields, DEVICE_FIELD_TWARN_HI)){
+        socket_writedec32(socket, config.hi_warn);
+    }
+    if(send_json_field(socket, fields, DEVICE_FIELD_TCRIT_LO)){
+        socket_writedec32(socket, config.lo_alarm);
+    }
+    if(send_json_field(socket, fields, DEVICE_FIELD_TWARN_LO)){
+        socket_writedec32(socket, config.lo_warn);
+    }
+    if(send_json_field(socket, fields, DEVICE_FIELD_TEMPERATURE)){
+        socket_writedec32(socket, temp_get());
+    }
+    if(send_json_field(socket, fields, DEVICE_FIELD_STATE)){
+        socket_writequotedstring_P(socket, devstate_name_P(devstate_classify(temp_get())));
+    }
+
+    //Log array
+    if(send_json_field(socket, fields, DEVICE_FIELD_LOG)){
+        socket_writechar(socket, '['); //start log array
+
+        //create log entry JSON objects and write them
+        unsigned char i;
+
+        for (i=0; i < log_get_num_entries(); i++){
+            send_json_log_entry(socket, i);
+
+            //HEADS UP! - This should be fine, but keep an eye on it
+            if(i < log_get_num_entries()-1){
+                socket_writechar(socket, ',');
+            }
+        }
+        socket_writechar(socket, ']'); //end log array
+    }
+
+    socket_writechar(socket, '}'); //close outer object
+ }
+
+ /**********************************
+ * devapi_send_log()
+ *
+ * Sends the log records that match an event type and fall within
+ * [from, to] as a json object, with the record count and last time of
+ * the event type (or the counts of every event type for EVENT_UNK).
+ * Matching records are found through the log index, so the log is not
+ * scanned and only the matching records are transferred.
+ *
+ * arguments:
+ *  socket - unsigned char represents an instance of a server socket
+ *  event - the event type, or EVENT_UNK for any
+ *  from, to - the time range (rtc date numbers)
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  none
+ */
+ void devapi_send_log(unsigned char socket, unsigned char event, unsigned long from, unsigned long to){
+    unsigned int mask;
+    unsigned char i;
+    unsigned char first = 1;
+
+    socket_writechar(socket, '{'); //open outer object
+    if(event != EVENT_UNK){
+        //summary for the requested event type
+        socket_writequotedstring_P(socket, PSTR("event"));
+        socket_writechar(socket, ':');
+        socket_writedec32(socket, event);
+        socket_writechar(socket, ',');
+        socket_writequotedstring_P(socket, PSTR("count"));
+        socket_writechar(socket, ':');
+        socket_writedec32(socket, logindex_get_count(event));
+        socket_writechar(socket, ',');
+        socket_writequotedstring_P(socket, PSTR("last"));
+        socket_writechar(socket, ':');
+        if(logindex_get_count(event)){
+            socket_writequotedstring(socket, rtc_num2datestr(logindex_get_last(event)));
+        } else{
+            socket_writestr_P(socket, PSTR("null"));
+        }
+        socket_writechar(socket, ',');
+    } else{
+        //counts for every event type
+        socket_writequotedstring_P(socket, PSTR("counts"));
+        socket_writechar(socket, ':');
+        socket_writechar(socket, '[');
+        for(i = 0; i < LOGINDEX_NUM_EVENTS; i++){
+            if(i){
+                socket_writechar(socket, ',');
+            }
+            socket_writedec32(socket, logindex_get_count(i));
+        }
+        socket_writechar(socket, ']');
+        socket_writechar(socket, ',');
+    }
+
+    //matching log records
+    socket_writequotedstring_P(socket, PSTR("log"));
+    socket_writechar(socket, ':');
+    socket_writechar(socket, '['); //start log array
+    mask = logindex_query(event, from, to);
+    for(i = 0; mask != 0; i++, mask >>= 1){
+        if(mask & 1){
+            if(!first){
+                socket_writechar(socket, ',');
+            }
+            send_json_log_entry(socket, i);
+            first = 0;
+        }
+    }
+    socket_writechar(socket, ']'); //end log array
+
+    socket_writechar(socket, '}'); //close outer object
+ }
+
+ /**********************************
+ * devapi_set_config()
+ *
+ * Validates a config parameter through the update_*() rules and marks
+ * the config as modified so that it is written back
+ *
+ * arguments:
+ *  param - the parameter (DEVICE_CONFIG_*)
+ *  value - the new value
+ *
+ * returns:
+ *  1 if the value was applied, otherwise 0
+ *
+ * changes:
+ *  config
+ */
+ unsigned char devapi_set_config(unsigned char param, int value){
+    if(param >= DEVICE_CONFIG_COUNT || !update[param](value)){
+        return 0;
+    }
+    config_set_modified();
+    return 1;
+ }
+
+ /**********************************
+ * devapi_get_thresholds()
+ *
+ * Copies the config thresholds
+ *
+ * arguments:
+ *  value - where the thresholds are placed, in DEVICE_CONFIG_* order
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  value
+ */
+ void devapi_get_thresholds(int *value){
+    unsigned char i;
+
+    for(i = 0; i < DEVICE_CONFIG_COUNT; i++){
+        value[i] = *thresholds[i];
+    }
+ }
+
+ /**********************************
+ * devapi_set_thresholds()
+ *
+ * Sets all the config thresholds or none of them.  Each update function
+ * checks the new value against the current values of the other
+ * thresholds, so the final set is checked first and the changed
+ * thresholds are then applied in whatever order keeps every step valid.
+ * The config is marked for writeback once.
+ *
+ * arguments:
+ *  value - the thresholds, in DEVICE_CONFIG_* order
+ *
+ * returns:
+ *  DEVICE_SET_OK (also if nothing changed), DEVICE_SET_INVALID if the
+ *  set breaks the threshold order, DEVICE_SET_FAILED if an update
+ *  function rejected a value of a valid set
+ *
+ * changes:
+ *  config
+ */
+ unsigned char devapi_set_thresholds(const int *value){
+    unsigned char pending = 0;
+    unsigned char pass;
+    unsigned char i;
+
+    for(i = 0; i < DEVICE_CONFIG_COUNT; i++){
+        if(value[i] != *thresholds[i]){
+            pending |= 1 << i;
+        }
+    }
+    if(!pending){
+        return DEVICE_SET_OK;
+    }
+    if(!thresholds_valid(value)){
+        return DEVICE_SET_INVALID;
+    }
+    for(pass = 0; pending && pass < DEVICE_CONFIG_COUNT; pass++){
+        for(i = 0; i < DEVICE_CONFIG_COUNT; i++){
+            if((pending & (1 << i)) && update[i](value[i])){
+                pending &= ~(1 << i);
+            }
+        }
+    }
+    config_set_modified();
+    return pending ? DEVICE_SET_FAILED : DEVICE_SET_OK;
+ }
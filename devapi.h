@@ -0,0 +1,98 @@
+/********************************************************
+ * devapi.h
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file provides declarations for the device resources shared by
+ * the http and CoAP servers (/device, /device/log and /device/config),
+ * so that both render the same json and apply the same config rules.
+ * The servers parse requests and send their own headers; the json is
+ * written with the socket_write functions (socket.h), which add to the
+ * current datagram on a udp socket.
+ */
+
+#ifndef DEVAPI_H_INCLUDED
+#define DEVAPI_H_INCLUDED
+
+/* members of the device object (GET /device), in the order they are sent
+* - the bit of each field in a fields mask is 1 << DEVICE_FIELD_*
+*/
+#define DEVICE_FIELD_VPD           0
+#define DEVICE_FIELD_TCRIT_HI      1
+#define DEVICE_FIELD_TWARN_HI      2
+#define DEVICE_FIELD_TCRIT_LO      3
+#define DEVICE_FIELD_TWARN_LO      4
+#define DEVICE_FIELD_TEMPERATURE   5
+#define DEVICE_FIELD_STATE         6
+#define DEVICE_FIELD_LOG           7
+#define DEVICE_FIELD_COUNT         8
+#define DEVICE_FIELDS_ALL          0xFF
+#define DEVICE_FIELD_NAME_SIZE     12
+
+/* config parameters (PUT /device/config?<name>=<value>) */
+#define DEVICE_CONFIG_TCRIT_HI     0
+#define DEVICE_CONFIG_TWARN_HI     1
+#define DEVICE_CONFIG_TCRIT_LO     2
+#define DEVICE_CONFIG_TWARN_LO     3
+#define DEVICE_CONFIG_COUNT        4
+#define DEVICE_CONFIG_NAME_SIZE    9
+
+/* results of devapi_set_thresholds() */
+#define DEVICE_SET_OK              0
+#define DEVICE_SET_INVALID         1
+#define DEVICE_SET_FAILED          2
+
+/* field and config parameter names, each row a program memory string */
+extern const char device_fields[DEVICE_FIELD_COUNT][DEVICE_FIELD_NAME_SIZE];
+extern const char device_configs[DEVICE_CONFIG_COUNT][DEVICE_CONFIG_NAME_SIZE];
+
+/**********************************
+ * devapi_find_name()
+ *
+ * Returns the row of a name (len characters, not null terminated) in
+ * device_fields or device_configs, or count if it is not found
+ */
+unsigned char devapi_find_name(const char *table, unsigned char size, unsigned char count,
+                               const char *name, unsigned char len);
+
+/**********************************
+ * devapi_send_device()
+ *
+ * Sends the device object, limited to the selected fields
+ */
+void devapi_send_device(unsigned char socket, unsigned char fields);
+
+/**********************************
+ * devapi_send_log()
+ *
+ * Sends the log records that match an event type (EVENT_UNK for any)
+ * and fall within [from, to], with the record counts
+ */
+void devapi_send_log(unsigned char socket, unsigned char event, unsigned long from, unsigned long to);
+
+/**********************************
+ * devapi_set_config()
+ *
+ * Validates a config parameter through the update_*() rules (util.h)
+ * and marks the config for writeback.  Returns 1 if applied, otherwise 0.
+ */
+unsigned char devapi_set_config(unsigned char param, int value);
+
+/**********************************
+ * devapi_get_thresholds()
+ *
+ * Copies the config thresholds (DEVICE_CONFIG_* order) to value
+ */
+void devapi_get_thresholds(int *value);
+
+/**********************************
+ * devapi_set_thresholds()
+ *
+ * Sets all the config thresholds (DEVICE_CONFIG_* order) or, if the set
+ * is not valid, none of them.  The config is written back once.
+ * Returns DEVICE_SET_OK, DEVICE_SET_INVALID or DEVICE_SET_FAILED.
+ */
+unsigned char devapi_set_thresholds(const int *value);
+
+#endif // DEVAPI_H_INCLUDED
@@ -0,0 +1,78 @@
+/********************************************************
+ * devstate.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file implements the alarm state classification shared by the
+ * http, Modbus and MQTT-SN interfaces.  The critical thresholds are
+ * checked first, so a temperature past both thresholds is critical.
+ *
+ * Functions:
+ *
+ * devstate_classify()
+ *  Returns the alarm state of a temperature
+ *
+ * devstate_name_P()
+ *  Returns the name of an alarm state
+ */
+
+ #include <avr/pgmspace.h>
+ #include "devstate.h"
+ #include "config.h"
+
+ /* state names, indexed by DEVSTATE_* */
+ static const char devstate_names[DEVSTATE_COUNT][DEVSTATE_NAME_MAX + 1] PROGMEM = {
+    "NORMAL", "WARN_HI", "CRIT_HI", "WARN_LO", "CRIT_LO"
+ };
+
+ /**********************************
+ * devstate_classify()
+ *
+ * Classifies a temperature against the configured thresholds
+ *
+ * arguments:
+ *  temp - the temperature
+ *
+ * returns:
+ *  the alarm state (DEVSTATE_*)
+ *
+ * changes:
+ *  none
+ */
+ unsigned char devstate_classify(int temp){
+    if(temp >= config.hi_alarm){
+        return DEVSTATE_CRIT_HI;
+    }
+    if(temp >= config.hi_warn){
+        return DEVSTATE_WARN_HI;
+    }
+    if(temp <= config.lo_alarm){
+        return DEVSTATE_CRIT_LO;
+    }
+    if(temp <= config.lo_warn){
+        return DEVSTATE_WARN_LO;
+    }
+    return DEVSTATE_NORMAL;
+ }
+
+ /**********************************
+ * devstate_name_P()
+ *
+ * Returns the name of an alarm state
+ *
+ * arguments:
+ *  state - the alarm state (DEVSTATE_*)
+ *
+ * returns:
+ *  program memory string with the name ("NORMAL" for an unknown state)
+ *
+ * changes:
+ *  none
+ */
+ const char *devstate_name_P(unsigned char state){
+    if(state >= DEVSTATE_COUNT){
+        state = DEVSTATE_NORMAL;
+    }
+    return devstate_names[state];
+ }
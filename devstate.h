@@ -0,0 +1,42 @@
+/********************************************************
+ * devstate.h
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file provides declarations for the alarm state classification
+ * shared by the http, Modbus and MQTT-SN interfaces, so that all of
+ * them report the same state for a temperature.
+ */
+
+#ifndef DEVSTATE_H_INCLUDED
+#define DEVSTATE_H_INCLUDED
+
+/* alarm states (also the Modbus state register values) */
+#define DEVSTATE_NORMAL     0
+#define DEVSTATE_WARN_HI    1
+#define DEVSTATE_CRIT_HI    2
+#define DEVSTATE_WARN_LO    3
+#define DEVSTATE_CRIT_LO    4
+#define DEVSTATE_COUNT      5
+
+/* longest state name (not counting the null) */
+#define DEVSTATE_NAME_MAX   7
+
+/**********************************
+ * devstate_classify()
+ *
+ * Returns the alarm state (DEVSTATE_*) of a temperature against the
+ * configured thresholds
+ */
+unsigned char devstate_classify(int temp);
+
+/**********************************
+ * devstate_name_P()
+ *
+ * Returns the name of an alarm state ("NORMAL", "CRIT_HI", ...) as a
+ * program memory string
+ */
+const char *devstate_name_P(unsigned char state);
+
+#endif // DEVSTATE_H_INCLUDED
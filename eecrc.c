@@ -0,0 +1,270 @@
+/********************************************************
+ * eecrc.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file implements CRC-16 protection of the vpd and config EEPROM
+ * images.  The library modules still maintain their additive checksum
+ * byte (so images remain readable by older firmware), and a separate crc
+ * record stored after the event log holds a CRC-16 of each image.
+ *
+ * The crc record also holds the additive checksum byte of the image that
+ * each crc describes.  If an image no longer matches its crc but has a
+ * different checksum byte, the image was rewritten after the crc record
+ * (e.g. a watchdog reset before the record was written back) and the crc
+ * is simply recomputed.  If the checksum byte is unchanged, the image has
+ * a corruption that the additive checksum missed.  A corrupt config is
+ * replaced by the defaults.  A corrupt vpd is only reported: it holds the
+ * factory mac address and serial number, which must never be overwritten,
+ * and its crc is left as is so that the error is reported at every boot.
+ *
+ * Functions:
+ *
+ * eecrc_init()
+ *  Verifies (or migrates) the vpd and config images
+ *
+ * eecrc_config_changed()
+ *  Incrementally updates the config crc
+ *
+ * eecrc_update()
+ *  Writes back the crc record if it has been modified
+ *
+ * eecrc_get_config_crc()
+ *  Returns the crc of the in-memory config
+ */
+
+ #include <avr/pgmspace.h>
+ #include "eecrc.h"
+ #include "crc16.h"
+ #include "config.h"
+ #include "vpd.h"
+ #include "eeprom.h"
+ #include "serial.h"
+ #include "ulog.h"
+
+ /* location of the image written by the config library module */
+ #define CONFIG_EEPROM_ADDR 0x0040
+
+ /* the crc covers everything but the trailing additive checksum byte */
+ #define VPD_CRC_SIZE       (sizeof(vpd_struct) - 1)
+ #define CONFIG_CRC_SIZE    (sizeof(config_struct) - 1)
+
+ typedef struct {
+    char          token[4];
+    unsigned int  vpd_crc;
+    unsigned char vpd_checksum;
+    unsigned int  config_crc;
+    unsigned char config_checksum;
+    unsigned int  crc;
+ } eecrc_struct;
+
+ static eecrc_struct eecrc;
+ static unsigned char modified;
+
+ /**********************************
+ * additive_checksum()
+ *
+ * Returns the additive checksum byte for the specified data (the value
+ * that makes the sum of all the bytes zero, see update_checksum())
+ *
+ * arguments:
+ *  data - pointer to the data, not including the checksum byte
+ *  size - number of bytes of data
+ *
+ * returns:
+ *  the checksum byte
+ *
+ * changes:
+ *  none
+ */
+ static unsigned char additive_checksum(const unsigned char *data, unsigned char size){
+    unsigned char sum = 0;
+    while(size--){
+        sum += *data++;
+    }
+    return -sum;
+ }
+
+ /**********************************
+ * record_is_valid()
+ *
+ * Checks the token and crc of the crc record
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  1 if the record is valid, otherwise 0
+ *
+ * changes:
+ *  none
+ */
+ static int record_is_valid(){
+    if(eecrc.token[0] != 'C' || eecrc.token[1] != 'R' || eecrc.token[2] != 'C' || eecrc.token[3] != '1'){
+        return 0;
+    }
+    return crc16((unsigned char*)&eecrc, sizeof(eecrc) - sizeof(eecrc.crc)) == eecrc.crc;
+ }
+
+ /**********************************
+ * baseline_vpd()
+ *
+ * Computes the vpd crc from the in-memory vpd
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  eecrc, modified
+ */
+ static void baseline_vpd(){
+    eecrc.vpd_crc = crc16((unsigned char*)&vpd, VPD_CRC_SIZE);
+    eecrc.vpd_checksum = vpd.checksum;
+    modified = 1;
+ }
+
+ /**********************************
+ * baseline_config()
+ *
+ * Computes the config crc from the in-memory config
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  eecrc, modified
+ */
+ static void baseline_config(){
+    eecrc.config_crc = crc16((unsigned char*)&config, CONFIG_CRC_SIZE);
+    eecrc.config_checksum = config.checksum;
+    modified = 1;
+ }
+
+ /**********************************
+ * eecrc_init()
+ *
+ * Reads the crc record from the eeprom and verifies the vpd and config
+ * images against it.  Images without a crc record (written by older
+ * firmware) are migrated by creating the record.
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  eecrc, modified, and config if defaults had to be restored
+ */
+ void eecrc_init(){
+    while(eeprom_isbusy()){}
+    eeprom_readbuf(EECRC_EEPROM_ADDR, (unsigned char*)&eecrc, sizeof(eecrc));
+
+    if(!record_is_valid()){
+        /* image written by older firmware (or a damaged record) - migrate it */
+        eecrc.token[0] = 'C';
+        eecrc.token[1] = 'R';
+        eecrc.token[2] = 'C';
+        eecrc.token[3] = '1';
+        baseline_vpd();
+        baseline_config();
+        return;
+    }
+
+    if(crc16((unsigned char*)&vpd, VPD_CRC_SIZE) != eecrc.vpd_crc){
+        if(vpd.checksum == eecrc.vpd_checksum){
+            /* keep the factory identity - report the corruption only */
+            ULOG(ULOG_ERROR, serial_writestr_P(PSTR("VPD crc error\r\n")));
+        }
+        else{
+            baseline_vpd();
+        }
+    }
+
+    if(crc16((unsigned char*)&config, CONFIG_CRC_SIZE) != eecrc.config_crc){
+        if(config.checksum == eecrc.config_checksum){
+            ULOG(ULOG_WARN, serial_writestr_P(PSTR("Config crc error - restoring defaults\r\n")));
+            config_write_defaults();
+            while(eeprom_isbusy()){}
+            eeprom_readbuf(CONFIG_EEPROM_ADDR, (unsigned char*)&config, sizeof(config));
+        }
+        baseline_config();
+    }
+ }
+
+ /**********************************
+ * eecrc_config_changed()
+ *
+ * Incrementally updates the config crc after len bytes at the specified
+ * offset within the config structure have changed.  Only the changed
+ * bytes and the bytes that follow them are processed.
+ *
+ * arguments:
+ *  offset - offset of the changed bytes within the config structure
+ *  old_value - the previous value of the changed bytes
+ *  len - number of changed bytes
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  eecrc, modified
+ */
+ void eecrc_config_changed(unsigned char offset, const unsigned char *old_value, unsigned char len){
+    eecrc.config_crc = crc16_adjust(eecrc.config_crc, old_value, (unsigned char*)&config + offset,
+                                    len, CONFIG_CRC_SIZE - offset - len);
+    modified = 1;
+ }
+
+ /**********************************
+ * eecrc_update()
+ *
+ * Writes back the crc record to the eeprom if it has been modified.
+ * The checksum byte stored with the config crc is computed from the
+ * in-memory config, since the library only updates config.checksum
+ * when it writes the config back.
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  eecrc, modified
+ */
+ void eecrc_update(){
+    if(!modified){
+        return;
+    }
+    eecrc.config_checksum = additive_checksum((unsigned char*)&config, CONFIG_CRC_SIZE);
+    eecrc.crc = crc16((unsigned char*)&eecrc, sizeof(eecrc) - sizeof(eecrc.crc));
+    eeprom_writebuf(EECRC_EEPROM_ADDR, (unsigned char*)&eecrc, sizeof(eecrc));
+    modified = 0;
+ }
+
+ /**********************************
+ * eecrc_get_config_crc()
+ *
+ * Returns the crc of the in-memory config (kept up to date by
+ * eecrc_config_changed()), which identifies the applied config
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  the crc
+ *
+ * changes:
+ *  none
+ */
+ unsigned int eecrc_get_config_crc(){
+    return eecrc.config_crc;
+ }
@@ -0,0 +1,51 @@
+/********************************************************
+ * eecrc.h
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file provides declarations for the CRC-16 protection
+ * of the vpd and config EEPROM images.
+ */
+
+#ifndef EECRC_H_INCLUDED
+#define EECRC_H_INCLUDED
+
+/* location of the crc record in the eeprom (after the event log) */
+#define EECRC_EEPROM_ADDR 0x0100
+
+/**********************************
+ * eecrc_init()
+ *
+ * Reads the crc record from the eeprom and verifies the vpd and config
+ * images against it.  Images without a crc record (written by older
+ * firmware) are migrated by creating the record.  A corrupt config is
+ * replaced by the defaults; a corrupt vpd is logged but left unchanged.
+ * Must be called after vpd_init(), config_init() and rtc_init().
+ */
+void eecrc_init();
+
+/**********************************
+ * eecrc_config_changed()
+ *
+ * Incrementally updates the config crc after len bytes at the specified
+ * offset within the config structure have changed from old_value
+ */
+void eecrc_config_changed(unsigned char offset, const unsigned char *old_value, unsigned char len);
+
+/**********************************
+ * eecrc_update()
+ *
+ * Writes back the crc record to the eeprom if it has been modified.
+ * Call only when the eeprom is not busy.
+ */
+void eecrc_update();
+
+/**********************************
+ * eecrc_get_config_crc()
+ *
+ * Returns the crc of the in-memory config
+ */
+unsigned int eecrc_get_config_crc();
+
+#endif // EECRC_H_INCLUDED
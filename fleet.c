@@ -0,0 +1,588 @@
+/********************************************************
+ * fleet.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file implements the device side of the fleet protocol.  Requests
+ * from the master are not answered right away: the reply is scheduled
+ * at a delay within the window given by the master and sent by
+ * fleet_update(), so hundreds of devices answering one broadcast do
+ * not overrun the receive buffer of the master.  The delay is the crc
+ * of the mac address and the sequence number, which differs between
+ * devices and between requests.  A request received while a reply is
+ * pending replaces it.
+ *
+ * A config message is applied as soon as it is received, if it is
+ * intact and addressed to this device.  Its thresholds are set together
+ * through the update rules and the config is written back once.
+ *
+ * A sync beacon updates the offset of the fleet clock from clock_ms() and
+ * moves the release of the sample task so that it falls on a multiple
+ * of the sample period in fleet time.  The offset is kept in 1/16 ms so
+ * that a beacon moves it by a quarter of its error without rounding the
+ * correction away.
+ *
+ * The whole file is compiled out unless FLEET_ENABLE is 1.
+ *
+ * Functions:
+ *
+ * fleet_receive()
+ *  Handles a datagram received from the master
+ *
+ * fleet_sync_init()
+ *  Selects the task aligned to the fleet clock
+ *
+ * fleet_mark_sample()
+ *  Records the alignment error of a sample
+ *
+ * fleet_update()
+ *  Sends a pending reply once its delay has passed
+ *
+ * get16()
+ *  Reads a big endian 16-bit value
+ *
+ * put16()
+ *  Writes a big endian 16-bit value
+ *
+ * get32()
+ *  Reads a big endian 32-bit value
+ *
+ * put_string()
+ *  Adds a length prefixed string to a message
+ *
+ * compare_string()
+ *  Compares a string with a length prefixed string of a message
+ *
+ * is_target()
+ *  Checks whether a config message is addressed to this device
+ *
+ * apply_config()
+ *  Applies a config message
+ *
+ * send_device()
+ *  Sends the discovery reply
+ *
+ * send_config_ack()
+ *  Sends the config acknowledgement
+ *
+ * phase_error()
+ *  Returns the distance of a time from the sample grid of the fleet clock
+ *
+ * handle_sync()
+ *  Updates the fleet clock offset and the sample task phase from a beacon
+ */
+
+ #include <string.h>
+ #include "fleet.h"
+ #include "udpmux.h"
+ #include "devapi.h"
+ #include "devstate.h"
+ #include "netboot.h"
+ #include "vpd.h"
+ #include "eecrc.h"
+ #include "clock.h"
+ #include "crc16.h"
+ #include "sched.h"
+
+ #if FLEET_ENABLE
+
+ #define HEADER_SIZE         4
+
+ /* offset of the model in a discovery record (fleet.h) */
+ #define DEVICE_STRINGS      17
+
+ /* largest reply - the discovery record with both strings at their longest:
+ * the fixed fields, a length byte and the characters of each string, and
+ * the 2 byte sample alignment error
+ */
+ #define REPLY_SIZE          (DEVICE_STRINGS + 1 + sizeof(vpd.model) + 1 + sizeof(vpd.serial_number) + 2)
+
+ /* offsets in a config message */
+ #define CONFIG_TARGET       6
+ #define CONFIG_MASK         7
+ #define CONFIG_VALUES       8
+ #define CONFIG_TARGET_DATA  (CONFIG_VALUES + 2 * DEVICE_CONFIG_COUNT)
+
+ /* length of a sync beacon, and the fraction of a ms the offset is kept in */
+ #define SYNC_SIZE           (HEADER_SIZE + 4)
+ #define SYNC_FRACTION       16
+
+ /* no task synchronized */
+ #define SYNC_NO_TASK        0xFF
+
+ extern int current_temperature;
+
+ /* pending reply (FLEET_MSG_DEVICE or FLEET_MSG_CONFIG_ACK, 0 if none) */
+ static unsigned char reply_type;
+ static unsigned int reply_seq;
+ static unsigned char reply_addr[4];
+ static unsigned long reply_due;
+ static unsigned char config_result;
+
+ /* fleet clock = clock_ms() + sync_offset + sync_residual / SYNC_FRACTION */
+ static unsigned char sync_task = SYNC_NO_TASK;
+ static unsigned int sync_period;
+ static unsigned char synced;
+ static long sync_offset;
+ static int sync_residual;
+
+ fleet_sync_stats_struct fleet_sync_stats = {0, 0, 0, FLEET_NOT_SYNCED};
+
+ /**********************************
+ * get16()
+ *
+ * Reads a big endian 16-bit value
+ *
+ * arguments:
+ *  p - the first byte
+ *
+ * returns:
+ *  the value
+ *
+ * changes:
+ *  none
+ */
+ static unsigned int get16(const unsigned char *p){
+    return ((unsigned int)p[0] << 8) | p[1];
+ }
+
+ /**********************************
+ * put16()
+ *
+ * Writes a big endian 16-bit value
+ *
+ * arguments:
+ *  p - the first byte
+ *  value - the value
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the 2 bytes at p
+ */
+ static void put16(unsigned char *p, unsigned int value){
+    p[0] = value >> 8;
+    p[1] = value;
+ }
+
+ /**********************************
+ * get32()
+ *
+ * Reads a big endian 32-bit value
+ *
+ * arguments:
+ *  p - the first byte
+ *
+ * returns:
+ *  the value
+ *
+ * changes:
+ *  none
+ */
+ static unsigned long get32(const unsigned char *p){
+    return ((unsigned long)get16(p) << 16) | get16(p + 2);
+ }
+
+ /**********************************
+ * put_string()
+ *
+ * Adds a string to a message as a length byte followed by the characters
+ * (without the terminating null)
+ *
+ * arguments:
+ *  msg - where the string is placed
+ *  str - the string
+ *  size - size of the array holding the string
+ *
+ * returns:
+ *  the number of bytes added
+ *
+ * changes:
+ *  msg
+ */
+ static unsigned char put_string(unsigned char *msg, const char *str, unsigned char size){
+    unsigned char n;
+
+    for(n = 0; n < size && str[n] != 0; n++){
+        msg[n + 1] = str[n];
+    }
+    msg[0] = n;
+    return n + 1;
+ }
+
+ /**********************************
+ * compare_string()
+ *
+ * Compares a string with a length prefixed string of a message, as
+ * strcmp() would
+ *
+ * arguments:
+ *  str - the string
+ *  size - size of the array holding the string
+ *  data - the length prefixed string
+ *
+ * returns:
+ *  less than, equal to or greater than 0 if str is less than, equal to
+ *  or greater than the string of the message
+ *
+ * changes:
+ *  none
+ */
+ static int compare_string(const char *str, unsigned char size, const unsigned char *data){
+    unsigned char i;
+    unsigned char c;
+
+    for(i = 0; i < data[0]; i++){
+        c = (i < size) ? str[i] : 0;
+        if(c != data[i + 1]){
+            return (int)c - data[i + 1];
+        }
+    }
+    return (i < size && str[i] != 0) ? 1 : 0;
+ }
+
+ /**********************************
+ * is_target()
+ *
+ * Checks whether a config message is addressed to this device: to all
+ * devices, to its model, or to a range of serial numbers that includes
+ * its own
+ *
+ * arguments:
+ *  msg - the config message
+ *  len - its length without the crc
+ *
+ * returns:
+ *  1 if addressed to this device, 0 if not or if the target is malformed
+ *
+ * changes:
+ *  none
+ */
+ static unsigned char is_target(const unsigned char *msg, unsigned int len){
+    const unsigned char *first = msg + CONFIG_TARGET_DATA;
+    unsigned int end;
+
+    if(msg[CONFIG_TARGET] == FLEET_TARGET_ALL){
+        return 1;
+    }
+    /* end of the first string */
+    if(len <= CONFIG_TARGET_DATA || (end = CONFIG_TARGET_DATA + 1 + first[0]) > len){
+        return 0;
+    }
+    switch(msg[CONFIG_TARGET]){
+    case FLEET_TARGET_MODEL:
+        return compare_string(vpd.model, sizeof(vpd.model), first) == 0;
+    case FLEET_TARGET_SERIAL:
+        if(end >= len || end + 1 + msg[end] > len){
+            return 0;
+        }
+        return compare_string(vpd.serial_number, sizeof(vpd.serial_number), first) >= 0 &&
+               compare_string(vpd.serial_number, sizeof(vpd.serial_number), msg + end) <= 0;
+    default:
+        return 0;
+    }
+ }
+
+ /**********************************
+ * apply_config()
+ *
+ * Applies the thresholds of a config message that is intact and
+ * addressed to this device.  Thresholds that are not selected by the
+ * mask keep their current values.
+ *
+ * arguments:
+ *  msg - the config message
+ *  len - its length
+ *
+ * returns:
+ *  1 if the message is for this device (the result is in
+ *  config_result), otherwise 0
+ *
+ * changes:
+ *  config_result, config
+ */
+ static unsigned char apply_config(const unsigned char *msg, unsigned int len){
+    int value[DEVICE_CONFIG_COUNT];
+    unsigned char i;
+
+    if(len < CONFIG_TARGET_DATA + 2){
+        return 0;
+    }
+    len -= 2;
+    if(crc16(msg, len) != get16(msg + len) || !is_target(msg, len)){
+        return 0;
+    }
+    devapi_get_thresholds(value);
+    for(i = 0; i < DEVICE_CONFIG_COUNT; i++){
+        if(msg[CONFIG_MASK] & (1 << i)){
+            value[i] = (short)get16(msg + CONFIG_VALUES + 2 * i);
+        }
+    }
+    config_result = devapi_set_thresholds(value);
+    return 1;
+ }
+
+ /**********************************
+ * send_device()
+ *
+ * Sends the discovery reply to the master
+ *
+ * arguments:
+ *  msg - the reply (the header is filled in)
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  msg
+ */
+ static void send_device(unsigned char *msg){
+    unsigned char len;
+
+    memcpy(msg + 4, vpd.mac_address, 6);
+    memcpy(msg + 10, netboot_get_ip(), 4);
+    msg[14] = devstate_classify(current_temperature);
+    put16(msg + 15, FLEET_FIRMWARE_VERSION);
+    len = DEVICE_STRINGS;
+    len += put_string(msg + len, vpd.model, sizeof(vpd.model));
+    len += put_string(msg + len, vpd.serial_number, sizeof(vpd.serial_number));
+    put16(msg + len, fleet_sync_stats.sample_error);
+    len += 2;
+    udpmux_sendto(msg, len, reply_addr, FLEET_MASTER_PORT);
+ }
+
+ /**********************************
+ * send_config_ack()
+ *
+ * Sends the config acknowledgement to the master, with the result, the
+ * config crc and the thresholds in effect
+ *
+ * arguments:
+ *  msg - the reply (the header is filled in)
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  msg
+ */
+ static void send_config_ack(unsigned char *msg){
+    int value[DEVICE_CONFIG_COUNT];
+    unsigned char i;
+
+    memcpy(msg + 4, vpd.mac_address, 6);
+    msg[10] = config_result;
+    put16(msg + 11, eecrc_get_config_crc());
+    devapi_get_thresholds(value);
+    for(i = 0; i < DEVICE_CONFIG_COUNT; i++){
+        put16(msg + 13 + 2 * i, value[i]);
+    }
+    udpmux_sendto(msg, 13 + 2 * DEVICE_CONFIG_COUNT, reply_addr, FLEET_MASTER_PORT);
+ }
+
+ /**********************************
+ * phase_error()
+ *
+ * Returns how far a time is from the nearest multiple of the sample
+ * period in fleet time
+ *
+ * arguments:
+ *  t - the time (clock_ms())
+ *
+ * returns:
+ *  the error in ms, from -period / 2 (early) to period / 2 (late)
+ *
+ * changes:
+ *  none
+ */
+ static int phase_error(unsigned long t){
+    unsigned int phase = (t + sync_offset) % sync_period;
+
+    return (phase >= (sync_period + 1) / 2) ? (int)phase - (int)sync_period : (int)phase;
+ }
+
+ /**********************************
+ * handle_sync()
+ *
+ * Updates the fleet clock offset from a sync beacon (stepping it on the
+ * first beacon or a large error, otherwise moving it by a fraction of
+ * the error) and moves the next release of the synchronized task onto
+ * the sample grid of the fleet clock
+ *
+ * arguments:
+ *  msg - the beacon
+ *  len - its length
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  sync_offset, sync_residual, synced, fleet_sync_stats, the release of
+ *  the synchronized task
+ */
+ static void handle_sync(const unsigned char *msg, unsigned int len){
+    long error;
+    int shift;
+
+    if(len < SYNC_SIZE){
+        return;
+    }
+    error = (long)(get32(msg + HEADER_SIZE) - clock_ms()) - sync_offset;
+    fleet_sync_stats.beacons++;
+    if(!synced || error > FLEET_SYNC_STEP_MS || error < -FLEET_SYNC_STEP_MS){
+        fleet_sync_stats.beacon_error = synced ? error : 0;
+        fleet_sync_stats.steps++;
+        sync_offset += error;
+        sync_residual = 0;
+        synced = 1;
+    }
+    else{
+        fleet_sync_stats.beacon_error = error;
+        sync_residual += (int)error * (SYNC_FRACTION >> FLEET_SYNC_GAIN_SHIFT);
+        sync_offset += sync_residual / SYNC_FRACTION;
+        sync_residual %= SYNC_FRACTION;
+    }
+
+    if(sync_task != SYNC_NO_TASK){
+        shift = phase_error(sched_get_task(sync_task)->release);
+        if(shift != 0){
+            sched_shift_release(sync_task, -shift);
+        }
+    }
+ }
+
+ /**********************************
+ * fleet_receive()
+ *
+ * Handles a datagram received from the master.  A discovery query, or a
+ * config message for this device (which is applied now), schedules the
+ * reply at a delay within the reply window.  A sync beacon is handled
+ * now and not answered.  Other messages are dropped.
+ *
+ * arguments:
+ *  msg - the received datagram
+ *  len - its length
+ *  addr - the master
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  reply_type, reply_seq, reply_addr, reply_due, config_result, config,
+ *  the fleet clock offset
+ */
+ void fleet_receive(const unsigned char *msg, unsigned int len, const unsigned char *addr){
+    unsigned char key[8];
+    unsigned int window;
+
+    if(len < HEADER_SIZE + 2 || msg[0] != FLEET_MAGIC){
+        return;
+    }
+    switch(msg[1]){
+    case FLEET_MSG_DISCOVER:
+        reply_type = FLEET_MSG_DEVICE;
+        break;
+    case FLEET_MSG_CONFIG:
+        if(!apply_config(msg, len)){
+            return;
+        }
+        reply_type = FLEET_MSG_CONFIG_ACK;
+        break;
+    case FLEET_MSG_SYNC:
+        handle_sync(msg, len);
+        return;
+    default:
+        return;
+    }
+
+    window = get16(msg + 4);
+    if(window == 0){
+        window = FLEET_DEFAULT_WINDOW_MS;
+    }
+    else if(window > FLEET_MAX_WINDOW_MS){
+        window = FLEET_MAX_WINDOW_MS;
+    }
+    reply_seq = get16(msg + 2);
+    memcpy(reply_addr, addr, 4);
+    memcpy(key, vpd.mac_address, 6);
+    key[6] = msg[2];
+    key[7] = msg[3];
+    reply_due = clock_ms() + crc16(key, sizeof(key)) % window;
+ }
+
+ /**********************************
+ * fleet_sync_init()
+ *
+ * Selects the periodic task whose releases are aligned to the fleet
+ * clock by the sync beacons
+ *
+ * arguments:
+ *  task - the task id (sched_add())
+ *  period_ms - its period
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  sync_task, sync_period
+ */
+ void fleet_sync_init(unsigned char task, unsigned int period_ms){
+    sync_period = period_ms;
+    sync_task = period_ms ? task : SYNC_NO_TASK;
+ }
+
+ /**********************************
+ * fleet_mark_sample()
+ *
+ * Records the alignment error of a sample taken now
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  fleet_sync_stats
+ */
+ void fleet_mark_sample(){
+    if(synced && sync_period){
+        fleet_sync_stats.sample_error = phase_error(clock_ms());
+    }
+ }
+
+ /**********************************
+ * fleet_update()
+ *
+ * Sends the pending reply once its delay has passed
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  reply_type
+ */
+ void fleet_update(){
+    unsigned char msg[REPLY_SIZE];
+
+    if(reply_type == 0 || (long)(clock_ms() - reply_due) < 0){
+        return;
+    }
+    msg[0] = FLEET_MAGIC;
+    msg[1] = reply_type;
+    put16(msg + 2, reply_seq);
+    if(reply_type == FLEET_MSG_DEVICE){
+        send_device(msg);
+    }
+    else{
+        send_config_ack(msg);
+    }
+    reply_type = 0;
+ }
+
+ #endif // FLEET_ENABLE
@@ -0,0 +1,174 @@
+/********************************************************
+ * fleet.h
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file provides declarations for the fleet protocol, which lets the
+ * master controller reach every device on a site with one datagram
+ * instead of a connection per device.  The master sends from
+ * FLEET_MASTER_PORT to the subnet broadcast address on the port of the
+ * shared udp socket (udpmux.h) - the other three W5100 sockets are taken
+ * by http, dhcp (and the alarms) and Modbus, and a udp socket receives
+ * broadcasts without joining a multicast group.
+ *
+ * Every message starts with:
+ *
+ *  0      FLEET_MAGIC
+ *  1      message type (FLEET_MSG_*)
+ *  2-3    sequence number (chosen by the master, echoed in replies)
+ *
+ * FLEET_MSG_DISCOVER (master to devices):
+ *
+ *  4-5    reply window (ms, 0 for FLEET_DEFAULT_WINDOW_MS)
+ *
+ * FLEET_MSG_DEVICE (device to master, unicast):
+ *
+ *  4-9    mac address
+ *  10-13  ip address
+ *  14     alarm state (DEVSTATE_*, devstate.h)
+ *  15-16  firmware version (FLEET_FIRMWARE_VERSION)
+ *  17     model length n, followed by the model
+ *  18+n   serial number length m, followed by the serial number
+ *  19+n+m sample alignment error (signed ms, FLEET_NOT_SYNCED if no
+ *         beacon has been received)
+ *
+ * FLEET_MSG_CONFIG (master to devices, broadcast or unicast):
+ *
+ *  4-5    reply window (ms, 0 for FLEET_DEFAULT_WINDOW_MS)
+ *  6      target (FLEET_TARGET_*)
+ *  7      thresholds to set (bit 1 << DEVICE_CONFIG_*, devapi.h)
+ *  8-15   tcrit_hi, twarn_hi, tcrit_lo, twarn_lo (signed)
+ *  16     FLEET_TARGET_MODEL: model length n, followed by the model
+ *         FLEET_TARGET_SERIAL: first and last serial number of the
+ *         range, each a length followed by the characters
+ *  last 2 crc16 of all the bytes before it
+ *
+ * FLEET_MSG_CONFIG_ACK (device to master, unicast):
+ *
+ *  4-9    mac address
+ *  10     result (DEVICE_SET_*, devapi.h)
+ *  11-12  crc of the config (eecrc.h) after the change
+ *  13-20  the resulting tcrit_hi, twarn_hi, tcrit_lo, twarn_lo
+ *
+ * FLEET_MSG_SYNC (master to devices, broadcast, not answered):
+ *
+ *  4-7    fleet clock (ms, kept by the master)
+ *
+ * Multi-byte fields are big endian.  Each device delays its reply by a
+ * pseudo random time within the window (derived from its mac address
+ * and the sequence number), so that the replies of a large fleet are
+ * spread out instead of arriving at the master at once.
+ *
+ * The thresholds of a config message are validated and applied together
+ * (devapi_set_thresholds()), so applying a message again changes nothing
+ * and returns the same result.  The master therefore retries by sending
+ * the same message to the devices that did not acknowledge it (unicast,
+ * to the addresses found by discovery).  The crc only protects against
+ * corruption - the message is not authenticated.
+ *
+ * Sync beacons align the sampling of the fleet: each device keeps the
+ * offset of the fleet clock from clock_ms() (filtered over
+ * the beacons, stepped when it is off by more than FLEET_SYNC_STEP_MS)
+ * and shifts its sample task so that samples are taken when the fleet
+ * clock is a multiple of the sample period.  The arrival time of a
+ * beacon is only known to within the udp poll period, and the network
+ * delay is not measured - both are about the same on every device of a
+ * site, so they delay the whole fleet instead of misaligning it.
+ *
+ * The protocol takes about 2K of flash, so it is only built when
+ * FLEET_ENABLE is defined as 1 - the samples are then not aligned.
+ */
+
+#ifndef FLEET_H_INCLUDED
+#define FLEET_H_INCLUDED
+
+#ifndef FLEET_ENABLE
+#define FLEET_ENABLE 0
+#endif
+
+/* port the master sends from */
+#define FLEET_MASTER_PORT       5690
+
+#define FLEET_MAGIC             0xF5
+
+/* message types */
+#define FLEET_MSG_DISCOVER      1
+#define FLEET_MSG_DEVICE        2
+#define FLEET_MSG_CONFIG        3
+#define FLEET_MSG_CONFIG_ACK    4
+#define FLEET_MSG_SYNC          5
+
+/* targets of a config message */
+#define FLEET_TARGET_ALL        0
+#define FLEET_TARGET_MODEL      1
+#define FLEET_TARGET_SERIAL     2
+
+/* firmware version in discovery replies (major << 8 | minor) */
+#define FLEET_FIRMWARE_VERSION  0x0100
+
+/* reply window used when the query does not give one, and the largest
+* window accepted
+*/
+#define FLEET_DEFAULT_WINDOW_MS 500
+#define FLEET_MAX_WINDOW_MS     10000
+
+/* a beacon this far (ms) from the filtered offset steps the offset
+* instead of being filtered in (first beacon, master restarted)
+*/
+#define FLEET_SYNC_STEP_MS      100
+
+/* weight of a beacon in the filtered offset (1 / 2^shift) */
+#define FLEET_SYNC_GAIN_SHIFT   2
+
+/* sample alignment error reported before the first beacon */
+#define FLEET_NOT_SYNCED        0x7FFF
+
+#if FLEET_ENABLE
+
+typedef struct {
+    unsigned int  beacons;      /* number of sync beacons received */
+    unsigned int  steps;        /* number of times the offset was stepped */
+    int           beacon_error; /* last beacon minus the filtered offset (ms) */
+    int           sample_error; /* fleet clock phase of the last sample (ms) */
+} fleet_sync_stats_struct;
+
+/* statistics of the sample synchronization */
+extern fleet_sync_stats_struct fleet_sync_stats;
+
+/**********************************
+ * fleet_receive()
+ *
+ * Handles a datagram received from FLEET_MASTER_PORT (called by
+ * udpmux_update())
+ */
+void fleet_receive(const unsigned char *msg, unsigned int len, const unsigned char *addr);
+
+/**********************************
+ * fleet_sync_init()
+ *
+ * Selects the periodic task whose releases are aligned to the fleet
+ * clock by the sync beacons, and its period (ms)
+ */
+void fleet_sync_init(unsigned char task, unsigned int period_ms);
+
+/**********************************
+ * fleet_mark_sample()
+ *
+ * Records the alignment error of a sample taken now.  Call from the
+ * synchronized task.
+ */
+void fleet_mark_sample();
+
+/**********************************
+ * fleet_update()
+ *
+ * Sends a pending reply (discovery record or config acknowledgement)
+ * once its delay has passed.  Call from the main loop every few ms -
+ * the delays are only as precise as the calls.
+ */
+void fleet_update();
+
+#endif // FLEET_ENABLE
+
+#endif // FLEET_H_INCLUDED
@@ -0,0 +1,288 @@
+/********************************************************
+ * fmt.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file implements the formatting functions declared in fmt.h.
+ * The ATmega328 has no divide instruction, so dividing a 32-bit value
+ * by 10 is a library call of several hundred cycles - per digit.
+ * Here values below 65536 are split into digit pairs by a reciprocal
+ * multiply (n / 100 == ((n >> 2) * 5243) >> 17 for every 16-bit n)
+ * and each pair is looked up in a 200 byte table in flash.  Larger
+ * values are first split into 4 digit groups by dividing by 10000.
+ *
+ * Functions:
+ *
+ * fmt_u16()
+ *  Formats an unsigned 16-bit value as decimal text
+ *
+ * fmt_u32()
+ *  Formats an unsigned 32-bit value as decimal text
+ *
+ * fmt_s32()
+ *  Formats a signed 32-bit value as decimal text
+ *
+ * fmt_hex8()
+ *  Formats an 8-bit value as hexadecimal text
+ *
+ * fmt_hex16()
+ *  Formats a 16-bit value as hexadecimal text
+ *
+ * fmt_ip()
+ *  Formats an ip address as dotted decimal text
+ *
+ * fmt_mac()
+ *  Formats a mac address as colon separated hexadecimal text
+ *
+ * put_digits()
+ *  Writes a fixed number of decimal digits
+ */
+
+ #include <avr/pgmspace.h>
+ #include "fmt.h"
+
+ /* "00" to "99" */
+ static const char digit_pairs[200] PROGMEM =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+ static const char hex_digits[16] PROGMEM = "0123456789ABCDEF";
+
+ /**********************************
+ * put_digits()
+ *
+ * Writes the last digits decimal digits of n (with leading zeros) so
+ * that they end just before end
+ *
+ * arguments:
+ *  end - the position after the last digit
+ *  n - the value
+ *  digits - number of digits to write
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the buffer
+ */
+ static void put_digits(char *end, unsigned int n, unsigned char digits){
+    unsigned int q;
+    unsigned char r;
+
+    while(digits >= 2){
+        q = ((unsigned long)(n >> 2) * 5243) >> 17;
+        r = n - q * 100;
+        end -= 2;
+        end[0] = pgm_read_byte(&digit_pairs[2 * r]);
+        end[1] = pgm_read_byte(&digit_pairs[2 * r + 1]);
+        n = q;
+        digits -= 2;
+    }
+    if(digits){
+        end[-1] = '0' + n;
+    }
+ }
+
+ /**********************************
+ * fmt_u16()
+ *
+ * Formats an unsigned 16-bit value as decimal text
+ *
+ * arguments:
+ *  buf - the buffer (at least FMT_U16_SIZE)
+ *  n - the value
+ *
+ * returns:
+ *  the number of characters
+ *
+ * changes:
+ *  the buffer
+ */
+ unsigned char fmt_u16(char *buf, unsigned int n){
+    unsigned char len;
+
+    if(n >= 10000){
+        len = 5;
+    }
+    else if(n >= 1000){
+        len = 4;
+    }
+    else if(n >= 100){
+        len = 3;
+    }
+    else if(n >= 10){
+        len = 2;
+    }
+    else{
+        len = 1;
+    }
+    put_digits(buf + len, n, len);
+    buf[len] = 0;
+    return len;
+ }
+
+ /**********************************
+ * fmt_u32()
+ *
+ * Formats an unsigned 32-bit value as decimal text.  Values above 65535
+ * are split into groups of 4 digits.
+ *
+ * arguments:
+ *  buf - the buffer (at least FMT_U32_SIZE)
+ *  n - the value
+ *
+ * returns:
+ *  the number of characters
+ *
+ * changes:
+ *  the buffer
+ */
+ unsigned char fmt_u32(char *buf, unsigned long n){
+    unsigned long hi;
+    unsigned int top;
+    unsigned char len;
+
+    if(n <= 0xFFFF){
+        return fmt_u16(buf, n);
+    }
+    hi = n / 10000;
+    if(hi <= 0xFFFF){
+        len = fmt_u16(buf, hi);
+    }
+    else{
+        top = hi / 10000;
+        len = fmt_u16(buf, top);
+        put_digits(buf + len + 4, hi - top * 10000UL, 4);
+        len += 4;
+    }
+    put_digits(buf + len + 4, n - hi * 10000UL, 4);
+    len += 4;
+    buf[len] = 0;
+    return len;
+ }
+
+ /**********************************
+ * fmt_s32()
+ *
+ * Formats a signed 32-bit value as decimal text
+ *
+ * arguments:
+ *  buf - the buffer (at least FMT_S32_SIZE)
+ *  n - the value
+ *
+ * returns:
+ *  the number of characters
+ *
+ * changes:
+ *  the buffer
+ */
+ unsigned char fmt_s32(char *buf, long n){
+    if(n < 0){
+        buf[0] = '-';
+        return 1 + fmt_u32(buf + 1, -(unsigned long)n);
+    }
+    return fmt_u32(buf, n);
+ }
+
+ /**********************************
+ * fmt_hex8()
+ *
+ * Formats an 8-bit value as two uppercase hexadecimal digits
+ *
+ * arguments:
+ *  buf - the buffer (at least FMT_HEX8_SIZE)
+ *  x - the value
+ *
+ * returns:
+ *  the number of characters (2)
+ *
+ * changes:
+ *  the buffer
+ */
+ unsigned char fmt_hex8(char *buf, unsigned char x){
+    buf[0] = pgm_read_byte(&hex_digits[x >> 4]);
+    buf[1] = pgm_read_byte(&hex_digits[x & 0x0F]);
+    buf[2] = 0;
+    return 2;
+ }
+
+ /**********************************
+ * fmt_hex16()
+ *
+ * Formats a 16-bit value as four uppercase hexadecimal digits
+ *
+ * arguments:
+ *  buf - the buffer (at least FMT_HEX16_SIZE)
+ *  x - the value
+ *
+ * returns:
+ *  the number of characters (4)
+ *
+ * changes:
+ *  the buffer
+ */
+ unsigned char fmt_hex16(char *buf, unsigned int x){
+    fmt_hex8(buf, x >> 8);
+    return 2 + fmt_hex8(buf + 2, x & 0xFF);
+ }
+
+ /**********************************
+ * fmt_ip()
+ *
+ * Formats an ip address as dotted decimal text (e.g. 192.168.1.10)
+ *
+ * arguments:
+ *  buf - the buffer (at least FMT_IP_SIZE)
+ *  ip - the 4 bytes of the address
+ *
+ * returns:
+ *  the number of characters
+ *
+ * changes:
+ *  the buffer
+ */
+ unsigned char fmt_ip(char *buf, const unsigned char *ip){
+    unsigned char len = 0;
+    unsigned char i;
+
+    for(i = 0; i < 4; i++){
+        if(i != 0){
+            buf[len++] = '.';
+        }
+        len += fmt_u16(buf + len, ip[i]);
+    }
+    return len;
+ }
+
+ /**********************************
+ * fmt_mac()
+ *
+ * Formats a mac address as six colon separated uppercase hexadecimal
+ * bytes (e.g. 00:16:36:DE:58:F6)
+ *
+ * arguments:
+ *  buf - the buffer (at least FMT_MAC_SIZE)
+ *  mac - the 6 bytes of the address
+ *
+ * returns:
+ *  the number of characters (17)
+ *
+ * changes:
+ *  the buffer
+ */
+ unsigned char fmt_mac(char *buf, const unsigned char *mac){
+    unsigned char len = 0;
+    unsigned char i;
+
+    for(i = 0; i < 6; i++){
+        if(i != 0){
+            buf[len++] = ':';
+        }
+        len += fmt_hex8(buf + len, mac[i]);
+    }
+    return len;
+ }
@@ -0,0 +1,77 @@
+/********************************************************
+ * fmt.h
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file provides declarations for the integer to text
+ * formatting used by the socket and uart writers.  Each function
+ * writes into a caller buffer of at least the listed size, null
+ * terminates it and returns the number of characters (not counting
+ * the null).  Decimal values of up to 16 bits are formatted without
+ * any division; larger values take one or two 32-bit divisions.
+ */
+
+#ifndef FMT_H_INCLUDED
+#define FMT_H_INCLUDED
+
+/* buffer sizes (including the terminating null) */
+#define FMT_U16_SIZE        6   /* 65535 */
+#define FMT_U32_SIZE        11  /* 4294967295 */
+#define FMT_S32_SIZE        12  /* -2147483648 */
+#define FMT_HEX8_SIZE       3   /* FF */
+#define FMT_HEX16_SIZE      5   /* FFFF */
+#define FMT_IP_SIZE         16  /* 255.255.255.255 */
+#define FMT_MAC_SIZE        18  /* FF:FF:FF:FF:FF:FF */
+
+/**********************************
+ * fmt_u16()
+ *
+ * Formats an unsigned 16-bit value as decimal text
+ */
+unsigned char fmt_u16(char *buf, unsigned int n);
+
+/**********************************
+ * fmt_u32()
+ *
+ * Formats an unsigned 32-bit value as decimal text
+ */
+unsigned char fmt_u32(char *buf, unsigned long n);
+
+/**********************************
+ * fmt_s32()
+ *
+ * Formats a signed 32-bit value as decimal text (with a leading '-'
+ * if negative)
+ */
+unsigned char fmt_s32(char *buf, long n);
+
+/**********************************
+ * fmt_hex8()
+ *
+ * Formats an 8-bit value as two uppercase hexadecimal digits
+ */
+unsigned char fmt_hex8(char *buf, unsigned char x);
+
+/**********************************
+ * fmt_hex16()
+ *
+ * Formats a 16-bit value as four uppercase hexadecimal digits
+ */
+unsigned char fmt_hex16(char *buf, unsigned int x);
+
+/**********************************
+ * fmt_ip()
+ *
+ * Formats an ip address as dotted decimal text
+ */
+unsigned char fmt_ip(char *buf, const unsigned char *ip);
+
+/**********************************
+ * fmt_mac()
+ *
+ * Formats a mac address as six colon separated hexadecimal bytes
+ */
+unsigned char fmt_mac(char *buf, const unsigned char *mac);
+
+#endif // FMT_H_INCLUDED
@@ -16,43 +16,87 @@
  *  This function is the finite state machine and will loop until all actions
  *  are completed. This includes returning an error message and exiting.
  *
- * send_json_device_info()
- *  Prepares and sends a json string which represents a
- *  status summary of the device
+ * parse_device_fields()
+ *  Parses the fields= query of a GET /device request
  *
  * create_error_response()
  *  Prepares and sends a 400 error response containing
  *  containing a description provided in the parameter
  *
- * get_state()
- *  Retreives temp info and uses it to calculate and return alarm state
+ * send_json_header()
+ *  Sends the status line and headers of a json response
  *
  * apply_config_changes()
  *  Applies config changes received via PUT req
  *
- * clear_junk()
- *  removes the specified number of characters (up to 254) from the receive buffer
- *  or stop early if the abort character is encountered
+ * send_json_log_query()
+ *  Parses the query of a GET /device/log request and sends the
+ *  matching log records (devapi.c) as a json string
+ *
+ * send_json_time_info()
+ *  Sends the current time and network time synchronization
+ *  statistics as a json string
+ *
+ * send_json_task_info()
+ *  Sends the scheduler statistics of every task as a json string
+ *
+ * send_json_latency_info()
+ *  Sends the main loop latency histograms as a json string
+ *
+ * send_json_crash_info()
+ *  Sends the crash record of the last watchdog reset as a json string
+ *
+ * send_json_socket_info()
+ *  Sends the buffer sizes and transmit buffer diagnostics of every
+ *  W5100 socket as a json string
+ *
+ * send_json_uart_info()
+ *  Sends the uart log level, dropped character count and sample stream
+ *  statistics as a json string
+ *
+ * apply_log_level()
+ *  Sets the uart log level received via PUT req
+ *
+ * socket_writelong()
+ *  Sends a 32-bit integer as a decimal text representation
+ *
+ * send_dashboard()
+ *  Sends the gzip compressed web dashboard
  *
  *
  */
 
+ #include <avr/pgmspace.h>
  #include "httpparser.h"
  #include "socket.h"
  #include "vpd.h"
  #include "config.h"
  #include "temp.h"
  #include "log.h"
+ #include "logindex.h"
+ #include "ntpclient.h"
  #include "util.h"
  #include "uart.h"
  #include "rtc.h"
+ #include "clock.h"
  #include "wdt.h"
+ #include "sched.h"
+ #include "latency.h"
+ #include "crash.h"
+ #include "w5burst.h"
+ #include "serial.h"
+ #include "ulog.h"
+ #include "stream.h"
+ #include "fmt.h"
+ #include "dashboard.h"
+ #include "devapi.h"
 
  #define MAX_TEMP 0x3FF
 
- enum put_config_operation {TCRIT_HI, TCRIT_LO, TWARN_HI, TWARN_LO, ERROR_OP};
- enum put_config_operation config_op;
-
+ /* cursor over the request in the receive buffer - the request is parsed in
+ * place and removed with a single RECV command when the parser flushes it
+ */
+ static socket_cursor rx;
 
  /**********************************
  * create_error_response()
@@ -62,7 +106,7 @@
  *
  * arguments:
  *  socket - unsigned char that represents the socket
- *  msg - string with a description of the error
+ *  msg - program memory string with a description of the error
  *
  * returns:
  *  none
@@ -70,99 +114,193 @@
  * changes:
  *  none
  */
- static void create_error_response(unsigned char socket, char* msg){
-    socket_writestr(socket, "HTTP/1.1 400 Bad Request\r\n"); //TODO: can sub in my message for "bad request"
+ static void create_error_response(unsigned char socket, const char* msg){
+    socket_writestr_P(socket, PSTR("HTTP/1.1 400 Bad Request\r\n")); //TODO: can sub in my message for "bad request"
     //TODO: How to get web browser to display error
-    //socket_writestr(socket, "Content-Type: application/vnd.api+json\r\n");
-    socket_writestr(socket, "Connection: close\r\n");
-    socket_writestr(socket, "\r\n");
+    //socket_writestr_P(socket, PSTR("Content-Type: application/vnd.api+json\r\n"));
+    socket_writestr_P(socket, PSTR("Connection: close\r\n"));
+    socket_writestr_P(socket, PSTR("\r\n"));
  }
 
 
  /**********************************
- * get_state()
+ * send_json_header()
  *
- * Retreives temp info and uses it to calculate alarm state
+ * Sends the status line and headers of a 200 response with a json
+ * body, up to the start of the body
  *
  * arguments:
- *  none
+ *  socket - unsigned char that represents the socket
  *
  * returns:
- *  char array representing the state
+ *  none
  *
  * changes:
  *  none
  */
- static char* get_state(){
-    if(temp_get() >= config.hi_alarm){
-        return "CRIT_HI";
-    }
-    else if(temp_get() >= config.hi_warn){
-        return "WARN_HI";
-    }
-    else if(temp_get() <= config.lo_alarm){
-        return "CRIT_LO";
-    }
-    else if(temp_get() <= config.lo_warn){
-        return "WARN_LO";
-    }
-    else{
-        return "NORMAL";
-    }
+ static void send_json_header(unsigned char socket){
+    socket_writestr_P(socket, PSTR("HTTP/1.1 200 OK\r\n"
+                                   "Content-Type: application/vnd.api+json\r\n"
+                                   "Connection: close\r\n"
+                                   "\r\n"));
  }
 
+
 /**********************************
  * apply_config_changes()
  *
- * Applies config changes received via PUT req
+ * Applies a config change received via PUT req (devapi.c).  A value
+ * that is not an integer fails like an out of range one - the caller
+ * sends the single error response.
  *
  * arguments:
- *  operation - enum put_config_operation indicating what will be changed
- *  socket - unsigned char that represents the socket we will receive the new setting from
+ *  param - the config parameter that will be changed (DEVICE_CONFIG_*)
  *
  * returns:
  *  success - int 1 for success, 0 for fail
  *
  * changes:
+ *  config
+ */
+ static int apply_config_changes(unsigned char param){
+    int input;
+
+    if(!socket_cursor_int(&rx, &input)){
+        return 0;
+    }
+    return devapi_set_config(param, input);
+ }
+
+ /**********************************
+ * apply_log_level()
+ *
+ * Sets the runtime uart log level received via PUT req.  The level is
+ * not part of the configuration and returns to ULOG_DEFAULT_LEVEL after
+ * a reset.
+ *
+ * arguments:
  *  none
+ *
+ * returns:
+ *  success - int 1 for success, 0 for fail
+ *
+ * changes:
+ *  the uart log level
  */
- static int apply_config_changes(enum put_config_operation setting, unsigned char socket){
+ static int apply_log_level(){
     int input;
-    if(!socket_recv_int(socket, &input)){
-        create_error_response(socket, "Invalid config parameter type for PUT request (int required)");
-        parser_state = FLUSH;
+
+    if(!socket_cursor_int(&rx, &input) || input < ULOG_NONE || input > ULOG_DEBUG){
         return 0;
     }
-    else{
-        switch(setting){
-        case TCRIT_HI:
-            return update_tcrit_hi(input);
-            break;
-        case TCRIT_LO:
-            return update_tcrit_lo(input);
-            break;
-        case TWARN_HI:
-            return update_twarn_hi(input);
-            break;
-        case TWARN_LO:
-            return update_twarn_lo(input);
-            break;
-        default:
-            create_error_response(socket, "Error updating temperature settings");
+    ulog_set_level(input);
+    return 1;
+ }
+
+ /**********************************
+ * parse_device_fields()
+ *
+ * Parses the (optional) query of a GET /device request.  The fields=
+ * parameter lists the members of the device object to send, separated
+ * by commas, e.g. ?fields=temperature,state.  Each name is matched in
+ * place with the same matcher as the request path.
+ *
+ * arguments:
+ *  fields - set to the mask of the requested fields (DEVICE_FIELDS_ALL
+ *           without a query)
+ *
+ * returns:
+ *  1 if the query is valid and ends the request path, 0 otherwise
+ *
+ * changes:
+ *  the receive cursor
+ */
+ static unsigned char parse_device_fields(unsigned char *fields){
+    unsigned char i;
+
+    *fields = DEVICE_FIELDS_ALL;
+    if(!socket_cursor_match_P(&rx, PSTR("?fields="))){
+        return socket_cursor_match_P(&rx, PSTR(" "));
+    }
+    *fields = 0;
+    do{
+        for(i = 0; i < DEVICE_FIELD_COUNT; i++){
+            if(socket_cursor_match_P(&rx, device_fields[i])){
+                break;
+            }
+        }
+        if(i == DEVICE_FIELD_COUNT){
             return 0;
-            break;
         }
+        *fields |= 1 << i;
+    } while(socket_cursor_match_P(&rx, PSTR(",")) || socket_cursor_match_P(&rx, PSTR("%2C")));
+    return socket_cursor_match_P(&rx, PSTR(" "));
+ }
+
+ /**********************************
+ * send_json_log_query()
+ *
+ * Parses the (optional) query of a GET /device/log request and sends
+ * the matching log records as a json string.  Supported parameters are
+ * event=<event number>, from=<rtc date number> and to=<rtc date number>.
+ *
+ * arguments:
+ *  socket - unsigned char represents an instance of a server socket
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  none
+ */
+ static void send_json_log_query(unsigned char socket){
+    int event = EVENT_UNK;
+    unsigned long from = 0;
+    unsigned long to = 0xFFFFFFFFUL;
+
+    if(socket_cursor_match_P(&rx, PSTR("?"))){
+        do{
+            if(socket_cursor_match_P(&rx, PSTR("event="))){
+                if(!socket_cursor_int(&rx, &event) || event < 0 || event >= LOGINDEX_NUM_EVENTS){
+                    create_error_response(socket, PSTR("Invalid event for GET request"));
+                    return;
+                }
+            } else if(socket_cursor_match_P(&rx, PSTR("from="))){
+                if(!socket_cursor_ulong(&rx, &from)){
+                    create_error_response(socket, PSTR("Invalid from time for GET request"));
+                    return;
+                }
+            } else if(socket_cursor_match_P(&rx, PSTR("to="))){
+                if(!socket_cursor_ulong(&rx, &to)){
+                    create_error_response(socket, PSTR("Invalid to time for GET request"));
+                    return;
+                }
+            } else{
+                create_error_response(socket, PSTR("Invalid query parameter for GET request"));
+                return;
+            }
+        } while(socket_cursor_match_P(&rx, PSTR("&")));
+    }
+    if(!socket_cursor_match_P(&rx, PSTR(" "))){
+        create_error_response(socket, PSTR("Invalid endpoint for GET request"));
+        return;
     }
+
+    send_json_header(socket);
+
+    devapi_send_log(socket, (unsigned char)event, from, to);
+    socket_writestr_P(socket, PSTR("\r\n")); //end of message body
  }
 
  /**********************************
- * send_json_device_info()
+ * socket_writelong()
  *
- * Prepares and sends a json string which represents a
- * status summary of the device
+ * Sends a 32-bit integer as a decimal text representation
+ * (socket_writedec32() only takes an int)
  *
  * arguments:
  *  socket - unsigned char represents an instance of a server socket
+ *  n - the value to send
  *
  * returns:
  *  none
@@ -170,118 +308,333 @@
  * changes:
  *  none
  */
- static void send_json_device_info(unsigned char socket){
-     //TODO: FIX TIMESTAMP ISSUE
+ static void socket_writelong(unsigned char socket, long n){
+    char buf[FMT_S32_SIZE];
 
-    //write <CRLF> line as separator
-    socket_writestr(socket, "\r\n");
+    socket_send(socket, (const unsigned char*)buf, fmt_s32(buf, n));
+ }
 
-    socket_writechar(socket, '{'); //open outer object
+ /**********************************
+ * send_json_time_info()
+ *
+ * Sends the current time, the time since startup and the network time
+ * synchronization statistics as a json string
+ *
+ * arguments:
+ *  socket - unsigned char represents an instance of a server socket
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  none
+ */
+ static void send_json_time_info(unsigned char socket){
+    send_json_header(socket);
 
-    //VPD Object
-    socket_writequotedstring(socket, "vpd");
+    socket_writechar(socket, '{');
+    socket_writequotedstring_P(socket, PSTR("time"));
     socket_writechar(socket, ':');
-    socket_writechar(socket, '{'); //open vpd object
-    socket_writequotedstring(socket, "model");
-    socket_writechar(socket, ':');
-    socket_writequotedstring(socket, vpd.model);
+    socket_writequotedstring(socket, rtc_get_date_string());
     socket_writechar(socket, ',');
-    socket_writequotedstring(socket, "manufacturer");
+    socket_writequotedstring_P(socket, PSTR("uptime_s"));
     socket_writechar(socket, ':');
-    socket_writequotedstring(socket, vpd.manufacturer);
+    socket_writelong(socket, clock_uptime());
     socket_writechar(socket, ',');
-    socket_writequotedstring(socket, "serial_number");
+    socket_writequotedstring_P(socket, PSTR("synced"));
     socket_writechar(socket, ':');
-    socket_writequotedstring(socket, vpd.serial_number);
+    socket_writestr_P(socket, ntpclient_is_synced() ? PSTR("true") : PSTR("false"));
     socket_writechar(socket, ',');
-    socket_writequotedstring(socket, "manufacture_date");
+    socket_writequotedstring_P(socket, PSTR("last_sync"));
     socket_writechar(socket, ':');
-    socket_writedate(socket, vpd.manufacture_date);
+    if(ntpclient_is_synced()){
+        socket_writequotedstring(socket, rtc_num2datestr(ntp_stats.last_sync));
+    } else{
+        socket_writestr_P(socket, PSTR("null"));
+    }
     socket_writechar(socket, ',');
-    socket_writequotedstring(socket, "mac_address");
+    socket_writequotedstring_P(socket, PSTR("offset_ms"));
     socket_writechar(socket, ':');
-    socket_write_macaddress(socket, vpd.mac_address);
+    socket_writelong(socket, ntp_stats.offset_ms);
     socket_writechar(socket, ',');
-    socket_writequotedstring(socket, "country_code");
+    socket_writequotedstring_P(socket, PSTR("delay_ms"));
     socket_writechar(socket, ':');
-    socket_writequotedstring(socket, vpd.country_of_origin);
-    socket_writechar(socket, '}'); //close vpd object
-
+    socket_writelong(socket, ntp_stats.delay_ms);
     socket_writechar(socket, ',');
-
-    //general info
-    socket_writequotedstring(socket, "tcrit_hi");
+    socket_writequotedstring_P(socket, PSTR("syncs"));
     socket_writechar(socket, ':');
-    socket_writedec32(socket, config.hi_alarm);
+    socket_writelong(socket, ntp_stats.syncs);
     socket_writechar(socket, ',');
-    socket_writequotedstring(socket, "twarn_hi");
+    socket_writequotedstring_P(socket, PSTR("failures"));
     socket_writechar(socket, ':');
-    socket_writedec32(socket, config.hi_warn);
+    socket_writelong(socket, ntp_stats.failures);
     socket_writechar(socket, ',');
-    socket_writequotedstring(socket, "tcrit_lo");
+    socket_writequotedstring_P(socket, PSTR("steps"));
     socket_writechar(socket, ':');
-    socket_writedec32(socket, config.lo_alarm);
-    socket_writechar(socket, ',');
-    socket_writequotedstring(socket, "twarn_lo");
+    socket_writelong(socket, ntp_stats.steps);
+    socket_writechar(socket, '}');
+
+    socket_writestr_P(socket, PSTR("\r\n")); //end of message body
+ }
+
+ /**********************************
+ * send_json_task_info()
+ *
+ * Sends the run count, worst case execution time, deadline misses and
+ * budget overruns of every scheduler task as a json string
+ *
+ * arguments:
+ *  socket - the socket to send to
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  none
+ */
+ static void send_json_task_info(unsigned char socket){
+    const task_struct *task;
+    unsigned char i;
+
+    send_json_header(socket);
+
+    socket_writechar(socket, '[');
+    for(i = 0; i < sched_get_num_tasks(); i++){
+        task = sched_get_task(i);
+        if(i > 0){
+            socket_writechar(socket, ',');
+        }
+        socket_writechar(socket, '{');
+        socket_writequotedstring_P(socket, PSTR("name"));
+        socket_writechar(socket, ':');
+        socket_writequotedstring_P(socket, task->name);
+        socket_writechar(socket, ',');
+        socket_writequotedstring_P(socket, PSTR("period_ms"));
+        socket_writechar(socket, ':');
+        socket_writelong(socket, task->period_ms);
+        socket_writechar(socket, ',');
+        socket_writequotedstring_P(socket, PSTR("deadline_ms"));
+        socket_writechar(socket, ':');
+        socket_writelong(socket, task->deadline_ms);
+        socket_writechar(socket, ',');
+        socket_writequotedstring_P(socket, PSTR("runs"));
+        socket_writechar(socket, ':');
+        socket_writelong(socket, task->runs);
+        socket_writechar(socket, ',');
+        socket_writequotedstring_P(socket, PSTR("wcet_ms"));
+        socket_writechar(socket, ':');
+        socket_writelong(socket, task->wcet_ms);
+        socket_writechar(socket, ',');
+        socket_writequotedstring_P(socket, PSTR("misses"));
+        socket_writechar(socket, ':');
+        socket_writelong(socket, task->misses);
+        socket_writechar(socket, ',');
+        socket_writequotedstring_P(socket, PSTR("overruns"));
+        socket_writechar(socket, ':');
+        socket_writelong(socket, task->overruns);
+        socket_writechar(socket, '}');
+    }
+    socket_writechar(socket, ']');
+
+    socket_writestr_P(socket, PSTR("\r\n")); //end of message body
+ }
+
+ /**********************************
+ * send_json_socket_info()
+ *
+ * Sends the rx and tx buffer sizes, the tx buffer high-water mark and the
+ * number of sends that waited for the tx buffer of every W5100 socket as
+ * a json string
+ *
+ * arguments:
+ *  socket - the socket to send to
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  none
+ */
+ static void send_json_socket_info(unsigned char socket){
+    unsigned char i;
+
+    send_json_header(socket);
+
+    socket_writechar(socket, '[');
+    for(i = 0; i < W5_NUM_SOCKETS; i++){
+        if(i > 0){
+            socket_writechar(socket, ',');
+        }
+        socket_writechar(socket, '{');
+        socket_writequotedstring_P(socket, PSTR("rx_size"));
+        socket_writechar(socket, ':');
+        socket_writelong(socket, w5burst_get_rx_size(i));
+        socket_writechar(socket, ',');
+        socket_writequotedstring_P(socket, PSTR("tx_size"));
+        socket_writechar(socket, ':');
+        socket_writelong(socket, w5burst_get_tx_size(i));
+        socket_writechar(socket, ',');
+        socket_writequotedstring_P(socket, PSTR("tx_peak"));
+        socket_writechar(socket, ':');
+        socket_writelong(socket, socket_get_tx_peak(i));
+        socket_writechar(socket, ',');
+        socket_writequotedstring_P(socket, PSTR("tx_stalls"));
+        socket_writechar(socket, ':');
+        socket_writelong(socket, socket_get_tx_stalls(i));
+        socket_writechar(socket, '}');
+    }
+    socket_writechar(socket, ']');
+
+    socket_writestr_P(socket, PSTR("\r\n")); //end of message body
+ }
+
+ /**********************************
+ * send_json_uart_info()
+ *
+ * Sends the runtime uart log level, the number of diagnostic characters
+ * dropped because the uart tx ring was full and (in a STREAM_ENABLE
+ * build) the frames sent and samples lost by the sample stream as a
+ * json string
+ *
+ * arguments:
+ *  socket - the socket to send to
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  none
+ */
+ static void send_json_uart_info(unsigned char socket){
+    send_json_header(socket);
+
+    socket_writechar(socket, '{');
+    socket_writequotedstring_P(socket, PSTR("log_level"));
     socket_writechar(socket, ':');
-    socket_writedec32(socket, config.lo_warn);
+    socket_writelong(socket, ulog_get_level());
     socket_writechar(socket, ',');
-    socket_writequotedstring(socket, "temperature");
+    socket_writequotedstring_P(socket, PSTR("tx_dropped"));
     socket_writechar(socket, ':');
-    socket_writedec32(socket, temp_get());
+    socket_writelong(socket, serial_get_dropped());
+ #if STREAM_ENABLE
     socket_writechar(socket, ',');
-    socket_writequotedstring(socket, "state");
+    socket_writequotedstring_P(socket, PSTR("stream_frames"));
     socket_writechar(socket, ':');
-    socket_writequotedstring(socket, get_state());
-
+    socket_writelong(socket, stream_get_frames());
     socket_writechar(socket, ',');
-
-
-    //Log array
-    socket_writequotedstring(socket, "log");
+    socket_writequotedstring_P(socket, PSTR("stream_lost"));
     socket_writechar(socket, ':');
-    socket_writechar(socket, '['); //start log array
+    socket_writelong(socket, stream_get_lost());
+ #endif
+    socket_writechar(socket, '}');
 
-    //create log entry JSON objects and write them
-    unsigned char i;
+    socket_writestr_P(socket, PSTR("\r\n")); //end of message body
+ }
 
-    for (i=0; i < log_get_num_entries(); i++){
-        unsigned long time;
-        unsigned char event_num;
-        log_get_record(i, &time, &event_num);
+ #if LATENCY_ENABLE
+ /**********************************
+ * send_json_latency_info()
+ *
+ * Sends the count, maximum and log2 histogram of every main loop stage
+ * along with the idle and sleep percentages, the spi transaction rate and
+ * the W5100 block transfer rates (in use, and measured at startup for
+ * block and single byte transfers) as a json string
+ *
+ * arguments:
+ *  socket - the socket to send to
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  none
+ */
+ static void send_json_latency_info(unsigned char socket){
+    const latency_stage_struct *stage;
+    unsigned char i;
+    unsigned char j;
 
-        socket_writechar(socket, '{'); //open log object
+    send_json_header(socket);
 
-        socket_writequotedstring(socket, "timestamp");
+    socket_writechar(socket, '{');
+    socket_writequotedstring_P(socket, PSTR("idle_pct"));
+    socket_writechar(socket, ':');
+    socket_writelong(socket, latency_get_idle_pct());
+    socket_writechar(socket, ',');
+    socket_writequotedstring_P(socket, PSTR("min_idle_pct"));
+    socket_writechar(socket, ':');
+    socket_writelong(socket, latency_get_min_idle_pct());
+    socket_writechar(socket, ',');
+    socket_writequotedstring_P(socket, PSTR("sleep_pct"));
+    socket_writechar(socket, ':');
+    socket_writelong(socket, latency_get_sleep_pct());
+    socket_writechar(socket, ',');
+    socket_writequotedstring_P(socket, PSTR("spi_per_s"));
+    socket_writechar(socket, ':');
+    socket_writelong(socket, latency_get_spi_rate());
+    socket_writechar(socket, ',');
+    socket_writequotedstring_P(socket, PSTR("w5_bytes_per_s"));
+    socket_writechar(socket, ':');
+    socket_writelong(socket, latency_get_block_rate());
+    socket_writechar(socket, ',');
+    socket_writequotedstring_P(socket, PSTR("w5_block_bench"));
+    socket_writechar(socket, ':');
+    socket_writelong(socket, w5burst_get_rate());
+    socket_writechar(socket, ',');
+    socket_writequotedstring_P(socket, PSTR("w5_byte_bench"));
+    socket_writechar(socket, ':');
+    socket_writelong(socket, w5burst_get_byte_rate());
+    socket_writechar(socket, ',');
+    socket_writequotedstring_P(socket, PSTR("stages"));
+    socket_writechar(socket, ':');
+    socket_writechar(socket, '[');
+    for(i = 0; i < LAT_NUM_STAGES; i++){
+        stage = latency_get_stage(i);
+        if(i > 0){
+            socket_writechar(socket, ',');
+        }
+        socket_writechar(socket, '{');
+        socket_writequotedstring_P(socket, PSTR("name"));
         socket_writechar(socket, ':');
-        socket_writequotedstring(socket, rtc_num2datestr(time));
+        socket_writequotedstring_P(socket, latency_get_stage_name(i));
         socket_writechar(socket, ',');
-        socket_writequotedstring(socket, "event");
+        socket_writequotedstring_P(socket, PSTR("count"));
         socket_writechar(socket, ':');
-        socket_writedec32(socket, (int)event_num);
-
-        socket_writechar(socket, '}'); //close log object
-
-        //HEADS UP! - This should be fine, but keep an eye on it
-        if(i < log_get_num_entries()-1){
-            socket_writechar(socket, ',');
+        socket_writelong(socket, stage->count);
+        socket_writechar(socket, ',');
+        socket_writequotedstring_P(socket, PSTR("max_us"));
+        socket_writechar(socket, ':');
+        socket_writelong(socket, stage->max_ticks * LATENCY_TICK_US);
+        socket_writechar(socket, ',');
+        socket_writequotedstring_P(socket, PSTR("hist"));
+        socket_writechar(socket, ':');
+        socket_writechar(socket, '[');
+        for(j = 0; j < LATENCY_NUM_BUCKETS; j++){
+            if(j > 0){
+                socket_writechar(socket, ',');
+            }
+            socket_writelong(socket, stage->hist[j]);
         }
+        socket_writechar(socket, ']');
+        socket_writechar(socket, '}');
     }
-    socket_writechar(socket, ']'); //end log array
+    socket_writechar(socket, ']');
+    socket_writechar(socket, '}');
 
-    socket_writechar(socket, '}'); //close outer object
+    socket_writestr_P(socket, PSTR("\r\n")); //end of message body
  }
+ #endif // LATENCY_ENABLE
 
+ #if DASHBOARD_ENABLE
  /**********************************
- * clear_junk()
+ * send_dashboard()
  *
- * removes the specified number of characters (up to 254) from the receive buffer
- * or stop early if the abort character is encountered
+ * Sends the gzip compressed web dashboard straight from program memory.
+ * The page only changes with the firmware, so browsers may cache it for
+ * a week.
  *
  * arguments:
  *  socket - unsigned char represents an instance of a server socket
- *  how_much_junk - unsigned char represents how many characters should be removed?
- *  abort_char - char represents the character that should cause junk collection to stop early
  *
  * returns:
  *  none
@@ -289,27 +642,113 @@
  * changes:
  *  none
  */
- static void clear_junk(unsigned char socket, unsigned char how_much_junk, char abort_character){
-    if (how_much_junk > 254){
-        how_much_junk = 254;
+ static void send_dashboard(unsigned char socket){
+    socket_writestr_P(socket, PSTR("HTTP/1.1 200 OK\r\n"
+                                   "Content-Type: text/html; charset=utf-8\r\n"
+                                   "Content-Encoding: gzip\r\n"
+                                   "Cache-Control: public, max-age=604800\r\n"
+                                   "Connection: close\r\n"
+                                   "Content-Length: "));
+    socket_writedec32(socket, DASHBOARD_GZ_SIZE);
+    socket_writestr_P(socket, PSTR("\r\n\r\n"));
+    socket_send_P(socket, dashboard_gz, DASHBOARD_GZ_SIZE);
+ }
+ #endif // DASHBOARD_ENABLE
+
+ /**********************************
+ * send_json_crash_info()
+ *
+ * Sends the crash record captured by the last watchdog reset (or null if
+ * there is none) as a json string
+ *
+ * arguments:
+ *  socket - the socket to send to
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  none
+ */
+ static void send_json_crash_info(unsigned char socket){
+    const crash_struct *crash = crash_get_record();
+
+    send_json_header(socket);
+
+    if(!crash){
+        socket_writestr_P(socket, PSTR("null"));
+        socket_writestr_P(socket, PSTR("\r\n")); //end of message body
+        return;
     }
-    unsigned char junk;
-    unsigned char i = 0;
-    while (i<how_much_junk){
-            socket_peek(socket, &junk);
-            if(junk == abort_character){
-                i = 255;
-            }
-            else{
-                socket_recv(socket, &junk, 1);
-                i++;
-            }
+
+    socket_writechar(socket, '{');
+    socket_writequotedstring_P(socket, PSTR("count"));
+    socket_writechar(socket, ':');
+    socket_writelong(socket, crash->count);
+    socket_writechar(socket, ',');
+    socket_writequotedstring_P(socket, PSTR("time"));
+    socket_writechar(socket, ':');
+    socket_writequotedstring(socket, rtc_num2datestr(crash->time));
+    socket_writechar(socket, ',');
+    socket_writequotedstring_P(socket, PSTR("task"));
+    socket_writechar(socket, ':');
+    if(crash->task < sched_get_num_tasks()){
+        socket_writequotedstring_P(socket, sched_get_task(crash->task)->name);
+    } else{
+        socket_writestr_P(socket, PSTR("null"));
+    }
+    socket_writechar(socket, ',');
+    socket_writequotedstring_P(socket, PSTR("stage"));
+    socket_writechar(socket, ':');
+ #if LATENCY_ENABLE
+    if(crash->stage < LAT_NUM_STAGES){
+        socket_writequotedstring_P(socket, latency_get_stage_name(crash->stage));
+    } else{
+        socket_writestr_P(socket, PSTR("null"));
     }
+    socket_writechar(socket, ',');
+    socket_writequotedstring_P(socket, PSTR("stage_us"));
+    socket_writechar(socket, ':');
+    socket_writelong(socket, crash->stage_ticks * LATENCY_TICK_US);
+    socket_writechar(socket, ',');
+    socket_writequotedstring_P(socket, PSTR("max_stage"));
+    socket_writechar(socket, ':');
+    if(crash->max_stage < LAT_NUM_STAGES){
+        socket_writequotedstring_P(socket, latency_get_stage_name(crash->max_stage));
+    } else{
+        socket_writestr_P(socket, PSTR("null"));
+    }
+    socket_writechar(socket, ',');
+    socket_writequotedstring_P(socket, PSTR("max_us"));
+    socket_writechar(socket, ':');
+    socket_writelong(socket, crash->max_ticks * LATENCY_TICK_US);
+ #else
+    socket_writestr_P(socket, PSTR("null"));
+ #endif
+    socket_writechar(socket, ',');
+    socket_writequotedstring_P(socket, PSTR("parser_state"));
+    socket_writechar(socket, ':');
+    socket_writelong(socket, crash->parser_state);
+    socket_writechar(socket, ',');
+    socket_writequotedstring_P(socket, PSTR("socket"));
+    socket_writechar(socket, ':');
+    socket_writelong(socket, crash->sockop >> 4);
+    socket_writechar(socket, ',');
+    socket_writequotedstring_P(socket, PSTR("socket_op"));
+    socket_writechar(socket, ':');
+    socket_writequotedstring_P(socket, crash_get_sockop_name(crash->sockop & 0x0F));
+    socket_writechar(socket, ',');
+    socket_writequotedstring_P(socket, PSTR("sp"));
+    socket_writechar(socket, ':');
+    socket_writelong(socket, crash->sp);
+    socket_writechar(socket, '}');
+
+    socket_writestr_P(socket, PSTR("\r\n")); //end of message body
  }
 
  static void send_ok(unsigned char socket){
-    socket_writestr(socket, "HTTP/1.1 200 OK\r\n");
-    socket_writestr(socket, "Connection: close\r\n");
+    socket_writestr_P(socket, PSTR("HTTP/1.1 200 OK\r\n"));
+    socket_writestr_P(socket, PSTR("Connection: close\r\n"));
  }
 /**********************************
  * parse_http()
@@ -328,130 +767,162 @@
  *  none
  */
  void parse_http(unsigned char socket){
+    unsigned char fields;
+
     //uart_writestr("Starting http Parse\r\n");
+    socket_cursor_open(&rx, socket);
 
     while(parser_state != DONE){
         switch(parser_state){
         case ID_TYPE:
-            if(socket_recv_compare(socket, "GET ")){
+            CRASH_SOCKOP(socket, SOCKOP_RECV);
+            if(socket_cursor_match_P(&rx, PSTR("GET "))){
                 parser_state = GET;
-                clear_junk(socket, 18, '/');
-            } else if(socket_recv_compare(socket, "PUT ")){
+                socket_cursor_skip(&rx, 18, '/');
+            } else if(socket_cursor_match_P(&rx, PSTR("PUT "))){
                 parser_state = PUT;
-                clear_junk(socket, 18, '/');
-            } else if(socket_recv_compare(socket, "DELETE ")){
+                socket_cursor_skip(&rx, 18, '/');
+            } else if(socket_cursor_match_P(&rx, PSTR("DELETE "))){
                 parser_state = DELETE;
-                clear_junk(socket, 18, '/');
+                socket_cursor_skip(&rx, 18, '/');
             } else{
-                create_error_response(socket, "Invalid Request Type");
+                create_error_response(socket, PSTR("Invalid Request Type"));
                 parser_state = FLUSH;
             }
             break;
         case GET:
+            CRASH_SOCKOP(socket, SOCKOP_SEND);
             //check URI/Endpoint
-            if(socket_recv_compare(socket, "/device ")){
-                socket_writestr(socket, "HTTP/1.1 200 OK\r\n");
-                socket_writestr(socket, "Content-Type: application/vnd.api+json\r\n");
-                socket_writestr(socket, "Connection: close\r\n");
-
-                socket_writestr(socket, "\r\n"); //start of message body
-                send_json_device_info(socket);
-                socket_writestr(socket, "\r\n"); //end of message body
+ #if DASHBOARD_ENABLE
+            if(socket_cursor_match_P(&rx, PSTR("/ "))){
+                send_dashboard(socket);
+            } else
+ #endif
+            if(socket_cursor_match_P(&rx, PSTR("/device/log"))){
+                send_json_log_query(socket);
+            } else if(socket_cursor_match_P(&rx, PSTR("/device/time "))){
+                send_json_time_info(socket);
+            } else if(socket_cursor_match_P(&rx, PSTR("/device/crash "))){
+                send_json_crash_info(socket);
+            } else if(socket_cursor_match_P(&rx, PSTR("/device/tasks "))){
+                send_json_task_info(socket);
+            } else if(socket_cursor_match_P(&rx, PSTR("/device/sockets "))){
+                send_json_socket_info(socket);
+            } else if(socket_cursor_match_P(&rx, PSTR("/device/uart "))){
+                send_json_uart_info(socket);
+ #if LATENCY_ENABLE
+            } else if(socket_cursor_match_P(&rx, PSTR("/device/latency "))){
+                send_json_latency_info(socket);
+ #endif
+            } else if(socket_cursor_match_P(&rx, PSTR("/device"))){
+                if(!parse_device_fields(&fields)){
+                    create_error_response(socket, PSTR("Invalid fields for GET request"));
+                    parser_state = FLUSH;
+                    break;
+                }
+                send_json_header(socket);
+                //write <CRLF> line as separator (the CoAP body has none)
+                socket_writestr_P(socket, PSTR("\r\n"));
+                devapi_send_device(socket, fields);
+                socket_writestr_P(socket, PSTR("\r\n")); //end of message body
             } else{
-                create_error_response(socket, "Invalid endpoint for GET request");
+                create_error_response(socket, PSTR("Invalid endpoint for GET request"));
             }
             parser_state = FLUSH;
             break;
         case PUT:
             //check URI/Endpoint
-            if(socket_recv_compare(socket, "/device/config")){
-                if (socket_recv_compare(socket, "?")){
+            if(socket_cursor_match_P(&rx, PSTR("/device/config"))){
+                if (socket_cursor_match_P(&rx, PSTR("?"))){
                     parser_state = APPLY_CHANGES;
                 } else{
-                    create_error_response(socket, "Invalid PUT request");
+                    create_error_response(socket, PSTR("Invalid PUT request"));
                     parser_state = FLUSH;
                     break;
                 }
-            } else if(socket_recv_compare(socket, "/device")){
-                if (socket_recv_compare(socket, "?reset=")){
+            } else if(socket_cursor_match_P(&rx, PSTR("/device"))){
+                if (socket_cursor_match_P(&rx, PSTR("?reset="))){
                     parser_state = RESET;
                 } else{
-                    create_error_response(socket, "Invalid PUT request");
+                    create_error_response(socket, PSTR("Invalid PUT request"));
                     parser_state = FLUSH;
                     break;
                 }
             }
             else{
-                create_error_response(socket, "Invalid endpoint for PUT request");
+                create_error_response(socket, PSTR("Invalid endpoint for PUT request"));
                 parser_state = FLUSH;
             }
             break;
         case RESET:
-            if (socket_recv_compare(socket, "\"true\"")){
+            if (socket_cursor_match_P(&rx, PSTR("\"true\""))){
                 send_ok(socket);
                 socket_disconnect(socket);
                 //reset machine
                 wdt_force_restart();
-            } else if(socket_recv_compare(socket, "\"false\"")){
+            } else if(socket_cursor_match_P(&rx, PSTR("\"false\""))){
                 //do nothing - just close connection with ok...?
                 send_ok(socket);
             } else{
-                create_error_response(socket, "Not a valid option for reset setting");
+                create_error_response(socket, PSTR("Not a valid option for reset setting"));
             }
             parser_state = FLUSH;
             break;
         case DELETE:
             //check URI/Endpoint
-            if(socket_recv_compare(socket, "/device/log")){
-                log_clear();
+            if(socket_cursor_match_P(&rx, PSTR("/device/log"))){
+                logindex_clear();
                 send_ok(socket);
             } else{
-                create_error_response(socket, "Invalid endpoint for DELETE request");
+                create_error_response(socket, PSTR("Invalid endpoint for DELETE request"));
             }
             parser_state = FLUSH;
             break;
         case APPLY_CHANGES:
-            if(socket_recv_compare(socket, "twarn_hi=")){
-                if(apply_config_changes(TWARN_HI, socket)){
-                    config_set_modified();
+            if(socket_cursor_match_P(&rx, PSTR("twarn_hi="))){
+                if(apply_config_changes(DEVICE_CONFIG_TWARN_HI)){
                     send_ok(socket);
                 } else{
-                    create_error_response(socket, "Invalid high warning temperature");
+                    create_error_response(socket, PSTR("Invalid high warning temperature"));
                 }
             }
-            else if(socket_recv_compare(socket, "twarn_lo=")){
-                if(apply_config_changes(TWARN_LO, socket)){
-                    config_set_modified();
+            else if(socket_cursor_match_P(&rx, PSTR("twarn_lo="))){
+                if(apply_config_changes(DEVICE_CONFIG_TWARN_LO)){
                     send_ok(socket);
                 }else{
-                    create_error_response(socket, "Invalid low warning temperature");
+                    create_error_response(socket, PSTR("Invalid low warning temperature"));
                 }
             }
-            else if(socket_recv_compare(socket, "tcrit_hi=")){
-                if(apply_config_changes(TCRIT_HI, socket)){
-                    config_set_modified();
+            else if(socket_cursor_match_P(&rx, PSTR("tcrit_hi="))){
+                if(apply_config_changes(DEVICE_CONFIG_TCRIT_HI)){
                     send_ok(socket);
                 }else{
-                    create_error_response(socket, "Invalid critical high temperature");
+                    create_error_response(socket, PSTR("Invalid critical high temperature"));
+                }
+            }
+            else if(socket_cursor_match_P(&rx, PSTR("tcrit_lo="))){
+                if(apply_config_changes(DEVICE_CONFIG_TCRIT_LO)){
+                    send_ok(socket);
+                } else{
+                    create_error_response(socket, PSTR("Invalid critical low temperature"));
                 }
             }
-            else if(socket_recv_compare(socket, "tcrit_lo=")){
-                if(apply_config_changes(TCRIT_LO, socket)){
-                    config_set_modified();
+            else if(socket_cursor_match_P(&rx, PSTR("loglevel="))){
+                if(apply_log_level()){
                     send_ok(socket);
                 } else{
-                    create_error_response(socket, "Invalid critical low temperature");
+                    create_error_response(socket, PSTR("Invalid log level"));
                 }
             }
             else{
-                create_error_response(socket, "Invalid config parameter name for PUT request");
+                create_error_response(socket, PSTR("Invalid config parameter name for PUT request"));
             }
             parser_state = FLUSH;
             break;
         case FLUSH:
-            do{
-                socket_flush_line(socket);
-            } while(socket_recv_available(socket)>0 || socket_received_line(socket));
+            CRASH_SOCKOP(socket, SOCKOP_FLUSH);
+            socket_cursor_flush(&rx);
+            CRASH_SOCKOP(socket, SOCKOP_DISCONNECT);
             socket_disconnect(socket);
             parser_state = DONE;
             break;
@@ -0,0 +1,569 @@
+/********************************************************
+ * latency.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file implements the main loop latency instrumentation.
+ * Timer2 runs free at 4us per tick and its overflow interrupt
+ * extends the count to 32 bits (wraps after about 4.7 hours, which
+ * is harmless since only differences are used).  Each stage keeps a
+ * run count, its maximum duration and a log2 bucketed histogram, so
+ * a stage that comes close to the watchdog timeout can be identified.
+ * The time spent in passes through the loop that find no work is
+ * accumulated as idle time and reported as a percentage per window,
+ * as is the part of it spent in the idle sleep between ticks.  The
+ * spi transaction rate and the W5100 block transfer byte rate are
+ * sampled over the same window.
+ *
+ * The whole file is compiled out unless LATENCY_ENABLE is 1.
+ *
+ * Functions:
+ *
+ * latency_init()
+ *  Starts timer2 as the free running timestamp counter
+ *
+ * latency_begin()
+ *  Marks the start of a stage
+ *
+ * latency_end()
+ *  Marks the end of a stage and adds its duration to the histogram
+ *
+ * latency_idle_begin()
+ *  Marks the start of a pass through the loop
+ *
+ * latency_idle_end()
+ *  Counts the time since latency_idle_begin() as idle time
+ *
+ * latency_get_stage()
+ *  Returns the statistics of a stage
+ *
+ * latency_get_stage_name()
+ *  Returns the name of a stage
+ *
+ * latency_sleep_begin()
+ *  Marks the start of a sleep
+ *
+ * latency_sleep_end()
+ *  Counts the time since latency_sleep_begin() as sleep time
+ *
+ * latency_get_idle_pct()
+ *  Returns the idle percentage of the last complete window
+ *
+ * latency_get_min_idle_pct()
+ *  Returns the lowest idle percentage of any window
+ *
+ * latency_get_sleep_pct()
+ *  Returns the sleep percentage of the last complete window
+ *
+ * latency_get_spi_rate()
+ *  Returns the spi transactions per second of the last complete window
+ *
+ * latency_get_block_rate()
+ *  Returns the W5100 block transfer bytes per second of the last window
+ *
+ * latency_get_current()
+ *  Returns the running stage and its elapsed time
+ *
+ * latency_get_max()
+ *  Returns the stage with the longest run
+ *
+ * latency_report_line()
+ *  Writes one line of the stage statistics, idle and sleep fractions
+ *  and spi rate to the uart
+ */
+
+ #include "latency.h"
+
+ #if LATENCY_ENABLE
+
+ #include <avr/io.h>
+ #include <avr/interrupt.h>
+ #include <avr/pgmspace.h>
+ #include "uart.h"
+ #include "serial.h"
+ #include "spi.h"
+ #include "w5burst.h"
+
+ static volatile unsigned long overflows;
+
+ static latency_stage_struct stages[LAT_NUM_STAGES];
+ static unsigned long stage_start[LAT_NUM_STAGES];
+
+ /* running stage and the stage each stage was started within (stages nest) */
+ static volatile unsigned char current_stage = LAT_NO_STAGE;
+ static unsigned char stage_parent[LAT_NUM_STAGES];
+
+ /* longest name and its terminator */
+ #define STAGE_NAME_SIZE    8
+
+ static const char stage_names[LAT_NUM_STAGES][STAGE_NAME_SIZE] PROGMEM = {
+    "led", "sample", "fsm", "socket", "parse", "network", "config", "log", "eecrc"
+ };
+
+ static unsigned long idle_start;
+ static unsigned long idle_ticks;
+ static unsigned long window_start;
+ static unsigned char idle_pct = 100;
+ static unsigned char min_idle_pct = 100;
+ static unsigned long sleep_start;
+ static unsigned long sleep_ticks;
+ static unsigned char sleep_pct;
+ static unsigned long window_spi;
+ static unsigned int spi_rate;
+ static unsigned long window_bytes;
+ static unsigned long block_rate;
+
+ /**********************************
+ * TIMER2_OVF_vect
+ *
+ * Extends the 8-bit timer2 count (one overflow every 1.024ms)
+ */
+ ISR(TIMER2_OVF_vect){
+    overflows++;
+ }
+
+ /**********************************
+ * latency_now()
+ *
+ * Returns the current 32-bit timestamp.  An overflow that is pending
+ * (but not yet serviced) while the count is read is accounted for.
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  the timestamp in 4us ticks
+ *
+ * changes:
+ *  none
+ */
+ static unsigned long latency_now(){
+    unsigned char sreg;
+    unsigned char count;
+    unsigned long ovf;
+
+    sreg = SREG;
+    cli();
+    count = TCNT2;
+    ovf = overflows;
+    if((TIFR2 & (1<<TOV2)) && count != 0xFF){
+        ovf++;
+    }
+    SREG = sreg;
+    return (ovf << 8) | count;
+ }
+
+ /**********************************
+ * latency_init()
+ *
+ * Starts timer2 in normal mode with a prescaler of 64 (4us per tick)
+ * and enables its overflow interrupt
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  timer2 registers, window_start
+ */
+ void latency_init(){
+    TCCR2A = 0;
+    TCNT2 = 0;
+    TIFR2 = (1<<TOV2);
+    TIMSK2 |= (1<<TOIE2);
+    TCCR2B = (1<<CS22);
+    window_start = latency_now();
+    window_spi = spi_get_transactions();
+    window_bytes = w5burst_get_bytes();
+ }
+
+ /**********************************
+ * latency_begin()
+ *
+ * Marks the start of a stage
+ *
+ * arguments:
+ *  stage - the stage (enum latency_stage)
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  stage_start, stage_parent, current_stage
+ */
+ void latency_begin(unsigned char stage){
+    stage_start[stage] = latency_now();
+    stage_parent[stage] = current_stage;
+    current_stage = stage;
+ }
+
+ /**********************************
+ * latency_end()
+ *
+ * Marks the end of a stage and updates its count, maximum and histogram
+ *
+ * arguments:
+ *  stage - the stage (enum latency_stage)
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  stages, current_stage
+ */
+ void latency_end(unsigned char stage){
+    latency_stage_struct *s = &stages[stage];
+    unsigned long ticks = latency_now() - stage_start[stage];
+    unsigned long d = ticks >> 4;
+    unsigned char bucket = 0;
+
+    while(d && bucket < LATENCY_NUM_BUCKETS - 1){
+        d >>= 1;
+        bucket++;
+    }
+    if(s->hist[bucket] != 0xFFFF){
+        s->hist[bucket]++;
+    }
+    s->count++;
+    if(ticks > s->max_ticks){
+        s->max_ticks = ticks;
+    }
+    current_stage = stage_parent[stage];
+ }
+
+ /**********************************
+ * latency_idle_begin()
+ *
+ * Marks the start of a pass through the loop
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  idle_start
+ */
+ void latency_idle_begin(){
+    idle_start = latency_now();
+ }
+
+ /**********************************
+ * latency_idle_end()
+ *
+ * Counts the time since latency_idle_begin() as idle time and closes
+ * the idle window once it is complete
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  idle_ticks, sleep_ticks, window_start, idle_pct, min_idle_pct, sleep_pct,
+ *  window_spi, spi_rate, window_bytes, block_rate
+ */
+ void latency_idle_end(){
+    unsigned long now = latency_now();
+    unsigned long elapsed;
+
+    idle_ticks += now - idle_start;
+    elapsed = now - window_start;
+    if(elapsed >= LATENCY_WINDOW){
+        unsigned long spi = spi_get_transactions();
+        unsigned long bytes = w5burst_get_bytes();
+        spi_rate = (spi - window_spi) / (elapsed / (1000000UL / LATENCY_TICK_US));
+        window_spi = spi;
+        block_rate = (bytes - window_bytes) / (elapsed / (1000000UL / LATENCY_TICK_US));
+        window_bytes = bytes;
+        /* idle_ticks <= elapsed, so scale elapsed down instead of idle_ticks up */
+        idle_pct = idle_ticks / (elapsed / 100);
+        sleep_pct = sleep_ticks / (elapsed / 100);
+        if(idle_pct < min_idle_pct){
+            min_idle_pct = idle_pct;
+        }
+        idle_ticks = 0;
+        sleep_ticks = 0;
+        window_start = now;
+    }
+ }
+
+ /**********************************
+ * latency_sleep_begin()
+ *
+ * Marks the start of a sleep (within an idle pass)
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  sleep_start
+ */
+ void latency_sleep_begin(){
+    sleep_start = latency_now();
+ }
+
+ /**********************************
+ * latency_sleep_end()
+ *
+ * Counts the time since latency_sleep_begin() as sleep time.  Timer2
+ * keeps running in idle sleep, so the wakeup interrupt is included.
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  sleep_ticks
+ */
+ void latency_sleep_end(){
+    sleep_ticks += latency_now() - sleep_start;
+ }
+
+ /**********************************
+ * latency_get_stage()
+ *
+ * Returns the statistics of a stage
+ *
+ * arguments:
+ *  stage - the stage (enum latency_stage)
+ *
+ * returns:
+ *  pointer to the stage statistics
+ *
+ * changes:
+ *  none
+ */
+ const latency_stage_struct *latency_get_stage(unsigned char stage){
+    return &stages[stage];
+ }
+
+ /**********************************
+ * latency_get_stage_name()
+ *
+ * Returns the name of a stage
+ *
+ * arguments:
+ *  stage - the stage (enum latency_stage)
+ *
+ * returns:
+ *  the name of the stage (in program memory)
+ *
+ * changes:
+ *  none
+ */
+ const char *latency_get_stage_name(unsigned char stage){
+    return stage_names[stage];
+ }
+
+ /**********************************
+ * latency_get_idle_pct()
+ *
+ * Returns the idle percentage of the last complete window
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  idle percentage (0-100)
+ *
+ * changes:
+ *  none
+ */
+ unsigned char latency_get_idle_pct(){
+    return idle_pct;
+ }
+
+ /**********************************
+ * latency_get_min_idle_pct()
+ *
+ * Returns the lowest idle percentage of any window since startup
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  idle percentage (0-100)
+ *
+ * changes:
+ *  none
+ */
+ unsigned char latency_get_min_idle_pct(){
+    return min_idle_pct;
+ }
+
+ /**********************************
+ * latency_get_sleep_pct()
+ *
+ * Returns the percentage of the last complete window spent asleep
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  sleep percentage (0-100)
+ *
+ * changes:
+ *  none
+ */
+ unsigned char latency_get_sleep_pct(){
+    return sleep_pct;
+ }
+
+ /**********************************
+ * latency_get_spi_rate()
+ *
+ * Returns the spi transactions per second of the last complete window
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  spi transactions per second
+ *
+ * changes:
+ *  none
+ */
+ unsigned int latency_get_spi_rate(){
+    return spi_rate;
+ }
+
+ /**********************************
+ * latency_get_block_rate()
+ *
+ * Returns the bytes per second moved by W5100 block transfers in the last
+ * complete window
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  bytes per second
+ *
+ * changes:
+ *  none
+ */
+ unsigned long latency_get_block_rate(){
+    return block_rate;
+ }
+
+ /**********************************
+ * latency_get_current()
+ *
+ * Returns the innermost stage that is running and the time elapsed since
+ * it started.  Safe to call from an interrupt (used by the watchdog).
+ *
+ * arguments:
+ *  elapsed - receives the elapsed ticks (0 outside of any stage)
+ *
+ * returns:
+ *  the running stage, or LAT_NO_STAGE
+ *
+ * changes:
+ *  none
+ */
+ unsigned char latency_get_current(unsigned long *elapsed){
+    unsigned char stage = current_stage;
+
+    *elapsed = (stage == LAT_NO_STAGE) ? 0 : latency_now() - stage_start[stage];
+    return stage;
+ }
+
+ /**********************************
+ * latency_get_max()
+ *
+ * Returns the stage with the longest run so far
+ *
+ * arguments:
+ *  max_ticks - receives the longest run in ticks
+ *
+ * returns:
+ *  the stage with the longest run
+ *
+ * changes:
+ *  none
+ */
+ unsigned char latency_get_max(unsigned long *max_ticks){
+    unsigned char worst = 0;
+    unsigned char i;
+
+    for(i = 1; i < LAT_NUM_STAGES; i++){
+        if(stages[i].max_ticks > stages[worst].max_ticks){
+            worst = i;
+        }
+    }
+    *max_ticks = stages[worst].max_ticks;
+    return worst;
+ }
+
+ /**********************************
+ * latency_report_line()
+ *
+ * Writes one line of the report: lines 0 to LAT_NUM_STAGES-1 give the
+ * count, maximum in us and the histogram up to the highest non-empty
+ * bucket of a stage, line LAT_NUM_STAGES the idle and sleep fractions
+ * and the spi transaction rate
+ *
+ * arguments:
+ *  line - the report line to write
+ *
+ * returns:
+ *  1 if the line was written, 0 if line is past the end of the report
+ *
+ * changes:
+ *  none
+ */
+ unsigned char latency_report_line(unsigned char line){
+    latency_stage_struct *stage;
+    unsigned char j;
+    unsigned char last;
+
+    if(line < LAT_NUM_STAGES){
+        stage = &stages[line];
+        last = 0;
+        for(j = 0; j < LATENCY_NUM_BUCKETS; j++){
+            if(stage->hist[j]){
+                last = j;
+            }
+        }
+        serial_writestr_P(stage_names[line]);
+        serial_writestr_P(PSTR(": n "));
+        uart_writedec32(stage->count);
+        serial_writestr_P(PSTR(" max "));
+        uart_writedec32(stage->max_ticks * LATENCY_TICK_US);
+        serial_writestr_P(PSTR("us hist"));
+        for(j = 0; j <= last; j++){
+            uart_writechar(' ');
+            uart_writedec32(stage->hist[j]);
+        }
+        serial_writestr_P(PSTR("\r\n"));
+        return 1;
+    }
+    if(line == LAT_NUM_STAGES){
+        serial_writestr_P(PSTR("idle "));
+        uart_writedec32(idle_pct);
+        serial_writestr_P(PSTR("% min "));
+        uart_writedec32(min_idle_pct);
+        serial_writestr_P(PSTR("% sleep "));
+        uart_writedec32(sleep_pct);
+        serial_writestr_P(PSTR("% spi "));
+        uart_writedec32(spi_rate);
+        serial_writestr_P(PSTR("/s w5 "));
+        uart_writedec32(block_rate);
+        serial_writestr_P(PSTR(" B/s\r\n"));
+        return 1;
+    }
+    return 0;
+ }
+
+ #endif // LATENCY_ENABLE
@@ -0,0 +1,206 @@
+/********************************************************
+ * latency.h
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file provides declarations for the main loop latency
+ * instrumentation.  Each stage of the main loop is timed with
+ * timer2 and kept in a log2 bucketed histogram along with its
+ * maximum, and the idle and sleep time of the loop are kept as
+ * fractions.
+ *
+ * The instrumentation is a diagnostic and takes about 450 bytes of
+ * RAM, so it is compiled out unless LATENCY_ENABLE is defined as 1 -
+ * the LATENCY_ macros then expand to nothing.
+ */
+
+#ifndef LATENCY_H_INCLUDED
+#define LATENCY_H_INCLUDED
+
+#ifndef LATENCY_ENABLE
+#define LATENCY_ENABLE 0
+#endif
+
+/* instrumented stages of the main loop */
+enum latency_stage {
+    LAT_LED,        /* led_update() */
+    LAT_SAMPLE,     /* temp_get() and temp_start() */
+    LAT_FSM,        /* tempfsm_update() */
+    LAT_SOCKET,     /* server socket handling (including parse_http()) */
+    LAT_PARSE,      /* parse_http() */
+    LAT_NETWORK,    /* udp clients, dhcp lease upkeep and alarms */
+    LAT_CONFIG,     /* config_update() */
+    LAT_LOG,        /* log_update() */
+    LAT_EECRC,      /* eecrc_update() */
+    LAT_NUM_STAGES
+};
+
+/* returned by latency_get_current() outside of any stage */
+#define LAT_NO_STAGE        0xFF
+
+/* timer2 tick (prescaler 64) */
+#define LATENCY_TICK_US     4
+
+/* histogram bucket 0 holds durations below 64us, bucket n (n>0) durations
+ * of [32us << n, 64us << n) and the last bucket everything longer
+ */
+#define LATENCY_NUM_BUCKETS 16
+
+/* length of the window the idle fraction is computed over (ticks, 10s) */
+#define LATENCY_WINDOW      2500000UL
+
+typedef struct {
+    unsigned long count;                        /* number of timed runs */
+    unsigned long max_ticks;                    /* longest run */
+    unsigned int  hist[LATENCY_NUM_BUCKETS];    /* saturating bucket counts */
+} latency_stage_struct;
+
+#if LATENCY_ENABLE
+
+#define LATENCY_INIT()          latency_init()
+#define LATENCY_REPORT_LINE(n)  latency_report_line(n)
+#define LATENCY_BEGIN(stage)    latency_begin(stage)
+#define LATENCY_END(stage)      latency_end(stage)
+#define LATENCY_IDLE_BEGIN()    latency_idle_begin()
+#define LATENCY_IDLE_END()      latency_idle_end()
+#define LATENCY_SLEEP_BEGIN()   latency_sleep_begin()
+#define LATENCY_SLEEP_END()     latency_sleep_end()
+
+/**********************************
+ * latency_init()
+ *
+ * Starts timer2 as the free running timestamp counter
+ */
+void latency_init();
+
+/**********************************
+ * latency_begin()
+ *
+ * Marks the start of a stage
+ */
+void latency_begin(unsigned char stage);
+
+/**********************************
+ * latency_end()
+ *
+ * Marks the end of a stage and adds its duration to the histogram
+ */
+void latency_end(unsigned char stage);
+
+/**********************************
+ * latency_idle_begin()
+ *
+ * Marks the start of a pass through the loop that may find no work
+ */
+void latency_idle_begin();
+
+/**********************************
+ * latency_idle_end()
+ *
+ * Counts the time since latency_idle_begin() as idle time
+ */
+void latency_idle_end();
+
+/**********************************
+ * latency_sleep_begin()
+ *
+ * Marks the start of a sleep
+ */
+void latency_sleep_begin();
+
+/**********************************
+ * latency_sleep_end()
+ *
+ * Counts the time since latency_sleep_begin() as sleep time
+ */
+void latency_sleep_end();
+
+/**********************************
+ * latency_get_stage()
+ *
+ * Returns the statistics of a stage
+ */
+const latency_stage_struct *latency_get_stage(unsigned char stage);
+
+/**********************************
+ * latency_get_stage_name()
+ *
+ * Returns the name of a stage (in program memory)
+ */
+const char *latency_get_stage_name(unsigned char stage);
+
+/**********************************
+ * latency_get_idle_pct()
+ *
+ * Returns the idle percentage of the last complete window
+ */
+unsigned char latency_get_idle_pct();
+
+/**********************************
+ * latency_get_min_idle_pct()
+ *
+ * Returns the lowest idle percentage of any window since startup
+ */
+unsigned char latency_get_min_idle_pct();
+
+/**********************************
+ * latency_get_sleep_pct()
+ *
+ * Returns the percentage of the last complete window spent in idle
+ * sleep between ticks
+ */
+unsigned char latency_get_sleep_pct();
+
+/**********************************
+ * latency_get_spi_rate()
+ *
+ * Returns the spi transactions per second of the last complete window
+ */
+unsigned int latency_get_spi_rate();
+
+/**********************************
+ * latency_get_block_rate()
+ *
+ * Returns the bytes per second moved by W5100 block transfers in the
+ * last complete window
+ */
+unsigned long latency_get_block_rate();
+
+/**********************************
+ * latency_get_current()
+ *
+ * Returns the innermost stage that is running (or LAT_NO_STAGE) and the
+ * ticks elapsed since it started.  Safe to call from an interrupt.
+ */
+unsigned char latency_get_current(unsigned long *elapsed);
+
+/**********************************
+ * latency_get_max()
+ *
+ * Returns the stage with the longest run so far and that run (in ticks)
+ */
+unsigned char latency_get_max(unsigned long *max_ticks);
+
+/**********************************
+ * latency_report_line()
+ *
+ * Writes one line of the stage statistics, idle and sleep fractions and
+ * spi rate to the uart, returns 0 once line is past the end of the report
+ */
+unsigned char latency_report_line(unsigned char line);
+
+#else
+
+#define LATENCY_INIT()          do{}while(0)
+#define LATENCY_REPORT_LINE(n)  0
+#define LATENCY_BEGIN(stage)    do{}while(0)
+#define LATENCY_END(stage)      do{}while(0)
+#define LATENCY_IDLE_BEGIN()    do{}while(0)
+#define LATENCY_IDLE_END()      do{}while(0)
+#define LATENCY_SLEEP_BEGIN()   do{}while(0)
+#define LATENCY_SLEEP_END()     do{}while(0)
+
+#endif // LATENCY_ENABLE
+
+#endif // LATENCY_H_INCLUDED
@@ -0,0 +1,584 @@
+/********************************************************
+ * logindex.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file implements a small summary index over the event log.
+ * For each event type it keeps a bitmap of the log positions holding
+ * that event, the number of such records and the timestamp of the
+ * most recent one.  The log is time ordered (oldest first), so time
+ * range lookups are done with a binary search on the record timestamps.
+ * (If the rtc was ever set backwards the log is scanned instead.)
+ *
+ * Records are stamped with the millisecond of the rtc (clock_read_rtc())
+ * when they are added or picked up by logindex_sync(), if the rtc is
+ * still in the second of the record.  The milliseconds are only kept in
+ * memory, so records read from the eeprom at startup have none.
+ *
+ * Functions:
+ *
+ * logindex_init()
+ *  Builds the index from the current contents of the log
+ *
+ * logindex_add_record()
+ *  Adds a record to the log and updates the index
+ *
+ * logindex_clear()
+ *  Clears the log and the index
+ *
+ * logindex_sync()
+ *  Rebuilds the index if a record was added outside of logindex_add_record()
+ *
+ * logindex_get_count()
+ *  Returns the number of records of an event type
+ *
+ * logindex_get_last()
+ *  Returns the timestamp of the last record of an event type
+ *
+ * logindex_query()
+ *  Returns a bitmap of the records matching an event type and time range
+ *
+ * logindex_get_ms()
+ *  Returns the millisecond of the timestamp of a record
+ *
+ * logindex_get_added()
+ *  Returns the number of records added since startup
+ *
+ * clear_ms()
+ *  Forgets the milliseconds of all records
+ *
+ * shift_ms()
+ *  Moves the milliseconds down after the oldest record was overwritten
+ *
+ * stamp_ms()
+ *  Records the millisecond of a new record
+ */
+
+ #include "logindex.h"
+ #include "log.h"
+ #include "clock.h"
+
+ static unsigned int  event_mask[LOGINDEX_NUM_EVENTS];
+ static unsigned char event_count[LOGINDEX_NUM_EVENTS];
+ static unsigned long event_last[LOGINDEX_NUM_EVENTS];
+
+ /* the number of records and the newest record at the time the index was
+ * last updated.  Used by logindex_sync() to detect records that were
+ * added directly with log_add_record().
+ */
+ static unsigned char indexed_entries;
+ static unsigned long newest_time;
+ static unsigned char newest_event;
+
+ /* 1 while the record timestamps are in non-decreasing order (required by
+ * the binary search).  Cleared if the rtc was ever set backwards.
+ */
+ static unsigned char sorted;
+
+ /* number of records added since startup (wraps), for modules that
+ * forward new records
+ */
+ static unsigned int added;
+
+ /* millisecond of each record (LOGINDEX_NO_MS if not known) */
+ static unsigned int record_ms[LOG_CAPACITY];
+
+ /**********************************
+ * clear_ms()
+ *
+ * Forgets the milliseconds of all records
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  record_ms
+ */
+ static void clear_ms(){
+    unsigned char i;
+    for(i = 0; i < LOG_CAPACITY; i++){
+        record_ms[i] = LOGINDEX_NO_MS;
+    }
+ }
+
+ /**********************************
+ * shift_ms()
+ *
+ * Moves the milliseconds down one position after the oldest record of
+ * a full log was overwritten
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  record_ms
+ */
+ static void shift_ms(){
+    unsigned char i;
+    for(i = 1; i < LOG_CAPACITY; i++){
+        record_ms[i - 1] = record_ms[i];
+    }
+    record_ms[LOG_CAPACITY - 1] = LOGINDEX_NO_MS;
+ }
+
+ /**********************************
+ * stamp_ms()
+ *
+ * Records the current millisecond of the rtc for a record that was
+ * just added, if the rtc is still in the second of the record
+ *
+ * arguments:
+ *  pos - index of the record within the log
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  record_ms
+ */
+ static void stamp_ms(unsigned char pos){
+    unsigned long time;
+    unsigned char eventnum;
+    unsigned long sec;
+    unsigned int ms;
+
+    clock_read_rtc(&sec, &ms);
+    log_get_record(pos, &time, &eventnum);
+    record_ms[pos] = (sec == time) ? ms : LOGINDEX_NO_MS;
+ }
+
+ /**********************************
+ * index_record()
+ *
+ * Adds the log record at the specified position to the index
+ *
+ * arguments:
+ *  pos - index of the record within the log
+ *  time - timestamp of the record
+ *  eventnum - event type of the record
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  event_mask, event_count, event_last, newest_time, newest_event, sorted
+ */
+ static void index_record(unsigned char pos, unsigned long time, unsigned char eventnum){
+    if(pos > 0 && time < newest_time){
+        sorted = 0;
+    }
+    if(eventnum < LOGINDEX_NUM_EVENTS){
+        event_mask[eventnum] |= (1U << pos);
+        event_count[eventnum]++;
+        event_last[eventnum] = time;
+    }
+    newest_time = time;
+    newest_event = eventnum;
+ }
+
+ /**********************************
+ * reset_index()
+ *
+ * Empties the index
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  all index data
+ */
+ static void reset_index(){
+    unsigned char i;
+    for(i = 0; i < LOGINDEX_NUM_EVENTS; i++){
+        event_mask[i] = 0;
+        event_count[i] = 0;
+        event_last[i] = 0;
+    }
+    indexed_entries = 0;
+    newest_time = 0;
+    newest_event = EVENT_UNK;
+    sorted = 1;
+ }
+
+ /**********************************
+ * rebuild_index()
+ *
+ * Rebuilds the index by scanning the (in memory) log once
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  all index data
+ */
+ static void rebuild_index(){
+    unsigned char i;
+    unsigned long time;
+    unsigned char eventnum;
+
+    reset_index();
+    indexed_entries = log_get_num_entries();
+    for(i = 0; i < indexed_entries; i++){
+        log_get_record(i, &time, &eventnum);
+        index_record(i, time, eventnum);
+    }
+ }
+
+ /**********************************
+ * lower_bound()
+ *
+ * Binary search for the first log record with a timestamp
+ * greater than or equal to the specified time
+ *
+ * arguments:
+ *  time - the timestamp to search for
+ *
+ * returns:
+ *  index of the first matching record, or the number of records if none match
+ *
+ * changes:
+ *  none
+ */
+ static unsigned char lower_bound(unsigned long time){
+    unsigned char lo = 0;
+    unsigned char hi = indexed_entries;
+    unsigned long rec_time;
+    unsigned char eventnum;
+
+    while(lo < hi){
+        unsigned char mid = (lo + hi) >> 1;
+        log_get_record(mid, &rec_time, &eventnum);
+        if(rec_time < time){
+            lo = mid + 1;
+        }
+        else{
+            hi = mid;
+        }
+    }
+    return lo;
+ }
+
+ /**********************************
+ * range_mask()
+ *
+ * Returns a bitmap of the log records with timestamps within [from, to].
+ * Uses a binary search when the log is time ordered, otherwise a scan.
+ *
+ * arguments:
+ *  from - earliest timestamp to match
+ *  to - latest timestamp to match
+ *
+ * returns:
+ *  bitmap of matching record indexes
+ *
+ * changes:
+ *  none
+ */
+ static unsigned int range_mask(unsigned long from, unsigned long to){
+    unsigned char first;
+    unsigned char last;
+    unsigned int mask = 0;
+    unsigned long time;
+    unsigned char eventnum;
+    unsigned char i;
+
+    if(!sorted){
+        for(i = 0; i < indexed_entries; i++){
+            log_get_record(i, &time, &eventnum);
+            if(time >= from && time <= to){
+                mask |= (1U << i);
+            }
+        }
+        return mask;
+    }
+
+    first = lower_bound(from);
+    last = (to == 0xFFFFFFFFUL) ? indexed_entries : lower_bound(to + 1);
+    if(first >= last){
+        return 0;
+    }
+
+    /* bits first..last-1 */
+    mask = (last >= LOG_CAPACITY) ? 0xFFFF : ((1U << last) - 1);
+    return mask & ~((1U << first) - 1);
+ }
+
+ /**********************************
+ * logindex_init()
+ *
+ * Builds the index from the current contents of the log.
+ * Must be called after log_init().
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  all index data
+ */
+ void logindex_init(){
+    clear_ms();
+    rebuild_index();
+ }
+
+ /**********************************
+ * logindex_add_record()
+ *
+ * Adds a record to the log (via log_add_record()) and updates
+ * the index without rescanning the log.  When the log is full the
+ * oldest record is overwritten, so every bitmap shifts down by one
+ * position and the evicted record is removed from its count.  The new
+ * record is stamped with the current millisecond.
+ *
+ * arguments:
+ *  eventnum - event type of the new record
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  all index data
+ */
+ void logindex_add_record(unsigned char eventnum){
+    unsigned long time;
+    unsigned char oldest_event = EVENT_UNK;
+    unsigned char i;
+
+    logindex_sync();
+    if(indexed_entries > 0){
+        log_get_record(0, &time, &oldest_event);
+    }
+
+    log_add_record(eventnum);
+    added++;
+
+    if(log_get_num_entries() == indexed_entries){
+        /* the oldest record was overwritten */
+        for(i = 0; i < LOGINDEX_NUM_EVENTS; i++){
+            event_mask[i] >>= 1;
+        }
+        shift_ms();
+        if(oldest_event < LOGINDEX_NUM_EVENTS){
+            event_count[oldest_event]--;
+            if(event_count[oldest_event] == 0){
+                event_last[oldest_event] = 0;
+            }
+        }
+    }
+    else{
+        indexed_entries++;
+    }
+
+    log_get_record(indexed_entries - 1, &time, &eventnum);
+    index_record(indexed_entries - 1, time, eventnum);
+    stamp_ms(indexed_entries - 1);
+ }
+
+ /**********************************
+ * logindex_clear()
+ *
+ * Clears the log (via log_clear()) and resets the index
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  all index data
+ */
+ void logindex_clear(){
+    log_clear();
+    reset_index();
+    clear_ms();
+ }
+
+ /**********************************
+ * logindex_sync()
+ *
+ * Picks up records added directly with log_add_record() by the
+ * library modules (tempfsm alarms).  A change is detected by comparing
+ * the number of records and the newest record against the indexed
+ * values; the (rare) change is handled with a full rebuild.  The new
+ * records are stamped with the current millisecond (the library adds
+ * at most one record per tempfsm_update(), and this is called right
+ * after it).
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  all index data (if the log changed)
+ */
+ void logindex_sync(){
+    unsigned long time;
+    unsigned char eventnum;
+    unsigned char entries = log_get_num_entries();
+    unsigned char first;
+
+    if(entries > indexed_entries){
+        /* records were added */
+        added += entries - indexed_entries;
+        first = indexed_entries;
+    }
+    else if(entries < indexed_entries){
+        /* the log was cleared by the library */
+        clear_ms();
+        first = entries;
+    }
+    else if(entries > 0){
+        log_get_record(entries - 1, &time, &eventnum);
+        if(time == newest_time && eventnum == newest_event){
+            return;
+        }
+        /* a full log - at least one record was added */
+        added++;
+        shift_ms();
+        first = entries - 1;
+    }
+    else{
+        return;
+    }
+    rebuild_index();
+    while(first < entries){
+        stamp_ms(first++);
+    }
+ }
+
+ /**********************************
+ * logindex_get_count()
+ *
+ * Returns the number of records of the specified event type in the log
+ *
+ * arguments:
+ *  eventnum - event type
+ *
+ * returns:
+ *  number of records (0 for unknown event types)
+ *
+ * changes:
+ *  none
+ */
+ unsigned char logindex_get_count(unsigned char eventnum){
+    if(eventnum >= LOGINDEX_NUM_EVENTS){
+        return 0;
+    }
+    return event_count[eventnum];
+ }
+
+ /**********************************
+ * logindex_get_last()
+ *
+ * Returns the timestamp of the most recent record of the specified
+ * event type
+ *
+ * arguments:
+ *  eventnum - event type
+ *
+ * returns:
+ *  timestamp of the last record, or 0 if there is none in the log
+ *
+ * changes:
+ *  none
+ */
+ unsigned long logindex_get_last(unsigned char eventnum){
+    if(eventnum >= LOGINDEX_NUM_EVENTS){
+        return 0;
+    }
+    return event_last[eventnum];
+ }
+
+ /**********************************
+ * logindex_query()
+ *
+ * Returns a bitmap of the log record indexes (bit 0 = oldest) that match
+ * the specified event type and fall within [from, to]
+ *
+ * arguments:
+ *  eventnum - event type to match, or EVENT_UNK to match any event
+ *  from - earliest timestamp to match
+ *  to - latest timestamp to match
+ *
+ * returns:
+ *  bitmap of matching record indexes
+ *
+ * changes:
+ *  none
+ */
+ unsigned int logindex_query(unsigned char eventnum, unsigned long from, unsigned long to){
+    unsigned int mask;
+
+    if(eventnum != EVENT_UNK && eventnum >= LOGINDEX_NUM_EVENTS){
+        return 0;
+    }
+    if(from > to){
+        return 0;
+    }
+
+    mask = range_mask(from, to);
+    if(eventnum != EVENT_UNK){
+        mask &= event_mask[eventnum];
+    }
+    return mask;
+ }
+
+ /**********************************
+ * logindex_get_ms()
+ *
+ * Returns the milliseconds into the second of the timestamp of the
+ * specified log record
+ *
+ * arguments:
+ *  index - index of the log record (0 = oldest)
+ *
+ * returns:
+ *  the milliseconds (0-999), or LOGINDEX_NO_MS if not known
+ *
+ * changes:
+ *  none
+ */
+ unsigned int logindex_get_ms(unsigned char index){
+    if(index >= LOG_CAPACITY){
+        return LOGINDEX_NO_MS;
+    }
+    return record_ms[index];
+ }
+
+ /**********************************
+ * logindex_get_added()
+ *
+ * Returns the number of records added since startup, through
+ * logindex_add_record() or picked up by logindex_sync().  The newest
+ * records can be found by comparing with an earlier value.
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  the number of records (wraps at 65536)
+ *
+ * changes:
+ *  none
+ */
+ unsigned int logindex_get_added(){
+    return added;
+ }
@@ -0,0 +1,100 @@
+/********************************************************
+ * logindex.h
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file provides declarations for the event log index.
+ * The index keeps a per-event-type bitmap of log positions
+ * along with per-type counts and last-occurrence timestamps
+ * so that log queries do not have to scan or transfer the
+ * entire log.  It also keeps the millisecond of each record
+ * added since startup, which the log records (whole seconds)
+ * do not hold.
+ */
+
+#ifndef LOGINDEX_H_INCLUDED
+#define LOGINDEX_H_INCLUDED
+
+/* number of records held by the circular event log (one bit per record) */
+#define LOG_CAPACITY        16
+
+/* number of indexed event types (EVENT_STARTUP through EVENT_COMERROR) */
+#define LOGINDEX_NUM_EVENTS 11
+
+/* returned by logindex_get_ms() for records read from the eeprom */
+#define LOGINDEX_NO_MS      0xFFFF
+
+/**********************************
+ * logindex_init()
+ *
+ * Builds the index from the current contents of the log.
+ * Must be called after log_init().
+ */
+void logindex_init();
+
+/**********************************
+ * logindex_add_record()
+ *
+ * Adds a record to the log (via log_add_record()) and updates
+ * the index without rescanning the log.
+ */
+void logindex_add_record(unsigned char eventnum);
+
+/**********************************
+ * logindex_clear()
+ *
+ * Clears the log (via log_clear()) and resets the index
+ */
+void logindex_clear();
+
+/**********************************
+ * logindex_sync()
+ *
+ * Picks up records added directly with log_add_record() by the
+ * library modules (tempfsm alarms).  Call after tempfsm_update().
+ */
+void logindex_sync();
+
+/**********************************
+ * logindex_get_count()
+ *
+ * Returns the number of records of the specified event type in the log
+ */
+unsigned char logindex_get_count(unsigned char eventnum);
+
+/**********************************
+ * logindex_get_last()
+ *
+ * Returns the timestamp of the most recent record of the specified
+ * event type, or 0 if there is none in the log
+ */
+unsigned long logindex_get_last(unsigned char eventnum);
+
+/**********************************
+ * logindex_query()
+ *
+ * Returns a bitmap of the log record indexes (bit 0 = oldest) that match
+ * the specified event type and fall within [from, to].  Pass EVENT_UNK
+ * as the event type to match any event.
+ */
+unsigned int logindex_query(unsigned char eventnum, unsigned long from, unsigned long to);
+
+/**********************************
+ * logindex_get_ms()
+ *
+ * Returns the milliseconds into the second of the timestamp of the
+ * specified log record, or LOGINDEX_NO_MS if it is not known
+ */
+unsigned int logindex_get_ms(unsigned char index);
+
+/**********************************
+ * logindex_get_added()
+ *
+ * Returns the number of records added since startup (wraps).  The
+ * difference from an earlier value is the number of new records, which
+ * are the newest ones in the log.
+ */
+unsigned int logindex_get_added();
+
+#endif // LOGINDEX_H_INCLUDED
@@ -6,11 +6,12 @@
 * 
 * This file contains the main() method for the SER486 final project
 */
+#include <avr/pgmspace.h>
 #include "config.h"
 #include "delay.h"
-#include "dhcp.h"
 #include "led.h"
 #include "log.h"
+#include "logindex.h"
 #include "rtc.h"
 #include "spi.h"
 #include "uart.h"
@@ -21,16 +22,274 @@
 #include "wdt.h"
 #include "tempfsm.h"
 #include "eeprom.h"
-#include "ntp.h"
+#include "eecrc.h"
+#include "ntpclient.h"
 #include "w51.h"
 #include "signature.h"
 #include "httpparser.h"
+#include "netboot.h"
+#include "boottime.h"
+#include "sched.h"
+#include "latency.h"
+#include "crash.h"
+#include "netirq.h"
+#include "w5burst.h"
+#include "serial.h"
+#include "ulog.h"
+#include "stream.h"
+#include "modbus.h"
+#include "udpmux.h"
+#include "mqttsn.h"
+#include "coap.h"
+#include "fleet.h"
 
 #define HTTP_PORT       8080	/* TCP port for HTTP */
 #define SERVER_SOCKET   0
 
 int current_temperature = 75;
 
+/* scheduler task periods, deadlines and budgets (ms) */
+#define LED_PERIOD          10
+#define SAMPLE_PERIOD       1000
+#define SAMPLE_FIRST        5000
+#define FSM_DEADLINE        100
+#define HTTP_PERIOD         5
+#define HTTP_DEADLINE       1000
+#define NETWORK_PERIOD      50
+#define NETWORK_DEADLINE    1000
+#define EEPROM_PERIOD       20
+#define REPORT_PERIOD       60000
+#define REPORT_LINE_PERIOD  100
+#define STREAM_PERIOD       4
+#define MODBUS_PERIOD       10
+#define MODBUS_DEADLINE     1000
+#define UDP_PERIOD          5
+#define UDP_DEADLINE        100
+
+/* number of tasks added by main() - the table must hold them all */
+#define MAIN_TASKS          (8 + STREAM_ENABLE + MODBUS_ENABLE)
+#if MAIN_TASKS > SCHED_MAX_TASKS
+#error "the scheduler task table is too small for the tasks of main() - raise SCHED_MAX_TASKS"
+#endif
+
+/* the report is written a line at a time, each once the uart tx ring has
+* drained (a line takes about 100ms at 9600 baud)
+*/
+#define REPORT_LINE_ROOM    (SERIAL_TX_SIZE - 1)
+#define REPORT_IDLE         0xFF
+
+static unsigned char fsm_task;
+static unsigned char sample_task;
+static unsigned char http_closing;
+static unsigned int report_ticks;
+static unsigned char report_line = REPORT_IDLE;
+
+/**********************************
+ * task_led()
+ *
+ * update the LED blink state
+ */
+static void task_led(){
+    LATENCY_BEGIN(LAT_LED);
+    led_update();
+    LATENCY_END(LAT_LED);
+}
+
+/**********************************
+ * task_sample()
+ *
+ * update the current temperature from the temperature sensor, start
+ * the next conversion, queue the sample for MQTT-SN and release the
+ * fsm task.  The fleet sync beacons keep the releases of this task
+ * aligned with the other devices of the fleet.
+ */
+static void task_sample(){
+    /* read the temperature sensor */
+    LATENCY_BEGIN(LAT_SAMPLE);
+#if FLEET_ENABLE
+    fleet_mark_sample();
+#endif
+#if STREAM_ENABLE
+    if(stream_is_active()){
+        /* the ADC is converting every ms for the sample stream */
+        current_temperature = stream_get_temp();
+    }
+    else
+#endif
+    {
+        current_temperature = temp_get();
+        /* start the next conversion, which is read on the next release */
+        temp_start();
+    }
+    boottime_mark(BOOT_FIRST_SAMPLE);
+#if MQTTSN_ENABLE
+    mqttsn_sample(current_temperature);
+#endif
+    LATENCY_END(LAT_SAMPLE);
+    sched_trigger(fsm_task);
+}
+
+/**********************************
+ * task_fsm()
+ *
+ * update the temperature sensor finite state machine (which provides
+ * hysteresis) and send any temperature sensor alarms (from FSM update)
+ */
+static void task_fsm(){
+    LATENCY_BEGIN(LAT_FSM);
+    tempfsm_update(current_temperature,config.hi_alarm,config.hi_warn,config.lo_alarm,config.lo_warn);
+    LATENCY_END(LAT_FSM);
+    /* index any log records added by the fsm */
+    logindex_sync();
+}
+
+/**********************************
+ * task_http()
+ *
+ * keep the server socket listening and parse any received request.  The
+ * socket is only accessed when the Ethernet controller flagged a change
+ * (or while it is closing after a request)
+ */
+static void task_http(){
+    if(!netirq_check()){
+        return;
+    }
+    LATENCY_BEGIN(LAT_SOCKET);
+    /* if socket is closed, open it in passive (listen) mode */
+    if(socket_is_closed(SERVER_SOCKET)){
+        http_closing = 0;
+        CRASH_SOCKOP(SERVER_SOCKET, SOCKOP_OPEN);
+        socket_open(SERVER_SOCKET, HTTP_PORT);
+        CRASH_SOCKOP(SERVER_SOCKET, SOCKOP_LISTEN);
+        socket_listen(SERVER_SOCKET);
+        ULOG(ULOG_DEBUG, serial_writestr_P(PSTR("Socket is now open and listening\r\n")));
+        parser_state = WAIT;
+    }
+    else if(socket_is_active(SERVER_SOCKET)){
+        if(socket_is_established(SERVER_SOCKET)){
+            if(socket_received_line(SERVER_SOCKET)){
+                parser_state = ID_TYPE;
+                LATENCY_BEGIN(LAT_PARSE);
+                parse_http(SERVER_SOCKET);
+                LATENCY_END(LAT_PARSE);
+                boottime_mark(BOOT_FIRST_HTTP);
+                /* the parser disconnected - reopen once it is closed */
+                http_closing = 1;
+            }
+        }
+    }
+    if(http_closing){
+        netirq_request();
+    }
+    LATENCY_END(LAT_SOCKET);
+}
+
+/**********************************
+ * task_network()
+ *
+ * handle network time requests/replies (and slew the rtc), publish
+ * MQTT-SN telemetry, notify CoAP observers, run a step of the dhcp client
+ * and write back the lease cache, then send the queued alarms if the dhcp
+ * socket is free
+ */
+static void task_network(){
+    LATENCY_BEGIN(LAT_NETWORK);
+    ntpclient_update();
+#if MQTTSN_ENABLE
+    mqttsn_update();
+#endif
+#if COAP_ENABLE
+    coap_update();
+#endif
+    netboot_update();
+    alarm_update();
+    LATENCY_END(LAT_NETWORK);
+}
+
+/**********************************
+ * task_eeprom()
+ *
+ * update any pending config, log and crc record write backs
+ */
+static void task_eeprom(){
+    if (!eeprom_isbusy()) {
+        LATENCY_BEGIN(LAT_CONFIG);
+        config_update();
+        LATENCY_END(LAT_CONFIG);
+    }
+    if (!eeprom_isbusy()){
+        LATENCY_BEGIN(LAT_LOG);
+        log_update();
+        LATENCY_END(LAT_LOG);
+    }
+    if (!eeprom_isbusy()){
+        LATENCY_BEGIN(LAT_EECRC);
+        eecrc_update();
+        LATENCY_END(LAT_EECRC);
+    }
+}
+
+/**********************************
+ * task_report()
+ *
+ * write the scheduler and main loop latency statistics to the uart every
+ * REPORT_PERIOD, one line per run once there is room in the uart tx ring
+ * so that the report never waits for the uart
+ */
+static void task_report(){
+    unsigned char tasks = sched_get_num_tasks();
+    unsigned char written = 0;
+
+    if(++report_ticks >= REPORT_PERIOD / REPORT_LINE_PERIOD){
+        report_ticks = 0;
+        report_line = 0;
+    }
+    if(report_line == REPORT_IDLE || serial_get_tx_free() < REPORT_LINE_ROOM){
+        return;
+    }
+    ULOG(ULOG_INFO, written = (report_line < tasks) ?
+        sched_report_line(report_line) : LATENCY_REPORT_LINE(report_line - tasks));
+    report_line = written ? report_line + 1 : REPORT_IDLE;
+}
+
+#if STREAM_ENABLE
+/**********************************
+ * task_stream()
+ *
+ * start and stop the binary sample stream on STREAM_KEY and send the
+ * queued samples
+ */
+static void task_stream(){
+    stream_update();
+}
+#endif
+
+#if MODBUS_ENABLE
+/**********************************
+ * task_modbus()
+ *
+ * keep the Modbus/TCP server listening and answer any received requests
+ */
+static void task_modbus(){
+    modbus_update();
+}
+#endif
+
+/**********************************
+ * task_udp()
+ *
+ * read the datagrams of the shared udp socket (answering CoAP requests
+ * and fleet messages) and send a pending fleet reply once its delay has
+ * passed.  Run often so that the replies of a fleet stay spread over
+ * the window and sync beacons are timed to within UDP_PERIOD.
+ */
+static void task_udp(){
+    udpmux_update();
+#if FLEET_ENABLE
+    fleet_update();
+#endif
+}
+
 int main(void)
 {
 	/* Initialize the hardware devices*/
@@ -39,17 +298,25 @@ int main(void)
     led_init();
     vpd_init();
     log_init();
+    logindex_init();
     rtc_init();
+    eecrc_init();
+    crash_init();
     spi_init();
     temp_init();
     W5x_init();
+    w5burst_set_layout(W5_RX_PROFILE, W5_TX_PROFILE);
+#if W5_BENCH_ENABLE
+    w5burst_benchmark();
+#endif
     tempfsm_init();
+    alarm_init();
     httpparser_init();
 
 
-    uart_writestr("SER486 Final Project\r\n");
-    uart_writestr("Jesse Baker");
-    uart_writestr("\r\n");
+    serial_writestr_P(PSTR("SER486 Final Project\r\n"));
+    serial_writestr_P(PSTR("Jesse Baker"));
+    serial_writestr_P(PSTR("\r\n"));
 
 
     //this is intended to ensure that the socket is truely closed at startup
@@ -62,31 +329,39 @@ int main(void)
     /*Assignment signature*/
     signature_set("Jesse","Baker","jjbaker4");
 
-    /* configure the W51xx ethernet controller prior to DHCP */
-    unsigned char blank_addr[] = {0,0,0,0};
-    W5x_config(vpd.mac_address, blank_addr, blank_addr, blank_addr);
+    boottime_mark(BOOT_INIT_DONE);
 
-    /* loop until a dhcp address has been gotten */
-    while (!dhcp_start(vpd.mac_address, 60000UL, 4000UL)) {}
-    uart_writestr("local ip: ");uart_writeip(dhcp_getLocalIp());
+    /* configure the W51xx ethernet controller prior to DHCP (W5x_config()
+    * would reset the socket buffer layout)
+    */
+    unsigned char blank_addr[] = {0,0,0,0};
+    w5burst_config(vpd.mac_address, blank_addr, blank_addr, blank_addr);
 
-    /* configure the MAC, TCP, subnet and gateway addresses for the Ethernet controller*/
-    W5x_config(vpd.mac_address, dhcp_getLocalIp(), dhcp_getGatewayIp(), dhcp_getSubnetMask());
+    /* configure the MAC, TCP, subnet and gateway addresses for the Ethernet controller
+    * from the static ip, the cached dhcp lease or (if neither is available) dhcp
+    */
+    netboot_start();
+    boottime_mark(BOOT_NET_UP);
 
-	/* add a log record for EVENT_TIMESET prior to synchronizing with network time */
-	log_add_record(EVENT_TIMESET);
+    /* service the server socket on Ethernet controller interrupts */
+    netirq_init(SERVER_SOCKET);
 
-    /* synchronize with network time */
-    ntp_sync_network_time(5);
+    /* seed the rtc from the log and start synchronizing with network time in
+    * the background.  The ntp client logs EVENT_NEWTIME once the time has
+    * been synchronized.
+    */
+    ntpclient_init();
 
-    /* add a log record for EVENT_NEWTIME now that time has been synchronized */
-    log_add_record(EVENT_NEWTIME);
+	/* add a log record for EVENT_TIMESET prior to synchronizing with network time */
+	logindex_add_record(EVENT_TIMESET);
 
     /* start the watchdog timer */
     wdt_init();
 
-    /* log the EVENT STARTUP and send and ALARM to the Master Controller */
-    log_add_record(EVENT_STARTUP);
+    /* log the EVENT STARTUP and send and ALARM to the Master Controller
+    * (queued until the network task runs)
+    */
+    logindex_add_record(EVENT_STARTUP);
     alarm_send(EVENT_STARTUP);
 
     /* request start of test if 'T' key pressed - You may run up to 3 tests per
@@ -99,54 +374,38 @@ int main(void)
     * trigger any false alarms.
     */
     temp_start();
-    delay_set(1,5000);
 
+    /* start timing the main loop stages */
+    LATENCY_INIT();
+
+    /* periodic and event triggered tasks of the main loop (MAIN_TASKS,
+    * checked against SCHED_MAX_TASKS at build time)
+    */
+    sched_add(PSTR("led"), task_led, LED_PERIOD, 0, 0, 1);
+    sample_task = sched_add(PSTR("sample"), task_sample, SAMPLE_PERIOD, SAMPLE_FIRST, 0, 2);
+    fsm_task = sched_add(PSTR("fsm"), task_fsm, 0, 0, FSM_DEADLINE, 50);
+    sched_add(PSTR("http"), task_http, HTTP_PERIOD, 0, HTTP_DEADLINE, 500);
+    sched_add(PSTR("network"), task_network, NETWORK_PERIOD, 0, NETWORK_DEADLINE, 100);
+    sched_add(PSTR("eeprom"), task_eeprom, EEPROM_PERIOD, 0, 0, 5);
+    sched_add(PSTR("report"), task_report, REPORT_LINE_PERIOD, 0, 0, 5);
+#if STREAM_ENABLE
+    sched_add(PSTR("stream"), task_stream, STREAM_PERIOD, 0, 0, 5);
+#endif
+#if MODBUS_ENABLE
+    sched_add(PSTR("modbus"), task_modbus, MODBUS_PERIOD, 0, MODBUS_DEADLINE, 50);
+#endif
+    sched_add(PSTR("udp"), task_udp, UDP_PERIOD, 0, UDP_DEADLINE, 50);
+
+#if FLEET_ENABLE
+    /* align the samples to the fleet clock of the sync beacons */
+    fleet_sync_init(sample_task, SAMPLE_PERIOD);
+#endif
 
+    /* run the tasks - the scheduler resets the watchdog timer as long as
+    * every task meets its deadline
+    */
     while (1) {
-        /* reset  the watchdog timer every loop */
-        wdt_reset();
-
-        /* update the LED blink state */
-        led_update();
-
-        /* if the temperature sensor delay is done, update the current temperature
-        * from the temperature sensor, update the temperature sensor finite state
-        * machine (which provides hysteresis) and send any temperature sensor
-        * alarms (from FSM update).
-        */
-        if(delay_isdone(1)){
-            /* read the temperature sensor */
-            current_temperature = temp_get();
-            /* update the temperature fsm and send any alarms associated with it */
-            tempfsm_update(current_temperature,config.hi_alarm,config.hi_warn,config.lo_alarm,config.lo_warn);
-            /* restart the temperature sensor delay to trigger in 1 second */
-            temp_start();
-            delay_set(1,1000);
-        }
-        /*if the server socket is closed */
-            /* if socket is closed, open it in passive (listen) mode */
-        if(socket_is_closed(SERVER_SOCKET)){
-            socket_open(SERVER_SOCKET, HTTP_PORT);
-            socket_listen(SERVER_SOCKET);
-            uart_writestr("Socket is now open and listening\r\n");
-            parser_state = WAIT;
-        }
-        else if(socket_is_active(SERVER_SOCKET)){
-            if(socket_is_established(SERVER_SOCKET)){
-                if(socket_received_line(SERVER_SOCKET)){
-                    parser_state = ID_TYPE;
-                    parse_http(SERVER_SOCKET);
-                }
-            }
-        }
-        /* update any pending config write backs */
-        if (!eeprom_isbusy()) {
-            config_update();
-        }
-        /* update any pending log write backs */
-        if (!eeprom_isbusy()){
-            log_update();
-        }
+        sched_run();
     }
 	return 0;
 }
@@ -0,0 +1,404 @@
+/********************************************************
+ * modbus.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file implements the Modbus/TCP server declared in modbus.h.
+ * Requests are examined in place with a receive cursor, so a complete
+ * request is read from the W5100 in one burst and removed with a
+ * single RECV command, and the response is built in place over the
+ * request and sent with a single SEND command.
+ *
+ * The whole file is compiled out unless MODBUS_ENABLE is 1.
+ *
+ * Functions:
+ *
+ * modbus_update()
+ *  Keeps the server listening and answers received requests
+ *
+ * get16()
+ *  Reads a big endian 16-bit value
+ *
+ * put16()
+ *  Writes a big endian 16-bit value
+ *
+ * exception()
+ *  Builds an exception response
+ *
+ * input_register()
+ *  Returns the value of an input register
+ *
+ * read_registers()
+ *  Handles a read holding/input registers request
+ *
+ * write_registers()
+ *  Writes holding registers through the update functions
+ *
+ * handle_pdu()
+ *  Handles a request and builds the response
+ *
+ * handle_requests()
+ *  Answers the complete requests in the receive buffer
+ */
+
+ #include "modbus.h"
+ #include "socket.h"
+ #include "config.h"
+ #include "devapi.h"
+ #include "log.h"
+ #include "logindex.h"
+ #include "clock.h"
+ #include "devstate.h"
+
+ #if MODBUS_ENABLE
+
+ /* MBAP header - transaction id, protocol id (0), length of the rest of
+ * the frame and unit id
+ */
+ #define MBAP_SIZE           7
+ #define MBAP_LENGTH_MAX     254
+
+ /* function codes */
+ #define FC_READ_HOLDING     0x03
+ #define FC_READ_INPUT       0x04
+ #define FC_WRITE_SINGLE     0x06
+ #define FC_WRITE_MULTIPLE   0x10
+
+ /* exception codes */
+ #define EX_ILLEGAL_FUNCTION 0x01
+ #define EX_ILLEGAL_ADDRESS  0x02
+ #define EX_ILLEGAL_VALUE    0x03
+ #define EX_DEVICE_FAILURE   0x04
+
+ /* protocol limits on the register count of one request */
+ #define READ_COUNT_MAX      125
+ #define WRITE_COUNT_MAX     123
+
+ /* a request or response frame - large enough for a read of every input
+ * register, the longest frame that is answered (longer requests are
+ * only partially stored, and are rejected before their data is used)
+ */
+ #define PDU_SIZE            (2 + 2 * MODBUS_INPUT_COUNT)
+ #define ADU_SIZE            (MBAP_SIZE + PDU_SIZE)
+
+ /* the latest temperature sample (main.c) */
+ extern int current_temperature;
+
+ /* holding registers (in DEVICE_CONFIG_* order, devapi.h) */
+ static int *const holding[MODBUS_HOLDING_COUNT] = {
+    &config.hi_alarm, &config.hi_warn, &config.lo_alarm, &config.lo_warn
+ };
+
+ static unsigned long last_request;
+
+ /**********************************
+ * get16()
+ *
+ * Reads a big endian 16-bit value
+ *
+ * arguments:
+ *  p - the first byte
+ *
+ * returns:
+ *  the value
+ *
+ * changes:
+ *  none
+ */
+ static unsigned int get16(const unsigned char *p){
+    return ((unsigned int)p[0] << 8) | p[1];
+ }
+
+ /**********************************
+ * put16()
+ *
+ * Writes a big endian 16-bit value
+ *
+ * arguments:
+ *  p - the first byte
+ *  value - the value
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the 2 bytes at p
+ */
+ static void put16(unsigned char *p, unsigned int value){
+    p[0] = value >> 8;
+    p[1] = value;
+ }
+
+ /**********************************
+ * exception()
+ *
+ * Builds an exception response in place over the request
+ *
+ * arguments:
+ *  pdu - the request (function code first)
+ *  code - the exception code
+ *
+ * returns:
+ *  the length of the response
+ *
+ * changes:
+ *  the pdu
+ */
+ static unsigned char exception(unsigned char *pdu, unsigned char code){
+    pdu[0] |= 0x80;
+    pdu[1] = code;
+    return 2;
+ }
+
+ /**********************************
+ * input_register()
+ *
+ * Returns the value of an input register
+ *
+ * arguments:
+ *  reg - the register address (less than MODBUS_INPUT_COUNT)
+ *
+ * returns:
+ *  the value
+ *
+ * changes:
+ *  none
+ */
+ static unsigned int input_register(unsigned char reg){
+    switch(reg){
+    case MODBUS_IR_TEMPERATURE:
+        return current_temperature;
+    case MODBUS_IR_STATE:
+        return devstate_classify(current_temperature);
+    case MODBUS_IR_LOG_ENTRIES:
+        return log_get_num_entries();
+    default:
+        return logindex_get_count(reg - MODBUS_IR_EVENT_COUNT);
+    }
+ }
+
+ /**********************************
+ * read_registers()
+ *
+ * Handles a read holding registers or read input registers request
+ *
+ * arguments:
+ *  pdu - the request (function code first), replaced by the response
+ *  input - 1 for input registers, 0 for holding registers
+ *
+ * returns:
+ *  the length of the response
+ *
+ * changes:
+ *  the pdu
+ */
+ static unsigned char read_registers(unsigned char *pdu, unsigned char input){
+    unsigned int addr = get16(pdu + 1);
+    unsigned int count = get16(pdu + 3);
+    unsigned char limit = input ? MODBUS_INPUT_COUNT : MODBUS_HOLDING_COUNT;
+    unsigned char i;
+
+    if(count == 0 || count > READ_COUNT_MAX){
+        return exception(pdu, EX_ILLEGAL_VALUE);
+    }
+    if(addr >= limit || count > limit - addr){
+        return exception(pdu, EX_ILLEGAL_ADDRESS);
+    }
+    pdu[1] = count * 2;
+    for(i = 0; i < count; i++){
+        put16(pdu + 2 + 2 * i, input ? input_register(addr + i) : (unsigned int)*holding[addr + i]);
+    }
+    return 2 + count * 2;
+ }
+
+ /**********************************
+ * write_registers()
+ *
+ * Writes consecutive holding registers - the thresholds are set all
+ * together or not at all (devapi.c)
+ *
+ * arguments:
+ *  addr - the first register (the registers are within the map)
+ *  count - number of registers
+ *  data - the big endian register values
+ *
+ * returns:
+ *  0 if the registers were written, otherwise an exception code
+ *
+ * changes:
+ *  the config thresholds
+ */
+ static unsigned char write_registers(unsigned char addr, unsigned char count, const unsigned char *data){
+    int value[MODBUS_HOLDING_COUNT];
+    unsigned char i;
+
+    devapi_get_thresholds(value);
+    for(i = 0; i < count; i++){
+        value[addr + i] = (short)get16(data + 2 * i);
+    }
+    switch(devapi_set_thresholds(value)){
+    case DEVICE_SET_INVALID:
+        return EX_ILLEGAL_VALUE;
+    case DEVICE_SET_FAILED:
+        return EX_DEVICE_FAILURE;
+    default:
+        return 0;
+    }
+ }
+
+ /**********************************
+ * handle_pdu()
+ *
+ * Handles a request and builds the response in its place
+ *
+ * arguments:
+ *  pdu - the request (function code first), replaced by the response
+ *  len - length of the request (may exceed PDU_SIZE if it was truncated)
+ *
+ * returns:
+ *  the length of the response
+ *
+ * changes:
+ *  the pdu, the config thresholds
+ */
+ static unsigned char handle_pdu(unsigned char *pdu, unsigned char len){
+    unsigned int addr;
+    unsigned int count;
+    unsigned char code;
+
+    switch(pdu[0]){
+    case FC_READ_HOLDING:
+    case FC_READ_INPUT:
+        if(len != 5){
+            return exception(pdu, EX_ILLEGAL_VALUE);
+        }
+        return read_registers(pdu, pdu[0] == FC_READ_INPUT);
+    case FC_WRITE_SINGLE:
+        if(len != 5){
+            return exception(pdu, EX_ILLEGAL_VALUE);
+        }
+        addr = get16(pdu + 1);
+        if(addr >= MODBUS_HOLDING_COUNT){
+            return exception(pdu, EX_ILLEGAL_ADDRESS);
+        }
+        code = write_registers(addr, 1, pdu + 3);
+        /* the response echoes the request */
+        return code ? exception(pdu, code) : 5;
+    case FC_WRITE_MULTIPLE:
+        if(len < 6){
+            return exception(pdu, EX_ILLEGAL_VALUE);
+        }
+        addr = get16(pdu + 1);
+        count = get16(pdu + 3);
+        if(count == 0 || count > WRITE_COUNT_MAX || pdu[5] != count * 2 || len != 6 + count * 2){
+            return exception(pdu, EX_ILLEGAL_VALUE);
+        }
+        if(addr >= MODBUS_HOLDING_COUNT || count > MODBUS_HOLDING_COUNT - addr){
+            return exception(pdu, EX_ILLEGAL_ADDRESS);
+        }
+        code = write_registers(addr, count, pdu + 6);
+        /* the response is the address and count of the request */
+        return code ? exception(pdu, code) : 5;
+    default:
+        return exception(pdu, EX_ILLEGAL_FUNCTION);
+    }
+ }
+
+ /**********************************
+ * handle_requests()
+ *
+ * Answers every complete request in the receive buffer.  A frame that
+ * is not Modbus/TCP closes the connection, since the following frames
+ * cannot be found.
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  socket registers and buffers, the config thresholds
+ */
+ static void handle_requests(){
+    socket_cursor rx;
+    unsigned char adu[ADU_SIZE];
+    unsigned int length;
+    unsigned int i;
+    unsigned char len;
+    int b;
+
+    while(1){
+        socket_cursor_open(&rx, MODBUS_SOCKET);
+        for(i = 0; i < MBAP_SIZE; i++){
+            if((b = socket_cursor_get(&rx)) < 0){
+                return;
+            }
+            adu[i] = b;
+        }
+        length = get16(adu + 4);
+        if(get16(adu + 2) != 0 || length < 2 || length > MBAP_LENGTH_MAX){
+            socket_cursor_flush(&rx);
+            socket_disconnect(MODBUS_SOCKET);
+            return;
+        }
+        /* the length counts the unit id, which is part of the header */
+        len = length - 1;
+        for(i = 0; i < len; i++){
+            if((b = socket_cursor_get(&rx)) < 0){
+                return;
+            }
+            if(i < PDU_SIZE){
+                adu[MBAP_SIZE + i] = b;
+            }
+        }
+        socket_cursor_commit(&rx);
+        last_request = clock_ms();
+
+        len = handle_pdu(adu + MBAP_SIZE, len);
+        put16(adu + 4, len + 1);
+        socket_send(MODBUS_SOCKET, adu, MBAP_SIZE + len);
+    }
+ }
+
+ /**********************************
+ * modbus_update()
+ *
+ * Keeps the server socket listening, answers the received requests and
+ * closes connections that were closed by the client or have been idle
+ * for MODBUS_IDLE_MS
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  socket registers and buffers, the config thresholds
+ */
+ void modbus_update(){
+    if(socket_is_closed(MODBUS_SOCKET)){
+        socket_open(MODBUS_SOCKET, MODBUS_PORT);
+        socket_listen(MODBUS_SOCKET);
+        return;
+    }
+    if(socket_is_established(MODBUS_SOCKET)){
+        if(socket_recv_available(MODBUS_SOCKET) > 0){
+            handle_requests();
+        }
+        else if(clock_ms() - last_request >= MODBUS_IDLE_MS){
+            socket_disconnect(MODBUS_SOCKET);
+        }
+    }
+    else if(socket_is_listening(MODBUS_SOCKET)){
+        /* the idle time starts when a client connects */
+        last_request = clock_ms();
+    }
+    else if(!socket_is_active(MODBUS_SOCKET)){
+        socket_disconnect(MODBUS_SOCKET);
+    }
+ }
+
+ #endif // MODBUS_ENABLE
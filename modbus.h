@@ -0,0 +1,83 @@
+/********************************************************
+ * modbus.h
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file provides declarations for the Modbus/TCP server, which
+ * lets SCADA systems read the temperature, alarm state and log
+ * counters and change the alarm thresholds without an http gateway.
+ * One client is served at a time.
+ *
+ * Input registers (function 04, read only):
+ *
+ *  0       temperature
+ *  1       alarm state (DEVSTATE_*, devstate.h)
+ *  2       number of log entries
+ *  3-13    number of log records of each event type (EVENT_STARTUP
+ *          through EVENT_COMERROR)
+ *
+ * Holding registers (functions 03, 06 and 16):
+ *
+ *  0       tcrit_hi
+ *  1       twarn_hi
+ *  2       tcrit_lo
+ *  3       twarn_lo
+ *
+ * Temperatures are signed 16-bit values.  Writes are validated by the
+ * update_*() functions (util.h) - a write of several thresholds is
+ * applied completely or not at all.
+ *
+ * The server (and its task) are only built when MODBUS_ENABLE is
+ * defined as 1.
+ */
+
+#ifndef MODBUS_H_INCLUDED
+#define MODBUS_H_INCLUDED
+
+#ifndef MODBUS_ENABLE
+#define MODBUS_ENABLE 0
+#endif
+
+#include "logindex.h"
+
+/* TCP socket and port of the server.  No other module uses the socket
+ * (the alarms are sent on the dhcp socket, alarm.c) - only the W5100
+ * benchmark of a W5_BENCH_ENABLE build borrows it before the server
+ * starts.
+ */
+#define MODBUS_SOCKET       3
+#define MODBUS_PORT         502
+
+/* a connection without requests for this long is closed, so that a
+ * client that disappeared does not lock out the others
+ */
+#define MODBUS_IDLE_MS      60000UL
+
+/* register map */
+#define MODBUS_IR_TEMPERATURE   0
+#define MODBUS_IR_STATE         1
+#define MODBUS_IR_LOG_ENTRIES   2
+#define MODBUS_IR_EVENT_COUNT   3
+#define MODBUS_INPUT_COUNT      (MODBUS_IR_EVENT_COUNT + LOGINDEX_NUM_EVENTS)
+
+#define MODBUS_HR_TCRIT_HI      0
+#define MODBUS_HR_TWARN_HI      1
+#define MODBUS_HR_TCRIT_LO      2
+#define MODBUS_HR_TWARN_LO      3
+#define MODBUS_HOLDING_COUNT    4
+
+#if MODBUS_ENABLE
+
+/**********************************
+ * modbus_update()
+ *
+ * Keeps the server socket listening and answers every complete request
+ * that has been received.  Never waits for data.  Call from the main
+ * loop.
+ */
+void modbus_update();
+
+#endif // MODBUS_ENABLE
+
+#endif // MODBUS_H_INCLUDED
@@ -0,0 +1,624 @@
+/********************************************************
+ * mqttsn.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file implements the MQTT-SN (v1.2) telemetry publisher.  All of
+ * the work is done from mqttsn_update() in the main loop: the client
+ * never waits for a reply, it checks for the reply (handled by
+ * mqttsn_receive()) or a timeout on the next call.
+ *
+ * Only one QoS 1 message is outstanding at a time.  It is kept in
+ * inflight[] until the PUBACK arrives and is retransmitted (with the DUP
+ * flag) every MQTTSN_RETRY_MS.  A gateway that does not answer
+ * MQTTSN_MAX_RETRIES retransmissions (or keep alive pings) is considered
+ * lost, and the client reconnects with an exponential back off.  The
+ * outstanding message is sent again after reconnecting.
+ *
+ * The whole file is compiled out unless MQTTSN_ENABLE is 1.
+ *
+ * Functions:
+ *
+ * mqttsn_sample()
+ *  Queues a temperature sample for publishing
+ *
+ * mqttsn_update()
+ *  Connects, publishes and keeps the connection alive
+ *
+ * mqttsn_receive()
+ *  Handles a datagram from the gateway
+ *
+ * mqttsn_is_connected()
+ *  Returns 1 if connected to the gateway
+ *
+ * send_message()
+ *  Sends a message to the gateway
+ *
+ * send_connect()
+ *  Sends a CONNECT message
+ *
+ * send_ping()
+ *  Sends a PINGREQ message
+ *
+ * build_publish()
+ *  Builds a PUBLISH message
+ *
+ * publish_temperature()
+ *  Publishes the queued sample with QoS 0
+ *
+ * publish_qos1()
+ *  Publishes a message with QoS 1
+ *
+ * publish_next()
+ *  Publishes the next state change or log record with QoS 1
+ *
+ * connect_failed()
+ *  Schedules the next connect attempt after the back off
+ *
+ * gateway_lost()
+ *  Disconnects and schedules a reconnect
+ */
+
+ #include "mqttsn.h"
+ #include "udpmux.h"
+ #include "devstate.h"
+ #include "clock.h"
+ #include "log.h"
+ #include "logindex.h"
+ #include "vpd.h"
+ #include "fmt.h"
+ #include "serial.h"
+ #include "ulog.h"
+ #include <avr/pgmspace.h>
+
+ #if MQTTSN_ENABLE
+
+ /* message types */
+ #define MSG_CONNECT         0x04
+ #define MSG_CONNACK         0x05
+ #define MSG_PUBLISH         0x0C
+ #define MSG_PUBACK          0x0D
+ #define MSG_PINGREQ         0x16
+ #define MSG_PINGRESP        0x17
+ #define MSG_DISCONNECT      0x18
+
+ /* flags */
+ #define FLAG_DUP            0x80
+ #define FLAG_QOS1           0x20
+ #define FLAG_RETAIN         0x10
+ #define FLAG_CLEAN_SESSION  0x04
+ #define FLAG_TOPIC_PREDEF   0x01
+
+ #define PROTOCOL_ID         0x01
+ #define RC_ACCEPTED         0x00
+
+ /* PUBLISH header - length, type, flags, topic id, message id */
+ #define PUBLISH_HEADER      7
+
+ /* longest payload - an event record "255,4294967295.999" */
+ #define PAYLOAD_MAX         18
+ #define PUBLISH_MAX         (PUBLISH_HEADER + PAYLOAD_MAX)
+
+ /* longest client id sent (the vpd serial number) */
+ #define CLIENT_ID_MAX       11
+ #define CONNECT_MAX         (6 + CLIENT_ID_MAX)
+
+ #define MQTTSN_RETRY_MS     2000UL      /* time to wait for an answer */
+ #define MQTTSN_MAX_RETRIES  3           /* retransmissions before the gateway is lost */
+ #define MQTTSN_BACKOFF_MIN_MS   2000UL  /* first reconnect delay */
+ #define MQTTSN_BACKOFF_MAX_MS   64000UL /* longest reconnect delay */
+ #define MQTTSN_PING_MS      (MQTTSN_KEEPALIVE_S * 500UL)
+
+ /* state_published value that forces the state to be published */
+ #define STATE_NONE          0xFF
+
+ enum mqttsn_state {MQTTSN_DISCONNECTED, MQTTSN_CONNECTING, MQTTSN_CONNECTED};
+
+ mqttsn_stats_struct mqttsn_stats;
+
+ static const unsigned char gateway[4] = {192, 168, 1, 2};
+
+ static enum mqttsn_state state;
+ static unsigned long next_connect;
+ static unsigned long backoff = MQTTSN_BACKOFF_MIN_MS;
+ static unsigned long connect_sent;
+ static unsigned long last_rx;
+
+ /* keep alive ping outstanding, time sent and retransmissions */
+ static unsigned char ping_pending;
+ static unsigned long ping_sent;
+ static unsigned char ping_retries;
+
+ /* sample waiting to be published */
+ static unsigned char sampled;
+ static unsigned char sample_pending;
+ static int sample_temp;
+
+ /* outstanding QoS 1 message */
+ static unsigned char inflight[PUBLISH_MAX];
+ static unsigned char inflight_len;
+ static unsigned long inflight_sent;
+ static unsigned char inflight_retries;
+ static unsigned int next_msg_id;
+
+ /* last state queued and number of log records queued (compared with
+ * logindex_get_added())
+ */
+ static unsigned char state_published = STATE_NONE;
+ static unsigned int events_published;
+
+ /**********************************
+ * send_message()
+ *
+ * Sends a message to the gateway
+ *
+ * arguments:
+ *  msg - the message
+ *  len - its length
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  mqttsn_stats
+ */
+ static void send_message(const unsigned char *msg, unsigned char len){
+    if(udpmux_sendto(msg, len, gateway, MQTTSN_GATEWAY_PORT) == len){
+        mqttsn_stats.bytes_sent += len;
+    }
+ }
+
+ /**********************************
+ * send_connect()
+ *
+ * Sends a CONNECT message (clean session) with the vpd serial number as
+ * the client id
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  state, connect_sent
+ */
+ static void send_connect(){
+    unsigned char msg[CONNECT_MAX];
+    unsigned char len = 6;
+
+    while(len < CONNECT_MAX && vpd.serial_number[len - 6] != 0){
+        msg[len] = vpd.serial_number[len - 6];
+        len++;
+    }
+    msg[0] = len;
+    msg[1] = MSG_CONNECT;
+    msg[2] = FLAG_CLEAN_SESSION;
+    msg[3] = PROTOCOL_ID;
+    msg[4] = MQTTSN_KEEPALIVE_S >> 8;
+    msg[5] = MQTTSN_KEEPALIVE_S & 0xFF;
+    send_message(msg, len);
+    connect_sent = clock_ms();
+    state = MQTTSN_CONNECTING;
+ }
+
+ /**********************************
+ * send_ping()
+ *
+ * Sends a PINGREQ message
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  ping_pending, ping_sent
+ */
+ static void send_ping(){
+    unsigned char msg[2];
+
+    msg[0] = 2;
+    msg[1] = MSG_PINGREQ;
+    send_message(msg, 2);
+    ping_pending = 1;
+    ping_sent = clock_ms();
+ }
+
+ /**********************************
+ * build_publish()
+ *
+ * Builds a PUBLISH message to a pre-defined topic
+ *
+ * arguments:
+ *  msg - where the message is placed (PUBLISH_MAX bytes)
+ *  flags - QoS and retain flags
+ *  topic - the topic id
+ *  msg_id - the message id (0 for QoS 0)
+ *  payload - the data
+ *  len - number of bytes of data (at most PAYLOAD_MAX)
+ *
+ * returns:
+ *  the length of the message
+ *
+ * changes:
+ *  msg
+ */
+ static unsigned char build_publish(unsigned char *msg, unsigned char flags, unsigned char topic,
+                                    unsigned int msg_id, const char *payload, unsigned char len){
+    unsigned char i;
+
+    msg[0] = PUBLISH_HEADER + len;
+    msg[1] = MSG_PUBLISH;
+    msg[2] = flags | FLAG_TOPIC_PREDEF;
+    msg[3] = 0;
+    msg[4] = topic;
+    msg[5] = msg_id >> 8;
+    msg[6] = msg_id & 0xFF;
+    for(i = 0; i < len; i++){
+        msg[PUBLISH_HEADER + i] = payload[i];
+    }
+    return PUBLISH_HEADER + len;
+ }
+
+ /**********************************
+ * publish_temperature()
+ *
+ * Publishes the queued sample with QoS 0
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  sample_pending, mqttsn_stats
+ */
+ static void publish_temperature(){
+    unsigned char msg[PUBLISH_MAX];
+    char payload[FMT_S32_SIZE];
+    unsigned char len = fmt_s32(payload, sample_temp);
+
+    send_message(msg, build_publish(msg, 0, MQTTSN_TOPIC_TEMPERATURE, 0, payload, len));
+    mqttsn_stats.published++;
+    sample_pending = 0;
+ }
+
+ /**********************************
+ * publish_qos1()
+ *
+ * Publishes a message with QoS 1 - the message is kept until it is
+ * acknowledged
+ *
+ * arguments:
+ *  flags - additional flags (FLAG_RETAIN)
+ *  topic - the topic id
+ *  payload - the data
+ *  len - number of bytes of data (at most PAYLOAD_MAX)
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  inflight, inflight_len, inflight_sent, inflight_retries, next_msg_id,
+ *  mqttsn_stats
+ */
+ static void publish_qos1(unsigned char flags, unsigned char topic, const char *payload, unsigned char len){
+    if(++next_msg_id == 0){
+        next_msg_id = 1;
+    }
+    inflight_len = build_publish(inflight, flags | FLAG_QOS1, topic, next_msg_id, payload, len);
+    inflight_retries = 0;
+    inflight_sent = clock_ms();
+    send_message(inflight, inflight_len);
+    mqttsn_stats.published++;
+ }
+
+ /**********************************
+ * publish_next()
+ *
+ * Publishes the state if it changed since it was last published,
+ * otherwise the oldest log record that has not been published.  Records
+ * that were pushed out of the log before they could be published are
+ * skipped.
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  state_published, events_published, inflight
+ */
+ static void publish_next(){
+    char payload[PAYLOAD_MAX];
+    unsigned char len;
+    unsigned char current;
+    unsigned int pending;
+    unsigned char entries;
+    unsigned long time;
+    unsigned int ms;
+    unsigned char eventnum;
+    const char *name;
+
+    if(sampled){
+        current = devstate_classify(sample_temp);
+        if(current != state_published){
+            name = devstate_name_P(current);
+            len = 0;
+            while((payload[len] = pgm_read_byte(name + len)) != 0){
+                len++;
+            }
+            publish_qos1(FLAG_RETAIN, MQTTSN_TOPIC_STATE, payload, len);
+            state_published = current;
+            return;
+        }
+    }
+
+    pending = logindex_get_added() - events_published;
+    if(pending == 0){
+        return;
+    }
+    entries = log_get_num_entries();
+    if(pending > entries){
+        events_published += pending - entries;
+        pending = entries;
+    }
+    if(pending == 0 || !log_get_record(entries - pending, &time, &eventnum)){
+        return;
+    }
+    len = fmt_u16(payload, eventnum);
+    payload[len++] = ',';
+    len += fmt_u32(payload + len, time);
+    ms = logindex_get_ms(entries - pending);
+    if(ms != LOGINDEX_NO_MS){
+        /* milliseconds as a 3 digit fraction of the timestamp */
+        payload[len++] = '.';
+        payload[len++] = '0' + ms / 100;
+        payload[len++] = '0' + ms / 10 % 10;
+        payload[len++] = '0' + ms % 10;
+    }
+    publish_qos1(0, MQTTSN_TOPIC_EVENT, payload, len);
+    events_published++;
+ }
+
+ /**********************************
+ * connect_failed()
+ *
+ * Schedules the next connect attempt after the back off (which doubles
+ * up to MQTTSN_BACKOFF_MAX_MS)
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  state, next_connect, backoff
+ */
+ static void connect_failed(){
+    state = MQTTSN_DISCONNECTED;
+    next_connect = clock_ms() + backoff;
+    if(backoff < MQTTSN_BACKOFF_MAX_MS){
+        backoff *= 2;
+    }
+ }
+
+ /**********************************
+ * gateway_lost()
+ *
+ * Disconnects from a gateway that stopped answering and schedules a
+ * reconnect.  The outstanding message is kept.
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  state, next_connect, mqttsn_stats
+ */
+ static void gateway_lost(){
+    mqttsn_stats.lost++;
+    state = MQTTSN_DISCONNECTED;
+    next_connect = clock_ms();
+    ULOG(ULOG_WARN, serial_writestr_P(PSTR("mqtt-sn: gateway lost\r\n")));
+ }
+
+ /**********************************
+ * mqttsn_sample()
+ *
+ * Queues a temperature sample for publishing (a sample that was not
+ * sent yet is replaced)
+ *
+ * arguments:
+ *  temp - the temperature
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  sampled, sample_pending, sample_temp
+ */
+ void mqttsn_sample(int temp){
+    sample_temp = temp;
+    sample_pending = 1;
+    sampled = 1;
+ }
+
+ /**********************************
+ * mqttsn_update()
+ *
+ * Connects (and reconnects with back off), publishes the queued sample,
+ * state changes and new log records, retransmits unacknowledged
+ * messages and keeps the connection alive.  Never waits for a reply.
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  state, the connection and publish state, mqttsn_stats
+ */
+ void mqttsn_update(){
+    unsigned long now = clock_ms();
+
+    switch(state){
+    case MQTTSN_DISCONNECTED:
+        if((long)(now - next_connect) >= 0){
+            send_connect();
+        }
+        break;
+    case MQTTSN_CONNECTING:
+        /* CONNACK is handled by mqttsn_receive() */
+        if(now - connect_sent >= MQTTSN_RETRY_MS){
+            connect_failed();
+        }
+        break;
+    case MQTTSN_CONNECTED:
+        /* keep alive - ping a gateway that has been quiet */
+        if(ping_pending){
+            if(now - ping_sent >= MQTTSN_RETRY_MS){
+                if(++ping_retries > MQTTSN_MAX_RETRIES){
+                    gateway_lost();
+                    return;
+                }
+                mqttsn_stats.retries++;
+                send_ping();
+            }
+        }
+        else if(now - last_rx >= MQTTSN_PING_MS){
+            ping_retries = 0;
+            send_ping();
+        }
+
+        if(inflight_len != 0){
+            if(now - inflight_sent >= MQTTSN_RETRY_MS){
+                if(++inflight_retries > MQTTSN_MAX_RETRIES){
+                    gateway_lost();
+                    return;
+                }
+                inflight[2] |= FLAG_DUP;
+                inflight_sent = now;
+                mqttsn_stats.retries++;
+                send_message(inflight, inflight_len);
+            }
+        }
+        else{
+            publish_next();
+        }
+
+        if(sample_pending){
+            publish_temperature();
+        }
+        break;
+    default:
+        state = MQTTSN_DISCONNECTED;
+        break;
+    }
+ }
+
+ /**********************************
+ * mqttsn_receive()
+ *
+ * Handles a datagram received from MQTTSN_GATEWAY_PORT.  Messages that
+ * are not from the gateway, or are not expected in the current state,
+ * are ignored.
+ *
+ * arguments:
+ *  msg - the received datagram
+ *  len - its length
+ *  addr - its source ip address
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  state, the connection and publish state, mqttsn_stats
+ */
+ void mqttsn_receive(const unsigned char *msg, unsigned int len, const unsigned char *addr){
+    unsigned char i;
+
+    for(i = 0; i < 4; i++){
+        if(addr[i] != gateway[i]){
+            return;
+        }
+    }
+    if(len < 2 || msg[0] != len || state == MQTTSN_DISCONNECTED){
+        return;
+    }
+    last_rx = clock_ms();
+
+    switch(msg[1]){
+    case MSG_CONNACK:
+        if(state != MQTTSN_CONNECTING || len < 3){
+            break;
+        }
+        if(msg[2] != RC_ACCEPTED){
+            connect_failed();
+            break;
+        }
+        state = MQTTSN_CONNECTED;
+        backoff = MQTTSN_BACKOFF_MIN_MS;
+        ping_pending = 0;
+        mqttsn_stats.connects++;
+        /* the retained state may have changed while disconnected */
+        state_published = STATE_NONE;
+        if(inflight_len != 0){
+            inflight_retries = 0;
+            inflight_sent = last_rx;
+            send_message(inflight, inflight_len);
+        }
+        ULOG(ULOG_INFO, serial_writestr_P(PSTR("mqtt-sn: connected\r\n")));
+        break;
+    case MSG_PUBACK:
+        if(len < 7 || inflight_len == 0 || msg[4] != inflight[5] || msg[5] != inflight[6]){
+            break;
+        }
+        if(msg[6] == RC_ACCEPTED){
+            mqttsn_stats.acked++;
+        }
+        else{
+            mqttsn_stats.rejected++;
+        }
+        inflight_len = 0;
+        break;
+    case MSG_PINGRESP:
+        ping_pending = 0;
+        break;
+    case MSG_DISCONNECT:
+        state = MQTTSN_DISCONNECTED;
+        next_connect = last_rx + backoff;
+        break;
+    default:
+        break;
+    }
+ }
+
+ /**********************************
+ * mqttsn_is_connected()
+ *
+ * Returns 1 if connected to the gateway
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  1 if connected, otherwise 0
+ *
+ * changes:
+ *  none
+ */
+ unsigned char mqttsn_is_connected(){
+    return state == MQTTSN_CONNECTED;
+ }
+
+ #endif // MQTTSN_ENABLE
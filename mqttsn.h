@@ -0,0 +1,100 @@
+/********************************************************
+ * mqttsn.h
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file provides declarations for the MQTT-SN (v1.2) telemetry
+ * publisher, which feeds the broker through an MQTT-SN gateway over udp
+ * instead of the broker polling GET /device.  Topics are pre-defined
+ * (topic id type 01) so that no REGISTER exchange is needed - the
+ * gateway maps the ids to topic names for this client id (the vpd
+ * serial number):
+ *
+ *  MQTTSN_TOPIC_TEMPERATURE  QoS 0, every sample   "75"
+ *  MQTTSN_TOPIC_STATE        QoS 1, retained       "WARN_HI"
+ *  MQTTSN_TOPIC_EVENT        QoS 1, each log record "5,1234567.250"
+ *                            (event number, timestamp - with the
+ *                            milliseconds when they are known)
+ *
+ * The state topic carries the latest state - transitions that happen
+ * while a publish is unacknowledged are merged, the complete history
+ * is in the event topic.  Log records added while the gateway is
+ * unreachable are published after reconnecting (as long as they are
+ * still in the log).
+ *
+ * The publisher takes about 2.7K of flash, so it is only built when
+ * MQTTSN_ENABLE is defined as 1.
+ */
+
+#ifndef MQTTSN_H_INCLUDED
+#define MQTTSN_H_INCLUDED
+
+#ifndef MQTTSN_ENABLE
+#define MQTTSN_ENABLE 0
+#endif
+
+/* gateway port (the client sends from the shared udp socket, udpmux.h) */
+#define MQTTSN_GATEWAY_PORT     10000
+
+/* pre-defined topic ids */
+#define MQTTSN_TOPIC_TEMPERATURE    1
+#define MQTTSN_TOPIC_STATE          2
+#define MQTTSN_TOPIC_EVENT          3
+
+/* keep alive duration sent in CONNECT (s).  The gateway is pinged once
+* nothing has been received from it for half of this time.
+*/
+#define MQTTSN_KEEPALIVE_S      60
+
+#if MQTTSN_ENABLE
+
+typedef struct {
+    unsigned int  connects;    /* number of accepted CONNECTs */
+    unsigned int  lost;        /* number of times the gateway stopped answering */
+    unsigned long published;   /* number of PUBLISH messages sent (not retries) */
+    unsigned int  acked;       /* number of QoS 1 messages acknowledged */
+    unsigned int  rejected;    /* number of QoS 1 messages rejected by the gateway */
+    unsigned int  retries;     /* number of retransmissions */
+    unsigned long bytes_sent;  /* MQTT-SN bytes sent (without udp/ip headers) */
+} mqttsn_stats_struct;
+
+/* statistics of the publisher */
+extern mqttsn_stats_struct mqttsn_stats;
+
+/**********************************
+ * mqttsn_sample()
+ *
+ * Queues a temperature sample for publishing.  Does not access the
+ * network, so it can be called from the sample task.
+ */
+void mqttsn_sample(int temp);
+
+/**********************************
+ * mqttsn_update()
+ *
+ * Connects (and reconnects with back off), publishes the queued sample,
+ * state changes and new log records, retransmits unacknowledged
+ * messages and keeps the connection alive.  Never waits for a reply.
+ * Call from the main loop after udpmux_update().
+ */
+void mqttsn_update();
+
+/**********************************
+ * mqttsn_receive()
+ *
+ * Handles a datagram received from MQTTSN_GATEWAY_PORT (called by
+ * udpmux_update())
+ */
+void mqttsn_receive(const unsigned char *msg, unsigned int len, const unsigned char *addr);
+
+/**********************************
+ * mqttsn_is_connected()
+ *
+ * Returns 1 if connected to the gateway, otherwise 0
+ */
+unsigned char mqttsn_is_connected();
+
+#endif // MQTTSN_ENABLE
+
+#endif // MQTTSN_H_INCLUDED
@@ -0,0 +1,843 @@
+/********************************************************
+ * netboot.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file implements the network startup path and the dhcp lease
+ * upkeep.  Waiting for dhcp at every boot keeps the device dark for tens
+ * of seconds, and after a site wide power loss every device hits the dhcp
+ * server at the same moment.  Instead, the device uses its static ip when
+ * one is configured, or reuses the last lease (cached in the eeprom) and
+ * confirms it with the dhcp server from the main loop.  The first attempt
+ * is delayed by a per-device offset derived from the mac address, so that
+ * devices restarting together do not all query the server at once.
+ *
+ * Once the boot is complete the lease is kept by a non-blocking dhcp
+ * client (RFC 2131) driven from netboot_update(): each call either sends
+ * one message or reads at most one reply, so the main loop never waits on
+ * the server.  A cached lease is confirmed with an INIT-REBOOT request.
+ * A bound lease is renewed with its server at T1 and with any server at
+ * T2; a refused or expired lease starts a new discovery.  The address in
+ * use is kept until a new lease is bound, since the device has no other
+ * address to fall back to.  The dhcp socket is only open during an
+ * exchange, so that the alarms can use it in between (see alarm.c).
+ *
+ * Functions:
+ *
+ * netboot_start()
+ *  Configures the Ethernet controller addresses
+ *
+ * netboot_update()
+ *  Runs the dhcp client and writes back the lease cache
+ *
+ * copy_ip()
+ *  Copies an ip address
+ *
+ * read_cache()
+ *  Reads and validates the cached lease
+ *
+ * store_lease()
+ *  Copies a lease into the cache
+ *
+ * apply_lease()
+ *  Configures the Ethernet controller with the lease in memory
+ *
+ * send_zeros()
+ *  Adds zero bytes to the dhcp message
+ *
+ * send_option()
+ *  Adds an option to the dhcp message
+ *
+ * send_message()
+ *  Sends a dhcp DISCOVER or REQUEST
+ *
+ * start_exchange()
+ *  Sends the message for the current state
+ *
+ * end_exchange()
+ *  Closes the dhcp socket and schedules the next attempt
+ *
+ * read_reply()
+ *  Reads part of a dhcp reply
+ *
+ * receive_reply()
+ *  Reads and parses one dhcp reply
+ *
+ * bind_lease()
+ *  Applies an acknowledged lease and schedules its renewal
+ *
+ * check_timers()
+ *  Moves to the renewing, rebinding or selecting state when due
+ *
+ * netboot_get_ip()
+ *  Returns the configured ip address
+ */
+
+ #include <string.h>
+ #include <avr/pgmspace.h>
+ #include "netboot.h"
+ #include "config.h"
+ #include "vpd.h"
+ #include "dhcp.h"
+ #include "w5burst.h"
+ #include "socket.h"
+ #include "clock.h"
+ #include "eeprom.h"
+ #include "crc16.h"
+ #include "fmt.h"
+ #include "uart.h"
+ #include "serial.h"
+ #include "ulog.h"
+ #include "crash.h"
+
+ /* socket and ports used for dhcp (shared with the alarms between exchanges) */
+ #define DHCP_SOCKET             NETBOOT_SOCKET
+ #define DHCP_SERVER_PORT        67
+ #define DHCP_CLIENT_PORT        68
+
+ /* time to wait for a reply before the attempt counts as failed */
+ #define DHCP_RESPONSE_MS        2000UL
+
+ /* window over which the first attempts are spread */
+ #define REVALIDATE_SPREAD_MS    30000U
+
+ /* retry interval after a failed attempt (doubles up to the maximum) */
+ #define RETRY_MIN_MS            10000UL
+ #define RETRY_MAX_MS            300000UL
+
+ /* lease times are clamped so that uptime + time cannot wrap */
+ #define LEASE_MAX_S             0x7FFFFFFFUL
+
+ /* message layout (RFC 2131) */
+ #define DHCP_FIXED_SIZE         236
+ #define DHCP_MIN_SIZE           300
+ #define DHCP_BOOTREQUEST        1
+ #define DHCP_BOOTREPLY          2
+ #define DHCP_FLAG_BROADCAST     0x80
+
+ /* message types */
+ #define DHCPDISCOVER            1
+ #define DHCPOFFER               2
+ #define DHCPREQUEST             3
+ #define DHCPACK                 5
+ #define DHCPNAK                 6
+
+ /* options */
+ #define OPT_PAD                 0
+ #define OPT_SUBNET              1
+ #define OPT_ROUTER              3
+ #define OPT_HOSTNAME            12
+ #define OPT_REQUESTED_IP        50
+ #define OPT_LEASE_TIME          51
+ #define OPT_MESSAGE_TYPE        53
+ #define OPT_SERVER_ID           54
+ #define OPT_PARAMS              55
+ #define OPT_T1                  58
+ #define OPT_T2                  59
+ #define OPT_CLIENT_ID           61
+ #define OPT_END                 255
+
+ /* dhcp client states */
+ enum dhcp_state {
+    DHCP_OFF,           /* static ip - no dhcp */
+    DHCP_BOUND,         /* lease bound, waiting for T1 */
+    DHCP_REBOOTING,     /* confirming a cached lease (INIT-REBOOT) */
+    DHCP_SELECTING,     /* looking for a server (DISCOVER) */
+    DHCP_REQUESTING,    /* requesting an offered address */
+    DHCP_RENEWING,      /* renewing with the server that granted the lease */
+    DHCP_REBINDING      /* renewing with any server */
+ };
+
+ typedef struct {
+    char          token[4];
+    unsigned char ip[4];
+    unsigned char gateway[4];
+    unsigned char subnet[4];
+    unsigned int  crc;
+ } lease_struct;
+
+ /* fields of a reply that are used */
+ typedef struct {
+    unsigned char type;
+    unsigned char ip[4];
+    unsigned char gateway[4];
+    unsigned char subnet[4];
+    unsigned char server[4];
+    unsigned long lease_time;
+    unsigned long t1;
+    unsigned long t2;
+ } reply_struct;
+
+ static lease_struct lease;
+ static unsigned char cache_modified;
+
+ static unsigned char state = DHCP_OFF;
+ static unsigned char waiting;
+ static unsigned long xid;
+ static unsigned char server_ip[4];
+ static unsigned char offer_ip[4];
+ static unsigned long reply_deadline;
+ static unsigned int  reply_left;
+ static unsigned long next_attempt;
+ static unsigned long retry_interval;
+ static unsigned long renew_at;
+ static unsigned long rebind_at;
+ static unsigned long expire_at;
+
+ /**********************************
+ * copy_ip()
+ *
+ * Copies a 4 byte ip address
+ *
+ * arguments:
+ *  dst - destination address
+ *  src - source address
+ *
+ * returns:
+ *  1 if the destination was changed, otherwise 0
+ *
+ * changes:
+ *  dst
+ */
+ static int copy_ip(unsigned char *dst, const unsigned char *src){
+    unsigned char i;
+    int changed = 0;
+    for(i = 0; i < 4; i++){
+        if(dst[i] != src[i]){
+            dst[i] = src[i];
+            changed = 1;
+        }
+    }
+    return changed;
+ }
+
+ /**********************************
+ * read_cache()
+ *
+ * Reads the cached lease from the eeprom and validates it
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  1 if a valid lease was cached, otherwise 0
+ *
+ * changes:
+ *  lease
+ */
+ static int read_cache(){
+    while(eeprom_isbusy()){}
+    eeprom_readbuf(NETBOOT_EEPROM_ADDR, (unsigned char*)&lease, sizeof(lease));
+    if(lease.token[0] != 'L' || lease.token[1] != 'E' || lease.token[2] != 'A' || lease.token[3] != 'S'){
+        return 0;
+    }
+    return crc16((unsigned char*)&lease, sizeof(lease) - sizeof(lease.crc)) == lease.crc;
+ }
+
+ /**********************************
+ * store_lease()
+ *
+ * Copies a lease into the cache and marks the cache for write back if it
+ * changed
+ *
+ * arguments:
+ *  ip - the leased address
+ *  gateway - the gateway address
+ *  subnet - the subnet mask
+ *
+ * returns:
+ *  1 if the lease changed, otherwise 0
+ *
+ * changes:
+ *  lease, cache_modified
+ */
+ static int store_lease(const unsigned char *ip, const unsigned char *gateway, const unsigned char *subnet){
+    int changed = 0;
+    changed |= copy_ip(lease.ip, ip);
+    changed |= copy_ip(lease.gateway, gateway);
+    changed |= copy_ip(lease.subnet, subnet);
+    if(changed){
+        lease.token[0] = 'L';
+        lease.token[1] = 'E';
+        lease.token[2] = 'A';
+        lease.token[3] = 'S';
+        lease.crc = crc16((unsigned char*)&lease, sizeof(lease) - sizeof(lease.crc));
+        cache_modified = 1;
+    }
+    return changed;
+ }
+
+ /**********************************
+ * apply_lease()
+ *
+ * Configures the Ethernet controller with the lease in memory (keeping
+ * the socket buffer layout) and writes the address to the uart
+ *
+ * arguments:
+ *  how - the message before the address, describing where the lease
+ *        came from (in program memory)
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  none
+ */
+ static void apply_lease(const char *how){
+    char ip[FMT_IP_SIZE];
+
+    w5burst_config(vpd.mac_address, lease.ip, lease.gateway, lease.subnet);
+    fmt_ip(ip, lease.ip);
+    ulog_str(ULOG_INFO, how, ip);
+ }
+
+ /**********************************
+ * send_zeros()
+ *
+ * Adds zero bytes to the dhcp message being built
+ *
+ * arguments:
+ *  len - number of bytes
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the dhcp socket transmit buffer
+ */
+ static void send_zeros(unsigned int len){
+    unsigned char zeros[16] = {0};
+    unsigned int n;
+
+    while(len > 0){
+        n = (len > sizeof(zeros)) ? sizeof(zeros) : len;
+        socket_send(DHCP_SOCKET, zeros, n);
+        len -= n;
+    }
+ }
+
+ /**********************************
+ * send_option()
+ *
+ * Adds an option to the dhcp message being built
+ *
+ * arguments:
+ *  code - the option code
+ *  value - the option value
+ *  len - number of bytes of value
+ *
+ * returns:
+ *  the number of bytes added
+ *
+ * changes:
+ *  the dhcp socket transmit buffer
+ */
+ static unsigned char send_option(unsigned char code, const unsigned char *value, unsigned char len){
+    unsigned char head[2];
+
+    head[0] = code;
+    head[1] = len;
+    socket_send(DHCP_SOCKET, head, 2);
+    socket_send(DHCP_SOCKET, value, len);
+    return len + 2;
+ }
+
+ /**********************************
+ * send_message()
+ *
+ * Sends a dhcp DISCOVER or REQUEST for the current state.  The options
+ * match the library client (client id, host name and parameter list),
+ * so the server sees the same client before and after the boot.
+ *
+ * arguments:
+ *  type - DHCPDISCOVER or DHCPREQUEST
+ *
+ * returns:
+ *  1 if the message was sent, otherwise 0
+ *
+ * changes:
+ *  the dhcp socket registers and transmit buffer
+ */
+ static int send_message(unsigned char type){
+    static const unsigned char broadcast_ip[4] = {255, 255, 255, 255};
+    static const unsigned char params[6] = {OPT_SUBNET, OPT_ROUTER, 6, 15, OPT_T1, OPT_T2};
+    static const unsigned char cookie[4] = {99, 130, 83, 99};
+    unsigned char buf[12];
+    unsigned char renewing = (state == DHCP_RENEWING || state == DHCP_REBINDING);
+    unsigned int size = DHCP_FIXED_SIZE + sizeof(cookie);
+
+    /* renewals are unicast to the server that granted the lease */
+    if(!udpsocket_start_datagram(DHCP_SOCKET,
+            (unsigned char*)((state == DHCP_RENEWING) ? server_ip : broadcast_ip), DHCP_SERVER_PORT)){
+        return 0;
+    }
+
+    /* op, htype, hlen, hops, xid, secs, flags */
+    buf[0] = DHCP_BOOTREQUEST;
+    buf[1] = 1;
+    buf[2] = 6;
+    buf[3] = 0;
+    buf[4] = xid >> 24;
+    buf[5] = xid >> 16;
+    buf[6] = xid >> 8;
+    buf[7] = xid;
+    buf[8] = 0;
+    buf[9] = 0;
+    buf[10] = renewing ? 0 : DHCP_FLAG_BROADCAST;
+    buf[11] = 0;
+    socket_send(DHCP_SOCKET, buf, 12);
+
+    /* ciaddr (only when renewing), yiaddr, siaddr, giaddr, chaddr */
+    if(renewing){
+        socket_send(DHCP_SOCKET, lease.ip, 4);
+    }
+    else{
+        send_zeros(4);
+    }
+    send_zeros(12);
+    socket_send(DHCP_SOCKET, vpd.mac_address, 6);
+
+    /* rest of chaddr, sname and file */
+    send_zeros(DHCP_FIXED_SIZE - 34);
+    socket_send(DHCP_SOCKET, cookie, sizeof(cookie));
+
+    buf[0] = type;
+    size += send_option(OPT_MESSAGE_TYPE, buf, 1);
+    buf[0] = 1;
+    memcpy(&buf[1], vpd.mac_address, 6);
+    size += send_option(OPT_CLIENT_ID, buf, 7);
+    memcpy(buf, "WIZnet", 6);
+    fmt_hex8((char*)&buf[6], vpd.mac_address[3]);
+    fmt_hex8((char*)&buf[8], vpd.mac_address[4]);
+    fmt_hex8((char*)&buf[10], vpd.mac_address[5]);
+    size += send_option(OPT_HOSTNAME, buf, 12);
+    if(state == DHCP_REBOOTING){
+        size += send_option(OPT_REQUESTED_IP, lease.ip, 4);
+    }
+    else if(state == DHCP_REQUESTING){
+        size += send_option(OPT_REQUESTED_IP, offer_ip, 4);
+        size += send_option(OPT_SERVER_ID, server_ip, 4);
+    }
+    size += send_option(OPT_PARAMS, params, sizeof(params));
+    buf[0] = OPT_END;
+    socket_send(DHCP_SOCKET, buf, 1);
+    size++;
+
+    /* pad to the minimum BOOTP message size */
+    if(size < DHCP_MIN_SIZE){
+        send_zeros(DHCP_MIN_SIZE - size);
+    }
+    CRASH_SOCKOP(DHCP_SOCKET, SOCKOP_DHCP);
+    return udpsocket_send_datagram(DHCP_SOCKET);
+ }
+
+ /**********************************
+ * start_exchange()
+ *
+ * Opens the dhcp socket (unless an exchange is in progress) and sends the
+ * message for the current state.  A new transaction id is used unless an
+ * offer is being requested.
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  xid, waiting, reply_deadline, the dhcp socket
+ */
+ static void start_exchange(){
+    if(!waiting){
+        CRASH_SOCKOP(DHCP_SOCKET, SOCKOP_OPEN);
+        udpsocket_open(DHCP_SOCKET, DHCP_CLIENT_PORT);
+    }
+    if(state != DHCP_REQUESTING){
+        xid += clock_ms() | 1;
+    }
+    send_message((state == DHCP_SELECTING) ? DHCPDISCOVER : DHCPREQUEST);
+    waiting = 1;
+    reply_deadline = clock_ms() + DHCP_RESPONSE_MS;
+ }
+
+ /**********************************
+ * end_exchange()
+ *
+ * Closes the dhcp socket and schedules the next attempt
+ *
+ * arguments:
+ *  delay - time until the next attempt (ms)
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  waiting, next_attempt, the dhcp socket
+ */
+ static void end_exchange(unsigned long delay){
+    udpsocket_close(DHCP_SOCKET);
+    waiting = 0;
+    next_attempt = clock_ms() + delay;
+ }
+
+ /**********************************
+ * read_reply()
+ *
+ * Reads the next bytes of the reply being parsed.  Bytes past the end
+ * of the reply read as zero.
+ *
+ * arguments:
+ *  buf - where the bytes are placed (NULL to skip them)
+ *  len - number of bytes
+ *
+ * returns:
+ *  1 if all the bytes were in the reply, otherwise 0
+ *
+ * changes:
+ *  buf, reply_left, the dhcp socket receive buffer
+ */
+ static int read_reply(unsigned char *buf, unsigned int len){
+    unsigned char skip[16];
+    unsigned int n;
+    int complete = (len <= reply_left);
+
+    while(len > 0){
+        n = (len > sizeof(skip)) ? sizeof(skip) : len;
+        if(n > reply_left){
+            n = reply_left;
+        }
+        if(n == 0){
+            if(buf){
+                memset(buf, 0, len);
+            }
+            break;
+        }
+        udpsocket_recv_data(DHCP_SOCKET, buf ? buf : skip, n);
+        reply_left -= n;
+        len -= n;
+        if(buf){
+            buf += n;
+        }
+    }
+    return complete;
+ }
+
+ /**********************************
+ * receive_reply()
+ *
+ * Reads one datagram from the dhcp socket and parses it as a reply to
+ * the current transaction.  The reply is read in small pieces straight
+ * from the W5100, so no message buffer is needed.
+ *
+ * arguments:
+ *  reply - where the parsed fields are placed
+ *
+ * returns:
+ *  1 if the datagram is a reply for this device, otherwise 0
+ *
+ * changes:
+ *  reply, the dhcp socket receive buffer
+ */
+ static int receive_reply(reply_struct *reply){
+    unsigned char buf[8];
+    unsigned char code;
+    unsigned char len;
+    int valid;
+
+    /* udp header: source address, source port, length */
+    if(udpsocket_recv_available(DHCP_SOCKET) < 8){
+        return 0;
+    }
+    udpsocket_recv_data(DHCP_SOCKET, buf, 8);
+    reply_left = ((unsigned int)buf[6] << 8) | buf[7];
+
+    /* op, htype, hlen, hops and xid */
+    valid = read_reply(buf, 8) && buf[0] == DHCP_BOOTREPLY &&
+            buf[4] == (unsigned char)(xid >> 24) && buf[5] == (unsigned char)(xid >> 16) &&
+            buf[6] == (unsigned char)(xid >> 8) && buf[7] == (unsigned char)xid;
+
+    /* secs, flags, ciaddr, then yiaddr */
+    read_reply(NULL, 8);
+    read_reply(reply->ip, 4);
+
+    /* siaddr, giaddr, then chaddr */
+    read_reply(NULL, 8);
+    read_reply(buf, 6);
+    valid = valid && memcmp(buf, vpd.mac_address, 6) == 0;
+
+    /* rest of chaddr, sname, file, then the magic cookie */
+    read_reply(NULL, DHCP_FIXED_SIZE - 34);
+    valid = read_reply(buf, 4) && valid && buf[0] == 99 && buf[1] == 130 && buf[2] == 83 && buf[3] == 99;
+
+    reply->type = 0;
+    reply->lease_time = 0;
+    reply->t1 = 0;
+    reply->t2 = 0;
+    copy_ip(reply->gateway, lease.gateway);
+    copy_ip(reply->subnet, lease.subnet);
+    memset(reply->server, 0, 4);
+    while(valid && read_reply(&code, 1) && code != OPT_END){
+        if(code == OPT_PAD){
+            continue;
+        }
+        if(!read_reply(&len, 1)){
+            break;
+        }
+        if(len < 1 || len > 4){
+            read_reply(NULL, len);
+            continue;
+        }
+        read_reply(buf, len);
+        switch(code){
+        case OPT_MESSAGE_TYPE:
+            reply->type = buf[0];
+            break;
+        case OPT_SUBNET:
+            if(len == 4) copy_ip(reply->subnet, buf);
+            break;
+        case OPT_ROUTER:
+            if(len == 4) copy_ip(reply->gateway, buf);
+            break;
+        case OPT_SERVER_ID:
+            if(len == 4) copy_ip(reply->server, buf);
+            break;
+        case OPT_LEASE_TIME:
+        case OPT_T1:
+        case OPT_T2:
+            if(len == 4){
+                unsigned long t = ((unsigned long)buf[0] << 24) | ((unsigned long)buf[1] << 16) |
+                                  ((unsigned int)buf[2] << 8) | buf[3];
+                if(t > LEASE_MAX_S){
+                    t = LEASE_MAX_S;
+                }
+                if(code == OPT_LEASE_TIME) reply->lease_time = t;
+                else if(code == OPT_T1) reply->t1 = t;
+                else reply->t2 = t;
+            }
+            break;
+        }
+    }
+
+    /* drop the rest of the datagram */
+    read_reply(NULL, reply_left);
+    return valid && reply->type != 0;
+ }
+
+ /**********************************
+ * bind_lease()
+ *
+ * Applies an acknowledged lease (reconfiguring the Ethernet controller if
+ * it changed) and schedules its renewal.  T1 and T2 default to 1/2 and
+ * 7/8 of the lease time.
+ *
+ * arguments:
+ *  reply - the parsed DHCPACK
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  lease, cache_modified, state, server_ip, renew_at, rebind_at,
+ *  expire_at, retry_interval
+ */
+ static void bind_lease(const reply_struct *reply){
+    unsigned long now = clock_uptime();
+    unsigned long t1 = reply->t1;
+    unsigned long t2 = reply->t2;
+
+    if(reply->server[0] != 0){
+        copy_ip(server_ip, reply->server);
+    }
+    if(store_lease(reply->ip, reply->gateway, reply->subnet)){
+        apply_lease(PSTR("lease changed, local ip: "));
+    }
+    if(t1 == 0 || t1 > reply->lease_time){
+        t1 = reply->lease_time / 2;
+    }
+    if(t2 == 0 || t2 > reply->lease_time || t2 < t1){
+        t2 = reply->lease_time - reply->lease_time / 8;
+    }
+    renew_at = now + t1;
+    rebind_at = now + t2;
+    expire_at = now + reply->lease_time;
+    retry_interval = RETRY_MIN_MS;
+    state = DHCP_BOUND;
+    ULOG(ULOG_DEBUG,
+        serial_writestr_P(PSTR("dhcp: lease s "));
+        uart_writedec32(reply->lease_time);
+        serial_writestr_P(PSTR("\r\n")));
+ }
+
+ /**********************************
+ * check_timers()
+ *
+ * Moves a bound lease to the renewing state at T1, a renewing lease to
+ * the rebinding state at T2, and an expired lease to the selecting state
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  state, next_attempt, retry_interval
+ */
+ static void check_timers(){
+    unsigned long now = clock_uptime();
+
+    if(state == DHCP_BOUND && now >= renew_at){
+        state = DHCP_RENEWING;
+        next_attempt = clock_ms();
+    }
+    if(state == DHCP_RENEWING && now >= rebind_at){
+        state = DHCP_REBINDING;
+        next_attempt = clock_ms();
+        retry_interval = RETRY_MIN_MS;
+    }
+    if((state == DHCP_RENEWING || state == DHCP_REBINDING) && now >= expire_at){
+        ULOG(ULOG_WARN, serial_writestr_P(PSTR("dhcp: lease expired\r\n")));
+        state = DHCP_SELECTING;
+        next_attempt = clock_ms();
+        retry_interval = RETRY_MIN_MS;
+    }
+ }
+
+ /**********************************
+ * netboot_start()
+ *
+ * Configures the Ethernet controller addresses from the static ip, the
+ * cached lease or (when neither is available) a blocking dhcp request.
+ * The dhcp client then confirms the lease in the background to learn
+ * its renewal times.
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  lease, state, xid, next_attempt, retry_interval
+ */
+ void netboot_start(){
+    int cached = read_cache();
+
+    if(config.use_static_ip){
+        /* the config only holds the address - take the gateway and subnet
+        * from the last lease, or assume a /24 network with the gateway at .1
+        */
+        copy_ip(lease.ip, config.static_ip);
+        if(!cached){
+            copy_ip(lease.gateway, config.static_ip);
+            lease.gateway[3] = 1;
+            lease.subnet[0] = 255;
+            lease.subnet[1] = 255;
+            lease.subnet[2] = 255;
+            lease.subnet[3] = 0;
+        }
+        apply_lease(PSTR("static local ip: "));
+        state = DHCP_OFF;
+        return;
+    }
+
+    xid = ((unsigned long)vpd.mac_address[3] << 16) | ((unsigned int)vpd.mac_address[4] << 8) | vpd.mac_address[5];
+    retry_interval = RETRY_MIN_MS;
+    state = DHCP_REBOOTING;
+
+    if(cached){
+        apply_lease(PSTR("cached local ip: "));
+        next_attempt = clock_ms() + ((((unsigned int)vpd.mac_address[4] << 8) | vpd.mac_address[5]) % REVALIDATE_SPREAD_MS);
+        return;
+    }
+
+    /* no cached lease - loop until a dhcp address has been gotten */
+    while (!dhcp_start(vpd.mac_address, 60000UL, 4000UL)) {}
+    copy_ip(server_ip, dhcp_getDhcpServerIp());
+    store_lease(dhcp_getLocalIp(), dhcp_getGatewayIp(), dhcp_getSubnetMask());
+    apply_lease(PSTR("local ip: "));
+    next_attempt = clock_ms();
+ }
+
+ /**********************************
+ * netboot_update()
+ *
+ * Runs one step of the dhcp client and writes back the lease cache.
+ * A step sends at most one message or reads at most one reply, so it
+ * never waits for the server.
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  lease, the dhcp client state, cache_modified
+ */
+ void netboot_update(){
+    reply_struct reply;
+
+    if(state != DHCP_OFF){
+        if(waiting){
+            if(receive_reply(&reply)){
+                if(reply.type == DHCPOFFER && state == DHCP_SELECTING){
+                    copy_ip(offer_ip, reply.ip);
+                    copy_ip(server_ip, reply.server);
+                    state = DHCP_REQUESTING;
+                    start_exchange();
+                }
+                else if(reply.type == DHCPACK && state != DHCP_SELECTING){
+                    end_exchange(0);
+                    bind_lease(&reply);
+                }
+                else if(reply.type == DHCPNAK && state != DHCP_SELECTING){
+                    ULOG(ULOG_WARN, serial_writestr_P(PSTR("dhcp: lease refused\r\n")));
+                    end_exchange(0);
+                    state = DHCP_SELECTING;
+                    retry_interval = RETRY_MIN_MS;
+                }
+            }
+            else if((long)(clock_ms() - reply_deadline) >= 0){
+                /* no reply - an unanswered offer restarts the discovery */
+                end_exchange(retry_interval);
+                if(retry_interval < RETRY_MAX_MS){
+                    retry_interval <<= 1;
+                }
+                if(state == DHCP_REQUESTING){
+                    state = DHCP_SELECTING;
+                }
+            }
+        }
+        else{
+            check_timers();
+            if(state != DHCP_BOUND && (long)(clock_ms() - next_attempt) >= 0){
+                start_exchange();
+            }
+        }
+    }
+
+    if(cache_modified && !eeprom_isbusy()){
+        eeprom_writebuf(NETBOOT_EEPROM_ADDR, (unsigned char*)&lease, sizeof(lease));
+        cache_modified = 0;
+    }
+ }
+
+ /**********************************
+ * netboot_get_ip()
+ *
+ * Returns the ip address the Ethernet controller was configured with
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  the 4 byte ip address
+ *
+ * changes:
+ *  none
+ */
+ const unsigned char *netboot_get_ip(){
+    return lease.ip;
+ }
@@ -0,0 +1,50 @@
+/********************************************************
+ * netboot.h
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file provides declarations for the network startup
+ * functions (static ip, cached dhcp lease or dhcp) and the
+ * non-blocking dhcp client that keeps the lease.
+ */
+
+#ifndef NETBOOT_H_INCLUDED
+#define NETBOOT_H_INCLUDED
+
+/* socket of the dhcp client - only open during an exchange, and used by
+ * the alarms (alarm.c) in between
+ */
+#define NETBOOT_SOCKET      2
+
+/* location of the cached dhcp lease in the eeprom (after the crc record) */
+#define NETBOOT_EEPROM_ADDR 0x0110
+
+/**********************************
+ * netboot_start()
+ *
+ * Configures the Ethernet controller addresses.  The static ip is used
+ * if config.use_static_ip is set.  Otherwise a lease cached in the eeprom
+ * is reused (and confirmed later by netboot_update()).  Only when there
+ * is no cached lease does this function block on dhcp.
+ */
+void netboot_start();
+
+/**********************************
+ * netboot_update()
+ *
+ * Runs one step of the dhcp client (confirming a cached lease, renewing
+ * at T1, rebinding at T2 or discovering a new lease) and writes back the
+ * lease cache.  A step never waits for the server.  Call from the main
+ * loop.
+ */
+void netboot_update();
+
+/**********************************
+ * netboot_get_ip()
+ *
+ * Returns the ip address the Ethernet controller was configured with
+ */
+const unsigned char *netboot_get_ip();
+
+#endif // NETBOOT_H_INCLUDED
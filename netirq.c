@@ -0,0 +1,153 @@
+/********************************************************
+ * netirq.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file implements the Ethernet controller interrupt handling.
+ * Polling the server socket state and receive size on every pass of
+ * the main loop costs several W5100 register reads (spi transactions)
+ * per pass even when nothing has changed.  Instead, the W5100 socket interrupt (connect,
+ * disconnect, receive, timeout) is enabled and its INT output, wired
+ * to INT0, sets a flag.  The main loop services the socket only when
+ * the flag is set, when a follow up check was requested, or when the
+ * (slow) fallback poll is due.
+ *
+ * INT0 is level triggered, since the W5100 holds INT low until the
+ * socket interrupt register is cleared.  The interrupt routine masks
+ * INT0 and the main loop unmasks it after clearing the register, so
+ * no spi access is needed inside the interrupt.
+ *
+ * The spi transactions are counted by spi.c and reported per second by
+ * the latency instrumentation.  They have not been measured on a device
+ * yet; building with NETIRQ_ENABLE 0 (poll on every pass) gives the
+ * count to compare against.
+ *
+ * Functions:
+ *
+ * netirq_init()
+ *  Enables the socket interrupt in the W5100 and INT0
+ *
+ * netirq_check()
+ *  Returns 1 if the socket needs servicing
+ *
+ * netirq_request()
+ *  Requests that the socket is serviced on the next check
+ */
+
+ #include <avr/io.h>
+ #include <avr/interrupt.h>
+ #include "netirq.h"
+ #include "w51.h"
+ #include "clock.h"
+
+ #if NETIRQ_ENABLE
+
+ static unsigned char sock;
+ static volatile unsigned char irq_flag;
+ static unsigned char requested;
+ static unsigned long last_service;
+
+ /**********************************
+ * INT0_vect
+ *
+ * W5100 interrupt - masks INT0 (the line stays low until the socket
+ * interrupt register is cleared) and flags the socket for servicing
+ */
+ ISR(INT0_vect){
+    EIMSK &= ~(1<<INT0);
+    irq_flag = 1;
+ }
+
+ /**********************************
+ * netirq_init()
+ *
+ * Enables the socket interrupt of the specified socket in the W5100 and
+ * the (low level triggered) INT0 interrupt.  The first check always
+ * services the socket.
+ *
+ * arguments:
+ *  s - the socket to service
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  W5100 IMR and socket interrupt register, INT0 registers, sock, requested
+ */
+ void netirq_init(unsigned char s){
+    sock = s;
+
+    /* INT0 (PD2) is an input with pull-up (INT is open drain, active low) */
+    DDRD &= ~(1<<DDD2);
+    PORTD |= (1<<PD2);
+
+    W5x_writeSnIR(sock, 0xFF);
+    W5x_write(W5_IMR, W5x_read(W5_IMR) | (1<<sock));
+
+    EICRA &= ~((1<<ISC01) | (1<<ISC00));
+    EIMSK |= (1<<INT0);
+
+    requested = 1;
+ }
+
+ /**********************************
+ * netirq_check()
+ *
+ * Returns 1 if the socket needs servicing.  When an interrupt was flagged
+ * the socket interrupt register is cleared and INT0 is unmasked again.
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  1 if the socket should be serviced, otherwise 0
+ *
+ * changes:
+ *  irq_flag, requested, last_service, W5100 socket interrupt register
+ */
+ unsigned char netirq_check(){
+    unsigned char ir;
+
+    if(irq_flag){
+        irq_flag = 0;
+        ir = W5x_readSnIR(sock);
+        W5x_writeSnIR(sock, ir);
+        /* fires again right away if another event is already pending */
+        EIMSK |= (1<<INT0);
+        requested = 1;
+    }
+    if(requested || clock_ms() - last_service >= NETIRQ_POLL_MS){
+        requested = 0;
+        last_service = clock_ms();
+        return 1;
+    }
+    return 0;
+ }
+
+ /**********************************
+ * netirq_request()
+ *
+ * Requests that the socket is serviced again on the next check
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  requested
+ */
+ void netirq_request(){
+    requested = 1;
+ }
+
+ #else
+
+ /* polled on every pass: no interrupt, the socket is always serviced */
+ void netirq_init(unsigned char s){}
+ unsigned char netirq_check(){ return 1; }
+ void netirq_request(){}
+
+ #endif // NETIRQ_ENABLE
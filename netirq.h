@@ -0,0 +1,65 @@
+/********************************************************
+ * netirq.h
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file provides declarations for the Ethernet controller
+ * interrupt handling.  The W5100 INT output (wired to INT0) flags
+ * state changes and received data on the server socket, so that
+ * the main loop only accesses the socket when something happened.
+ *
+ * With NETIRQ_ENABLE defined as 0 the interrupt is not used and the
+ * socket is serviced on every pass, as before.  Comparing spi_per_s
+ * (GET /device/latency) of the two builds gives the spi transactions
+ * the interrupt saves.
+ */
+
+#ifndef NETIRQ_H_INCLUDED
+#define NETIRQ_H_INCLUDED
+
+#ifndef NETIRQ_ENABLE
+#define NETIRQ_ENABLE 1
+#endif
+
+/* W5100 interrupt mask register */
+#define W5_IMR              0x0016
+
+/* W5100 socket interrupt register bits */
+#define SNIR_CON            0x01
+#define SNIR_DISCON         0x02
+#define SNIR_RECV           0x04
+#define SNIR_TIMEOUT        0x08
+#define SNIR_SEND_OK        0x10
+
+/* fallback poll interval in case an interrupt is lost (e.g. the socket
+ * library clearing the socket interrupt register itself)
+ */
+#define NETIRQ_POLL_MS      1000
+
+/**********************************
+ * netirq_init()
+ *
+ * Enables the socket interrupt of the specified socket in the W5100 and
+ * the INT0 interrupt.  Call after the Ethernet controller is configured.
+ */
+void netirq_init(unsigned char s);
+
+/**********************************
+ * netirq_check()
+ *
+ * Returns 1 if the socket needs servicing (an interrupt was flagged, a
+ * check was requested or the fallback poll is due), otherwise 0.  The
+ * socket interrupt register is cleared when an interrupt is taken.
+ */
+unsigned char netirq_check();
+
+/**********************************
+ * netirq_request()
+ *
+ * Requests that the socket is serviced again on the next check (used
+ * while the socket is changing state)
+ */
+void netirq_request();
+
+#endif // NETIRQ_H_INCLUDED
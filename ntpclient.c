@@ -0,0 +1,390 @@
+/********************************************************
+ * ntpclient.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file implements a non-blocking (S)NTP client.  Requests are sent
+ * and replies are handled from the main loop, and the rtc is resynchronized
+ * every NTP_RESYNC_MS so that drift does not grow over the life of the
+ * device.
+ *
+ * Small offsets are slewed rather than stepped: the length of the current
+ * rtc second is adjusted by moving the timer1 count (the rtc tick source)
+ * by at most SLEW_MAX_MS per second, so rtc timestamps never go backwards.
+ * Only large offsets (or the first sync after startup) step the rtc.
+ *
+ * Functions:
+ *
+ * ntpclient_init()
+ *  Seeds the rtc and schedules the first sync
+ *
+ * ntpclient_update()
+ *  Sends requests, handles replies and slews the rtc
+ *
+ * ntpclient_receive()
+ *  Handles a datagram from the time server
+ *
+ * ntpclient_is_synced()
+ *  Returns 1 if the rtc has been synchronized
+ *
+ * send_request()
+ *  Sends an ntp request to the time server
+ *
+ * compute_offset()
+ *  Returns the offset between the server and local times
+ *
+ * handle_reply()
+ *  Validates an ntp reply and corrects the rtc
+ *
+ * slew_update()
+ *  Applies part of the pending slew to the rtc
+ */
+
+ #include <avr/io.h>
+ #include <avr/interrupt.h>
+ #include <avr/pgmspace.h>
+ #include "ntpclient.h"
+ #include "udpmux.h"
+ #include "rtc.h"
+ #include "clock.h"
+ #include "log.h"
+ #include "logindex.h"
+ #include "boottime.h"
+ #include "serial.h"
+ #include "ulog.h"
+
+ #define NTP_PACKET_SIZE     48
+
+ #define NTP_TIMEOUT_MS      1000UL      /* time to wait for a reply */
+ #define NTP_RETRY_MS        2000UL      /* retry interval until the first sync */
+ #define NTP_RETRY_SYNCED_MS 60000UL     /* retry interval once synchronized */
+ #define NTP_RESYNC_MS       3600000UL   /* interval between resynchronizations */
+ #define NTP_FOLLOWUP_MS     10000UL     /* sync after a step to slew the remainder */
+
+ /* offsets larger than this are stepped instead of slewed */
+ #define STEP_THRESHOLD_MS   60000L
+
+ /* maximum slew applied per second (5%) */
+ #define SLEW_MAX_MS         50
+
+ /* seconds from 1/1/1900 (ntp epoch) to 1/1/2000 (rtc epoch) */
+ #define NTP_TO_RTC          3155673600UL
+
+ /* timer1 counts kept from the ends of the rtc second when slewing */
+ #define TIMER1_MARGIN       200U
+
+ enum ntp_state {NTP_IDLE, NTP_WAIT_REPLY};
+ enum ntp_reply {NTP_REPLY_INVALID, NTP_REPLY_SLEWED, NTP_REPLY_STEPPED};
+
+ ntp_stats_struct ntp_stats;
+
+ static const unsigned char ntp_server[4] = {192, 168, 1, 1};
+
+ static enum ntp_state state;
+ static unsigned long next_request;
+ static unsigned long request_sent;
+ static unsigned char synced;
+ static long slew_remaining;
+ static unsigned long last_slew;
+
+ /**********************************
+ * send_request()
+ *
+ * Sends an ntp (client mode, version 4) request to the time server
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  state, request_sent
+ */
+ static void send_request(){
+    unsigned char packet[NTP_PACKET_SIZE];
+    unsigned char i;
+
+    for(i = 0; i < NTP_PACKET_SIZE; i++){
+        packet[i] = 0;
+    }
+    packet[0] = 0xE3;   /* LI = unsynchronized, version 4, mode 3 (client) */
+    packet[2] = 6;      /* poll interval */
+    packet[3] = 0xEC;   /* precision */
+
+    udpmux_sendto(packet, NTP_PACKET_SIZE, ntp_server, NTP_PORT);
+    request_sent = clock_ms();
+    state = NTP_WAIT_REPLY;
+ }
+
+ /**********************************
+ * compute_offset()
+ *
+ * Returns the offset between the server and local times in ms, saturated
+ * to about +/-23 days so that the result fits in a long
+ *
+ * arguments:
+ *  server_sec, server_ms - the server time
+ *  local_sec, local_ms - the local (rtc) time
+ *
+ * returns:
+ *  the offset (server - local) in ms
+ *
+ * changes:
+ *  none
+ */
+ static long compute_offset(unsigned long server_sec, unsigned int server_ms,
+                            unsigned long local_sec, unsigned int local_ms){
+    long diff_sec = (long)(server_sec - local_sec);
+
+    if(diff_sec > 2000000L){
+        return 2000000000L;
+    }
+    if(diff_sec < -2000000L){
+        return -2000000000L;
+    }
+    return diff_sec * 1000 + (long)server_ms - (long)local_ms;
+ }
+
+ /**********************************
+ * handle_reply()
+ *
+ * Validates an ntp reply and corrects the rtc.  The offset is computed from
+ * the server transmit timestamp plus half of the round trip delay.
+ *
+ * arguments:
+ *  packet - the received datagram
+ *  len - its length
+ *  addr - its source ip address
+ *
+ * returns:
+ *  NTP_REPLY_INVALID, NTP_REPLY_SLEWED or NTP_REPLY_STEPPED
+ *
+ * changes:
+ *  ntp_stats, synced, slew_remaining, the rtc
+ */
+ static int handle_reply(const unsigned char *packet, unsigned int len, const unsigned char *addr){
+    unsigned long server_sec;
+    unsigned int server_ms;
+    unsigned long local_sec;
+    unsigned int local_ms;
+    unsigned int rtt;
+    long offset;
+    unsigned char i;
+
+    if(len < NTP_PACKET_SIZE){
+        return NTP_REPLY_INVALID;
+    }
+    for(i = 0; i < 4; i++){
+        if(addr[i] != ntp_server[i]){
+            return NTP_REPLY_INVALID;
+        }
+    }
+    if((packet[0] & 0x07) != 4 || packet[1] == 0){
+        /* not a server mode reply, or a kiss-of-death (stratum 0) */
+        return NTP_REPLY_INVALID;
+    }
+
+    rtt = clock_ms() - request_sent;
+    clock_read_rtc(&local_sec, &local_ms);
+
+    /* transmit timestamp: seconds and 1/65536 fractions (top 16 bits) */
+    server_sec = ((unsigned long)packet[40] << 24) | ((unsigned long)packet[41] << 16) |
+                 ((unsigned long)packet[42] << 8) | packet[43];
+    server_sec -= NTP_TO_RTC;
+    server_ms = (((unsigned long)packet[44] << 8 | packet[45]) * 1000UL) >> 16;
+    server_ms += rtt / 2;
+    server_sec += server_ms / 1000;
+    server_ms %= 1000;
+
+    offset = compute_offset(server_sec, server_ms, local_sec, local_ms);
+    ntp_stats.offset_ms = offset;
+    ntp_stats.delay_ms = rtt;
+    ntp_stats.last_sync = server_sec;
+    ntp_stats.syncs++;
+
+    if(synced && offset <= STEP_THRESHOLD_MS && offset >= -STEP_THRESHOLD_MS){
+        slew_remaining = offset;
+        return NTP_REPLY_SLEWED;
+    }
+
+    /* step - the rtc only holds whole seconds, the remainder is slewed
+    * after the follow up sync
+    */
+    rtc_set_date(server_sec + (server_ms >= 500 ? 1 : 0));
+    slew_remaining = 0;
+    ntp_stats.steps++;
+    if(synced){
+        logindex_add_record(EVENT_TIMESET);
+    }
+    logindex_add_record(EVENT_NEWTIME);
+    synced = 1;
+    boottime_mark(BOOT_TIME_SYNC);
+    ulog_str(ULOG_INFO, PSTR("ntp: time set to "), rtc_get_date_string());
+    return NTP_REPLY_STEPPED;
+ }
+
+ /**********************************
+ * slew_update()
+ *
+ * Applies up to SLEW_MAX_MS of the pending slew once per second by moving
+ * the timer1 count forward (shortening the current second) or backward
+ * (lengthening it).  The count is only moved while it is far enough from
+ * the compare value that no tick can be skipped or repeated.
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  slew_remaining, last_slew, TCNT1
+ */
+ static void slew_update(){
+    int amount;
+    unsigned int counts;
+    unsigned int count;
+    unsigned char sreg;
+
+    if(slew_remaining == 0 || clock_ms() - last_slew < 1000){
+        return;
+    }
+
+    amount = (slew_remaining > SLEW_MAX_MS) ? SLEW_MAX_MS :
+             (slew_remaining < -SLEW_MAX_MS) ? -SLEW_MAX_MS : (int)slew_remaining;
+    counts = (unsigned int)((amount < 0) ? -amount : amount) * 125 / 2;
+
+    sreg = SREG;
+    cli();
+    count = TCNT1;
+    if(amount > 0 && count + counts < CLOCK_TIMER1_TOP - TIMER1_MARGIN){
+        TCNT1 = count + counts;
+    }
+    else if(amount < 0 && count >= counts + TIMER1_MARGIN){
+        TCNT1 = count - counts;
+    }
+    else{
+        amount = 0;   /* too close to the tick - try again on the next call */
+    }
+    SREG = sreg;
+
+    if(amount != 0){
+        slew_remaining -= amount;
+        last_slew = clock_ms();
+    }
+ }
+
+ /**********************************
+ * ntpclient_init()
+ *
+ * Seeds the rtc from the newest log record (so timestamps do not go
+ * backwards before the first sync) and schedules an immediate sync
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  state, next_request, the rtc
+ */
+ void ntpclient_init(){
+    unsigned long time;
+    unsigned char eventnum;
+    unsigned char entries = log_get_num_entries();
+
+    if(entries > 0 && log_get_record(entries - 1, &time, &eventnum) && time > rtc_get_date()){
+        rtc_set_date(time);
+    }
+    state = NTP_IDLE;
+    next_request = clock_ms();
+ }
+
+ /**********************************
+ * ntpclient_update()
+ *
+ * Sends requests when a sync is due, times out lost requests and slews
+ * the rtc.  Never blocks.
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  state, next_request, ntp_stats
+ */
+ void ntpclient_update(){
+    slew_update();
+
+    switch(state){
+    case NTP_IDLE:
+        if((long)(clock_ms() - next_request) >= 0){
+            send_request();
+        }
+        break;
+    case NTP_WAIT_REPLY:
+        /* replies are handled by ntpclient_receive() */
+        if(clock_ms() - request_sent >= NTP_TIMEOUT_MS || udpmux_is_closed()){
+            ntp_stats.failures++;
+            next_request = clock_ms() + (synced ? NTP_RETRY_SYNCED_MS : NTP_RETRY_MS);
+            state = NTP_IDLE;
+        }
+        break;
+    default:
+        state = NTP_IDLE;
+        break;
+    }
+ }
+
+ /**********************************
+ * ntpclient_receive()
+ *
+ * Handles a datagram received from NTP_PORT.  Replies are only accepted
+ * while a request is outstanding.
+ *
+ * arguments:
+ *  packet - the received datagram
+ *  len - its length
+ *  addr - its source ip address
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  state, next_request, ntp_stats, the rtc
+ */
+ void ntpclient_receive(const unsigned char *packet, unsigned int len, const unsigned char *addr){
+    int reply;
+
+    if(state != NTP_WAIT_REPLY){
+        return;
+    }
+    reply = handle_reply(packet, len, addr);
+    if(reply != NTP_REPLY_INVALID){
+        next_request = clock_ms() + (reply == NTP_REPLY_STEPPED ? NTP_FOLLOWUP_MS : NTP_RESYNC_MS);
+        state = NTP_IDLE;
+    }
+ }
+
+ /**********************************
+ * ntpclient_is_synced()
+ *
+ * Returns 1 if the rtc has been synchronized at least once
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  1 if synchronized, otherwise 0
+ *
+ * changes:
+ *  none
+ */
+ int ntpclient_is_synced(){
+    return synced;
+ }
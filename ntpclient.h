@@ -0,0 +1,61 @@
+/********************************************************
+ * ntpclient.h
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file provides declarations for the non-blocking
+ * ntp client, which periodically resynchronizes the rtc
+ * from the network time server.
+ */
+
+#ifndef NTPCLIENT_H_INCLUDED
+#define NTPCLIENT_H_INCLUDED
+
+/* server port (the client sends from the shared udp socket, udpmux.h) */
+#define NTP_PORT 123
+
+typedef struct {
+    long          offset_ms;   /* last measured offset (server - local) in ms */
+    unsigned int  delay_ms;    /* round trip delay of the last exchange */
+    unsigned long last_sync;   /* rtc date/time of the last sync (0 = never) */
+    unsigned int  syncs;       /* number of successful exchanges */
+    unsigned int  failures;    /* number of exchanges that timed out */
+    unsigned int  steps;       /* number of times the rtc was stepped */
+} ntp_stats_struct;
+
+/* statistics of the ntp client */
+extern ntp_stats_struct ntp_stats;
+
+/**********************************
+ * ntpclient_init()
+ *
+ * Seeds the rtc from the newest log record (so timestamps do not go
+ * backwards before the first sync) and schedules an immediate sync.
+ * Must be called after the network has been configured.
+ */
+void ntpclient_init();
+
+/**********************************
+ * ntpclient_update()
+ *
+ * Sends requests, handles replies and slews the rtc.  Never blocks.
+ * Call from the main loop.
+ */
+void ntpclient_update();
+
+/**********************************
+ * ntpclient_receive()
+ *
+ * Handles a datagram received from NTP_PORT (called by udpmux_update())
+ */
+void ntpclient_receive(const unsigned char *packet, unsigned int len, const unsigned char *addr);
+
+/**********************************
+ * ntpclient_is_synced()
+ *
+ * Returns 1 if the rtc has been synchronized at least once, otherwise 0
+ */
+int ntpclient_is_synced();
+
+#endif // NTPCLIENT_H_INCLUDED
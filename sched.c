@@ -0,0 +1,389 @@
+/********************************************************
+ * sched.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file implements a small cooperative scheduler.  Tasks are either
+ * periodic or event triggered, and each has a deadline relative to its
+ * release time and an execution time budget.  Each call to sched_run()
+ * runs the released task with the earliest deadline, so work is only done
+ * when it is due.  Time is taken from clock_ms() (clock.h), so the
+ * execution times and deadline misses are in the same time base as the
+ * timestamps of the rest of the project.
+ *
+ * The watchdog is only kicked while no released task is past its deadline,
+ * so a task that hangs, or that is starved by another task, causes a
+ * watchdog reset instead of going unnoticed.
+ *
+ * When no task is released and the next release is at least two ticks
+ * away, the cpu is put in idle sleep until the next interrupt.  This is
+ * only idle sleep between ticks, not a tickless idle: the library owns
+ * timer0, whose 1 ms tick interrupt wakes the cpu every millisecond, so
+ * each sleep lasts at most the rest of the current tick.  Idle sleep
+ * keeps the timers, adc, uart and spi running, so all interrupt driven
+ * work continues.  The time spent asleep is reported by the latency
+ * instrumentation (latency.c); the current draw has not been measured.
+ *
+ * Functions:
+ *
+ * sched_add()
+ *  Adds a periodic or event triggered task
+ *
+ * sched_trigger()
+ *  Releases an event triggered task
+ *
+ * sched_shift_release()
+ *  Moves the release time of a periodic task
+ *
+ * sched_run()
+ *  Runs the released task with the earliest deadline
+ *
+ * sched_idle()
+ *  Sleeps until the next interrupt (at the latest the next tick)
+ *
+ * sched_get_num_tasks()
+ *  Returns the number of tasks
+ *
+ * sched_get_task()
+ *  Returns a task (for statistics)
+ *
+ * sched_get_current()
+ *  Returns the running task
+ *
+ * sched_report_line()
+ *  Writes the statistics of one task to the uart
+ */
+
+ #include <avr/interrupt.h>
+ #include <avr/sleep.h>
+ #include <avr/pgmspace.h>
+ #include "sched.h"
+ #include "clock.h"
+ #include "wdt.h"
+ #include "uart.h"
+ #include "serial.h"
+ #include "latency.h"
+
+ static task_struct tasks[SCHED_MAX_TASKS];
+ static unsigned char num_tasks;
+ static volatile unsigned char current = SCHED_NO_TASK;
+
+ /**********************************
+ * sched_add()
+ *
+ * Adds a task, unless the task table (SCHED_MAX_TASKS) is full
+ *
+ * arguments:
+ *  name - name of the task (for reports, in program memory)
+ *  run - function that performs one run of the task
+ *  period_ms - release period, or 0 for an event triggered task
+ *  first_ms - delay until the first release of a periodic task
+ *  deadline_ms - deadline relative to the release (0 = same as the period)
+ *  budget_ms - allowed execution time per run
+ *
+ * returns:
+ *  the task id, or SCHED_NO_TASK if the table is full
+ *
+ * changes:
+ *  tasks, num_tasks
+ */
+ unsigned char sched_add(const char *name, task_fn run, unsigned int period_ms,
+                         unsigned int first_ms, unsigned int deadline_ms, unsigned int budget_ms){
+    task_struct *task;
+
+    if(num_tasks >= SCHED_MAX_TASKS){
+        return SCHED_NO_TASK;
+    }
+    task = &tasks[num_tasks];
+    task->name = name;
+    task->run = run;
+    task->period_ms = period_ms;
+    task->deadline_ms = deadline_ms ? deadline_ms : period_ms;
+    task->budget_ms = budget_ms;
+    task->release = clock_ms() + first_ms;
+    task->pending = 0;
+    task->runs = 0;
+    task->wcet_ms = 0;
+    task->misses = 0;
+    task->overruns = 0;
+    return num_tasks++;
+ }
+
+ /**********************************
+ * sched_trigger()
+ *
+ * Releases an event triggered task.  Triggering a task that is already
+ * released (or SCHED_NO_TASK) has no effect.
+ *
+ * arguments:
+ *  id - the task id
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the task's release time and pending flag
+ */
+ void sched_trigger(unsigned char id){
+    if(id < num_tasks && !tasks[id].pending){
+        tasks[id].release = clock_ms();
+        tasks[id].pending = 1;
+    }
+ }
+
+ /**********************************
+ * sched_shift_release()
+ *
+ * Moves the release time of a periodic task, which moves all its later
+ * releases by the same amount.  If the task is released but has not run
+ * yet, it still runs now and the shift applies from its next release.
+ *
+ * arguments:
+ *  id - the task id
+ *  delta_ms - amount to move the release by (negative for earlier)
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the task's release time
+ */
+ void sched_shift_release(unsigned char id, long delta_ms){
+    if(id < num_tasks && tasks[id].period_ms){
+        tasks[id].release += delta_ms;
+    }
+ }
+
+ /**********************************
+ * run_task()
+ *
+ * Runs a released task and updates its statistics and next release
+ *
+ * arguments:
+ *  task - the task to run
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the task, current
+ */
+ static void run_task(task_struct *task){
+    unsigned long start = clock_ms();
+    unsigned long end;
+    unsigned int exec;
+
+    current = task - tasks;
+    task->run();
+    current = SCHED_NO_TASK;
+
+    end = clock_ms();
+    exec = end - start;
+    task->runs++;
+    if(exec > task->wcet_ms){
+        task->wcet_ms = exec;
+    }
+    if(exec > task->budget_ms){
+        task->overruns++;
+    }
+    if((long)(end - (task->release + task->deadline_ms)) > 0){
+        task->misses++;
+    }
+
+    task->pending = 0;
+    if(task->period_ms){
+        task->release += task->period_ms;
+        if((long)(end - task->release) >= 0){
+            /* fell behind by more than a period - run once more right away */
+            task->release = end;
+        }
+    }
+ }
+
+ /**********************************
+ * sched_idle()
+ *
+ * Puts the cpu in idle sleep until the next interrupt, at the latest the
+ * timer0 millisecond tick.  Interrupts are enabled by the instruction
+ * just before the sleep instruction, so an interrupt that is already
+ * pending wakes the cpu right away instead of being missed.
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  none
+ */
+ static void sched_idle(){
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    LATENCY_SLEEP_BEGIN();
+    cli();
+    sleep_enable();
+    sei();
+    sleep_cpu();
+    sleep_disable();
+    LATENCY_SLEEP_END();
+ }
+
+ /**********************************
+ * sched_run()
+ *
+ * Releases the periodic tasks that are due, runs the released task with the
+ * earliest deadline (if any) and kicks the watchdog if no released task is
+ * past its deadline.  If no task was released, sleeps until the next
+ * interrupt when the next release is far enough away.
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  tasks
+ */
+ void sched_run(){
+    unsigned long now = clock_ms();
+    unsigned long deadline;
+    unsigned long best_deadline = 0;
+    unsigned char best = SCHED_NO_TASK;
+    unsigned long next_release = now + 0x7FFFFFFFUL;
+    unsigned char overdue = 0;
+    unsigned char i;
+
+    LATENCY_IDLE_BEGIN();
+    for(i = 0; i < num_tasks; i++){
+        task_struct *task = &tasks[i];
+        if(!task->pending && task->period_ms && (long)(now - task->release) >= 0){
+            task->pending = 1;
+        }
+        if(task->pending){
+            deadline = task->release + task->deadline_ms;
+            if(best == SCHED_NO_TASK || (long)(deadline - best_deadline) < 0){
+                best = i;
+                best_deadline = deadline;
+            }
+        }
+        else if(task->period_ms && (long)(task->release - next_release) < 0){
+            next_release = task->release;
+        }
+    }
+
+    if(best != SCHED_NO_TASK){
+        run_task(&tasks[best]);
+    }
+    else{
+        /* nothing was due - sleep unless the next release is on the next
+        * tick (the tick may already have happened since now was read, and
+        * sleeping would then delay that release by a whole tick)
+        */
+        if((long)(next_release - now) >= 2){
+            sched_idle();
+        }
+        /* count the pass as idle time */
+        LATENCY_IDLE_END();
+    }
+
+    now = clock_ms();
+    for(i = 0; i < num_tasks; i++){
+        if(tasks[i].pending && (long)(now - (tasks[i].release + tasks[i].deadline_ms)) > 0){
+            overdue = 1;
+        }
+    }
+    if(!overdue){
+        wdt_reset();
+    }
+ }
+
+ /**********************************
+ * sched_get_num_tasks()
+ *
+ * Returns the number of tasks
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  the number of tasks
+ *
+ * changes:
+ *  none
+ */
+ unsigned char sched_get_num_tasks(){
+    return num_tasks;
+ }
+
+ /**********************************
+ * sched_get_task()
+ *
+ * Returns the task with the specified id
+ *
+ * arguments:
+ *  id - the task id
+ *
+ * returns:
+ *  pointer to the task
+ *
+ * changes:
+ *  none
+ */
+ const task_struct *sched_get_task(unsigned char id){
+    return &tasks[id];
+ }
+
+ /**********************************
+ * sched_get_current()
+ *
+ * Returns the id of the running task
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  the task id, or SCHED_NO_TASK between tasks
+ *
+ * changes:
+ *  none
+ */
+ unsigned char sched_get_current(){
+    return current;
+ }
+
+ /**********************************
+ * sched_report_line()
+ *
+ * Writes the run count, worst case execution time, deadline misses and
+ * budget overruns of one task to the uart
+ *
+ * arguments:
+ *  line - the task (report line) to write
+ *
+ * returns:
+ *  1 if the line was written, 0 if there is no such task
+ *
+ * changes:
+ *  none
+ */
+ unsigned char sched_report_line(unsigned char line){
+    task_struct *task;
+
+    if(line >= num_tasks){
+        return 0;
+    }
+    task = &tasks[line];
+    serial_writestr_P(task->name);
+    serial_writestr_P(PSTR(": runs "));
+    uart_writedec32(task->runs);
+    serial_writestr_P(PSTR(" wcet "));
+    uart_writedec32(task->wcet_ms);
+    serial_writestr_P(PSTR("ms misses "));
+    uart_writedec32(task->misses);
+    serial_writestr_P(PSTR(" overruns "));
+    uart_writedec32(task->overruns);
+    serial_writestr_P(PSTR("\r\n"));
+    return 1;
+ }
@@ -0,0 +1,101 @@
+/********************************************************
+ * sched.h
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file provides declarations for the cooperative
+ * task scheduler that drives the main loop.
+ */
+
+#ifndef SCHED_H_INCLUDED
+#define SCHED_H_INCLUDED
+
+/* maximum number of tasks */
+#define SCHED_MAX_TASKS 10
+
+/* returned by sched_get_current() when no task is running, and by
+* sched_add() when the task table is full
+*/
+#define SCHED_NO_TASK   0xFF
+
+typedef void (*task_fn)(void);
+
+typedef struct {
+    const char    *name;        /* in program memory */
+    task_fn       run;
+    unsigned int  period_ms;    /* release period (0 = event triggered only) */
+    unsigned int  deadline_ms;  /* deadline relative to the release time */
+    unsigned int  budget_ms;    /* allowed execution time per run */
+    unsigned long release;      /* time (ms) of the current/next release */
+    unsigned char pending;      /* 1 if released and not yet run */
+    unsigned long runs;         /* number of times the task has run */
+    unsigned int  wcet_ms;      /* worst case execution time */
+    unsigned int  misses;       /* number of deadline misses */
+    unsigned int  overruns;     /* number of runs that exceeded the budget */
+} task_struct;
+
+/**********************************
+ * sched_add()
+ *
+ * Adds a task, named by a program memory string (PSTR()).  Periodic
+ * tasks (period_ms > 0) are first released after first_ms.  Event
+ * triggered tasks (period_ms = 0) are released by sched_trigger().
+ * Returns the task id, or SCHED_NO_TASK if the task table is full.
+ */
+unsigned char sched_add(const char *name, task_fn run, unsigned int period_ms,
+                        unsigned int first_ms, unsigned int deadline_ms, unsigned int budget_ms);
+
+/**********************************
+ * sched_trigger()
+ *
+ * Releases an event triggered task
+ */
+void sched_trigger(unsigned char id);
+
+/**********************************
+ * sched_shift_release()
+ *
+ * Moves the release time (and so the phase) of a periodic task by
+ * delta_ms
+ */
+void sched_shift_release(unsigned char id, long delta_ms);
+
+/**********************************
+ * sched_run()
+ *
+ * Runs the released task with the earliest deadline (if any) and kicks
+ * the watchdog if no task is past its deadline.  Call from the main loop.
+ */
+void sched_run();
+
+/**********************************
+ * sched_get_num_tasks()
+ *
+ * Returns the number of tasks
+ */
+unsigned char sched_get_num_tasks();
+
+/**********************************
+ * sched_get_task()
+ *
+ * Returns the task with the specified id (for statistics)
+ */
+const task_struct *sched_get_task(unsigned char id);
+
+/**********************************
+ * sched_get_current()
+ *
+ * Returns the id of the running task, or SCHED_NO_TASK between tasks
+ */
+unsigned char sched_get_current();
+
+/**********************************
+ * sched_report_line()
+ *
+ * Writes the statistics of one task to the uart, returns 0 once line
+ * is past the last task
+ */
+unsigned char sched_report_line(unsigned char line);
+
+#endif // SCHED_H_INCLUDED
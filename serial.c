@@ -0,0 +1,480 @@
+/********************************************************
+ * serial.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file implements the interrupt driven serial port declared in
+ * serial.h, replacing the library implementation to add a drop policy
+ * for a full transmit ring (which keeps the library size of 64 bytes -
+ * RAM is short).  With SERIAL_DROP selected, a character that does not
+ * fit is discarded and so is the rest of the output until the policy is
+ * set again, so that a message is either sent whole or cut short - never
+ * spliced with the next one.  Receiving (raw mode, and the line
+ * oriented socket mode used by the test host) behaves as in the
+ * library.
+ *
+ * Functions:
+ *
+ * serial_init()
+ *  Configures the uart for 9600 baud 8N1 with rx and tx interrupts
+ *
+ * serial_set_baud()
+ *  Changes the baud rate
+ *
+ * serial_writechar()
+ *  Queues a character for transmission
+ *
+ * serial_writestr()
+ *  Queues a null terminated string for transmission
+ *
+ * serial_writestr_P()
+ *  Queues a null terminated program memory string for transmission
+ *
+ * serial_rxchars()
+ *  Returns the number of received characters waiting
+ *
+ * serial_popchar()
+ *  Returns the next received character
+ *
+ * serial_isconnected()
+ *  Switches to socket mode and returns whether the host is connected
+ *
+ * serial_is_socket_mode()
+ *  Returns whether the receiver is in socket mode
+ *
+ * serial_is_packet_ready()
+ *  Returns the number of complete lines received
+ *
+ * serial_set_policy()
+ *  Selects the overflow policy of the tx ring
+ *
+ * serial_get_tx_free()
+ *  Returns the free space of the tx ring
+ *
+ * serial_get_dropped()
+ *  Returns the number of tx characters dropped
+ */
+
+ #include <avr/io.h>
+ #include <avr/interrupt.h>
+ #include <avr/pgmspace.h>
+ #include "serial.h"
+
+ #define TX_MASK            (SERIAL_TX_SIZE - 1)
+ #define RX_MASK            (SERIAL_RX_SIZE - 1)
+
+ /* ring is full when advancing the head would reach the tail */
+ #define TX_ROOM()          ((unsigned char)(txtail - txhead - 1) & TX_MASK)
+ #define RX_ROOM()          ((unsigned char)(rxtail - rxhead - 1) & RX_MASK)
+
+ /* baud rate registers at 16MHz (9600 normal speed, 115200 double speed) */
+ #define BAUD_UBRR          0x67
+ #define BAUD_UBRR_FAST     16
+
+ /* socket mode control characters */
+ #define CH_CONNECT         0x03
+ #define CH_EOT             0x04
+ #define CH_BS              0x08
+ #define CH_DEL             0x7F
+
+ static char txbuf[SERIAL_TX_SIZE];
+ static char rxbuf[SERIAL_RX_SIZE];
+ static volatile unsigned char txhead;
+ static volatile unsigned char txtail;
+ static volatile unsigned char rxhead;
+ static volatile unsigned char rxtail;
+ static volatile unsigned char packet_available;
+ static volatile unsigned char socket_connected;
+ static volatile unsigned char socket_mode;
+
+ static unsigned char policy = SERIAL_BLOCK;
+ static unsigned char dropping;
+ static unsigned long dropped;
+
+ /**********************************
+ * tx_put() (ISR context)
+ *
+ * Queues an echo character if there is room
+ */
+ static void tx_put(char c){
+    if(TX_ROOM()){
+        txbuf[txhead] = c;
+        txhead = (txhead + 1) & TX_MASK;
+        UCSR0B |= (1<<UDRIE0);
+    }
+ }
+
+ /**********************************
+ * rx_put() (ISR context)
+ *
+ * Stores a received character if there is room, returns 1 if stored
+ */
+ static unsigned char rx_put(char c){
+    if(!RX_ROOM()){
+        return 0;
+    }
+    rxbuf[rxhead] = c;
+    rxhead = (rxhead + 1) & RX_MASK;
+    return 1;
+ }
+
+ /**********************************
+ * USART_RX_vect
+ *
+ * Receive interrupt.  In raw mode every character is stored.  In
+ * socket mode the host connects with ^C, lines are echoed and counted
+ * as packets, backspace removes the last character and ^D ends the
+ * connection (terminating a partial line first).
+ */
+ ISR(USART_RX_vect){
+    char c = UDR0;
+
+    if(!socket_mode){
+        rx_put(c);
+        return;
+    }
+    if(!socket_connected){
+        if(c == CH_CONNECT){
+            socket_connected = 1;
+        }
+        return;
+    }
+    if((unsigned char)(c - ' ') < 0x5F || c == '\r'){
+        rx_put(c);
+        tx_put(c);
+        if(c == '\r'){
+            tx_put('\n');
+            packet_available++;
+        }
+    }
+    else if(c == CH_BS || c == CH_DEL){
+        if(rxhead != rxtail){
+            rxhead = (rxhead - 1) & RX_MASK;
+        }
+        tx_put(CH_DEL);
+    }
+    else if(c == CH_EOT){
+        if(rxhead != rxtail && rxbuf[(rxhead - 1) & RX_MASK] != '\r' && rx_put('\r')){
+            packet_available++;
+        }
+        rx_put(CH_EOT);
+    }
+ }
+
+ /**********************************
+ * USART_UDRE_vect
+ *
+ * Data register empty interrupt - sends the next queued character or
+ * disables itself when the tx ring is empty
+ */
+ ISR(USART_UDRE_vect){
+    if(txhead != txtail){
+        UDR0 = txbuf[txtail];
+        txtail = (txtail + 1) & TX_MASK;
+    }
+    else{
+        UCSR0B &= ~(1<<UDRIE0);
+    }
+ }
+
+ /**********************************
+ * serial_init()
+ *
+ * Configures the uart for 9600 baud, 8 data bits, no parity and 1 stop
+ * bit and enables the receive and data register empty interrupts
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the uart registers
+ */
+ void serial_init(void){
+    UCSR0A = 0;
+    UBRR0 = BAUD_UBRR;
+    UCSR0B = (1<<RXEN0) | (1<<TXEN0);
+    UCSR0C = (1<<UCSZ01) | (1<<UCSZ00);
+    UCSR0B |= (1<<RXCIE0) | (1<<UDRIE0);
+ }
+
+ /**********************************
+ * serial_set_baud()
+ *
+ * Changes the baud rate.  The tx ring should be empty and the last
+ * character sent, or that character is corrupted.
+ *
+ * arguments:
+ *  baud - SERIAL_BAUD_9600 or SERIAL_BAUD_115200
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the uart baud rate registers
+ */
+ void serial_set_baud(unsigned char baud){
+    if(baud == SERIAL_BAUD_115200){
+        UCSR0A = (1<<U2X0);
+        UBRR0 = BAUD_UBRR_FAST;
+    }
+    else{
+        UCSR0A = 0;
+        UBRR0 = BAUD_UBRR;
+    }
+ }
+
+ /**********************************
+ * serial_writechar()
+ *
+ * Queues a character for transmission.  When the tx ring is full the
+ * character is dropped if the drop policy is selected or interrupts
+ * are disabled (the ring could never drain), otherwise this waits for
+ * the interrupt to make room.
+ *
+ * arguments:
+ *  c - the character to send
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the tx ring, the dropped count
+ */
+ void serial_writechar(char c){
+    unsigned char sreg;
+
+    if(dropping){
+        dropped++;
+        return;
+    }
+    while(1){
+        sreg = SREG;
+        cli();
+        if(TX_ROOM()){
+            txbuf[txhead] = c;
+            txhead = (txhead + 1) & TX_MASK;
+            UCSR0B |= (1<<UDRIE0);
+            SREG = sreg;
+            return;
+        }
+        SREG = sreg;
+        if(policy == SERIAL_DROP || !(sreg & (1<<SREG_I))){
+            dropping = (policy == SERIAL_DROP);
+            dropped++;
+            return;
+        }
+    }
+ }
+
+ /**********************************
+ * serial_writestr()
+ *
+ * Queues a null terminated string for transmission
+ *
+ * arguments:
+ *  str - the string to send
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the tx ring
+ */
+ void serial_writestr(char *str){
+    while(*str){
+        serial_writechar(*str++);
+    }
+ }
+
+ /**********************************
+ * serial_writestr_P()
+ *
+ * Queues a null terminated string stored in program memory
+ *
+ * arguments:
+ *  str - the program memory string to send
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the tx ring
+ */
+ void serial_writestr_P(const char *str){
+    char c;
+
+    while((c = pgm_read_byte(str++))){
+        serial_writechar(c);
+    }
+ }
+
+ /**********************************
+ * serial_rxchars()
+ *
+ * Returns the number of received characters waiting in the rx ring
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  the number of characters
+ *
+ * changes:
+ *  none
+ */
+ unsigned char serial_rxchars(void){
+    return (rxhead - rxtail) & RX_MASK;
+ }
+
+ /**********************************
+ * serial_popchar()
+ *
+ * Removes the next character from the rx ring.  In socket mode a line
+ * end consumes a packet.
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  the character, or 0 if the rx ring is empty
+ *
+ * changes:
+ *  the rx ring, the packet count
+ */
+ char serial_popchar(void){
+    char c;
+
+    if(rxhead == rxtail){
+        return 0;
+    }
+    c = rxbuf[rxtail];
+    rxtail = (rxtail + 1) & RX_MASK;
+    if(socket_mode && c == '\r'){
+        packet_available--;
+    }
+    return c;
+ }
+
+ /**********************************
+ * serial_isconnected()
+ *
+ * Switches the receiver to socket mode.  A pending ^D disconnects the
+ * host.
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  1 if the host is connected, 0 otherwise
+ *
+ * changes:
+ *  the socket mode and connection state
+ */
+ unsigned char serial_isconnected(void){
+    socket_mode = 1;
+    if(rxhead != rxtail && rxbuf[rxtail] == CH_EOT){
+        socket_connected = 0;
+        rxtail = (rxtail + 1) & RX_MASK;
+    }
+    return socket_connected;
+ }
+
+ /**********************************
+ * serial_is_socket_mode()
+ *
+ * Returns whether the receiver has been switched to socket mode by
+ * serial_isconnected() (the test host protocol)
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  1 in socket mode, 0 in raw mode
+ *
+ * changes:
+ *  none
+ */
+ unsigned char serial_is_socket_mode(void){
+    return socket_mode;
+ }
+
+ /**********************************
+ * serial_is_packet_ready()
+ *
+ * Returns the number of complete lines received in socket mode
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  the number of lines
+ *
+ * changes:
+ *  none
+ */
+ unsigned char serial_is_packet_ready(void){
+    return packet_available;
+ }
+
+ /**********************************
+ * serial_set_policy()
+ *
+ * Selects the tx ring overflow policy.  Ends any drop in progress.
+ *
+ * arguments:
+ *  p - SERIAL_BLOCK or SERIAL_DROP
+ *
+ * returns:
+ *  the previous policy
+ *
+ * changes:
+ *  the policy
+ */
+ unsigned char serial_set_policy(unsigned char p){
+    unsigned char old = policy;
+
+    policy = p;
+    dropping = 0;
+    return old;
+ }
+
+ /**********************************
+ * serial_get_tx_free()
+ *
+ * Returns the number of characters that can be queued without waiting
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  the free space of the tx ring
+ *
+ * changes:
+ *  none
+ */
+ unsigned char serial_get_tx_free(void){
+    return TX_ROOM();
+ }
+
+ /**********************************
+ * serial_get_dropped()
+ *
+ * Returns the number of tx characters dropped since startup (by the
+ * drop policy or while interrupts were disabled)
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  the number of characters
+ *
+ * changes:
+ *  none
+ */
+ unsigned long serial_get_dropped(void){
+    return dropped;
+ }
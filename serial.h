@@ -0,0 +1,126 @@
+/********************************************************
+ * serial.h
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file provides declarations for the interrupt driven serial
+ * port used by the uart library functions.  Transmitted characters
+ * are queued in a ring buffer that is drained by the data register
+ * empty interrupt, so writing to the uart only waits when the ring
+ * is full - and not at all when the drop policy is selected.
+ */
+
+#ifndef SERIAL_H_INCLUDED
+#define SERIAL_H_INCLUDED
+
+/* ring buffer sizes (powers of 2) */
+#define SERIAL_TX_SIZE      64
+#define SERIAL_RX_SIZE      64
+
+/* baud rates for serial_set_baud() */
+#define SERIAL_BAUD_9600    0   /* the library default */
+#define SERIAL_BAUD_115200  1   /* double speed, 2.1% error at 16MHz */
+
+/* overflow policy of serial_writechar() when the tx ring is full */
+#define SERIAL_BLOCK        0   /* wait for the interrupt to make room */
+#define SERIAL_DROP         1   /* discard the character */
+
+/**********************************
+ * serial_init()
+ *
+ * Configures the uart for 9600 baud 8N1 and enables the receive and
+ * data register empty interrupts
+ */
+void serial_init(void);
+
+/**********************************
+ * serial_set_baud()
+ *
+ * Changes the baud rate (SERIAL_BAUD_9600 or SERIAL_BAUD_115200).  Any
+ * character being sent is corrupted, so wait for the tx ring to drain.
+ */
+void serial_set_baud(unsigned char baud);
+
+/**********************************
+ * serial_writechar()
+ *
+ * Queues a character for transmission (see serial_set_policy() for
+ * the behavior when the tx ring is full)
+ */
+void serial_writechar(char c);
+
+/**********************************
+ * serial_writestr()
+ *
+ * Queues a null terminated string for transmission
+ */
+void serial_writestr(char *str);
+
+/**********************************
+ * serial_writestr_P()
+ *
+ * Queues a null terminated string stored in program memory
+ */
+void serial_writestr_P(const char *str);
+
+/**********************************
+ * serial_rxchars()
+ *
+ * Returns the number of received characters waiting in the rx ring
+ */
+unsigned char serial_rxchars(void);
+
+/**********************************
+ * serial_popchar()
+ *
+ * Returns the next received character (0 if there is none)
+ */
+char serial_popchar(void);
+
+/**********************************
+ * serial_isconnected()
+ *
+ * Switches the receiver to socket (line) mode and returns whether
+ * the host is connected
+ */
+unsigned char serial_isconnected(void);
+
+/**********************************
+ * serial_is_socket_mode()
+ *
+ * Returns 1 once the receiver is in socket mode (the test host owns the
+ * received characters), 0 in raw mode
+ */
+unsigned char serial_is_socket_mode(void);
+
+/**********************************
+ * serial_is_packet_ready()
+ *
+ * Returns the number of complete lines received in socket mode
+ */
+unsigned char serial_is_packet_ready(void);
+
+/**********************************
+ * serial_set_policy()
+ *
+ * Selects SERIAL_BLOCK or SERIAL_DROP for a full tx ring and returns
+ * the previous policy
+ */
+unsigned char serial_set_policy(unsigned char policy);
+
+/**********************************
+ * serial_get_tx_free()
+ *
+ * Returns the number of characters that fit in the tx ring
+ */
+unsigned char serial_get_tx_free(void);
+
+/**********************************
+ * serial_get_dropped()
+ *
+ * Returns the number of tx characters dropped since startup
+ */
+unsigned long serial_get_dropped(void);
+
+#endif // SERIAL_H_INCLUDED
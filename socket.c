@@ -0,0 +1,1848 @@
+/********************************************************
+ * socket.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file implements the socket (TCP) and udpsocket (udp) functions
+ * declared in socket.h, replacing the library implementation so that
+ * socket data moves through the W5100 block transfer routines
+ * (w5burst.h) instead of one spi transaction per byte.  The behavior
+ * of each function follows the library.  In addition, the receive
+ * buffer of each socket is addressed from its own base (the library
+ * read socket 1 data from 0x4800, the socket 1 transmit buffer),
+ * and udpsocket_recvfrom() no longer copies more than len bytes.
+ * On a udp socket the socket_send() family adds to the current datagram
+ * instead of sending, so the json writers can fill a datagram too.
+ * Buffer sizes follow the layout set with w5burst_set_layout(), and the
+ * high-water mark of each transmit buffer is kept, along with the
+ * number of sends that had to wait for the buffer to drain, so that
+ * the layout can be sized from real traffic.
+ *
+ * Functions:
+ *
+ * socket_open(), socket_connect(), socket_disconnect(), socket_close(),
+ * socket_listen()
+ *  Open, connect and close a TCP socket
+ *
+ * socket_is_active(), socket_is_listening(), socket_is_established(),
+ * socket_is_closed()
+ *  Return the state of a TCP socket
+ *
+ * socket_send(), socket_send_P(), socket_writechar(), socket_writestr(),
+ * socket_writequotedstring(), socket_writestr_P(),
+ * socket_writequotedstring_P(), socket_writehex8(), socket_writehex16(),
+ * socket_writedec32(), socket_writedate(), socket_write_macaddress()
+ *  Send data to the remote host
+ *
+ * socket_recv_available(), socket_received_line(), socket_is_blank_line(),
+ * socket_peek(), socket_recv(), socket_recv_int(), socket_recv_compare(),
+ * socket_flush_line()
+ *  Examine and receive data from the remote host
+ *
+ * udpsocket_open(), udpsocket_open_multicast(), udpsocket_close(),
+ * udpsocket_is_open(), udpsocket_is_closed()
+ *  Open and close a udp socket
+ *
+ * udpsocket_sendto(), udpsocket_start_datagram(),
+ * udpsocket_add_to_datagram(), udpsocket_send_datagram()
+ *  Send datagrams
+ *
+ * udpsocket_recv_available(), udpsocket_recvfrom(), udpsocket_recv_data()
+ *  Receive datagrams
+ *
+ * udpsocket_set_window(), udpsocket_get_window_count()
+ *  Select part of the data written to a datagram
+ *
+ * socket_cursor_open(), socket_cursor_peek(), socket_cursor_get(),
+ * socket_cursor_match(), socket_cursor_match_P(), socket_cursor_skip(),
+ * socket_cursor_int(), socket_cursor_ulong(), socket_cursor_commit(),
+ * socket_cursor_flush()
+ *  Examine received data in place and remove it with one RECV command
+ *
+ * socket_get_tx_peak(), socket_get_tx_stalls()
+ *  Return the transmit buffer diagnostics
+ *
+ * note_tx_use()
+ *  Updates the transmit buffer high-water mark
+ *
+ * cursor_peek_at()
+ *  Returns the byte at an offset from a cursor's start
+ *
+ * cursor_digits()
+ *  Reads decimal digits at a cursor
+ *
+ * open_socket()
+ *  Opens a socket in the specified mode
+ *
+ * tx_reserve()
+ *  Waits for room in the transmit buffer
+ *
+ * tx_send()
+ *  Sends the data written to the transmit buffer
+ *
+ * tx_write()
+ *  Copies data into the transmit buffer
+ *
+ * datagram_append()
+ *  Adds data to the datagram being built on a udp socket
+ *
+ * rx_read()
+ *  Copies data out of the receive buffer
+ *
+ * rx_consume()
+ *  Removes data from the receive buffer
+ */
+
+ #include <string.h>
+ #include <avr/pgmspace.h>
+ #include "socket.h"
+ #include "w51.h"
+ #include "w5burst.h"
+ #include "rtc.h"
+ #include "fmt.h"
+
+ /* socket mode register */
+ #define SNMR_TCP            0x01
+ #define SNMR_UDP            0x02
+ #define SNMR_IPRAW          0x03
+ #define SNMR_MACRAW         0x04
+ #define SNMR_PROTOCOL       0x07
+ #define SNMR_MULTI          0x80
+
+ /* socket commands */
+ #define SNCR_OPEN           0x01
+ #define SNCR_LISTEN         0x02
+ #define SNCR_CONNECT        0x04
+ #define SNCR_DISCON         0x08
+ #define SNCR_CLOSE          0x10
+ #define SNCR_SEND           0x20
+ #define SNCR_RECV           0x40
+
+ /* socket interrupt register */
+ #define SNIR_TIMEOUT        0x08
+ #define SNIR_SEND_OK        0x10
+
+ /* socket status register */
+ #define SNSR_CLOSED         0x00
+ #define SNSR_INIT           0x13
+ #define SNSR_LISTEN         0x14
+ #define SNSR_ESTABLISHED    0x17
+ #define SNSR_CLOSING        0x1A
+ #define SNSR_CLOSE_WAIT     0x1C
+ #define SNSR_UDP            0x22
+
+ /* chunk size used to scan the receive buffer */
+ #define SCAN_CHUNK          16
+
+ static unsigned int local_port;
+ static unsigned int tx_peak[W5_NUM_SOCKETS];
+ static unsigned int tx_stalls[W5_NUM_SOCKETS];
+
+ /* udp sockets (a bit per socket) - socket_send() adds to their datagram */
+ static unsigned char udp_sockets;
+
+ /* window over the data written to the datagram of window_socket (none if
+ * W5_NUM_SOCKETS) - the first window_skip bytes are dropped, then at most
+ * window_limit bytes are kept.  window_count counts every byte written.
+ */
+ static SOCKET window_socket = W5_NUM_SOCKETS;
+ static unsigned int window_skip;
+ static unsigned int window_limit;
+ static unsigned int window_count;
+
+ /**********************************
+ * note_tx_use()
+ *
+ * Updates the high-water mark of a transmit buffer with the data about
+ * to be written
+ *
+ * arguments:
+ *  s - the socket
+ *  freesize - free space in the buffer before the write
+ *  len - number of bytes to be written
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  tx_peak
+ */
+ static void note_tx_use(SOCKET s, unsigned int freesize, unsigned int len){
+    unsigned int used = w5burst_get_tx_size(s) - freesize + len;
+
+    if(used > tx_peak[s]){
+        tx_peak[s] = used;
+    }
+ }
+
+ /**********************************
+ * tx_write()
+ *
+ * Copies data into the transmit buffer of a socket at an offset from the
+ * start of the data not yet sent, and moves the write pointer past it
+ *
+ * arguments:
+ *  s - the socket
+ *  offset - offset from the start of the unsent data
+ *  buf - the data
+ *  len - number of bytes
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the socket transmit buffer and Sn_TX_WR
+ */
+ static void tx_write(SOCKET s, unsigned int offset, const unsigned char *buf, unsigned int len){
+    unsigned int ptr = W5x_readSnTX_RD(s) + offset;
+
+    w5burst_write_tx(s, ptr, buf, len);
+    W5x_writeSnTX_WR(s, ptr + len);
+ }
+
+ /**********************************
+ * datagram_append()
+ *
+ * Adds data to the end of the datagram being built on a udp socket,
+ * keeping only the part inside the window (if one is set) and what fits
+ * in the transmit buffer
+ *
+ * arguments:
+ *  s - the socket
+ *  buf - the data
+ *  len - number of bytes
+ *
+ * returns:
+ *  len
+ *
+ * changes:
+ *  the socket transmit buffer and Sn_TX_WR, tx_peak, window_count
+ */
+ static unsigned int datagram_append(SOCKET s, const unsigned char *buf, unsigned int len){
+    unsigned int start = 0;
+    unsigned int end = len;
+    unsigned int kept;
+    unsigned int ptr;
+    unsigned int room;
+
+    if(s == window_socket){
+        /* buf holds bytes [window_count, window_count + len) of the data */
+        if(window_count < window_skip){
+            start = (window_skip - window_count > len) ? len : window_skip - window_count;
+            kept = 0;
+        }
+        else{
+            kept = window_count - window_skip;
+        }
+        room = (kept < window_limit) ? window_limit - kept : 0;
+        if(end - start > room){
+            end = start + room;
+        }
+        window_count += len;
+        if(start == end){
+            return len;
+        }
+    }
+
+    ptr = W5x_readSnTX_WR(s);
+    room = w5burst_get_tx_size(s) - (ptr - W5x_readSnTX_RD(s));
+    if(end - start > room){
+        end = start + room;
+    }
+    note_tx_use(s, room, end - start);
+    w5burst_write_tx(s, ptr, buf + start, end - start);
+    W5x_writeSnTX_WR(s, ptr + end - start);
+    return len;
+ }
+
+ /**********************************
+ * rx_read()
+ *
+ * Copies data out of the receive buffer of a socket without removing it
+ *
+ * arguments:
+ *  s - the socket
+ *  offset - offset from the start of the received data
+ *  buf - where the data is placed
+ *  len - number of bytes
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  buf
+ */
+ static void rx_read(SOCKET s, unsigned int offset, unsigned char *buf, unsigned int len){
+    w5burst_read_rx(s, W5x_readSnRX_RD(s) + offset, buf, len);
+ }
+
+ /**********************************
+ * rx_consume()
+ *
+ * Removes data from the receive buffer of a socket
+ *
+ * arguments:
+ *  s - the socket
+ *  len - number of bytes
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  Sn_RX_RD
+ */
+ static void rx_consume(SOCKET s, unsigned int len){
+    W5x_writeSnRX_RD(s, W5x_readSnRX_RD(s) + len);
+    W5x_execCmdSn(s, SNCR_RECV);
+ }
+
+ /**********************************
+ * open_socket()
+ *
+ * Closes the socket and opens it again in the specified mode
+ *
+ * arguments:
+ *  s - the socket
+ *  mode - value for the socket mode register
+ *  port - local port (0 to use the next ephemeral port)
+ *
+ * returns:
+ *  1
+ *
+ * changes:
+ *  socket registers, local_port, udp_sockets
+ */
+ static unsigned char open_socket(SOCKET s, unsigned char mode, unsigned int port){
+    socket_close(s);
+    if((mode & SNMR_PROTOCOL) == SNMR_UDP){
+        udp_sockets |= 1 << s;
+    }
+    else{
+        udp_sockets &= ~(1 << s);
+    }
+    W5x_writeSnMR(s, mode);
+    if(port == 0){
+        port = ++local_port;
+    }
+    W5x_writeSnPORT(s, port);
+    W5x_execCmdSn(s, SNCR_OPEN);
+    return 1;
+ }
+
+ /**********************************
+ * socket_open()
+ *
+ * Opens the socket in TCP mode
+ *
+ * arguments:
+ *  s - the socket
+ *  port - local port (0 to use the next ephemeral port)
+ *
+ * returns:
+ *  1
+ *
+ * changes:
+ *  socket registers
+ */
+ unsigned char socket_open(SOCKET s, unsigned int port){
+    return open_socket(s, SNMR_TCP, port);
+ }
+
+ /**********************************
+ * socket_connect()
+ *
+ * Starts a connection to a remote host
+ *
+ * arguments:
+ *  s - the socket
+ *  addr - ip address of the remote host
+ *  port - port of the remote host
+ *
+ * returns:
+ *  1 if the connection was started, 0 if the address or port is invalid
+ *
+ * changes:
+ *  socket registers
+ */
+ unsigned char socket_connect(SOCKET s, unsigned char *addr, unsigned int port){
+    if((addr[0] == 0xFF && addr[1] == 0xFF && addr[2] == 0xFF && addr[3] == 0xFF) ||
+       (addr[0] == 0 && addr[1] == 0 && addr[2] == 0 && addr[3] == 0) ||
+       port == 0){
+        return 0;
+    }
+    W5x_writeSnDIPR(s, addr);
+    W5x_writeSnDPORT(s, port);
+    W5x_execCmdSn(s, SNCR_CONNECT);
+    return 1;
+ }
+
+ /**********************************
+ * socket_disconnect()
+ *
+ * Starts a graceful disconnect from the remote host
+ *
+ * arguments:
+ *  s - the socket
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  socket registers
+ */
+ void socket_disconnect(SOCKET s){
+    W5x_execCmdSn(s, SNCR_DISCON);
+ }
+
+ /**********************************
+ * socket_close()
+ *
+ * Closes the socket immediately and clears its interrupt flags
+ *
+ * arguments:
+ *  s - the socket
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  socket registers
+ */
+ void socket_close(SOCKET s){
+    W5x_execCmdSn(s, SNCR_CLOSE);
+    W5x_writeSnIR(s, 0xFF);
+ }
+
+ /**********************************
+ * socket_listen()
+ *
+ * Places an opened TCP socket in listen mode
+ *
+ * arguments:
+ *  s - the socket
+ *
+ * returns:
+ *  1 on success, 0 if the socket is not opened
+ *
+ * changes:
+ *  socket registers
+ */
+ unsigned char socket_listen(SOCKET s){
+    if(W5x_readSnSR(s) != SNSR_INIT){
+        return 0;
+    }
+    W5x_execCmdSn(s, SNCR_LISTEN);
+    return 1;
+ }
+
+ /**********************************
+ * socket_is_active()
+ *
+ * Checks whether the socket is open and not closing
+ *
+ * arguments:
+ *  s - the socket
+ *
+ * returns:
+ *  1 if the socket is active, otherwise 0
+ *
+ * changes:
+ *  none
+ */
+ unsigned char socket_is_active(SOCKET s){
+    unsigned char status = W5x_readSnSR(s);
+
+    return status != SNSR_CLOSED && status != SNSR_CLOSE_WAIT && status != SNSR_CLOSING;
+ }
+
+ /**********************************
+ * socket_is_listening()
+ *
+ * arguments:
+ *  s - the socket
+ *
+ * returns:
+ *  1 if the socket is in the LISTEN state, otherwise 0
+ *
+ * changes:
+ *  none
+ */
+ unsigned char socket_is_listening(SOCKET s){
+    return W5x_readSnSR(s) == SNSR_LISTEN;
+ }
+
+ /**********************************
+ * socket_is_established()
+ *
+ * arguments:
+ *  s - the socket
+ *
+ * returns:
+ *  1 if the socket is in the ESTABLISHED state, otherwise 0
+ *
+ * changes:
+ *  none
+ */
+ unsigned char socket_is_established(SOCKET s){
+    return W5x_readSnSR(s) == SNSR_ESTABLISHED;
+ }
+
+ /**********************************
+ * socket_is_closed()
+ *
+ * arguments:
+ *  s - the socket
+ *
+ * returns:
+ *  1 if the socket is in the CLOSED state, otherwise 0
+ *
+ * changes:
+ *  none
+ */
+ unsigned char socket_is_closed(SOCKET s){
+    return W5x_readSnSR(s) == SNSR_CLOSED;
+ }
+
+ /**********************************
+ * tx_reserve()
+ *
+ * Waits for room for len bytes in the transmit buffer, counting a stall
+ * if it has to, and updates the high-water mark
+ *
+ * arguments:
+ *  s - the socket
+ *  len - number of bytes (at most the buffer size is reserved)
+ *
+ * returns:
+ *  the number of bytes that may be written, or 0 if the connection was
+ *  lost
+ *
+ * changes:
+ *  tx_peak, tx_stalls
+ */
+ static unsigned int tx_reserve(SOCKET s, unsigned int len){
+    unsigned int size = w5burst_get_tx_size(s);
+    unsigned int ret = (len > size) ? size : len;
+    unsigned int freesize;
+    unsigned char status;
+    unsigned char stalled = 0;
+
+    do{
+        freesize = W5x_getTXFreeSize(s);
+        status = W5x_readSnSR(s);
+        if(status != SNSR_ESTABLISHED && status != SNSR_CLOSE_WAIT){
+            return 0;
+        }
+        if(freesize < ret && !stalled){
+            stalled = 1;
+            tx_stalls[s]++;
+        }
+    } while(freesize < ret);
+
+    note_tx_use(s, freesize, ret);
+    return ret;
+ }
+
+ /**********************************
+ * tx_send()
+ *
+ * Issues the SEND command for the data written to the transmit buffer
+ * and waits for the W5100 to send it
+ *
+ * arguments:
+ *  s - the socket
+ *  len - number of bytes written
+ *
+ * returns:
+ *  len, or 0 if the connection was closed
+ *
+ * changes:
+ *  socket registers
+ */
+ static unsigned int tx_send(SOCKET s, unsigned int len){
+    W5x_execCmdSn(s, SNCR_SEND);
+
+    while(!(W5x_readSnIR(s) & SNIR_SEND_OK)){
+        if(W5x_readSnSR(s) == SNSR_CLOSED){
+            socket_close(s);
+            return 0;
+        }
+    }
+    W5x_writeSnIR(s, SNIR_SEND_OK);
+    return len;
+ }
+
+ /**********************************
+ * socket_send()
+ *
+ * Waits for room in the transmit buffer (counting a stall if it has to),
+ * copies the data into it in at most two blocks and waits for the W5100
+ * to send it.  On a udp socket the data is added to the datagram, which
+ * is sent by udpsocket_send_datagram().
+ *
+ * arguments:
+ *  s - the socket
+ *  buf - the data
+ *  len - number of bytes (at most the buffer size is sent)
+ *
+ * returns:
+ *  the number of bytes sent, or 0 if the connection was lost
+ *
+ * changes:
+ *  socket registers and transmit buffer, tx_peak, tx_stalls
+ */
+ unsigned int socket_send(SOCKET s, const unsigned char *buf, unsigned int len){
+    unsigned int ret;
+
+    if(udp_sockets & (1 << s)){
+        return datagram_append(s, buf, len);
+    }
+    ret = tx_reserve(s, len);
+
+    /* as in the library, a lost connection still issues the SEND command */
+    tx_write(s, 0, buf, ret);
+    return tx_send(s, ret);
+ }
+
+ /**********************************
+ * socket_writechar()
+ *
+ * Sends a single character
+ *
+ * arguments:
+ *  s - the socket
+ *  ch - the character
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  socket registers and transmit buffer
+ */
+ void socket_writechar(SOCKET s, const char ch){
+    socket_send(s, (const unsigned char*)&ch, 1);
+ }
+
+ /**********************************
+ * socket_writestr()
+ *
+ * Sends a string (not including the terminating null)
+ *
+ * arguments:
+ *  s - the socket
+ *  str - the string
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  socket registers and transmit buffer
+ */
+ void socket_writestr(SOCKET s, const char *str){
+    socket_send(s, (const unsigned char*)str, strlen(str));
+ }
+
+ /**********************************
+ * socket_writequotedstring()
+ *
+ * Sends a string enclosed in double quotes
+ *
+ * arguments:
+ *  s - the socket
+ *  str - the string
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  socket registers and transmit buffer
+ */
+ void socket_writequotedstring(SOCKET s, const char *str){
+    socket_writechar(s, '"');
+    socket_writestr(s, str);
+    socket_writechar(s, '"');
+ }
+
+ /**********************************
+ * socket_send_P()
+ *
+ * Sends data stored in program memory.  Each block that fits in the
+ * transmit buffer is copied into it SCAN_CHUNK bytes at a time and sent
+ * with a single SEND command, so data larger than the buffer is streamed
+ * in one pass without a RAM copy.  On a udp socket the data is added to
+ * the datagram.
+ *
+ * arguments:
+ *  s - the socket
+ *  data - the program memory data
+ *  len - number of bytes
+ *
+ * returns:
+ *  the number of bytes sent (less than len if the connection was lost)
+ *
+ * changes:
+ *  socket registers and transmit buffer, tx_peak, tx_stalls
+ */
+ unsigned int socket_send_P(SOCKET s, const unsigned char *data, unsigned int len){
+    unsigned char buf[SCAN_CHUNK];
+    unsigned int sent = 0;
+    unsigned int block;
+    unsigned int offset;
+    unsigned int n;
+
+    if(udp_sockets & (1 << s)){
+        for(sent = 0; sent < len; sent += n){
+            n = (len - sent > SCAN_CHUNK) ? SCAN_CHUNK : len - sent;
+            memcpy_P(buf, data + sent, n);
+            datagram_append(s, buf, n);
+        }
+        return len;
+    }
+    do{
+        block = tx_reserve(s, len - sent);
+        for(offset = 0; offset < block; offset += n){
+            n = (block - offset > SCAN_CHUNK) ? SCAN_CHUNK : block - offset;
+            memcpy_P(buf, data + sent + offset, n);
+            tx_write(s, offset, buf, n);
+        }
+        /* as socket_send(), a lost connection still issues the SEND command */
+        if(!tx_send(s, block)){
+            break;
+        }
+        sent += block;
+    } while(sent < len);
+    return sent;
+ }
+
+ /**********************************
+ * socket_writestr_P()
+ *
+ * Sends a string stored in program memory (not including the terminating
+ * null), as socket_send_P()
+ *
+ * arguments:
+ *  s - the socket
+ *  str - the program memory string
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  socket registers and transmit buffer
+ */
+ void socket_writestr_P(SOCKET s, const char *str){
+    socket_send_P(s, (const unsigned char*)str, strlen_P(str));
+ }
+
+ /**********************************
+ * socket_writequotedstring_P()
+ *
+ * Sends a string stored in program memory enclosed in double quotes
+ *
+ * arguments:
+ *  s - the socket
+ *  str - the program memory string
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  socket registers and transmit buffer
+ */
+ void socket_writequotedstring_P(SOCKET s, const char *str){
+    socket_writechar(s, '"');
+    socket_writestr_P(s, str);
+    socket_writechar(s, '"');
+ }
+
+ /**********************************
+ * socket_writehex8()
+ *
+ * Sends an 8-bit value as two uppercase hexadecimal digits
+ *
+ * arguments:
+ *  s - the socket
+ *  x - the value
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  socket registers and transmit buffer
+ */
+ void socket_writehex8(SOCKET s, const unsigned char x){
+    char text[FMT_HEX8_SIZE];
+
+    socket_send(s, (const unsigned char*)text, fmt_hex8(text, x));
+ }
+
+ /**********************************
+ * socket_writehex16()
+ *
+ * Sends a 16-bit value as four uppercase hexadecimal digits
+ *
+ * arguments:
+ *  s - the socket
+ *  x - the value
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  socket registers and transmit buffer
+ */
+ void socket_writehex16(SOCKET s, const unsigned int x){
+    char text[FMT_HEX16_SIZE];
+
+    socket_send(s, (const unsigned char*)text, fmt_hex16(text, x));
+ }
+
+ /**********************************
+ * socket_writedec32()
+ *
+ * Sends an integer as decimal text (without leading zeros)
+ *
+ * arguments:
+ *  s - the socket
+ *  n - the value
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  socket registers and transmit buffer
+ */
+ void socket_writedec32(SOCKET s, int n){
+    char text[FMT_S32_SIZE];
+
+    socket_send(s, (const unsigned char*)text, fmt_s32(text, n));
+ }
+
+ /**********************************
+ * socket_writedate()
+ *
+ * Sends the date (MM/DD/YYYY) of an rtc date/time number in double quotes
+ *
+ * arguments:
+ *  s - the socket
+ *  datenum - the rtc date/time number
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  socket registers and transmit buffer
+ */
+ void socket_writedate(SOCKET s, unsigned long datenum){
+    char *date = rtc_num2datestr(datenum);
+
+    date[10] = 0;
+    socket_writequotedstring(s, date);
+ }
+
+ /**********************************
+ * socket_write_macaddress()
+ *
+ * Sends a mac address as six colon separated hexadecimal bytes in
+ * double quotes
+ *
+ * arguments:
+ *  s - the socket
+ *  mac_address - the 6 bytes of the address
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  socket registers and transmit buffer
+ */
+ void socket_write_macaddress(SOCKET s, unsigned char *mac_address){
+    char text[FMT_MAC_SIZE + 1];
+    unsigned char len;
+
+    text[0] = '"';
+    len = fmt_mac(text + 1, mac_address) + 1;
+    text[len++] = '"';
+    socket_send(s, (const unsigned char*)text, len);
+ }
+
+ /**********************************
+ * socket_recv_available()
+ *
+ * arguments:
+ *  s - the socket
+ *
+ * returns:
+ *  the number of bytes in the receive buffer
+ *
+ * changes:
+ *  none
+ */
+ int socket_recv_available(SOCKET s){
+    return W5x_getRXReceivedSize(s);
+ }
+
+ /**********************************
+ * socket_received_line()
+ *
+ * Scans the receive buffer for a line feed, a chunk at a time
+ *
+ * arguments:
+ *  s - the socket
+ *
+ * returns:
+ *  1 if a complete line has been received, otherwise 0
+ *
+ * changes:
+ *  none
+ */
+ unsigned char socket_received_line(SOCKET s){
+    unsigned char chunk[SCAN_CHUNK];
+    unsigned int size = W5x_getRXReceivedSize(s);
+    unsigned int offset;
+    unsigned int len;
+    unsigned int i;
+
+    for(offset = 0; offset < size; offset += len){
+        len = (size - offset > SCAN_CHUNK) ? SCAN_CHUNK : size - offset;
+        rx_read(s, offset, chunk, len);
+        for(i = 0; i < len; i++){
+            if(chunk[i] == '\n'){
+                return 1;
+            }
+        }
+    }
+    return 0;
+ }
+
+ /**********************************
+ * socket_is_blank_line()
+ *
+ * arguments:
+ *  s - the socket
+ *
+ * returns:
+ *  1 if the receive buffer is empty or starts with a CR or LF, otherwise 0
+ *
+ * changes:
+ *  none
+ */
+ unsigned char socket_is_blank_line(SOCKET s){
+    unsigned char ch;
+
+    if(W5x_getRXReceivedSize(s) == 0){
+        return 1;
+    }
+    rx_read(s, 0, &ch, 1);
+    return ch == '\r' || ch == '\n';
+ }
+
+ /**********************************
+ * socket_peek()
+ *
+ * Reads the first byte of the receive buffer without removing it
+ *
+ * arguments:
+ *  s - the socket
+ *  buf - where the byte is placed
+ *
+ * returns:
+ *  1
+ *
+ * changes:
+ *  buf
+ */
+ unsigned int socket_peek(SOCKET s, unsigned char *buf){
+    rx_read(s, 0, buf, 1);
+    return 1;
+ }
+
+ /**********************************
+ * socket_recv()
+ *
+ * Copies data out of the receive buffer in at most two blocks and
+ * removes it
+ *
+ * arguments:
+ *  s - the socket
+ *  buf - where the data is placed
+ *  len - maximum number of bytes
+ *
+ * returns:
+ *  the number of bytes received, 0 if none are available, or -1 if there
+ *  is no data and the connection is still open
+ *
+ * changes:
+ *  buf, socket registers
+ */
+ int socket_recv(SOCKET s, unsigned char *buf, int len){
+    int ret = W5x_getRXReceivedSize(s);
+    unsigned char status;
+
+    if(ret == 0){
+        status = W5x_readSnSR(s);
+        if(status == SNSR_LISTEN || status == SNSR_CLOSED || status == SNSR_CLOSE_WAIT){
+            ret = 0;
+        }
+        else{
+            ret = -1;
+        }
+    }
+    else if(ret > len){
+        ret = len;
+    }
+    if(ret > 0){
+        rx_read(s, 0, buf, ret);
+        rx_consume(s, ret);
+    }
+    return ret;
+ }
+
+ /**********************************
+ * socket_recv_int()
+ *
+ * Receives decimal text (with an optional leading '-') up to a CR, LF or
+ * space.  Other characters are skipped.
+ *
+ * arguments:
+ *  s - the socket
+ *  num - where the value is placed
+ *
+ * returns:
+ *  1 if at least one digit was received, otherwise 0
+ *
+ * changes:
+ *  num, socket registers
+ */
+ unsigned char socket_recv_int(SOCKET s, int *num){
+    unsigned char digits = 0;
+    int sign = 1;
+    unsigned char ch;
+
+    *num = 0;
+    if(W5x_getRXReceivedSize(s) == 0){
+        return 0;
+    }
+    while(W5x_getRXReceivedSize(s) > 0){
+        rx_read(s, 0, &ch, 1);
+        if(ch == '-'){
+            if(digits != 0){
+                return 0;
+            }
+            sign = -1;
+        }
+        else if(ch >= '0' && ch <= '9'){
+            *num = *num * 10 + (ch - '0');
+            digits++;
+        }
+        else if(ch == '\n' || ch == '\r' || ch == ' '){
+            break;
+        }
+        rx_consume(s, 1);
+    }
+    *num *= sign;
+    return digits != 0;
+ }
+
+ /**********************************
+ * socket_recv_compare()
+ *
+ * Compares the start of the receive buffer with a string, removing it if
+ * it matches
+ *
+ * arguments:
+ *  s - the socket
+ *  str - the string
+ *
+ * returns:
+ *  1 if the string matched (and was removed), otherwise 0
+ *
+ * changes:
+ *  socket registers
+ */
+ unsigned char socket_recv_compare(SOCKET s, const char *str){
+    unsigned char chunk[SCAN_CHUNK];
+    unsigned int size = strlen(str);
+    unsigned int offset;
+    unsigned int len;
+
+    if(W5x_getRXReceivedSize(s) < size){
+        return 0;
+    }
+    for(offset = 0; offset < size; offset += len){
+        len = (size - offset > SCAN_CHUNK) ? SCAN_CHUNK : size - offset;
+        rx_read(s, offset, chunk, len);
+        if(memcmp(chunk, str + offset, len) != 0){
+            return 0;
+        }
+    }
+    if(size > 0){
+        rx_consume(s, size);
+    }
+    return 1;
+ }
+
+ /**********************************
+ * socket_flush_line()
+ *
+ * Removes data from the receive buffer up to and including the end of
+ * the line (CR LF, or LF CR), or until the buffer is empty
+ *
+ * arguments:
+ *  s - the socket
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  socket registers
+ */
+ void socket_flush_line(SOCKET s){
+    unsigned char ch;
+    unsigned char pair;
+
+    while(W5x_getRXReceivedSize(s) > 0){
+        socket_recv(s, &ch, 1);
+        if(ch == '\r' || ch == '\n'){
+            pair = (ch == '\r') ? '\n' : '\r';
+            if(W5x_getRXReceivedSize(s) > 0){
+                rx_read(s, 0, &ch, 1);
+                if(ch == pair){
+                    rx_consume(s, 1);
+                }
+            }
+            return;
+        }
+    }
+ }
+
+ /**********************************
+ * udpsocket_open()
+ *
+ * Opens the socket in udp mode
+ *
+ * arguments:
+ *  s - the socket
+ *  port - local port (0 to use the next ephemeral port)
+ *
+ * returns:
+ *  1
+ *
+ * changes:
+ *  socket registers
+ */
+ unsigned char udpsocket_open(SOCKET s, unsigned int port){
+    return open_socket(s, SNMR_UDP, port);
+ }
+
+ /**********************************
+ * udpsocket_open_multicast()
+ *
+ * Opens the socket in udp multicast mode on a multicast group.  Like
+ * udpsocket_open(), it marks the socket as udp, so that the socket_send()
+ * family builds datagrams on it.
+ *
+ * arguments:
+ *  s - the socket
+ *  address - the multicast group address
+ *  port - the multicast port (local and remote)
+ *
+ * returns:
+ *  1
+ *
+ * changes:
+ *  socket registers, udp_sockets
+ */
+ unsigned char udpsocket_open_multicast(SOCKET s, unsigned char *address, unsigned int port){
+    unsigned char mac[6];
+
+    mac[0] = 0x01;
+    mac[1] = 0x00;
+    mac[2] = 0x5E;
+    mac[3] = address[1] & 0x7F;
+    mac[4] = address[2];
+    mac[5] = address[3];
+    W5x_writeSnDHAR(s, mac);
+    W5x_writeSnDIPR(s, address);
+    W5x_writeSnDPORT(s, port);
+    return open_socket(s, SNMR_UDP | SNMR_MULTI, port);
+ }
+
+ /**********************************
+ * udpsocket_close()
+ *
+ * Closes the socket and clears its interrupt flags
+ *
+ * arguments:
+ *  s - the socket
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  socket registers
+ */
+ void udpsocket_close(SOCKET s){
+    socket_close(s);
+ }
+
+ /**********************************
+ * udpsocket_is_open()
+ *
+ * arguments:
+ *  s - the socket
+ *
+ * returns:
+ *  1 if the socket is open in udp mode, otherwise 0
+ *
+ * changes:
+ *  none
+ */
+ unsigned char udpsocket_is_open(SOCKET s){
+    return W5x_readSnSR(s) == SNSR_UDP;
+ }
+
+ /**********************************
+ * udpsocket_is_closed()
+ *
+ * arguments:
+ *  s - the socket
+ *
+ * returns:
+ *  1 if the socket is closed, otherwise 0
+ *
+ * changes:
+ *  none
+ */
+ unsigned char udpsocket_is_closed(SOCKET s){
+    return W5x_readSnSR(s) == SNSR_CLOSED;
+ }
+
+ /**********************************
+ * udpsocket_sendto()
+ *
+ * Sends a datagram and waits for it to be sent
+ *
+ * arguments:
+ *  s - the socket
+ *  buf - the data
+ *  len - number of bytes (at most the buffer size is sent)
+ *  addr - ip address of the remote host
+ *  port - port of the remote host
+ *
+ * returns:
+ *  the number of bytes sent, or 0 on error or timeout
+ *
+ * changes:
+ *  socket registers and transmit buffer, tx_peak
+ */
+ unsigned int udpsocket_sendto(SOCKET s, const unsigned char *buf, unsigned int len, unsigned char *addr, unsigned int port){
+    unsigned int size = w5burst_get_tx_size(s);
+    unsigned int ret = (len > size) ? size : len;
+
+    if((addr[0] == 0 && addr[1] == 0 && addr[2] == 0 && addr[3] == 0) || port == 0 || ret == 0){
+        return 0;
+    }
+    W5x_writeSnDIPR(s, addr);
+    W5x_writeSnDPORT(s, port);
+    note_tx_use(s, W5x_getTXFreeSize(s), ret);
+    tx_write(s, 0, buf, ret);
+    return udpsocket_send_datagram(s) ? ret : 0;
+ }
+
+ /**********************************
+ * udpsocket_start_datagram()
+ *
+ * Sets the destination of a datagram built with udpsocket_add_to_datagram()
+ * or the socket_send() family, and drops the data of a datagram that was
+ * not sent
+ *
+ * arguments:
+ *  s - the socket
+ *  addr - ip address of the remote host
+ *  port - port of the remote host
+ *
+ * returns:
+ *  1 on success, 0 if the address or port is invalid
+ *
+ * changes:
+ *  socket registers
+ */
+ int udpsocket_start_datagram(SOCKET s, unsigned char *addr, unsigned int port){
+    if((addr[0] == 0 && addr[1] == 0 && addr[2] == 0 && addr[3] == 0) || port == 0){
+        return 0;
+    }
+    W5x_writeSnDIPR(s, addr);
+    W5x_writeSnDPORT(s, port);
+    W5x_writeSnTX_WR(s, W5x_readSnTX_RD(s));
+    return 1;
+ }
+
+ /**********************************
+ * udpsocket_add_to_datagram()
+ *
+ * Copies data into the datagram at an offset from its start
+ *
+ * arguments:
+ *  s - the socket
+ *  offset - offset of the data in the datagram
+ *  buf - the data
+ *  len - number of bytes (limited to the free space in the buffer)
+ *
+ * returns:
+ *  the number of bytes added
+ *
+ * changes:
+ *  socket registers and transmit buffer, tx_peak
+ */
+ unsigned int udpsocket_add_to_datagram(SOCKET s, unsigned int offset, const unsigned char *buf, unsigned int len){
+    unsigned int freesize = W5x_getTXFreeSize(s);
+
+    if(len > freesize){
+        len = freesize;
+    }
+    note_tx_use(s, freesize, len);
+    tx_write(s, offset, buf, len);
+    return len;
+ }
+
+ /**********************************
+ * udpsocket_send_datagram()
+ *
+ * Sends the datagram in the transmit buffer and waits for it to be sent.
+ * A window set on the socket ends with the datagram.
+ *
+ * arguments:
+ *  s - the socket
+ *
+ * returns:
+ *  1 if the datagram was sent, 0 on timeout
+ *
+ * changes:
+ *  socket registers, window_socket
+ */
+ int udpsocket_send_datagram(SOCKET s){
+    unsigned char ir;
+
+    if(s == window_socket){
+        window_socket = W5_NUM_SOCKETS;
+    }
+    W5x_execCmdSn(s, SNCR_SEND);
+    while(!((ir = W5x_readSnIR(s)) & SNIR_SEND_OK)){
+        if(ir & SNIR_TIMEOUT){
+            W5x_writeSnIR(s, SNIR_SEND_OK | SNIR_TIMEOUT);
+            return 0;
+        }
+    }
+    W5x_writeSnIR(s, SNIR_SEND_OK);
+    return 1;
+ }
+
+ /**********************************
+ * udpsocket_recv_available()
+ *
+ * arguments:
+ *  s - the socket
+ *
+ * returns:
+ *  the number of bytes in the receive buffer (including datagram headers)
+ *
+ * changes:
+ *  none
+ */
+ int udpsocket_recv_available(SOCKET s){
+    return W5x_getRXReceivedSize(s);
+ }
+
+ /**********************************
+ * udpsocket_recvfrom()
+ *
+ * Receives the next datagram (or raw packet) and its source.  Data past
+ * len bytes is discarded.
+ *
+ * arguments:
+ *  s - the socket
+ *  buf - where the data is placed
+ *  len - maximum number of bytes
+ *  addr - where the source ip address is placed
+ *  port - where the source port is placed
+ *
+ * returns:
+ *  the number of bytes placed in buf
+ *
+ * changes:
+ *  buf, addr, port, socket registers
+ */
+ unsigned int udpsocket_recvfrom(SOCKET s, unsigned char *buf, unsigned int len, unsigned char *addr, unsigned int *port){
+    unsigned char head[8];
+    unsigned int ptr;
+    unsigned int size;
+
+    if(len == 0){
+        return 0;
+    }
+    ptr = W5x_readSnRX_RD(s);
+    switch(W5x_readSnMR(s) & SNMR_PROTOCOL){
+    case SNMR_UDP:
+        w5burst_read_rx(s, ptr, head, 8);
+        ptr += 8;
+        memcpy(addr, head, 4);
+        *port = ((unsigned int)head[4] << 8) | head[5];
+        size = ((unsigned int)head[6] << 8) | head[7];
+        break;
+    case SNMR_IPRAW:
+        w5burst_read_rx(s, ptr, head, 6);
+        ptr += 6;
+        memcpy(addr, head, 4);
+        size = ((unsigned int)head[4] << 8) | head[5];
+        break;
+    case SNMR_MACRAW:
+        w5burst_read_rx(s, ptr, head, 2);
+        ptr += 2;
+        size = (((unsigned int)head[0] << 8) | head[1]) - 2;
+        break;
+    default:
+        return 0;
+    }
+    w5burst_read_rx(s, ptr, buf, (size > len) ? len : size);
+    W5x_writeSnRX_RD(s, ptr + size);
+    W5x_execCmdSn(s, SNCR_RECV);
+    return (size > len) ? len : size;
+ }
+
+ /**********************************
+ * udpsocket_recv_data()
+ *
+ * Receives raw data from the receive buffer (headers are not parsed)
+ *
+ * arguments:
+ *  s - the socket
+ *  buf - where the data is placed
+ *  len - maximum number of bytes
+ *
+ * returns:
+ *  the number of bytes received
+ *
+ * changes:
+ *  buf, socket registers
+ */
+ unsigned int udpsocket_recv_data(SOCKET s, unsigned char *buf, unsigned int len){
+    unsigned int size = W5x_getRXReceivedSize(s);
+
+    if(len > size){
+        len = size;
+    }
+    if(len > 0){
+        rx_read(s, 0, buf, len);
+        rx_consume(s, len);
+    }
+    return len;
+ }
+
+ /**********************************
+ * udpsocket_set_window()
+ *
+ * Selects part of the data written to the datagram of a udp socket with
+ * the socket_send() family: the first skip bytes are dropped and at most
+ * limit bytes after them are kept.  Used to send one block of a larger
+ * response, or (with limit 0) to measure its length.  The window ends
+ * when the datagram is sent, or when a window is set on another socket.
+ *
+ * arguments:
+ *  s - the socket
+ *  skip - number of bytes to drop
+ *  limit - maximum number of bytes to keep
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  window_socket, window_skip, window_limit, window_count
+ */
+ void udpsocket_set_window(SOCKET s, unsigned int skip, unsigned int limit){
+    window_socket = s;
+    window_skip = skip;
+    window_limit = limit;
+    window_count = 0;
+ }
+
+ /**********************************
+ * udpsocket_get_window_count()
+ *
+ * Returns the number of bytes written since the window was set,
+ * including the bytes that were dropped
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  the number of bytes
+ *
+ * changes:
+ *  none
+ */
+ unsigned int udpsocket_get_window_count(){
+    return window_count;
+ }
+
+ /**********************************
+ * cursor_peek_at()
+ *
+ * Returns the received byte at an offset from the start of the cursor,
+ * reading the next SOCKET_CURSOR_CACHE bytes from the W5100 in one block
+ * if it is not cached
+ *
+ * arguments:
+ *  c - the cursor
+ *  offset - offset from the start of the cursor
+ *
+ * returns:
+ *  the byte, or -1 if it had not been received when the cursor was opened
+ *
+ * changes:
+ *  the cursor cache
+ */
+ static int cursor_peek_at(socket_cursor *c, unsigned int offset){
+    unsigned int len;
+
+    if(offset >= c->avail){
+        return -1;
+    }
+    if(offset < c->cache_pos || offset >= c->cache_pos + c->cache_len){
+        len = c->avail - offset;
+        if(len > SOCKET_CURSOR_CACHE){
+            len = SOCKET_CURSOR_CACHE;
+        }
+        w5burst_read_rx(c->s, c->rd + offset, c->cache, len);
+        c->cache_pos = offset;
+        c->cache_len = len;
+    }
+    return c->cache[offset - c->cache_pos];
+ }
+
+ /**********************************
+ * cursor_digits()
+ *
+ * Reads decimal digits at the cursor up to the first other character.
+ * A number that does not fit in an unsigned long is refused, so that it
+ * cannot wrap into a valid value.
+ *
+ * arguments:
+ *  c - the cursor
+ *  num - where the value is placed
+ *
+ * returns:
+ *  the number of digits read, or 0 if there are none or the value is too
+ *  large
+ *
+ * changes:
+ *  num, the cursor
+ */
+ static unsigned char cursor_digits(socket_cursor *c, unsigned long *num){
+    unsigned char digits = 0;
+    int ch;
+
+    *num = 0;
+    while((ch = cursor_peek_at(c, c->pos)) >= '0' && ch <= '9'){
+        if(*num > 429496729UL || (*num == 429496729UL && ch > '5')){
+            return 0;
+        }
+        *num = *num * 10 + (ch - '0');
+        c->pos++;
+        digits++;
+    }
+    return digits;
+ }
+
+ /**********************************
+ * socket_cursor_open()
+ *
+ * Opens a cursor at the start of the receive buffer of a socket.  The
+ * receive pointer and received size are read here and nowhere else.
+ *
+ * arguments:
+ *  c - the cursor
+ *  s - the socket
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the cursor
+ */
+ void socket_cursor_open(socket_cursor *c, SOCKET s){
+    c->s = s;
+    c->rd = W5x_readSnRX_RD(s);
+    c->avail = W5x_getRXReceivedSize(s);
+    c->pos = 0;
+    c->cache_pos = 0;
+    c->cache_len = 0;
+ }
+
+ /**********************************
+ * socket_cursor_peek()
+ *
+ * Returns the byte at the cursor without moving it
+ *
+ * arguments:
+ *  c - the cursor
+ *
+ * returns:
+ *  the byte, or -1 if there is none
+ *
+ * changes:
+ *  the cursor cache
+ */
+ int socket_cursor_peek(socket_cursor *c){
+    return cursor_peek_at(c, c->pos);
+ }
+
+ /**********************************
+ * socket_cursor_get()
+ *
+ * Returns the byte at the cursor and moves the cursor past it
+ *
+ * arguments:
+ *  c - the cursor
+ *
+ * returns:
+ *  the byte, or -1 if there is none
+ *
+ * changes:
+ *  the cursor
+ */
+ int socket_cursor_get(socket_cursor *c){
+    int ch = cursor_peek_at(c, c->pos);
+
+    if(ch >= 0){
+        c->pos++;
+    }
+    return ch;
+ }
+
+ /**********************************
+ * socket_cursor_match()
+ *
+ * Compares the bytes at the cursor with a string, moving the cursor past
+ * them if they match
+ *
+ * arguments:
+ *  c - the cursor
+ *  str - the string
+ *
+ * returns:
+ *  1 if the string matched, otherwise 0
+ *
+ * changes:
+ *  the cursor
+ */
+ unsigned char socket_cursor_match(socket_cursor *c, const char *str){
+    unsigned int i;
+
+    for(i = 0; str[i]; i++){
+        if(cursor_peek_at(c, c->pos + i) != (unsigned char)str[i]){
+            return 0;
+        }
+    }
+    c->pos += i;
+    return 1;
+ }
+
+ /**********************************
+ * socket_cursor_match_P()
+ *
+ * Compares the bytes at the cursor with a string stored in program
+ * memory, moving the cursor past them if they match
+ *
+ * arguments:
+ *  c - the cursor
+ *  str - the program memory string
+ *
+ * returns:
+ *  1 if the string matched, otherwise 0
+ *
+ * changes:
+ *  the cursor
+ */
+ unsigned char socket_cursor_match_P(socket_cursor *c, const char *str){
+    unsigned int i;
+    unsigned char ch;
+
+    for(i = 0; (ch = pgm_read_byte(str + i)); i++){
+        if(cursor_peek_at(c, c->pos + i) != ch){
+            return 0;
+        }
+    }
+    c->pos += i;
+    return 1;
+ }
+
+ /**********************************
+ * socket_cursor_skip()
+ *
+ * Moves the cursor past up to max bytes, stopping before the stop
+ * character or at the end of the data
+ *
+ * arguments:
+ *  c - the cursor
+ *  max - maximum number of bytes to skip
+ *  stop - character to stop at
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the cursor
+ */
+ void socket_cursor_skip(socket_cursor *c, unsigned int max, char stop){
+    int ch;
+
+    while(max-- > 0 && (ch = cursor_peek_at(c, c->pos)) >= 0 && ch != (unsigned char)stop){
+        c->pos++;
+    }
+ }
+
+ /**********************************
+ * socket_cursor_int()
+ *
+ * Reads an integer (decimal digits with an optional leading '-') at the
+ * cursor, up to the first other character.  Values beyond +/-0x7FFF are
+ * refused (as by the CoAP server) rather than wrapped.
+ *
+ * arguments:
+ *  c - the cursor
+ *  num - where the value is placed
+ *
+ * returns:
+ *  1 if at least one digit was read and the value is in range, otherwise 0
+ *
+ * changes:
+ *  num, the cursor
+ */
+ unsigned char socket_cursor_int(socket_cursor *c, int *num){
+    unsigned long value;
+    unsigned char negative = 0;
+
+    if(cursor_peek_at(c, c->pos) == '-'){
+        negative = 1;
+        c->pos++;
+    }
+    if(!cursor_digits(c, &value) || value > 0x7FFF){
+        *num = 0;
+        return 0;
+    }
+    *num = negative ? -(int)value : (int)value;
+    return 1;
+ }
+
+ /**********************************
+ * socket_cursor_ulong()
+ *
+ * Reads an unsigned long (decimal digits) at the cursor, up to the first
+ * other character
+ *
+ * arguments:
+ *  c - the cursor
+ *  num - where the value is placed (unchanged if there are no digits)
+ *
+ * returns:
+ *  1 if at least one digit was read and the value fits, otherwise 0
+ *
+ * changes:
+ *  num, the cursor
+ */
+ unsigned char socket_cursor_ulong(socket_cursor *c, unsigned long *num){
+    unsigned long value;
+
+    if(!cursor_digits(c, &value)){
+        return 0;
+    }
+    *num = value;
+    return 1;
+ }
+
+ /**********************************
+ * socket_cursor_commit()
+ *
+ * Removes the bytes before the cursor from the receive buffer with a single
+ * RECV command, and restarts the cursor at the new start of the buffer
+ *
+ * arguments:
+ *  c - the cursor
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the cursor, Sn_RX_RD
+ */
+ void socket_cursor_commit(socket_cursor *c){
+    if(c->pos == 0){
+        return;
+    }
+    c->rd += c->pos;
+    c->avail -= c->pos;
+    c->pos = 0;
+    c->cache_len = 0;
+    W5x_writeSnRX_RD(c->s, c->rd);
+    W5x_execCmdSn(c->s, SNCR_RECV);
+ }
+
+ /**********************************
+ * socket_cursor_flush()
+ *
+ * Removes everything in the receive buffer (including data received after
+ * the cursor was opened) with a single RECV command
+ *
+ * arguments:
+ *  c - the cursor
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the cursor, Sn_RX_RD
+ */
+ void socket_cursor_flush(socket_cursor *c){
+    c->pos = W5x_getRXReceivedSize(c->s);
+    c->avail = c->pos;
+    socket_cursor_commit(c);
+ }
+
+ /**********************************
+ * socket_get_tx_peak()
+ *
+ * Returns the high-water mark of the transmit buffer of a socket
+ *
+ * arguments:
+ *  s - the socket
+ *
+ * returns:
+ *  the largest number of bytes queued in the buffer since startup
+ *
+ * changes:
+ *  none
+ */
+ unsigned int socket_get_tx_peak(SOCKET s){
+    return tx_peak[s];
+ }
+
+ /**********************************
+ * socket_get_tx_stalls()
+ *
+ * Returns the number of sends on a socket that had to wait for room in
+ * the transmit buffer
+ *
+ * arguments:
+ *  s - the socket
+ *
+ * returns:
+ *  the stall count since startup
+ *
+ * changes:
+ *  none
+ */
+ unsigned int socket_get_tx_stalls(SOCKET s){
+    return tx_stalls[s];
+ }
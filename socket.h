@@ -62,6 +62,11 @@ unsigned char socket_is_closed(SOCKET s);
 /* send the contents of the buffer to the remote host */
 unsigned int  socket_send(SOCKET s, const unsigned char * buf, unsigned int len);
 
+/* send data stored in program memory (PROGMEM), in as many blocks as the transmit
+* buffer requires
+*/
+unsigned int  socket_send_P(SOCKET s, const unsigned char * data, unsigned int len);
+
 /* send a single character to the remote host */
 void          socket_writechar(SOCKET s, const char ch);
 
@@ -71,6 +76,12 @@ void          socket_writestr(SOCKET s, const char*str);
 /* send the specified ascii string to the remote host, enclosed in double quote characters */
 void          socket_writequotedstring(SOCKET s, const char*str);
 
+/* as socket_writestr() and socket_writequotedstring(), for a string stored in program
+* memory (PSTR() or PROGMEM)
+*/
+void          socket_writestr_P(SOCKET s, const char*str);
+void          socket_writequotedstring_P(SOCKET s, const char*str);
+
 /* send the specified 8-bit integer to the remote host as a hexadecimal, text representation */
 void          socket_writehex8(SOCKET s, const unsigned char x);
 
@@ -175,6 +186,88 @@ unsigned int  udpsocket_recvfrom(SOCKET s, unsigned char * buf, unsigned int len
 */
 unsigned int  udpsocket_recv_data(SOCKET s, unsigned char *buf, unsigned int len);
 
+/* on a udp socket, the socket_send() family adds to the datagram started with
+* udpsocket_start_datagram().  The window drops the first skip bytes written and
+* keeps at most limit bytes after them, until the datagram is sent.
+*/
+void          udpsocket_set_window(SOCKET s, unsigned int skip, unsigned int limit);
+
+/* returns the number of bytes written since the window was set (including dropped bytes) */
+unsigned int  udpsocket_get_window_count();
+
+/*****************************************************************
+* Receive Cursor Functions
+******************************************************************/
+/* number of received bytes a cursor reads from the W5100 at a time */
+#define SOCKET_CURSOR_CACHE 32
+
+/* a cursor over the data in a socket's receive buffer.  The receive pointer
+* and received size are read once when the cursor is opened, bytes are
+* examined in place at a local offset, and nothing is removed from the
+* buffer until the cursor is committed.
+*/
+typedef struct {
+    SOCKET        s;
+    unsigned int  rd;           /* receive pointer when the cursor was opened */
+    unsigned int  avail;        /* bytes received when the cursor was opened */
+    unsigned int  pos;          /* offset of the next byte */
+    unsigned int  cache_pos;    /* offset of the first cached byte */
+    unsigned char cache_len;
+    unsigned char cache[SOCKET_CURSOR_CACHE];
+} socket_cursor;
+
+/* open a cursor at the start of the socket's receive buffer */
+void          socket_cursor_open(socket_cursor *c, SOCKET s);
+
+/* return the next byte without moving the cursor, or -1 if there is none */
+int           socket_cursor_peek(socket_cursor *c);
+
+/* return the next byte and move the cursor past it, or -1 if there is none */
+int           socket_cursor_get(socket_cursor *c);
+
+/* if the next bytes match the string, move the cursor past them and return 1,
+* otherwise return 0 (the cursor does not move)
+*/
+unsigned char socket_cursor_match(socket_cursor *c, const char *str);
+
+/* as socket_cursor_match(), for a string stored in program memory */
+unsigned char socket_cursor_match_P(socket_cursor *c, const char *str);
+
+/* move the cursor past up to max bytes, stopping before the stop character */
+void          socket_cursor_skip(socket_cursor *c, unsigned int max, char stop);
+
+/* read decimal digits (with an optional leading '-') up to the first other
+* character.  Returns 1 if at least one digit was read and the value is
+* within +/-0x7FFF, otherwise 0.
+*/
+unsigned char socket_cursor_int(socket_cursor *c, int *num);
+
+/* read decimal digits up to the first other character.  Returns 1 if at least
+* one digit was read and the value fits in an unsigned long, otherwise 0.
+*/
+unsigned char socket_cursor_ulong(socket_cursor *c, unsigned long *num);
+
+/* remove the bytes before the cursor from the receive buffer */
+void          socket_cursor_commit(socket_cursor *c);
+
+/* remove everything in the receive buffer (including data received since the
+* cursor was opened)
+*/
+void          socket_cursor_flush(socket_cursor *c);
+
+/*****************************************************************
+* Diagnostics
+******************************************************************/
+/* return the largest number of bytes queued in the socket's transmit buffer
+* since startup (its high-water mark)
+*/
+unsigned int  socket_get_tx_peak(SOCKET s);
+
+/* return the number of sends on the socket that had to wait for room in the
+* transmit buffer
+*/
+unsigned int  socket_get_tx_stalls(SOCKET s);
+
 
 #endif
 /* _SOCKET_H_ */
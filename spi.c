@@ -0,0 +1,183 @@
+/********************************************************
+ * spi.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file implements the spi bus functions declared in spi.h,
+ * replacing the library implementation so that bus transactions can
+ * be counted.  The bus is the hardware spi port in master mode, with
+ * the slave select of the Ethernet controller on PB2.
+ *
+ * Functions:
+ *
+ * spi_init()
+ *  Configures the spi pins and enables the spi port in master mode
+ *
+ * spi_is_locked()
+ *  Returns 1 while a transaction holds the bus
+ *
+ * spi_begin_transfer()
+ *  Starts a transaction (configures the port and selects the slave)
+ *
+ * spi_transfer()
+ *  Exchanges one byte
+ *
+ * spi_end_transfer()
+ *  Ends a transaction (deselects the slave)
+ *
+ * spi_get_transactions()
+ *  Returns the number of transactions since startup
+ */
+
+ #include <avr/io.h>
+ #include <avr/interrupt.h>
+ #include "spi.h"
+
+ static volatile unsigned char locked;
+ static volatile unsigned long transactions;
+
+ /**********************************
+ * spi_init()
+ *
+ * Configures slave select, MOSI and SCK as outputs (slave deselected)
+ * and enables the spi port in master mode
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  spi port and pin registers, locked
+ */
+ void spi_init(){
+    unsigned char sreg = SREG;
+
+    cli();
+    if(!(DDRB & (1<<DDB2))){
+        PORTB |= (1<<PB2);
+    }
+    DDRB |= (1<<DDB2) | (1<<DDB5) | (1<<DDB3);
+    PORTB &= ~(1<<PB5);
+    SPCR |= (1<<MSTR);
+    SPCR |= (1<<SPE);
+    locked = 0;
+    SREG = sreg;
+ }
+
+ /**********************************
+ * spi_is_locked()
+ *
+ * Returns 1 while a transaction holds the spi bus
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  1 if the bus is in use, otherwise 0
+ *
+ * changes:
+ *  none
+ */
+ unsigned char spi_is_locked(){
+    return locked;
+ }
+
+ /**********************************
+ * spi_begin_transfer()
+ *
+ * Starts a transaction: sets the spi control and status registers for the
+ * device and selects the slave.  As in the library, nothing is done if the
+ * bus is already held.
+ *
+ * arguments:
+ *  spcr - value for the spi control register
+ *  spsr - value for the spi status register (SPI2X)
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  SPCR, SPSR, locked, transactions
+ */
+ void spi_begin_transfer(unsigned char spcr, unsigned char spsr){
+    unsigned char sreg;
+
+    if(locked){
+        return;
+    }
+    sreg = SREG;
+    cli();
+    SPCR = spcr;
+    SPSR = spsr;
+    locked = 1;
+    SREG = sreg;
+    transactions++;
+    PORTB &= ~(1<<PB2);
+ }
+
+ /**********************************
+ * spi_transfer()
+ *
+ * Writes a byte to the bus and returns the byte received at the same time
+ *
+ * arguments:
+ *  data - the byte to send
+ *
+ * returns:
+ *  the received byte
+ *
+ * changes:
+ *  SPDR
+ */
+ unsigned char spi_transfer(unsigned char data){
+    SPDR = data;
+    __asm__ __volatile__ ("nop");
+    while(!(SPSR & (1<<SPIF))){}
+    return SPDR;
+ }
+
+ /**********************************
+ * spi_end_transfer()
+ *
+ * Deselects the slave and releases the bus
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  locked
+ */
+ void spi_end_transfer(){
+    PORTB |= (1<<PB2);
+    locked = 0;
+ }
+
+ /**********************************
+ * spi_get_transactions()
+ *
+ * Returns the number of transactions started since startup
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  the transaction count
+ *
+ * changes:
+ *  none
+ */
+ unsigned long spi_get_transactions(){
+    unsigned long count;
+    unsigned char sreg = SREG;
+
+    cli();
+    count = transactions;
+    SREG = sreg;
+    return count;
+ }
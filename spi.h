@@ -13,7 +13,7 @@
 #define SPIE0   7
 
 /* bit definitions for SPI Status Register 0 */
-#define SPI2X0  1
+#define SPI2X0  0
 #define WCOL0   6
 #define SPIF0   7
 
@@ -34,4 +34,12 @@
   */
   void spi_end_transfer(void);
 
+  // returns 1 while a transaction holds the spi bus
+  unsigned char spi_is_locked(void);
+
+  /* returns the number of transactions (spi_begin_transfer() calls) since
+  * startup - used to measure the spi traffic of the main loop
+  */
+  unsigned long spi_get_transactions(void);
+
 #endif // SPI_H_INCLUDED
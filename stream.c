@@ -0,0 +1,446 @@
+/********************************************************
+ * stream.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file implements the binary sample stream declared in stream.h.
+ * While streaming, the ADC is auto triggered by the timer0 compare
+ * match that drives the millisecond tick, so there is one sample per
+ * ms.  At 115200 baud a frame of 8 samples (56 bytes encoded) takes
+ * about 4.8ms to send, leaving the line idle 40% of the time.
+ *
+ * The whole file is compiled out unless STREAM_ENABLE is 1.
+ *
+ * Functions:
+ *
+ * stream_update()
+ *  Switches the stream on and off and sends the queued samples
+ *
+ * stream_is_active()
+ *  Returns whether the ADC is owned by the stream
+ *
+ * stream_get_temp()
+ *  Returns the temperature of the latest filtered sample
+ *
+ * stream_get_frames()
+ *  Returns the number of frames sent
+ *
+ * stream_get_lost()
+ *  Returns the number of samples lost
+ *
+ * key_pressed()
+ *  Checks the received characters for STREAM_KEY
+ *
+ * line_idle()
+ *  Returns whether the uart has finished sending
+ *
+ * adc_start()
+ *  Starts the auto triggered conversions
+ *
+ * adc_stop()
+ *  Returns the ADC to single conversions
+ *
+ * send_cobs()
+ *  Sends a COBS encoded frame
+ *
+ * send_frame()
+ *  Builds and sends a frame of samples
+ */
+
+ #include <avr/io.h>
+ #include <avr/interrupt.h>
+ #include "stream.h"
+ #include "serial.h"
+ #include "ulog.h"
+ #include "clock.h"
+ #include "crc16.h"
+
+ #if STREAM_ENABLE
+
+ #define RING_MASK          (STREAM_RING_SIZE - 1)
+ #define FRAME_SIZE         (STREAM_HEADER_SIZE + STREAM_FRAME_SAMPLES * STREAM_SAMPLE_SIZE + STREAM_CRC_SIZE)
+
+ /* encoded frame - one COBS overhead byte (frames are shorter than 254
+ * bytes) and the zero delimiter
+ */
+ #define FRAME_ENCODED_SIZE (FRAME_SIZE + 2)
+
+ /* temp_init() settings - internal temperature sensor, 1.1V reference,
+ * ADC clock fosc/64
+ */
+ #define ADC_SINGLE         ((1<<ADEN) | (1<<ADPS2) | (1<<ADPS1))
+
+ /* ADTS value for the timer0 compare match A trigger */
+ #define ADC_TRIGGER_TIMER0 ((1<<ADTS1) | (1<<ADTS0))
+
+ enum stream_state {STREAM_OFF, STREAM_STARTING, STREAM_ON, STREAM_STOPPING};
+
+ typedef struct {
+    unsigned int tick;
+    unsigned int raw;
+ } stream_sample;
+
+ /* written by the ADC interrupt */
+ static stream_sample ring[STREAM_RING_SIZE];
+ static volatile unsigned char head;
+ static volatile unsigned char tail;
+ static volatile unsigned char lost;
+ static volatile unsigned int tick;
+
+ /* filtered value of the last sample sent */
+ static unsigned int filtered;
+
+ static unsigned char state = STREAM_OFF;
+ static unsigned char seq;
+ static unsigned char saved_level;
+ static unsigned long drain_start;
+ static unsigned long frames;
+ static unsigned long lost_total;
+
+ /**********************************
+ * ADC_vect
+ *
+ * Conversion complete (once per ms while streaming) - queues the sample,
+ * counting it as lost if the ring is full
+ */
+ ISR(ADC_vect){
+    unsigned int raw = ADC;
+    unsigned char next = (head + 1) & RING_MASK;
+
+    tick++;
+    if(next == tail){
+        if(lost != 0xFF){
+            lost++;
+        }
+        return;
+    }
+    ring[head].tick = tick;
+    ring[head].raw = raw;
+    head = next;
+ }
+
+ /**********************************
+ * key_pressed()
+ *
+ * Removes the received characters (unless the test host owns the
+ * receiver) and checks them for STREAM_KEY
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  1 if STREAM_KEY was received, 0 otherwise
+ *
+ * changes:
+ *  the serial rx ring
+ */
+ static unsigned char key_pressed(){
+    unsigned char pressed = 0;
+
+    if(serial_is_socket_mode()){
+        return 0;
+    }
+    while(serial_rxchars()){
+        if(serial_popchar() == STREAM_KEY){
+            pressed = 1;
+        }
+    }
+    return pressed;
+ }
+
+ /**********************************
+ * line_idle()
+ *
+ * Returns whether the uart tx ring has been empty for STREAM_DRAIN_MS,
+ * so that the last character has been sent and the baud rate can change
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  1 if the line is idle, 0 otherwise
+ *
+ * changes:
+ *  drain_start
+ */
+ static unsigned char line_idle(){
+    if(serial_get_tx_free() != SERIAL_TX_SIZE - 1){
+        drain_start = clock_ms();
+        return 0;
+    }
+    return clock_ms() - drain_start >= STREAM_DRAIN_MS;
+ }
+
+ /**********************************
+ * adc_start()
+ *
+ * Empties the sample ring, seeds the filter with the last conversion and
+ * starts conversions on every timer0 compare match
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the ADC registers, the sample ring and filter
+ */
+ static void adc_start(){
+    unsigned char sreg = SREG;
+
+    cli();
+    head = 0;
+    tail = 0;
+    lost = 0;
+    tick = 0;
+    filtered = ADC << STREAM_FILTER_Q;
+    ADCSRB = ADC_TRIGGER_TIMER0;
+    ADCSRA = ADC_SINGLE | (1<<ADATE) | (1<<ADIF) | (1<<ADIE);
+    SREG = sreg;
+ }
+
+ /**********************************
+ * adc_stop()
+ *
+ * Returns the ADC to the single conversions started by temp_start()
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the ADC registers
+ */
+ static void adc_stop(){
+    ADCSRA = ADC_SINGLE;
+    ADCSRB = 0;
+ }
+
+ /**********************************
+ * send_cobs()
+ *
+ * Sends data with consistent overhead byte stuffing followed by the zero
+ * delimiter.  Each run of up to 254 non-zero bytes is preceded by its
+ * length + 1, which replaces the zero that follows it.
+ *
+ * arguments:
+ *  data - the frame to send
+ *  len - length of the frame
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the serial tx ring
+ */
+ static void send_cobs(const unsigned char *data, unsigned char len){
+    unsigned char start = 0;
+    unsigned char end;
+    unsigned char i;
+
+    while(1){
+        end = start;
+        while(end < len && data[end] != 0 && end - start < 254){
+            end++;
+        }
+        serial_writechar(end - start + 1);
+        for(i = start; i < end; i++){
+            serial_writechar(data[i]);
+        }
+        if(end >= len){
+            break;
+        }
+        /* skip the zero replaced by the run length */
+        start = (data[end] == 0) ? end + 1 : end;
+    }
+    serial_writechar(0);
+ }
+
+ /**********************************
+ * send_frame()
+ *
+ * Takes STREAM_FRAME_SAMPLES samples from the ring, runs them through
+ * the low-pass filter and sends them with their filtered values as a
+ * frame
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the sample ring, filtered, seq, frames, lost_total
+ */
+ static void send_frame(){
+    unsigned char frame[FRAME_SIZE];
+    unsigned char *p = frame;
+    stream_sample *sample;
+    unsigned char sreg;
+    unsigned char i;
+    unsigned int crc;
+
+    *p++ = STREAM_TYPE_SAMPLES;
+    *p++ = seq++;
+    sreg = SREG;
+    cli();
+    *p = lost;
+    lost = 0;
+    SREG = sreg;
+    lost_total += *p++;
+    *p++ = STREAM_FRAME_SAMPLES;
+    for(i = 0; i < STREAM_FRAME_SAMPLES; i++){
+        sample = &ring[tail];
+        filtered += (sample->raw << (STREAM_FILTER_Q - STREAM_FILTER_SHIFT)) - (filtered >> STREAM_FILTER_SHIFT);
+        *p++ = sample->tick;
+        *p++ = sample->tick >> 8;
+        *p++ = sample->raw;
+        *p++ = sample->raw >> 8;
+        *p++ = filtered;
+        *p++ = filtered >> 8;
+        tail = (tail + 1) & RING_MASK;
+    }
+    crc = crc16(frame, p - frame);
+    *p++ = crc;
+    *p++ = crc >> 8;
+    send_cobs(frame, FRAME_SIZE);
+    frames++;
+ }
+
+ /**********************************
+ * stream_update()
+ *
+ * Runs the stream state machine.  Starting and stopping wait for the
+ * uart to finish sending before the baud rate is changed.  While
+ * streaming, every complete frame of samples that fits in the uart tx
+ * ring is sent.
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the stream state, the uart baud rate and the log level
+ */
+ void stream_update(){
+    switch(state){
+    case STREAM_OFF:
+        if(key_pressed()){
+            saved_level = ulog_get_level();
+            ulog_set_level(ULOG_NONE);
+            drain_start = clock_ms();
+            state = STREAM_STARTING;
+        }
+        break;
+    case STREAM_STARTING:
+        if(line_idle()){
+            serial_set_baud(SERIAL_BAUD_115200);
+            adc_start();
+            state = STREAM_ON;
+        }
+        break;
+    case STREAM_ON:
+        if(key_pressed()){
+            adc_stop();
+            drain_start = clock_ms();
+            state = STREAM_STOPPING;
+            break;
+        }
+        while(((head - tail) & RING_MASK) >= STREAM_FRAME_SAMPLES &&
+                serial_get_tx_free() >= FRAME_ENCODED_SIZE){
+            send_frame();
+        }
+        break;
+    case STREAM_STOPPING:
+        if(line_idle()){
+            serial_set_baud(SERIAL_BAUD_9600);
+            ulog_set_level(saved_level);
+            state = STREAM_OFF;
+        }
+        break;
+    default:
+        break;
+    }
+ }
+
+ /**********************************
+ * stream_is_active()
+ *
+ * Returns whether the ADC is converting for the stream
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  1 while streaming, 0 otherwise
+ *
+ * changes:
+ *  none
+ */
+ unsigned char stream_is_active(){
+    return state == STREAM_ON;
+ }
+
+ /**********************************
+ * stream_get_temp()
+ *
+ * Converts the filtered value of the last sample sent to a temperature
+ * as temp_get() does for a raw conversion
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  the temperature
+ *
+ * changes:
+ *  none
+ */
+ int stream_get_temp(){
+    return (long)filtered * 101 / (100L << STREAM_FILTER_Q) - 273;
+ }
+
+ /**********************************
+ * stream_get_frames()
+ *
+ * Returns the number of frames sent since startup
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  the number of frames
+ *
+ * changes:
+ *  none
+ */
+ unsigned long stream_get_frames(){
+    return frames;
+ }
+
+ /**********************************
+ * stream_get_lost()
+ *
+ * Returns the number of samples lost because the sample ring was full
+ * (each frame reports at most 255)
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  the number of samples
+ *
+ * changes:
+ *  none
+ */
+ unsigned long stream_get_lost(){
+    return lost_total;
+ }
+
+ #endif // STREAM_ENABLE
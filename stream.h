@@ -0,0 +1,106 @@
+/********************************************************
+ * stream.h
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file provides declarations for the binary sample stream used
+ * when commissioning the temperature sensor.  Pressing STREAM_KEY on
+ * the uart (raw mode only) switches the uart to 115200 baud and
+ * starts converting the sensor every millisecond (triggered by the
+ * timer0 compare match of the millisecond tick).  The ADC interrupt
+ * queues each sample with its tick, and stream_update() adds a
+ * low-pass filtered value and sends the samples as COBS encoded
+ * frames terminated by a zero byte.  Pressing STREAM_KEY again (at 115200
+ * baud) returns to 9600 baud and normal operation.  Text output is
+ * suppressed while streaming.
+ *
+ * Frame contents before COBS encoding (multi-byte values little
+ * endian):
+ *
+ *  type     1 byte   STREAM_TYPE_SAMPLES
+ *  seq      1 byte   frame sequence number
+ *  lost     1 byte   samples lost since the previous frame (saturating)
+ *  count    1 byte   number of samples
+ *  samples  6 bytes each - tick (ms, 16 bits), raw adc value and the
+ *                    filtered value (raw adc * 16)
+ *  crc      2 bytes  crc16() of the preceding bytes
+ *
+ * The host side decoder is tools/stream_decode.py, and tools/stream_test.py
+ * checks the frames of stream.c against it.
+ *
+ * The stream is a commissioning aid, so it is only built (with its
+ * task and ADC interrupt) when STREAM_ENABLE is defined as 1.
+ */
+
+#ifndef STREAM_H_INCLUDED
+#define STREAM_H_INCLUDED
+
+#ifndef STREAM_ENABLE
+#define STREAM_ENABLE 0
+#endif
+
+/* key that starts and stops the stream */
+#define STREAM_KEY          'S'
+
+/* frame type and layout */
+#define STREAM_TYPE_SAMPLES 0x01
+#define STREAM_HEADER_SIZE  4
+#define STREAM_SAMPLE_SIZE  6
+#define STREAM_CRC_SIZE     2
+
+/* samples per frame and sample ring size (power of 2) */
+#define STREAM_FRAME_SAMPLES 8
+#define STREAM_RING_SIZE    16
+
+/* filtered value: fixed point with 4 fraction bits, time constant 8 samples */
+#define STREAM_FILTER_Q     4
+#define STREAM_FILTER_SHIFT 3
+
+/* time the uart line must be idle before the baud rate is changed (ms) */
+#define STREAM_DRAIN_MS     3
+
+#if STREAM_ENABLE
+
+/**********************************
+ * stream_update()
+ *
+ * Checks for STREAM_KEY, switches the stream on and off and sends the
+ * queued samples.  Call every few milliseconds - a frame is due every
+ * STREAM_FRAME_SAMPLES ms while streaming.
+ */
+void stream_update();
+
+/**********************************
+ * stream_is_active()
+ *
+ * Returns 1 while the ADC is owned by the stream (temp_start() must not
+ * be called), 0 otherwise
+ */
+unsigned char stream_is_active();
+
+/**********************************
+ * stream_get_temp()
+ *
+ * Returns the temperature (as temp_get()) of the latest filtered
+ * sample while streaming
+ */
+int stream_get_temp();
+
+/**********************************
+ * stream_get_frames()
+ *
+ * Returns the number of frames sent since startup
+ */
+unsigned long stream_get_frames();
+
+/**********************************
+ * stream_get_lost()
+ *
+ * Returns the number of samples lost (sample ring full) since startup
+ */
+unsigned long stream_get_lost();
+
+#endif // STREAM_ENABLE
+
+#endif // STREAM_H_INCLUDED
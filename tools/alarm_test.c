@@ -0,0 +1,189 @@
+/********************************************************
+ * alarm_test.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * Host tests for the alarm module (alarm.c).  The firmware alarm.c,
+ * socket.c and fmt.c run unchanged over the W5100 emulation in
+ * tools/host, bound to 127.0.0.2 with ports offset by 10000.  The alarm
+ * multicast datagrams are mapped to 127.0.0.1 and read back here on port
+ * 18888 (ALARM_PORT offset by 10000).
+ *
+ * The tests check that alarm_send() writes the uart line at once and
+ * sends nothing, that alarm_update() leaves the socket alone while the
+ * dhcp client has it open, that the queued alarms are then sent in order
+ * with the library payload (date and time of the event, serial number,
+ * event number in hex) to 239.1.1.1:8888 and the socket is closed again,
+ * and that an alarm raised with the queue full is still written to the
+ * uart.
+ *
+ *    gcc -O2 -I tools/host -I . -o alarm_test tools/alarm_test.c \
+ *        tools/host/w5emu.c alarm.c socket.c fmt.c
+ *    ./alarm_test
+ *
+ * Functions:
+ *
+ * main()
+ *  Runs the tests
+ *
+ * receive()
+ *  Reads the next alarm datagram from the host socket
+ *
+ * (stand-ins for the rtc, uart, log and vpd)
+ */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <unistd.h>
+ #include <fcntl.h>
+ #include <sys/socket.h>
+ #include <netinet/in.h>
+ #include "alarm.h"
+ #include "vpd.h"
+ #include "socket.h"
+ #include "netboot.h"
+ #include "w5emu.h"
+
+ #define CHECK(cond) do{ \
+        checks++; \
+        if(!(cond)){ \
+            failures++; \
+            printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        } \
+    }while(0)
+
+ vpd_struct vpd = {"SER", "IIoT", "ASU", "SN00100", 0, {0x00, 0x08, 0xDC, 0x00, 0x00, 0x64}, "USA", 0};
+ volatile unsigned char crash_last_sockop;
+
+ static unsigned long checks;
+ static unsigned long failures;
+ static unsigned long rtc_now = 1000;
+ static char uart_out[256];
+ static unsigned int warnings;
+ static int rx_fd;
+
+ unsigned long rtc_get_date(){ return rtc_now; }
+ char *rtc_num2datestr(unsigned long num){
+    static char str[24];
+
+    snprintf(str, sizeof(str), "01/01/2022 00:%02lu:%02lu", num / 60 % 60, num % 60);
+    return str;
+ }
+ void uart_writestr(char *str){ strncat(uart_out, str, sizeof(uart_out) - strlen(uart_out) - 1); }
+ void serial_writestr_P(const char *str){ uart_writestr((char*)str); }
+ void uart_writedec32(signed long num){
+    char buf[12];
+
+    snprintf(buf, sizeof(buf), "%ld", num);
+    uart_writestr(buf);
+ }
+ unsigned char ulog_begin(unsigned char level){ warnings++; return 0; }
+ void ulog_end(){}
+
+ /**********************************
+ * receive()
+ *
+ * Reads the next alarm datagram waiting on the host socket
+ *
+ * arguments:
+ *  buf - where the datagram is placed (null terminated)
+ *  size - size of buf
+ *
+ * returns:
+ *  the datagram length, or -1 if none is waiting
+ *
+ * changes:
+ *  buf
+ */
+ static int receive(char *buf, int size){
+    int n;
+
+    usleep(1000);
+    n = recv(rx_fd, buf, size - 1, 0);
+    buf[(n > 0) ? n : 0] = 0;
+    return n;
+ }
+
+ /**********************************
+ * main()
+ *
+ * Runs the tests and prints the totals
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  0 if every check passed, 1 otherwise
+ *
+ * changes:
+ *  none
+ */
+ int main(){
+    struct sockaddr_in addr;
+    const unsigned char *dest;
+    unsigned int port;
+    char buf[128];
+    char expect[64];
+    int i;
+
+    w5emu_bind_ip = 0x7F000002UL;
+    w5emu_port_offset = 10000;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(8888 + 10000);
+    addr.sin_addr.s_addr = htonl(0x7F000001UL);
+    rx_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if(bind(rx_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0){
+        perror("bind");
+        return 1;
+    }
+    fcntl(rx_fd, F_SETFL, O_NONBLOCK);
+
+    /* the uart line is written at once, nothing is sent */
+    alarm_init();
+    alarm_send(5);
+    CHECK(strcmp(uart_out, "\r\nALARM: 5\r\n") == 0);
+    CHECK(w5emu_sends == 0);
+
+    /* nothing is sent while the dhcp client has the socket open */
+    udpsocket_open(NETBOOT_SOCKET, 68);
+    rtc_now = 1010;
+    alarm_update();
+    CHECK(w5emu_sends == 0);
+    CHECK(udpsocket_is_open(NETBOOT_SOCKET));
+    udpsocket_close(NETBOOT_SOCKET);
+
+    /* sent with the time of the event, and the socket is closed again */
+    alarm_update();
+    CHECK(w5emu_sends == 1);
+    CHECK(receive(buf, sizeof(buf)) > 0);
+    CHECK(strcmp(buf, "01/01/2022 00:16:40 SN00100 05") == 0);
+    dest = w5emu_get_dest(NETBOOT_SOCKET, &port);
+    CHECK(dest[0] == 239 && dest[1] == 1 && dest[2] == 1 && dest[3] == 1 && port == 8888);
+    CHECK(udpsocket_is_closed(NETBOOT_SOCKET));
+    alarm_update();
+    CHECK(w5emu_sends == 1);
+
+    /* a full queue: the fifth alarm only reaches the uart */
+    uart_out[0] = 0;
+    for(i = 0; i < 5; i++){
+        rtc_now = 2000 + i;
+        alarm_send(0x0B + i);
+    }
+    CHECK(strstr(uart_out, "\r\nALARM: 15\r\n") != NULL);
+    CHECK(warnings == 1);
+    alarm_update();
+    CHECK(w5emu_sends == 5);
+    for(i = 0; i < 4; i++){
+        snprintf(expect, sizeof(expect), "01/01/2022 00:33:%02d SN00100 %02X", 20 + i, 0x0B + i);
+        CHECK(receive(buf, sizeof(buf)) > 0);
+        CHECK(strcmp(buf, expect) == 0);
+    }
+    CHECK(receive(buf, sizeof(buf)) < 0);
+    CHECK(udpsocket_is_closed(NETBOOT_SOCKET));
+
+    printf("%lu checks, %lu failures\n", checks, failures);
+    return failures != 0;
+ }
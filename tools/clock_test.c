@@ -0,0 +1,350 @@
+/********************************************************
+ * clock_test.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * Host tests for the clock (clock.c) and the milliseconds of the log
+ * index (logindex.c).  The firmware clock.c and logindex.c run unchanged
+ * over stand-ins for the delay library millisecond count, the rtc, the
+ * timer1 count and the 16 record circular log of the library.
+ *
+ * The clock test moves the millisecond count through 46000 wraps of its
+ * 32 bits (the 16-bit wrap counter of clock.c, about 6200 years), calling
+ * clock_ms() at random points of each wrap and just before and after it,
+ * and checks that clock_uptime() equals the true seconds since startup
+ * modulo 2^32 (the width of the result on the device).  The host unsigned
+ * long is wider, so the result is truncated to 32 bits before the check;
+ * the intermediate products of clock.c fit in 32 bits up to 65535 wraps,
+ * so this is the device result.
+ *
+ * The log index test starts from records read from the eeprom (no
+ * millisecond), then adds records with logindex_add_record() and, as the
+ * tempfsm library does, directly with log_add_record() followed by
+ * logindex_sync(), well past the 16 records of a full log.  After every
+ * record the millisecond of each position must follow its record as the
+ * oldest ones are overwritten.  A record picked up after the rtc second
+ * has changed must have no millisecond, and logindex_clear() must forget
+ * them all.
+ *
+ *    gcc -O2 -I tools/host -I . -o clock_test tools/clock_test.c \
+ *        clock.c logindex.c
+ *    ./clock_test
+ *
+ * Functions:
+ *
+ * main()
+ *  Runs the tests
+ *
+ * test_uptime()
+ *  Checks clock_uptime() across the wraps of the millisecond count
+ *
+ * set_rtc()
+ *  Sets the rtc second and millisecond
+ *
+ * add_expected()
+ *  Adds a record to the expected milliseconds
+ *
+ * check_ms()
+ *  Checks the milliseconds of every log position
+ *
+ * test_logindex()
+ *  Checks the log index milliseconds
+ *
+ * (stand-ins for the delay library, the rtc, timer1 and the log)
+ */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include "clock.h"
+ #include "log.h"
+ #include "logindex.h"
+
+ #define CHECK(cond) do{ \
+        checks++; \
+        if(!(cond)){ \
+            failures++; \
+            printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        } \
+    }while(0)
+
+ #define TEST_WRAPS          46000UL
+ #define CALLS_PER_WRAP      6
+
+ volatile unsigned char SREG;
+ volatile unsigned int TCNT1;
+
+ static unsigned long checks;
+ static unsigned long failures;
+
+ static unsigned long millis_now;
+ static unsigned long rtc_now;
+
+ static unsigned long log_time[LOG_CAPACITY];
+ static unsigned char log_event[LOG_CAPACITY];
+ static unsigned char log_entries;
+
+ static unsigned int expected_ms[LOG_CAPACITY];
+
+ unsigned long millis(){ return millis_now; }
+ unsigned long rtc_get_date(){ return rtc_now; }
+ void log_clear(){ log_entries = 0; }
+ void log_add_record(unsigned char eventnum){
+    unsigned char i;
+
+    if(log_entries == LOG_CAPACITY){
+        for(i = 1; i < LOG_CAPACITY; i++){
+            log_time[i - 1] = log_time[i];
+            log_event[i - 1] = log_event[i];
+        }
+        log_entries--;
+    }
+    log_time[log_entries] = rtc_now;
+    log_event[log_entries] = eventnum;
+    log_entries++;
+ }
+ int log_get_record(unsigned long index, unsigned long *time, unsigned char *eventnum){
+    if(index >= log_entries){
+        return 0;
+    }
+    *time = log_time[index];
+    *eventnum = log_event[index];
+    return 1;
+ }
+ unsigned char log_get_num_entries(){ return log_entries; }
+
+ /**********************************
+ * test_uptime()
+ *
+ * Moves the millisecond count through TEST_WRAPS wraps and checks
+ * clock_uptime() against the true seconds at random points of each wrap
+ * and at the last millisecond before and the first after the wrap
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  millis_now, checks, failures
+ */
+ static void test_uptime(){
+    unsigned long wrap;
+    unsigned long points[CALLS_PER_WRAP];
+    unsigned long long true_ms;
+    unsigned long uptime;
+    unsigned long bad = 0;
+    unsigned char i, j;
+
+    for(wrap = 0; wrap < TEST_WRAPS; wrap++){
+        /* random points in order, ending just before the wrap */
+        for(i = 0; i < CALLS_PER_WRAP - 1; i++){
+            points[i] = (((unsigned long)rand() << 16) ^ rand()) & 0xFFFFFFFFUL;
+        }
+        points[CALLS_PER_WRAP - 1] = 0xFFFFFFFFUL;
+        for(i = 1; i < CALLS_PER_WRAP - 1; i++){
+            for(j = i; j > 0 && points[j - 1] > points[j]; j--){
+                unsigned long t = points[j];
+                points[j] = points[j - 1];
+                points[j - 1] = t;
+            }
+        }
+        if(wrap > 0){
+            points[0] = 0;
+        }
+
+        for(i = 0; i < CALLS_PER_WRAP; i++){
+            millis_now = points[i];
+            true_ms = ((unsigned long long)wrap << 32) + millis_now;
+            uptime = clock_uptime() & 0xFFFFFFFFUL;
+            if(uptime != (unsigned long)((true_ms / 1000) & 0xFFFFFFFFUL)){
+                if(bad++ < 5){
+                    printf("FAIL wrap %lu ms %lu: uptime %lu, expected %llu\n", wrap, millis_now,
+                           uptime, (true_ms / 1000) & 0xFFFFFFFFULL);
+                }
+            }
+            checks++;
+        }
+    }
+    failures += bad;
+    printf("uptime: %lu wraps, %lu calls, %lu wrong\n", TEST_WRAPS, TEST_WRAPS * CALLS_PER_WRAP, bad);
+ }
+
+ /**********************************
+ * set_rtc()
+ *
+ * Sets the rtc date/time number and the timer1 count of the specified
+ * millisecond (timer1 counts 62500 per second, 62.5 per millisecond)
+ *
+ * arguments:
+ *  sec - rtc date/time number
+ *  ms - millisecond into the second
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  rtc_now, TCNT1
+ */
+ static void set_rtc(unsigned long sec, unsigned int ms){
+    rtc_now = sec;
+    TCNT1 = (ms * 125U + 1) / 2;
+ }
+
+ /**********************************
+ * add_expected()
+ *
+ * Adds the expected millisecond of a new record, dropping the oldest
+ * when the log was full
+ *
+ * arguments:
+ *  was_full - 1 if the log held LOG_CAPACITY records before the record
+ *  pos - position of the new record
+ *  ms - expected millisecond of the new record
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  expected_ms
+ */
+ static void add_expected(unsigned char was_full, unsigned char pos, unsigned int ms){
+    unsigned char i;
+
+    if(was_full){
+        for(i = 1; i < LOG_CAPACITY; i++){
+            expected_ms[i - 1] = expected_ms[i];
+        }
+    }
+    expected_ms[pos] = ms;
+ }
+
+ /**********************************
+ * check_ms()
+ *
+ * Checks the millisecond of every position of the log, and that the
+ * positions past the last record have none
+ *
+ * arguments:
+ *  step - the number of the record just added (for the failure report)
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  checks, failures
+ */
+ static void check_ms(unsigned int step){
+    unsigned char i;
+    unsigned int expected;
+
+    for(i = 0; i < LOG_CAPACITY; i++){
+        expected = (i < log_entries) ? expected_ms[i] : LOGINDEX_NO_MS;
+        checks++;
+        if(logindex_get_ms(i) != expected){
+            failures++;
+            printf("FAIL record %u position %u: ms %u, expected %u\n", step, i, logindex_get_ms(i), expected);
+        }
+    }
+ }
+
+ /**********************************
+ * test_logindex()
+ *
+ * Adds records through logindex_add_record() and directly to the log
+ * (picked up by logindex_sync()) until the log has been overwritten
+ * several times, checking the milliseconds after each
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the log, the rtc, checks, failures
+ */
+ static void test_logindex(){
+    unsigned int step;
+    unsigned int ms;
+    unsigned char was_full;
+    unsigned char i;
+
+    /* records read from the eeprom at startup */
+    for(i = 0; i < 5; i++){
+        set_rtc(500 + i, 0);
+        log_add_record(EVENT_STARTUP);
+        expected_ms[i] = LOGINDEX_NO_MS;
+    }
+    logindex_init();
+    check_ms(0);
+    CHECK(logindex_get_added() == 0);
+
+    for(step = 1; step <= 5 * LOG_CAPACITY; step++){
+        ms = (step * 373) % 1000;
+        set_rtc(1000 + step, ms);
+        was_full = (log_entries == LOG_CAPACITY);
+        if(step % 3 == 0){
+            /* a tempfsm alarm, picked up after tempfsm_update() */
+            log_add_record(EVENT_HI_ALARM);
+            set_rtc(1000 + step, ms + 1);
+            logindex_sync();
+            add_expected(was_full, log_entries - 1, ms + 1);
+        }
+        else{
+            logindex_add_record(EVENT_TIMESET);
+            add_expected(was_full, log_entries - 1, ms);
+        }
+        check_ms(step);
+        CHECK(logindex_get_added() == step);
+    }
+    CHECK(logindex_get_count(EVENT_HI_ALARM) == 5);
+    CHECK(logindex_get_count(EVENT_TIMESET) == 11);
+    CHECK(logindex_get_count(EVENT_STARTUP) == 0);
+
+    /* picked up in a later second: the millisecond is not known */
+    set_rtc(2000, 900);
+    was_full = (log_entries == LOG_CAPACITY);
+    log_add_record(EVENT_LO_WARN);
+    set_rtc(2001, 10);
+    logindex_sync();
+    add_expected(was_full, log_entries - 1, LOGINDEX_NO_MS);
+    check_ms(step);
+
+    /* nothing new: sync changes nothing */
+    logindex_sync();
+    check_ms(step);
+    CHECK(logindex_get_added() == step);
+
+    logindex_clear();
+    CHECK(log_entries == 0);
+    check_ms(step + 1);
+
+    set_rtc(3000, 999);
+    logindex_add_record(EVENT_NEWTIME);
+    expected_ms[0] = 999;
+    check_ms(step + 2);
+ }
+
+ /**********************************
+ * main()
+ *
+ * Runs the tests and prints the number of checks and failures
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  0 if every check passed, otherwise 1
+ *
+ * changes:
+ *  none
+ */
+ int main(){
+    srand(486);
+    test_uptime();
+    test_logindex();
+    printf("%lu checks, %lu failures\n", checks, failures);
+    return failures ? 1 : 0;
+ }
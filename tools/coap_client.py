@@ -0,0 +1,363 @@
+#!/usr/bin/env python3
+"""
+coap_client.py
+
+SER486 Final Project
+Author: Jesse Baker (student jjbaker4)
+
+CoAP test client for the CoAP server (coap.h), run against
+tools/coap_host.c or a device.  Checks every resource and error code,
+the blockwise transfer of /device and /device/log (the ETag must be the
+same in every block of a representation and change with it), the
+deduplication of a retransmitted PUT, ping, observe with a notification
+on an alarm state change and deregistration by RST, then times GET
+/device?fields=temperature,state round trips (on the host harness these
+are set by its 1 ms polling period).
+
+    coap_client.py                      (tools/coap_host.c)
+    coap_client.py --host 192.168.1.60 --port 5683
+
+The config is changed during the run and put back at the end.  The log
+is only cleared (DELETE /device/log) with --harness (the default when
+the host is 127.0.0.1).
+"""
+
+import argparse
+import json
+import random
+import socket
+import statistics
+import struct
+import sys
+import time
+
+TYPE_CON, TYPE_NON, TYPE_ACK, TYPE_RST = 0, 1, 2, 3
+GET, POST, PUT, DELETE = 1, 2, 3, 4
+OPT_ETAG, OPT_OBSERVE, OPT_URI_PATH, OPT_CONTENT_FORMAT = 4, 6, 11, 12
+OPT_URI_QUERY, OPT_ACCEPT, OPT_BLOCK2 = 15, 17, 23
+UINT_OPTIONS = (OPT_OBSERVE, OPT_CONTENT_FORMAT, OPT_ACCEPT, OPT_BLOCK2)
+THRESHOLDS = ('tcrit_hi', 'twarn_hi', 'tcrit_lo', 'twarn_lo')
+TIMING_REQUESTS = 2000
+
+checks = 0
+failures = 0
+
+
+def check(cond, what):
+    """Counts a check and reports it if it failed."""
+    global checks, failures
+    checks += 1
+    if not cond:
+        failures += 1
+        print('FAIL', what)
+
+
+def uint(value):
+    """Encodes an unsigned integer option value in the fewest bytes."""
+    out = b''
+    while value:
+        out = bytes([value & 0xFF]) + out
+        value >>= 8
+    return out
+
+
+def encode_options(options):
+    """Encodes (number, value) options in increasing order."""
+    def nibble(x):
+        if x < 13:
+            return x, b''
+        if x < 269:
+            return 13, bytes([x - 13])
+        return 14, struct.pack('>H', x - 269)
+
+    out = b''
+    last = 0
+    for number, value in sorted(options, key=lambda o: o[0]):
+        dn, dext = nibble(number - last)
+        ln, lext = nibble(len(value))
+        out += bytes([dn << 4 | ln]) + dext + lext + value
+        last = number
+    return out
+
+
+class Response:
+    """A parsed CoAP message."""
+
+    def __init__(self, d):
+        self.type = (d[0] >> 4) & 3
+        tkl = d[0] & 15
+        self.code = '%d.%02d' % (d[1] >> 5, d[1] & 31)
+        self.mid = struct.unpack('>H', d[2:4])[0]
+        self.token = d[4:4 + tkl]
+        self.options = {}
+        p = 4 + tkl
+        number = 0
+        while p < len(d) and d[p] != 0xFF:
+            delta, length = d[p] >> 4, d[p] & 15
+            p += 1
+            if delta == 13:
+                delta = 13 + d[p]
+                p += 1
+            if length == 13:
+                length = 13 + d[p]
+                p += 1
+            number += delta
+            value = d[p:p + length]
+            self.options[number] = int.from_bytes(value, 'big') if number in UINT_OPTIONS else value
+            p += length
+        self.body = d[p + 1:] if p < len(d) else b''
+
+    def block2(self):
+        """Returns (num, more, szx) of the Block2 option, or None."""
+        b = self.options.get(OPT_BLOCK2)
+        return None if b is None else (b >> 4, (b >> 3) & 1, b & 7)
+
+
+class Client:
+    """Minimal CoAP client - one request at a time."""
+
+    def __init__(self, host, port):
+        self.server = (host, port)
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.settimeout(1.0)
+        self.mid = random.randint(0, 0xFFFF)
+        self.pending = []
+
+    def next_mid(self):
+        self.mid = (self.mid + 1) & 0xFFFF
+        return self.mid
+
+    def send(self, mtype, code, mid, token=b'', options=(), payload=b''):
+        """Sends a message."""
+        d = bytes([0x40 | mtype << 4 | len(token), code]) + struct.pack('>H', mid) + token
+        d += encode_options(options) + (b'\xff' + payload if payload else b'')
+        self.sock.sendto(d, self.server)
+
+    def receive(self):
+        """Returns the next message, or None after the timeout."""
+        if self.pending:
+            return self.pending.pop(0)
+        try:
+            return Response(self.sock.recv(2048))
+        except socket.timeout:
+            return None
+
+    def request(self, code, path, query=(), mtype=TYPE_CON, options=(), token=b'\x01\x02'):
+        """Sends a request and returns the response (notifications that
+        arrive first are kept for receive())."""
+        opts = [(OPT_URI_PATH, s.encode()) for s in path.strip('/').split('/') if s]
+        opts += [(OPT_URI_QUERY, q.encode()) for q in query] + list(options)
+        mid = self.next_mid()
+        self.send(mtype, code, mid, token, opts)
+        while True:
+            try:
+                r = Response(self.sock.recv(2048))
+            except socket.timeout:
+                return None
+            if r.token == token and (r.mid == mid or mtype == TYPE_NON):
+                return r
+            self.pending.append(r)
+
+    def get_block(self, path, num, szx, query=()):
+        """Requests one block of a representation."""
+        return self.request(GET, path, query, options=[(OPT_BLOCK2, uint(num << 4 | szx))])
+
+    def get_blockwise(self, path, szx, query=()):
+        """Reassembles a representation from its blocks; returns the body and the ETags."""
+        body = b''
+        etags = []
+        num = 0
+        while True:
+            r = self.get_block(path, num, szx, query)
+            body += r.body
+            etags.append(r.options.get(OPT_ETAG))
+            if not r.block2()[1]:
+                return body, etags
+            num += 1
+
+
+def is_json(body):
+    """Returns True if the body is a json document."""
+    try:
+        json.loads(body)
+        return True
+    except ValueError:
+        return False
+
+
+def run_resources(c):
+    """Resources, queries and error codes."""
+    r = c.request(GET, '/.well-known/core')
+    check(r.code == '2.05' and r.options.get(OPT_CONTENT_FORMAT) == 40, 'core %s' % r.code)
+    check(b'</device>;ct=50;obs' in r.body, 'core links %s' % r.body)
+
+    r = c.request(GET, '/device')
+    check(r.code == '2.05' and r.type == TYPE_ACK and r.options.get(OPT_CONTENT_FORMAT) == 50, 'GET /device')
+    check(len(r.options.get(OPT_ETAG, b'')) == 2, 'GET /device has an ETag')
+    r = c.request(GET, '/device', ['fields=temperature,state'])
+    check(r.code == '2.05' and set(json.loads(r.body)) == {'temperature', 'state'}, 'fields %s' % r.body)
+    check(r.block2() is None, 'no Block2 for a representation that fits')
+
+    r = c.request(GET, '/device/log', ['event=3'])
+    check(r.code == '2.05' and is_json(r.body), 'log of one event %s' % r.body[:80])
+    r = c.request(GET, '/device/log', ['from=1005', 'to=1007'])
+    check(r.code == '2.05' and is_json(r.body), 'log range %s' % r.body[:80])
+    check(c.request(GET, '/device/log', ['event=99']).code == '4.00', 'bad event')
+
+    check(c.request(POST, '/device').code == '4.05', 'POST /device')
+    check(c.request(GET, '/nope').code == '4.04', 'unknown resource')
+    check(c.request(GET, '/device', options=[(9, b'x')]).code == '4.02', 'unknown critical option')
+    check(c.request(GET, '/device', options=[(OPT_ACCEPT, uint(0))]).code == '4.06', 'Accept text/plain')
+    check(c.request(GET, '/device', options=[(OPT_ACCEPT, uint(50))]).code == '2.05', 'Accept json')
+    r = c.request(GET, '/device', ['fields=state'], mtype=TYPE_NON)
+    check(r.type == TYPE_NON and r.code == '2.05', 'NON request')
+
+    mid = c.next_mid()
+    c.send(TYPE_CON, 0, mid)
+    r = c.receive()
+    check(r is not None and r.type == TYPE_RST and r.mid == mid, 'ping')
+    c.sock.sendto(bytes([0x49, 1, 0, 1]), c.server)
+    check(c.receive() is None, 'token length 9 is dropped')
+
+
+def run_config(c, temperature):
+    """PUT /device/config, the retransmitted PUT and the ETag of /device."""
+    etag = c.request(GET, '/device').options.get(OPT_ETAG)
+    check(c.request(PUT, '/device/config', ['tcrit_hi=%d' % (temperature + 35)]).code == '2.04', 'PUT')
+    check(c.request(GET, '/device').options.get(OPT_ETAG) != etag, 'ETag changes with the config')
+
+    # the same message id again is answered without being applied
+    mid = c.next_mid()
+    opts = [(OPT_URI_PATH, b'device'), (OPT_URI_PATH, b'config'),
+            (OPT_URI_QUERY, b'tcrit_hi=%d' % (temperature + 36))]
+    c.send(TYPE_CON, PUT, mid, b'\x01\x02', opts)
+    first = c.receive()
+    opts[2] = (OPT_URI_QUERY, b'tcrit_hi=%d' % (temperature + 37))
+    c.send(TYPE_CON, PUT, mid, b'\x01\x02', opts)
+    again = c.receive()
+    check(first.code == '2.04' and again.code == '2.04', 'retransmitted PUT answered')
+    tcrit_hi = json.loads(c.request(GET, '/device', ['fields=tcrit_hi']).body)['tcrit_hi']
+    check(tcrit_hi == temperature + 36, 'retransmitted PUT not applied (tcrit_hi %d)' % tcrit_hi)
+
+    check(c.request(PUT, '/device/config', ['tcrit_lo=-5']).code == '2.04', 'negative value')
+    check(c.request(PUT, '/device/config', ['bogus=1']).code == '4.00', 'unknown name')
+    check(c.request(PUT, '/device/config', ['tcrit_hi=abc']).code == '4.00', 'non-integer value')
+
+
+def run_blockwise(c, temperature):
+    """Blockwise transfers and the ETag across the blocks."""
+    full = c.request(GET, '/device', options=[(OPT_BLOCK2, uint(5))])
+    whole, etags = c.get_blockwise('/device', 5)
+    check(is_json(whole), '/device in 512 byte blocks is json (%d bytes)' % len(whole))
+    body, etags = c.get_blockwise('/device', 2)
+    check(body == whole, '/device in 64 byte blocks (%d blocks)' % len(etags))
+    check(len(etags) > 2 and len(set(etags)) == 1 and etags[0] == full.options.get(OPT_ETAG),
+          'one ETag in every block %s' % etags)
+
+    r = c.get_block('/device', 0, 6)
+    check(r.code == '2.05' and r.block2() == (0, 1, 5) and r.body == whole[:512],
+          'a 1024 byte block is answered with a 512 byte block')
+    check(c.get_block('/device', 1000, 2).code == '4.02', 'block past the end')
+
+    # the representation changes between two blocks
+    first = c.get_block('/device', 0, 2)
+    c.request(PUT, '/device/config', ['twarn_hi=%d' % (temperature + 20)])
+    second = c.get_block('/device', 1, 2)
+    check(first.options.get(OPT_ETAG) != second.options.get(OPT_ETAG), 'ETag changes between the blocks')
+
+    log, etags = c.get_blockwise('/device/log', 2)
+    check(is_json(log) and len(set(etags)) == 1, '/device/log in %d blocks' % len(etags))
+
+
+def run_observe(c, temperature, thresholds):
+    """Observe registration, a notification on a state change and RST."""
+    r = c.request(GET, '/device', ['fields=temperature,state'], options=[(OPT_OBSERVE, b'')], token=b'\xaa')
+    check(r.code == '2.05' and OPT_OBSERVE in r.options, 'observe registration')
+
+    # twarn_hi below the temperature: WARN_HI
+    put(c, thresholds[0], temperature - 10, thresholds[2], thresholds[3])
+    n = c.receive()
+    while n is not None and n.code != '2.05':
+        n = c.receive()
+    check(n is not None and n.token == b'\xaa' and n.options.get(OPT_OBSERVE, 0) > r.options[OPT_OBSERVE]
+          and json.loads(n.body)['state'] == 'WARN_HI', 'notification of WARN_HI')
+    put(c, thresholds[0], temperature - 5, thresholds[2], thresholds[3])
+    check(c.receive() is None, 'no notification for the same state')
+
+    c.send(TYPE_RST, 0, n.mid)
+    time.sleep(0.05)
+    put(c, *thresholds)
+    check(c.receive() is None, 'deregistered by RST')
+
+
+def get_thresholds(c):
+    """Returns (tcrit_hi, twarn_hi, tcrit_lo, twarn_lo)."""
+    d = json.loads(c.request(GET, '/device', ['fields=' + ','.join(THRESHOLDS)]).body)
+    return tuple(d[name] for name in THRESHOLDS)
+
+
+def put(c, *values):
+    """Sets the thresholds - each PUT is checked against the others, so the
+    ones that are refused are tried again once the others have moved."""
+    for _ in range(len(THRESHOLDS)):
+        current = get_thresholds(c)
+        if current == values:
+            return
+        for name, value, now in zip(THRESHOLDS, values, current):
+            if value != now:
+                c.request(PUT, '/device/config', ['%s=%d' % (name, value)])
+    raise ValueError('thresholds %s, wanted %s' % (get_thresholds(c), values))
+
+
+def run_log_delete(c):
+    """DELETE /device/log empties the log and changes its ETag."""
+    etag = c.request(GET, '/device/log').options.get(OPT_ETAG)
+    check(c.request(DELETE, '/device/log').code == '2.02', 'DELETE /device/log')
+    r = c.request(GET, '/device/log')
+    check(r.options.get(OPT_ETAG) != etag, 'ETag changes when the log is cleared')
+
+
+def run_timing(c):
+    """Times GET /device?fields=temperature,state round trips."""
+    times = []
+    start = time.time()
+    for _ in range(TIMING_REQUESTS):
+        t = time.perf_counter()
+        r = c.request(GET, '/device', ['fields=temperature,state'])
+        times.append(time.perf_counter() - t)
+    times.sort()
+    print('%d GET in %.2f s, median %.0f us, p99 %.0f us, payload %d bytes' %
+          (TIMING_REQUESTS, time.time() - start, statistics.median(times) * 1e6,
+           times[TIMING_REQUESTS * 99 // 100] * 1e6, len(r.body)))
+
+
+def main():
+    ap = argparse.ArgumentParser(description='CoAP server test client')
+    ap.add_argument('--host', default='127.0.0.1')
+    ap.add_argument('--port', type=int, default=15683)
+    ap.add_argument('--harness', action='store_true')
+    args = ap.parse_args()
+    harness = args.harness or args.host == '127.0.0.1'
+
+    c = Client(args.host, args.port)
+    temperature = json.loads(c.request(GET, '/device', ['fields=temperature']).body)['temperature']
+    thresholds = get_thresholds(c)
+    normal = (temperature + 40, temperature + 30, temperature - 40, temperature - 30)
+    put(c, *normal)
+    run_resources(c)
+    run_config(c, temperature)
+    put(c, *normal)
+    run_blockwise(c, temperature)
+    put(c, *normal)
+    run_observe(c, temperature, normal)
+    if harness:
+        run_log_delete(c)
+    run_timing(c)
+    put(c, *thresholds)
+
+    print('%d checks, %d failures' % (checks, failures))
+    sys.exit(1 if failures else 0)
+
+
+if __name__ == '__main__':
+    main()
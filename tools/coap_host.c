@@ -0,0 +1,136 @@
+/********************************************************
+ * coap_host.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * Host harness for the CoAP server in coap.c.  The firmware coap.c,
+ * devapi.c, util.c, udpmux.c, socket.c, devstate.c, fmt.c and crc16.c run
+ * unchanged over the W5100 emulation in tools/host, with ports offset by
+ * 10000 (the server is reached on 127.0.0.1:15683).  udpmux_update() and
+ * coap_update() are called every millisecond (every 5 ms on the device).
+ * The temperature is 75, the log holds 16 records (event n % 11 at time
+ * 1000 + n) and PUT /device/config changes the emulated config and its
+ * crc, so a client can move the alarm state and the ETag.
+ *
+ * Run it against the client tools/coap_client.py, which checks the
+ * responses and times the requests:
+ *
+ *    gcc -O2 -DCOAP_ENABLE=1 -ffunction-sections -Wl,--gc-sections -I tools/host -I . \
+ *        -o coap_host tools/coap_host.c tools/host/w5emu.c coap.c devapi.c \
+ *        util.c udpmux.c socket.c devstate.c fmt.c crc16.c
+ *    ./coap_host & python3 tools/coap_client.py
+ *
+ * Functions:
+ *
+ * main()
+ *  Runs the server every millisecond
+ *
+ * (stand-ins for the log, log index, eeprom crc, sensor and the other
+ * udpmux clients)
+ */
+
+ #include <stdio.h>
+ #include <string.h>
+ #include <unistd.h>
+ #include "config.h"
+ #include "vpd.h"
+ #include "log.h"
+ #include "logindex.h"
+ #include "crc16.h"
+ #include "socket.h"
+ #include "udpmux.h"
+ #include "coap.h"
+ #include "w5emu.h"
+
+ #define LOG_RECORDS 16
+
+ config_struct config = {"ASU", 100, 90, 40, 50, 0, {0}, 0};
+ vpd_struct vpd = {"SER", "IIoT", "ASU", "SN12345", 0, {0x00, 0x08, 0xDC, 0x00, 0x00, 0x64}, "USA", 0};
+ volatile unsigned char crash_last_sockop;
+ int current_temperature = 75;
+
+ static unsigned char log_entries = LOG_RECORDS;
+ static unsigned int log_added = LOG_RECORDS;
+
+ int temp_get(){ return current_temperature; }
+ void config_set_modified(){}
+ void eecrc_config_changed(unsigned char offset, const unsigned char *old_value, unsigned char len){}
+ unsigned int eecrc_get_config_crc(){ return crc16((const unsigned char*)&config, sizeof(config)); }
+ unsigned char log_get_num_entries(){ return log_entries; }
+ int log_get_record(unsigned long index, unsigned long *time, unsigned char *eventnum){
+    if(index >= log_entries){
+        return 0;
+    }
+    *time = 1000 + index;
+    *eventnum = index % 11;
+    return 1;
+ }
+ void logindex_clear(){ log_entries = 0; log_added++; }
+ unsigned int logindex_get_added(){ return log_added; }
+ unsigned int logindex_get_ms(unsigned char index){ return LOGINDEX_NO_MS; }
+ unsigned char logindex_get_count(unsigned char event){
+    unsigned char i, n = 0;
+
+    for(i = 0; i < log_entries; i++){
+        n += (i % 11 == event);
+    }
+    return n;
+ }
+ unsigned long logindex_get_last(unsigned char event){
+    unsigned char i;
+    unsigned long last = 0;
+
+    for(i = 0; i < log_entries; i++){
+        if(i % 11 == event){
+            last = 1000 + i;
+        }
+    }
+    return last;
+ }
+ unsigned int logindex_query(unsigned char event, unsigned long from, unsigned long to){
+    unsigned char i;
+    unsigned int matches = 0;
+
+    for(i = 0; i < log_entries; i++){
+        if((event == EVENT_UNK || i % 11 == event) && 1000 + i >= from && 1000 + i <= to){
+            matches |= 1U << i;
+        }
+    }
+    return matches;
+ }
+ char *rtc_num2datestr(unsigned long num){
+    static char str[24];
+
+    snprintf(str, sizeof(str), "01/01/2022 00:%02lu:%02lu", num / 60 % 60, num % 60);
+    return str;
+ }
+ void ntpclient_receive(const unsigned char *msg, unsigned int len, const unsigned char *addr){}
+ void mqttsn_receive(const unsigned char *msg, unsigned int len, const unsigned char *addr){}
+ void fleet_receive(const unsigned char *msg, unsigned int len, const unsigned char *addr){}
+
+ /**********************************
+ * main()
+ *
+ * Opens the shared socket (as the first ntp request does on the device)
+ * and calls udpmux_update() and coap_update() every millisecond until
+ * killed
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  never
+ *
+ * changes:
+ *  none
+ */
+ int main(){
+    w5emu_port_offset = 10000;
+    udpsocket_open(UDPMUX_SOCKET, UDPMUX_PORT);
+    while(1){
+        udpmux_update();
+        coap_update();
+        usleep(1000);
+    }
+ }
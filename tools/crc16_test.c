@@ -0,0 +1,442 @@
+/********************************************************
+ * crc16_test.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * Host unit tests and benchmark for the CRC-16 module and the eeprom
+ * image protection built on it (crc16.c, eecrc.c and the threshold
+ * setters in util.c, compiled unchanged against the stand-in headers in
+ * tools/host).  The eeprom, the library vpd/config modules and the log
+ * output are emulated.
+ *
+ * The tests check crc16() against a bitwise CRC-16/CCITT reference,
+ * crc16_adjust() against a full recompute for random edits, and the
+ * eecrc_init() migration and corruption handling.  The benchmark counts
+ * table steps (one flash table read and shift per byte, a fixed number of
+ * AVR cycles each) for a config change by crc16_adjust() and by a full
+ * rescan, and reports the host time of each.  AVR cycle counts cannot be
+ * measured on the host.
+ *
+ * The structures must be packed as on the AVR, so that the checksum byte
+ * is the last byte of each image.
+ *
+ *    gcc -O2 -fpack-struct -I tools/host -I . -o crc16_test tools/crc16_test.c
+ *    ./crc16_test
+ *
+ * Functions:
+ *
+ * main()
+ *  Runs the tests and the benchmark
+ *
+ * crc16_reference()
+ *  Bitwise CRC-16/CCITT
+ *
+ * test_crc16()
+ *  Tests crc16() and crc16_update()
+ *
+ * test_adjust()
+ *  Tests crc16_adjust() against a full recompute
+ *
+ * reset_eeprom()
+ *  Writes fresh images without a crc record to the emulated eeprom
+ *
+ * reboot()
+ *  Writes back and reloads the images and runs eecrc_init()
+ *
+ * test_eecrc()
+ *  Tests the eecrc migration and corruption handling
+ *
+ * now_ns()
+ *  Returns a monotonic host time
+ * bench_adjust()
+ *  Compares the cost of crc16_adjust() with a full rescan
+ */
+
+ #include <stddef.h>
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <time.h>
+ #include <avr/pgmspace.h>
+
+ /* count the table steps taken by crc16.c */
+ static unsigned long table_steps;
+ #undef pgm_read_word
+ #define pgm_read_word(p) (table_steps++, (uint16_t)*(p))
+
+ #include "../crc16.c"
+ #include "../eecrc.c"
+ #include "../util.c"
+
+ #define CHECK(cond) do{ \
+        checks++; \
+        if(!(cond)){ \
+            failures++; \
+            printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        } \
+    }while(0)
+
+ static unsigned long checks;
+ static unsigned long failures;
+
+ /* emulated library state */
+ config_struct config;
+ vpd_struct vpd;
+ static unsigned char eeprom[1024];
+ static unsigned int vpd_defaults_written;
+ static unsigned int config_defaults_written;
+ static char last_log[80];
+
+ static const config_struct default_config = {"ASU", 0x3FF, 0x3FE, 0x0000, 0x0001, 0, {192, 168, 1, 100}, 0};
+ static const vpd_struct factory_vpd = {"SER", "IIoT", "ASU", "SN01234", 1539129600UL,
+                                       {0x00, 0x08, 0xDC, 0x12, 0x34, 0x56}, "USA", 0};
+
+ int eeprom_isbusy(){ return 0; }
+ void eeprom_readbuf(unsigned int addr, unsigned char *buf, unsigned char size){ memcpy(buf, eeprom + addr, size); }
+ void eeprom_writebuf(unsigned int addr, unsigned char *buf, unsigned char size){ memcpy(eeprom + addr, buf, size); }
+ void vpd_write_defaults(){ vpd_defaults_written++; }
+ void config_set_modified(){}
+ void config_write_defaults(){
+    config_defaults_written++;
+    memcpy(eeprom + CONFIG_EEPROM_ADDR, &default_config, sizeof(default_config));
+ }
+ unsigned char ulog_begin(unsigned char level){ last_log[0] = 0; return 1; }
+ void ulog_end(){}
+ void uart_writestr(char *str){ strncat(last_log, str, sizeof(last_log) - strlen(last_log) - 1); }
+ void serial_writestr_P(const char *str){ uart_writestr((char*)str); }
+
+ /**********************************
+ * crc16_reference()
+ *
+ * Bitwise CRC-16/CCITT (polynomial 0x1021, initial value 0xFFFF)
+ *
+ * arguments:
+ *  data - pointer to the data
+ *  len - number of bytes of data
+ *
+ * returns:
+ *  the crc of the data
+ *
+ * changes:
+ *  none
+ */
+ static unsigned int crc16_reference(const unsigned char *data, unsigned int len){
+    unsigned int crc = 0xFFFF;
+    unsigned char bit;
+    while(len--){
+        crc ^= (unsigned int)*data++ << 8;
+        for(bit = 0; bit < 8; bit++){
+            crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) & 0xFFFF : (crc << 1) & 0xFFFF;
+        }
+    }
+    return crc;
+ }
+
+ /**********************************
+ * test_crc16()
+ *
+ * Tests crc16() against the check value and the bitwise reference, and
+ * crc16_update() against crc16() for split messages
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  checks, failures
+ */
+ static void test_crc16(){
+    unsigned char buf[300] = {0};
+    unsigned int i, len, split;
+
+    /* published check value for CRC-16/CCITT-FALSE */
+    CHECK(crc16((const unsigned char*)"123456789", 9) == 0x29B1);
+    CHECK(crc16(buf, 0) == CRC16_INIT);
+
+    for(i = 0; i < 2000; i++){
+        len = rand() % sizeof(buf);
+        for(split = 0; split < len; split++){
+            buf[split] = rand();
+        }
+        CHECK(crc16(buf, len) == crc16_reference(buf, len));
+        split = len ? rand() % len : 0;
+        CHECK(crc16_update(crc16(buf, split), buf + split, len - split) == crc16(buf, len));
+    }
+ }
+
+ /**********************************
+ * test_adjust()
+ *
+ * Tests crc16_adjust() against a full recompute for random runs of
+ * changed bytes at random offsets (including the first and last bytes)
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  checks, failures
+ */
+ static void test_adjust(){
+    unsigned char msg[128], old[128];
+    unsigned int i, j, len, offset, run, crc;
+
+    for(i = 0; i < 20000; i++){
+        len = 1 + rand() % sizeof(msg);
+        for(j = 0; j < len; j++){
+            msg[j] = rand();
+        }
+        crc = crc16(msg, len);
+        offset = rand() % len;
+        run = 1 + rand() % (len - offset);
+        memcpy(old, msg + offset, run);
+        for(j = 0; j < run; j++){
+            msg[offset + j] = (i & 1) ? rand() : msg[offset + j];
+        }
+        CHECK(crc16_adjust(crc, old, msg + offset, run, len - offset - run) == crc16(msg, len));
+    }
+ }
+
+ /**********************************
+ * reset_eeprom()
+ *
+ * Writes the factory vpd and the default config to the emulated eeprom
+ * (with their additive checksums), leaves the crc record blank and
+ * loads the images as the library vpd_init() and config_init() would
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  eeprom, vpd, config, counters
+ */
+ static void reset_eeprom(){
+    vpd_struct v = factory_vpd;
+    config_struct c = default_config;
+
+    v.checksum = additive_checksum((unsigned char*)&v, VPD_CRC_SIZE);
+    c.checksum = additive_checksum((unsigned char*)&c, CONFIG_CRC_SIZE);
+    memset(eeprom, 0xFF, sizeof(eeprom));
+    memcpy(eeprom, &v, sizeof(v));
+    memcpy(eeprom + CONFIG_EEPROM_ADDR, &c, sizeof(c));
+    vpd = v;
+    config = c;
+    vpd_defaults_written = 0;
+    config_defaults_written = 0;
+    memset(&eecrc, 0, sizeof(eecrc));
+    modified = 0;
+ }
+
+ /**********************************
+ * reboot()
+ *
+ * Writes back the crc record and the config (as the main loop would),
+ * then reloads everything from the eeprom and runs eecrc_init()
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  eeprom, vpd, config, eecrc, last_log
+ */
+ static void reboot(){
+    eecrc_update();
+    config.checksum = additive_checksum((unsigned char*)&config, CONFIG_CRC_SIZE);
+    memcpy(eeprom + CONFIG_EEPROM_ADDR, &config, sizeof(config));
+    memcpy(&vpd, eeprom, sizeof(vpd));
+    memcpy(&config, eeprom + CONFIG_EEPROM_ADDR, sizeof(config));
+    last_log[0] = 0;
+    eecrc_init();
+ }
+
+ /**********************************
+ * test_eecrc()
+ *
+ * Tests migration of images without a crc record, detection of vpd and
+ * config corruption, and the incremental config crc
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  checks, failures
+ */
+ static void test_eecrc(){
+    vpd_struct before;
+
+    /* first boot migrates, the second boot is clean */
+    reset_eeprom();
+    last_log[0] = 0;
+    eecrc_init();
+    CHECK(modified && last_log[0] == 0);
+    reboot();
+    CHECK(!modified && last_log[0] == 0);
+
+    /* threshold changes keep the crc matching the config */
+    CHECK(update_tcrit_hi(0x3FE) == 0);
+    CHECK(update_twarn_hi(0x100) == 1);
+    CHECK(update_tcrit_lo(-20) == 1);
+    CHECK(eecrc_get_config_crc() == crc16((unsigned char*)&config, CONFIG_CRC_SIZE));
+    reboot();
+    CHECK(last_log[0] == 0 && config.hi_warn == 0x100 && config.lo_alarm == -20);
+
+    /* vpd corruption that the additive checksum misses is reported at
+    * every boot and the identity fields are kept
+    */
+    eeprom[offsetof(vpd_struct, serial_number) + 2]++;
+    eeprom[offsetof(vpd_struct, serial_number) + 3]--;
+    memcpy(&before, eeprom, sizeof(before));
+    reboot();
+    CHECK(strcmp(last_log, "VPD crc error\r\n") == 0);
+    CHECK(vpd_defaults_written == 0);
+    CHECK(memcmp(&vpd, &before, sizeof(vpd)) == 0);
+    CHECK(memcmp(vpd.mac_address, factory_vpd.mac_address, 6) == 0);
+    reboot();
+    CHECK(strcmp(last_log, "VPD crc error\r\n") == 0);
+
+    /* a rewritten vpd (new checksum byte) is accepted */
+    reset_eeprom();
+    eecrc_init();
+    reboot();
+    eeprom[offsetof(vpd_struct, model)]++;
+    eeprom[offsetof(vpd_struct, checksum)]--;
+    reboot();
+    CHECK(last_log[0] == 0 && modified);
+    reboot();
+    CHECK(last_log[0] == 0 && !modified);
+
+    /* config corruption restores the defaults */
+    eeprom[CONFIG_EEPROM_ADDR + offsetof(config_struct, hi_warn)] ^= 0x01;
+    eeprom[CONFIG_EEPROM_ADDR + offsetof(config_struct, lo_warn)] ^= 0xFF;
+    eeprom[CONFIG_EEPROM_ADDR + offsetof(config_struct, static_ip)] += 0xFE;
+    memcpy(&vpd, eeprom, sizeof(vpd));
+    memcpy(&config, eeprom + CONFIG_EEPROM_ADDR, sizeof(config));
+    last_log[0] = 0;
+    eecrc_init();
+    CHECK(strcmp(last_log, "Config crc error - restoring defaults\r\n") == 0);
+    CHECK(config_defaults_written == 1 && config.hi_warn == default_config.hi_warn);
+    reboot();
+    CHECK(last_log[0] == 0);
+ }
+
+ /**********************************
+ * now_ns()
+ *
+ * Returns a monotonic host time in nanoseconds
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  the time
+ *
+ * changes:
+ *  none
+ */
+ static double now_ns(){
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+ }
+
+ /**********************************
+ * bench_adjust()
+ *
+ * Compares the table steps and host time of updating the config crc
+ * after each threshold change by crc16_adjust() with a full rescan
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  none
+ */
+ static void bench_adjust(){
+    static const char *names[] = {"hi_alarm", "hi_warn", "lo_alarm", "lo_warn"};
+    unsigned char offsets[4];
+    unsigned long steps, i, rounds = 1000000;
+    unsigned char t;
+    volatile unsigned int sink = 0;
+    double start, adjust_ns, full_ns;
+    int old = 0;
+
+    offsets[0] = offsetof(config_struct, hi_alarm);
+    offsets[1] = offsetof(config_struct, hi_warn);
+    offsets[2] = offsetof(config_struct, lo_alarm);
+    offsets[3] = offsetof(config_struct, lo_warn);
+
+    /* the step counts follow from the AVR layout: with 2 byte ints the
+    * crc covers 17 bytes and threshold t is at offset 4 + 2t
+    */
+    printf("AVR change         adjust steps  rescan steps\n");
+    for(t = 0; t < 4; t++){
+        printf("%-18s %12u  %12u\n", names[t], 17 - (4 + 2 * t), 17);
+    }
+
+    /* host layout timing, using the counted steps as a cross check */
+    for(t = 0; t < 4; t++){
+        table_steps = 0;
+        sink ^= crc16_adjust(0x1234, (unsigned char*)&old, (unsigned char*)&config + offsets[t],
+                             sizeof(int), CONFIG_CRC_SIZE - offsets[t] - sizeof(int));
+        steps = table_steps;
+        start = now_ns();
+        for(i = 0; i < rounds; i++){
+            sink ^= crc16_adjust(i, (unsigned char*)&old, (unsigned char*)&config + offsets[t],
+                                 sizeof(int), CONFIG_CRC_SIZE - offsets[t] - sizeof(int));
+        }
+        adjust_ns = (now_ns() - start) / rounds;
+        start = now_ns();
+        for(i = 0; i < rounds; i++){
+            config.hi_alarm = i;
+            sink ^= crc16((unsigned char*)&config, CONFIG_CRC_SIZE);
+        }
+        full_ns = (now_ns() - start) / rounds;
+        printf("host %-13s %3lu steps %6.1f ns   rescan %3lu steps %6.1f ns\n",
+               names[t], steps, adjust_ns, (unsigned long)CONFIG_CRC_SIZE, full_ns);
+    }
+ }
+
+ /**********************************
+ * main()
+ *
+ * Runs the tests and the benchmark
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  0 if all the tests passed, otherwise 1
+ *
+ * changes:
+ *  none
+ */
+ int main(){
+    if(offsetof(config_struct, checksum) != sizeof(config_struct) - 1){
+        printf("build with -fpack-struct\n");
+        return 1;
+    }
+    srand(486);
+    test_crc16();
+    test_adjust();
+    test_eecrc();
+    printf("%lu checks, %lu failures\n", checks, failures);
+    bench_adjust();
+    return failures != 0;
+ }
@@ -0,0 +1,165 @@
+/********************************************************
+ * dhcp_host.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * Host harness for the dhcp client in netboot.c.  The firmware netboot.c,
+ * socket.c, crc16.c and fmt.c run unchanged over the W5100 emulation in
+ * tools/host, with ports offset by 10000 so that no root access is needed.
+ * netboot_update() is called every 5 ms, as from the scheduler, and the
+ * longest call is reported at the end to show that no call waits for the
+ * server.  Every message sent and every address change is printed with
+ * the time since the start.  The socket buffer layout is set as in main.c,
+ * and the W5100 emulation stops the run if a W5x_config() call leaves the
+ * W5100 with a different one.
+ *
+ * Run it against the scripted server stand-in tools/dhcp_server.py:
+ *
+ *    gcc -O2 -fpack-struct -I tools/host -I . -o dhcp_host tools/dhcp_host.c \
+ *        tools/host/w5emu.c netboot.c socket.c crc16.c fmt.c
+ *    python3 tools/dhcp_server.py & ./dhcp_host 45 cached
+ *
+ * The second argument selects the boot: "cached" starts from a lease in
+ * the emulated eeprom, "dhcp" from the (emulated) blocking library dhcp.
+ *
+ * Functions:
+ *
+ * main()
+ *  Runs netboot_start() and calls netboot_update() for the run time
+ *
+ * now_ms()
+ *  Returns the host time since the start
+ *
+ * (stand-ins for the library, uart, clock and eeprom functions)
+ */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <time.h>
+ #include <unistd.h>
+ #include "config.h"
+ #include "vpd.h"
+ #include "netboot.h"
+ #include "w5burst.h"
+ #include "w5emu.h"
+
+ config_struct config = {"ASU", 100, 90, 40, 50, 0, {0}, 0};
+ vpd_struct vpd = {"SER", "IIoT", "ASU", "SN00100", 0, {0x00, 0x08, 0xDC, 0x00, 0x00, 0x64}, "USA", 0};
+ volatile unsigned char crash_last_sockop;
+
+ static unsigned char eeprom[1024];
+ static unsigned char library_ip[4] = {192, 168, 1, 60};
+ static unsigned char library_gateway[4] = {192, 168, 1, 1};
+ static unsigned char library_subnet[4] = {255, 255, 255, 0};
+ static unsigned char library_server[4] = {192, 168, 1, 1};
+ static unsigned long sends_seen;
+ static unsigned long configs_seen;
+
+ /**********************************
+ * now_ms()
+ *
+ * Returns the host time in milliseconds since the first call
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  the time
+ *
+ * changes:
+ *  none
+ */
+ static double now_ms(){
+    static double start;
+    struct timespec t;
+    double ms;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    ms = t.tv_sec * 1e3 + t.tv_nsec / 1e6;
+    if(start == 0){
+        start = ms;
+    }
+    return ms - start;
+ }
+
+ unsigned long clock_ms(){ return (unsigned long)now_ms(); }
+ unsigned long clock_uptime(){ return (unsigned long)(now_ms() / 1000); }
+ int eeprom_isbusy(){ return 0; }
+ void eeprom_readbuf(unsigned int addr, unsigned char *buf, unsigned char size){ memcpy(buf, eeprom + addr, size); }
+ void eeprom_writebuf(unsigned int addr, unsigned char *buf, unsigned char size){ memcpy(eeprom + addr, buf, size); }
+ unsigned char ulog_begin(unsigned char level){ printf("%8.0f ", now_ms()); return 1; }
+ void ulog_end(){ fflush(stdout); }
+ void uart_writestr(char *str){ fputs(str, stdout); }
+ void serial_writestr_P(const char *str){ uart_writestr((char*)str); }
+ void uart_writedec32(signed long num){ printf("%ld", num); }
+ void ulog_str(unsigned char level, const char *msg, const char *str){ ulog_begin(level); printf("%s%s\n", msg, str); ulog_end(); }
+ char *rtc_num2datestr(unsigned long num){ return ""; }
+ int dhcp_start(unsigned char *mac, unsigned long timeout_ms, unsigned long response_ms){ return 1; }
+ unsigned char *dhcp_getLocalIp(){ return library_ip; }
+ unsigned char *dhcp_getGatewayIp(){ return library_gateway; }
+ unsigned char *dhcp_getSubnetMask(){ return library_subnet; }
+ unsigned char *dhcp_getDhcpServerIp(){ return library_server; }
+
+ /**********************************
+ * main()
+ *
+ * Runs netboot_start() and calls netboot_update() every 5 ms for the
+ * run time, printing each dhcp message sent
+ *
+ * arguments:
+ *  argv[1] - run time (s)
+ *  argv[2] - "cached" or "dhcp"
+ *
+ * returns:
+ *  0
+ *
+ * changes:
+ *  none
+ */
+ int main(int argc, char **argv){
+    /* cached lease record: "LEAS", 192.168.1.77, gateway, subnet, crc */
+    static const unsigned char cached[] = {'L', 'E', 'A', 'S', 192, 168, 1, 77, 192, 168, 1, 1, 255, 255, 255, 0};
+    extern unsigned int crc16(const unsigned char *data, unsigned int len);
+    unsigned int seconds = (argc > 1) ? atoi(argv[1]) : 45;
+    unsigned int crc, port;
+    const unsigned char *dest;
+    double start, took, longest = 0;
+
+    w5emu_port_offset = 10000;
+    w5burst_set_layout(W5_RX_PROFILE, W5_TX_PROFILE);
+    now_ms();
+    if(argc < 3 || strcmp(argv[2], "dhcp") != 0){
+        crc = crc16(cached, sizeof(cached));
+        memcpy(eeprom + NETBOOT_EEPROM_ADDR, cached, sizeof(cached));
+        eeprom[NETBOOT_EEPROM_ADDR + sizeof(cached)] = crc;
+        eeprom[NETBOOT_EEPROM_ADDR + sizeof(cached) + 1] = crc >> 8;
+    }
+    netboot_start();
+
+    while(now_ms() < seconds * 1000.0){
+        start = now_ms();
+        netboot_update();
+        took = now_ms() - start;
+        if(took > longest){
+            longest = took;
+        }
+        if(w5emu_configs != configs_seen){
+            configs_seen = w5emu_configs;
+            printf("%8.0f W5x_config ip %d.%d.%d.%d gateway %d.%d.%d.%d subnet %d.%d.%d.%d\n", now_ms(),
+                   w5emu_ip[0], w5emu_ip[1], w5emu_ip[2], w5emu_ip[3], w5emu_gateway[0], w5emu_gateway[1],
+                   w5emu_gateway[2], w5emu_gateway[3], w5emu_subnet[0], w5emu_subnet[1], w5emu_subnet[2],
+                   w5emu_subnet[3]);
+        }
+        if(w5emu_sends != sends_seen){
+            sends_seen = w5emu_sends;
+            dest = w5emu_get_dest(2, &port);
+            printf("%8.0f sent to %d.%d.%d.%d:%u\n", now_ms(), dest[0], dest[1], dest[2], dest[3], port);
+            fflush(stdout);
+        }
+        usleep(5000);
+    }
+    printf("longest netboot_update() %.3f ms, %lu datagrams sent\n", longest, w5emu_sends);
+    return 0;
+ }
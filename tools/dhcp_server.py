@@ -0,0 +1,138 @@
+#!/usr/bin/env python3
+"""
+dhcp_server.py
+
+SER486 Final Project
+Author: Jesse Baker (student jjbaker4)
+
+Scripted dhcp server stand-in for tools/dhcp_host.c.  Listens on
+127.0.0.1:10067 (port 67 offset by 10000), checks every request against
+the client state it implies (RFC 2131 table 5) and answers according to a
+script that walks the client through each of its states:
+
+    INIT-REBOOT  ack 192.168.1.77, 12 s lease, no T1/T2 (defaults 6/10.5 s)
+    RENEWING     ack, 12 s lease with T1 4 s and T2 8 s
+    RENEWING     ignored (no reply) until the client rebinds
+    REBINDING    ack a different address, 192.168.1.78, 12 s lease
+    RENEWING     nak - the client starts a new discovery
+    SELECTING    offer 192.168.1.79
+    REQUESTING   ack, 8 s lease, then stop answering (the lease expires)
+
+    dhcp_server.py
+"""
+
+import socket
+import struct
+import sys
+import time
+
+SERVER_ID = bytes([192, 168, 1, 1])
+COOKIE = bytes([99, 130, 83, 99])
+
+
+def parse(d):
+    """Returns the fields and options of a client message"""
+    opts = {}
+    p = 240
+    while p < len(d) and d[p] != 255:
+        if d[p] == 0:
+            p += 1
+            continue
+        opts[d[p]] = d[p + 2:p + 2 + d[p + 1]]
+        p += 2 + d[p + 1]
+    return dict(op=d[0], xid=d[4:8], flags=d[10], ciaddr=d[12:16], chaddr=d[28:34],
+                cookie=d[236:240], type=opts.get(53, b'\0')[0], opts=opts, size=len(d))
+
+
+def reply(req, mtype, yiaddr=b'\0\0\0\0', lease=None, t1=None, t2=None):
+    """Builds a server reply to a request"""
+    m = bytes([2, 1, 6, 0]) + req['xid'] + bytes(4) + req['ciaddr'] + yiaddr + bytes(8)
+    m += req['chaddr'] + bytes(10 + 64 + 128) + COOKIE
+    m += bytes([53, 1, mtype, 54, 4]) + SERVER_ID
+    if mtype != 6:
+        m += bytes([1, 4, 255, 255, 255, 0, 3, 4, 192, 168, 1, 1])
+        # an unknown multi-byte option, which the client must skip
+        m += bytes([15, 11]) + b'example.com'
+    for code, value in ((51, lease), (58, t1), (59, t2)):
+        if value is not None:
+            m += bytes([code, 4]) + struct.pack('>I', value)
+    return m + bytes([255])
+
+
+def classify(req):
+    """Returns the client state implied by a request"""
+    o = req['opts']
+    if req['type'] == 1:
+        return 'SELECTING'
+    if 54 in o:
+        return 'REQUESTING'
+    if 50 in o:
+        return 'INIT-REBOOT'
+    return 'RENEWING/REBINDING'
+
+
+def check(req, state):
+    """Checks the fields that RFC 2131 requires in each state"""
+    errors = []
+    o = req['opts']
+    if req['op'] != 1 or req['cookie'] != COOKIE or req['size'] < 300:
+        errors.append('bad header or short message')
+    if o.get(61) != b'\x01' + req['chaddr']:
+        errors.append('client id')
+    if state in ('SELECTING', 'INIT-REBOOT', 'REQUESTING'):
+        if req['ciaddr'] != bytes(4) or not req['flags'] & 0x80:
+            errors.append('ciaddr must be 0 with the broadcast flag')
+    else:
+        if req['ciaddr'] == bytes(4) or 50 in o or 54 in o:
+            errors.append('renewal needs ciaddr and no requested ip/server id')
+    return errors
+
+
+def main():
+    s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    s.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    s.bind(('127.0.0.1', 10067))
+    client = ('127.0.0.1', 10068)
+    step = 0
+    ignore_until = 0
+    t0 = None
+    errors = 0
+    while True:
+        d, _ = s.recvfrom(2048)
+        now = time.time()
+        if t0 is None:
+            t0 = now
+        req = parse(d)
+        state = classify(req)
+        problems = check(req, state)
+        errors += len(problems)
+        ip = '.'.join(str(b) for b in (req['opts'].get(50) or req['ciaddr']))
+        print('%8.0f server: %-18s ip %-15s %s' % ((now - t0) * 1000, state, ip,
+              'ok' if not problems else 'ERROR ' + ', '.join(problems)))
+        sys.stdout.flush()
+
+        if step == 0 and state == 'INIT-REBOOT':
+            s.sendto(reply(req, 5, req['opts'][50], lease=12), client)
+            step = 1
+        elif step == 1 and state == 'RENEWING/REBINDING':
+            s.sendto(reply(req, 5, req['ciaddr'], lease=12, t1=4, t2=8), client)
+            step = 2
+        elif step == 2:
+            # drop the renewals, answer the first request after T2
+            if ignore_until == 0:
+                ignore_until = now + 3.5
+            if now >= ignore_until:
+                s.sendto(reply(req, 5, bytes([192, 168, 1, 78]), lease=12), client)
+                step = 3
+        elif step == 3 and state == 'RENEWING/REBINDING':
+            s.sendto(reply(req, 6), client)
+            step = 4
+        elif step == 4 and state == 'SELECTING':
+            s.sendto(reply(req, 2, bytes([192, 168, 1, 79]), lease=8), client)
+        elif step == 4 and state == 'REQUESTING':
+            s.sendto(reply(req, 5, req['opts'][50], lease=8), client)
+            step = 5
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,129 @@
+/********************************************************
+ * fleet_host.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * Host harness for the device side of the fleet protocol (fleet.c).  One
+ * process is one device: the firmware fleet.c, udpmux.c, socket.c,
+ * devapi.c, util.c, devstate.c, fmt.c and crc16.c run unchanged over the
+ * W5100 emulation in tools/host.  Device n binds to 127.1.x.y (the
+ * address n + 1) with ports offset by 10000, has the mac address
+ * 00:08:DC:10:x:y, the ip address 10.1.x.y, the serial number SN<n> and
+ * a temperature of 60 + n % 50.  udpmux_update() and fleet_update() are
+ * called every 5 ms, as by the "udp" task.  An optional percentage of the
+ * received datagrams is dropped.
+ *
+ * The master side is tools/fleet_master.py, which starts the devices:
+ *
+ *    gcc -O2 -DFLEET_ENABLE=1 -ffunction-sections -Wl,--gc-sections -I tools/host -I . \
+ *        -o fleet_host tools/fleet_host.c tools/host/w5emu.c fleet.c \
+ *        udpmux.c socket.c devapi.c util.c devstate.c fmt.c crc16.c
+ *    fleet_host <device number> <run time (s)> [receive loss (%)]
+ *
+ * Functions:
+ *
+ * main()
+ *  Runs one device for the run time
+ *
+ * (stand-ins for the clock, scheduler (no task is synchronized), eeprom
+ * crc, dhcp address, log and the other udpmux clients)
+ */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <time.h>
+ #include <unistd.h>
+ #include "config.h"
+ #include "vpd.h"
+ #include "crc16.h"
+ #include "socket.h"
+ #include "udpmux.h"
+ #include "fleet.h"
+ #include "sched.h"
+ #include "w5emu.h"
+
+ config_struct config = {"ASU", 100, 90, 40, 50, 0, {0}, 0};
+ vpd_struct vpd = {"SER", "IIoT", "ASU", "SN00000", 0, {0x00, 0x08, 0xDC, 0x10, 0x00, 0x00}, "USA", 0};
+ volatile unsigned char crash_last_sockop;
+ int current_temperature;
+
+ static unsigned char ip[4] = {10, 1, 0, 0};
+
+ unsigned long clock_ms(){
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000UL + t.tv_nsec / 1000000;
+ }
+ const task_struct *sched_get_task(unsigned char id){ return NULL; }
+ void sched_shift_release(unsigned char id, long delta_ms){}
+ int temp_get(){ return current_temperature; }
+ void config_set_modified(){}
+ void eecrc_config_changed(unsigned char offset, const unsigned char *old_value, unsigned char len){}
+ unsigned int eecrc_get_config_crc(){ return crc16((const unsigned char*)&config, sizeof(config)); }
+ const unsigned char *netboot_get_ip(){ return ip; }
+ unsigned char log_get_num_entries(){ return 0; }
+ int log_get_record(unsigned long index, unsigned long *time, unsigned char *eventnum){ return 0; }
+ char *rtc_num2datestr(unsigned long num){ return ""; }
+ unsigned char ulog_begin(unsigned char level){ return 0; }
+ void ulog_end(){}
+ void uart_writestr(char *str){}
+ void ntpclient_receive(const unsigned char *msg, unsigned int len, const unsigned char *addr){}
+ void mqttsn_receive(const unsigned char *msg, unsigned int len, const unsigned char *addr){}
+ void coap_receive(const unsigned char *msg, unsigned int len, const unsigned char *addr, unsigned int port){}
+
+ /**********************************
+ * main()
+ *
+ * Sets up device n and calls udpmux_update() and fleet_update() every
+ * 5 ms for the run time
+ *
+ * arguments:
+ *  argv[1] - the device number n (0 to 65533)
+ *  argv[2] - run time (s)
+ *  argv[3] - optional receive loss (%)
+ *
+ * returns:
+ *  0, or 1 if the arguments are missing
+ *
+ * changes:
+ *  none
+ */
+ int main(int argc, char **argv){
+    unsigned int n;
+    unsigned long seconds;
+    unsigned long start;
+    unsigned long next_update;
+
+    if(argc < 3){
+        fprintf(stderr, "usage: fleet_host <device number> <run time (s)> [receive loss (%%)]\n");
+        return 1;
+    }
+    n = atoi(argv[1]);
+    seconds = atol(argv[2]);
+    w5emu_rx_loss = (argc > 3) ? atoi(argv[3]) : 0;
+    w5emu_bind_ip = 0x7F010000UL + n + 1;
+    w5emu_port_offset = 10000;
+    srand(n * 7919 + 1);
+
+    ip[2] = vpd.mac_address[4] = (n + 1) >> 8;
+    ip[3] = vpd.mac_address[5] = (n + 1) & 0xFF;
+    snprintf(vpd.serial_number, sizeof(vpd.serial_number), "SN%05u", n);
+    current_temperature = 60 + n % 50;
+    udpsocket_open(UDPMUX_SOCKET, UDPMUX_PORT);
+
+    /* the devices do not poll in step */
+    start = clock_ms();
+    next_update = start + n % 5;
+    while(clock_ms() - start < seconds * 1000UL){
+        if((long)(clock_ms() - next_update) >= 0){
+            next_update += 5;
+            udpmux_update();
+            fleet_update();
+        }
+        usleep(1000);
+    }
+    return 0;
+ }
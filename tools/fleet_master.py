@@ -0,0 +1,260 @@
+#!/usr/bin/env python3
+"""
+fleet_master.py
+
+SER486 Final Project
+Author: Jesse Baker (student jjbaker4)
+
+Master side of the fleet protocol (fleet.h) for the fleet simulation.
+Starts N device processes (tools/fleet_host.c) on 127.1.x.y and talks
+to them from 127.0.0.1:15690 (FLEET_MASTER_PORT offset by 10000).  The
+master sends one datagram to every device address in turn, standing in
+for one subnet broadcast.
+
+    fleet_master.py discover [--devices N] [--window MS] [--rcvbuf BYTES]
+    fleet_master.py config [--devices N] [--loss PERCENT] [--rcvbuf BYTES]
+
+discover sends three DISCOVER queries and reports, for each, how many
+devices answered and when the last record arrived.  The records are
+checked against the identity fleet_host.c gives each device, and the
+reply order must change between the queries.
+
+config pushes thresholds to the fleet, retrying by unicast to the
+devices that have not acknowledged, with the devices dropping a
+percentage of what they receive.  It pushes tcrit_hi to every device,
+all four thresholds to a serial number range, then checks that a
+message for another model, an invalid set of thresholds and a message
+with a bad crc are not applied, and that a repeated message changes
+nothing.
+"""
+
+import argparse
+import socket
+import struct
+import subprocess
+import sys
+import time
+
+FLEET_MAGIC = 0xF5
+MSG_DISCOVER, MSG_DEVICE, MSG_CONFIG, MSG_CONFIG_ACK = 1, 2, 3, 4
+TARGET_ALL, TARGET_MODEL, TARGET_SERIAL = 0, 1, 2
+SET_OK, SET_INVALID = 0, 1
+MAX_ROUNDS = 8
+MASTER_PORT = 5690 + 10000
+DEVICE_PORT = 5683 + 10000
+NOT_SYNCED = 0x7FFF
+
+checks = 0
+failures = 0
+
+
+def check(cond, what):
+    """Counts a check and reports it if it failed."""
+    global checks, failures
+    checks += 1
+    if not cond:
+        failures += 1
+        print('FAIL', what)
+
+
+def crc16(data):
+    """CRC-16 (CCITT polynomial 0x1021, initial value 0xFFFF) as crc16.c."""
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def device_addr(n):
+    """Returns the host address of device n."""
+    return ('127.1.%d.%d' % ((n + 1) >> 8, (n + 1) & 0xFF), DEVICE_PORT)
+
+
+def start_devices(args, seconds, loss=0):
+    """Starts the device processes and gives them time to open their sockets."""
+    procs = [subprocess.Popen([args.host, str(n), str(seconds), str(loss)]) for n in range(args.devices)]
+    time.sleep(1.0)
+    return procs
+
+
+def broadcast(sock, args, msg):
+    """Sends a message to every device (one broadcast on a site)."""
+    for n in range(args.devices):
+        sock.sendto(msg, device_addr(n))
+
+
+def parse_device(d):
+    """Parses a FLEET_MSG_DEVICE record."""
+    n = d[17]
+    m = d[18 + n]
+    return {'mac': d[4:10], 'ip': bytes(d[10:14]), 'state': d[14],
+            'version': struct.unpack('>H', d[15:17])[0], 'model': d[18:18 + n],
+            'serial': d[19 + n:19 + n + m], 'sync': struct.unpack('>h', d[19 + n + m:21 + n + m])[0]}
+
+
+def discover(sock, args, seq):
+    """Sends one DISCOVER and collects the records until the window has passed."""
+    broadcast(sock, args, struct.pack('>BBHH', FLEET_MAGIC, MSG_DISCOVER, seq, args.window))
+    start = time.perf_counter()
+    last = start
+    records = {}
+    order = []
+    while time.perf_counter() - start < args.window / 1000 + 0.5 and len(records) < args.devices:
+        try:
+            d = sock.recv(256)
+        except socket.timeout:
+            continue
+        if d[0] != FLEET_MAGIC or d[1] != MSG_DEVICE or struct.unpack('>H', d[2:4])[0] != seq:
+            continue
+        r = parse_device(d)
+        records[r['mac']] = r
+        order.append(r['mac'])
+        last = time.perf_counter()
+    return records, order, last - start
+
+
+def run_discover(args):
+    """Three discovery rounds over the whole fleet."""
+    procs = start_devices(args, 8)
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, args.rcvbuf)
+    sock.bind(('127.0.0.1', MASTER_PORT))
+    sock.settimeout(0.05)
+    orders = []
+    for seq in (1, 2, 3):
+        records, order, elapsed = discover(sock, args, seq)
+        orders.append(order)
+        print('window %d ms, rcvbuf %d: %d/%d devices in %.0f ms' %
+              (args.window, args.rcvbuf, len(records), args.devices, elapsed * 1000))
+        check(len(records) == args.devices, 'query %d: %d records' % (seq, len(records)))
+        for r in records.values():
+            n = (r['mac'][4] << 8 | r['mac'][5]) - 1
+            check(r['mac'][:4] == b'\x00\x08\xdc\x10' and r['ip'] == bytes([10, 1, r['mac'][4], r['mac'][5]])
+                  and r['model'] == b'IIoT' and r['serial'] == b'SN%05d' % n and r['version'] == 0x0100
+                  and r['sync'] == NOT_SYNCED, 'record %s' % r)
+    check(orders[0] != orders[1] or args.devices < 3, 'the reply order changes between queries')
+    for p in procs:
+        p.kill()
+
+
+def config_msg(seq, window, target, mask, values, target_data=b''):
+    """Builds a FLEET_MSG_CONFIG message with its crc."""
+    m = struct.pack('>BBHHBB4h', FLEET_MAGIC, MSG_CONFIG, seq, window, target, mask, *values) + target_data
+    return m + struct.pack('>H', crc16(m))
+
+
+def string(s):
+    """Encodes a target string (length and characters)."""
+    return bytes([len(s)]) + s.encode()
+
+
+def collect_acks(sock, seq, wait):
+    """Collects the config acks of a message until wait (s) has passed."""
+    acks = {}
+    start = time.perf_counter()
+    while time.perf_counter() - start < wait:
+        try:
+            d = sock.recv(256)
+        except socket.timeout:
+            continue
+        if d[0] != FLEET_MAGIC or d[1] != MSG_CONFIG_ACK or struct.unpack('>H', d[2:4])[0] != seq:
+            continue
+        n = (d[8] << 8 | d[9]) - 1
+        acks[n] = (d[10], struct.unpack('>H', d[11:13])[0], struct.unpack('>4h', d[13:21]))
+    return acks
+
+
+def push(sock, args, msg, targets, window):
+    """Broadcasts a config message, then unicasts it again to the targets
+    that have not acknowledged it.  Returns the acks, the time, the
+    datagrams sent and the rounds."""
+    seq = struct.unpack('>H', msg[2:4])[0]
+    start = time.perf_counter()
+    pending = set(targets)
+    acks = {}
+    sent = 0
+    rounds = 0
+    while pending and rounds < MAX_ROUNDS:
+        rounds += 1
+        if rounds == 1:
+            broadcast(sock, args, msg)
+            sent += args.devices
+        else:
+            for n in sorted(pending):
+                sock.sendto(msg, device_addr(n))
+            sent += len(pending)
+        round_acks = collect_acks(sock, seq, window / 1000 + 0.15)
+        acks.update(round_acks)
+        pending -= set(round_acks)
+        print('  round %d: %d acks, %d pending' % (rounds, len(round_acks), len(pending)))
+    return acks, time.perf_counter() - start, sent, rounds
+
+
+def run_config(args):
+    """Config pushes to the whole fleet and to part of it."""
+    procs = start_devices(args, 30, args.loss)
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, args.rcvbuf)
+    sock.bind(('127.0.0.1', MASTER_PORT))
+    sock.settimeout(0.02)
+    everyone = range(args.devices)
+
+    print('%d devices, %d%% receive loss' % (args.devices, args.loss))
+    acks, elapsed, sent, rounds = push(sock, args, config_msg(1, 500, TARGET_ALL, 0b0001, (110, 0, 0, 0)),
+                                       everyone, 500)
+    print('tcrit_hi=110 to all: %d/%d acked in %.2f s, %d rounds, %d datagrams (%d retries)' %
+          (len(acks), args.devices, elapsed, rounds, sent, sent - args.devices))
+    check(len(acks) == args.devices, 'every device acked')
+    check(all(a[0] == SET_OK and a[2] == (110, 90, 40, 50) for a in acks.values()), 'tcrit_hi applied')
+    check(len(set(a[1] for a in acks.values())) == 1, 'one config crc across the fleet')
+
+    first, last = min(10, args.devices - 1), min(19, args.devices - 1)
+    in_range = range(first, last + 1)
+    msg = config_msg(2, 200, TARGET_SERIAL, 0b1111, (105, 95, 35, 45),
+                     string('SN%05d' % first) + string('SN%05d' % last))
+    acks, elapsed, sent, rounds = push(sock, args, msg, in_range, 200)
+    check(set(acks) == set(in_range), 'serial range acked by %s' % sorted(acks))
+    check(all(a[2] == (105, 95, 35, 45) for a in acks.values()), 'all four thresholds applied')
+
+    sock.sendto(config_msg(3, 100, TARGET_MODEL, 0b0001, (120, 0, 0, 0), string('Other')), device_addr(0))
+    check(collect_acks(sock, 3, 0.4) == {}, 'another model does not ack')
+
+    acks, elapsed, sent, rounds = push(sock, args, config_msg(4, 100, TARGET_ALL, 0b0010, (200, 0, 0, 0)), [0], 100)
+    check(acks.get(0, (None,))[0] == SET_INVALID and acks[0][2] == (110, 90, 40, 50),
+          'twarn_hi above tcrit_hi is refused %s' % acks)
+
+    bad = bytearray(config_msg(5, 100, TARGET_ALL, 0b0001, (111, 0, 0, 0)))
+    bad[-1] ^= 1
+    sock.sendto(bytes(bad), device_addr(0))
+    check(collect_acks(sock, 5, 0.4) == {}, 'a bad crc is not acked')
+
+    acks, elapsed, sent, rounds = push(sock, args, config_msg(6, 100, TARGET_ALL, 0b0001, (110, 0, 0, 0)), [0], 100)
+    check(acks.get(0, (None,))[0] == SET_OK and acks[0][2] == (110, 90, 40, 50), 'a repeated message %s' % acks)
+    for p in procs:
+        p.kill()
+
+
+def main():
+    ap = argparse.ArgumentParser(description='fleet protocol master for the fleet simulation')
+    ap.add_argument('command', choices=['discover', 'config'])
+    ap.add_argument('--devices', type=int, default=200)
+    ap.add_argument('--window', type=int, default=500, help='reply window (ms)')
+    ap.add_argument('--rcvbuf', type=int, default=4096, help='master receive buffer (bytes)')
+    ap.add_argument('--loss', type=int, default=0, help='device receive loss (%%)')
+    ap.add_argument('--host', default='./fleet_host', help='device program')
+    args = ap.parse_args()
+
+    if args.command == 'discover':
+        run_discover(args)
+    else:
+        run_config(args)
+
+    print('%d checks, %d failures' % (checks, failures))
+    sys.exit(1 if failures else 0)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,249 @@
+/********************************************************
+ * fmt_test.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * Host check of the formatting kernels in fmt.c (compiled unchanged
+ * against the stand-in headers in tools/host).  Every kernel is compared
+ * with printf over its whole input range: fmt_u16() and fmt_hex16() for
+ * every 16-bit value, fmt_hex8() for every byte, fmt_u32() and fmt_s32()
+ * for every 32-bit pattern (as unsigned and as signed), and fmt_ip() and
+ * fmt_mac() for every byte value in every position.  Each call must also
+ * return the text length and write nothing past its FMT_*_SIZE buffer.
+ *
+ * The 32-bit range takes about 20 minutes on one host core.  An optional
+ * step checks every step-th 32-bit pattern instead (with the values next
+ * to each power of ten and the sign boundary always checked):
+ *
+ *    gcc -O2 -I tools/host -I . -o fmt_test tools/fmt_test.c fmt.c
+ *    ./fmt_test [step]
+ *
+ * Functions:
+ *
+ * main()
+ *  Runs the checks
+ *
+ * check()
+ *  Compares the output of one kernel call with the printf text
+ *
+ * check_u32()
+ *  Checks fmt_u32() and fmt_s32() for one 32-bit pattern
+ *
+ * check_16bit()
+ *  Checks the 8 and 16-bit kernels over their whole range
+ *
+ * check_addresses()
+ *  Checks fmt_ip() and fmt_mac()
+ */
+
+ #include <stdint.h>
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include "fmt.h"
+
+ /* byte the output buffers are filled with before each call */
+ #define GUARD       0x5A
+ #define BUF_SIZE    32
+
+ static unsigned long checks;
+ static unsigned long failures;
+
+ /**********************************
+ * check()
+ *
+ * Compares the output of one kernel call with the printf text: the
+ * text, the returned length and the bytes past the kernel buffer size
+ * (which must still hold the guard byte)
+ *
+ * arguments:
+ *  name - the kernel name
+ *  buf - the output buffer (BUF_SIZE bytes, filled with GUARD before the call)
+ *  len - the length returned by the kernel
+ *  size - the FMT_*_SIZE buffer size of the kernel
+ *  expect - the printf text
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  checks, failures
+ */
+ static void check(const char *name, const char *buf, unsigned char len, unsigned int size, const char *expect){
+    unsigned int i;
+    int bad = (strcmp(buf, expect) != 0 || len != strlen(expect));
+
+    for(i = size; i < BUF_SIZE; i++){
+        if((unsigned char)buf[i] != GUARD){
+            bad = 1;
+        }
+    }
+    checks++;
+    if(bad){
+        failures++;
+        if(failures <= 20){
+            printf("FAIL %s: \"%.*s\" (%u) expected \"%s\"\n", name, BUF_SIZE - 1, buf, len, expect);
+        }
+    }
+ }
+
+ /**********************************
+ * check_u32()
+ *
+ * Checks fmt_u32() and fmt_s32() for one 32-bit pattern
+ *
+ * arguments:
+ *  v - the pattern
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  checks, failures
+ */
+ static void check_u32(uint32_t v){
+    char buf[BUF_SIZE];
+    char expect[BUF_SIZE];
+    unsigned char len;
+
+    memset(buf, GUARD, sizeof(buf));
+    len = fmt_u32(buf, v);
+    snprintf(expect, sizeof(expect), "%lu", (unsigned long)v);
+    check("fmt_u32", buf, len, FMT_U32_SIZE, expect);
+
+    memset(buf, GUARD, sizeof(buf));
+    len = fmt_s32(buf, (int32_t)v);
+    snprintf(expect, sizeof(expect), "%ld", (long)(int32_t)v);
+    check("fmt_s32", buf, len, FMT_S32_SIZE, expect);
+ }
+
+ /**********************************
+ * check_16bit()
+ *
+ * Checks fmt_u16() and fmt_hex16() for every 16-bit value and fmt_hex8()
+ * for every byte
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  checks, failures
+ */
+ static void check_16bit(){
+    char buf[BUF_SIZE];
+    char expect[BUF_SIZE];
+    unsigned char len;
+    unsigned int v;
+
+    for(v = 0; v <= 0xFFFF; v++){
+        memset(buf, GUARD, sizeof(buf));
+        len = fmt_u16(buf, v);
+        snprintf(expect, sizeof(expect), "%u", v);
+        check("fmt_u16", buf, len, FMT_U16_SIZE, expect);
+
+        memset(buf, GUARD, sizeof(buf));
+        len = fmt_hex16(buf, v);
+        snprintf(expect, sizeof(expect), "%04X", v);
+        check("fmt_hex16", buf, len, FMT_HEX16_SIZE, expect);
+
+        if(v <= 0xFF){
+            memset(buf, GUARD, sizeof(buf));
+            len = fmt_hex8(buf, v);
+            snprintf(expect, sizeof(expect), "%02X", v);
+            check("fmt_hex8", buf, len, FMT_HEX8_SIZE, expect);
+        }
+    }
+ }
+
+ /**********************************
+ * check_addresses()
+ *
+ * Checks fmt_ip() and fmt_mac() with every byte value in every position
+ * (the other bytes taking a different value each time)
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  checks, failures
+ */
+ static void check_addresses(){
+    char buf[BUF_SIZE];
+    char expect[BUF_SIZE];
+    unsigned char addr[6];
+    unsigned char len;
+    unsigned int pos, v, i;
+
+    for(pos = 0; pos < 6; pos++){
+        for(v = 0; v <= 0xFF; v++){
+            for(i = 0; i < 6; i++){
+                addr[i] = (i == pos) ? v : (unsigned char)(v * 7 + i * 31);
+            }
+            if(pos < 4){
+                memset(buf, GUARD, sizeof(buf));
+                len = fmt_ip(buf, addr);
+                snprintf(expect, sizeof(expect), "%u.%u.%u.%u", addr[0], addr[1], addr[2], addr[3]);
+                check("fmt_ip", buf, len, FMT_IP_SIZE, expect);
+            }
+            memset(buf, GUARD, sizeof(buf));
+            len = fmt_mac(buf, addr);
+            snprintf(expect, sizeof(expect), "%02X:%02X:%02X:%02X:%02X:%02X",
+                     addr[0], addr[1], addr[2], addr[3], addr[4], addr[5]);
+            check("fmt_mac", buf, len, FMT_MAC_SIZE, expect);
+        }
+    }
+ }
+
+ /**********************************
+ * main()
+ *
+ * Runs the checks and prints the totals
+ *
+ * arguments:
+ *  argv[1] - optional step through the 32-bit range (default 1, every value)
+ *
+ * returns:
+ *  0 if every check passed, 1 otherwise
+ *
+ * changes:
+ *  none
+ */
+ int main(int argc, char **argv){
+    uint32_t step = (argc > 1) ? strtoul(argv[1], NULL, 0) : 1;
+    uint64_t v;
+    uint32_t p;
+    int d;
+
+    if(step == 0){
+        step = 1;
+    }
+    check_16bit();
+    check_addresses();
+
+    /* the values around each power of ten and the sign boundary */
+    for(p = 1; ; p *= 10){
+        for(d = -3; d <= 3; d++){
+            check_u32(p + d);
+        }
+        if(p > 0xFFFFFFFFUL / 10){
+            break;
+        }
+    }
+    for(d = -3; d <= 3; d++){
+        check_u32(0x80000000UL + d);
+    }
+
+    for(v = 0; v <= 0xFFFFFFFFULL; v += step){
+        check_u32((uint32_t)v);
+    }
+
+    printf("%lu checks, %lu failures\n", checks, failures);
+    return failures != 0;
+ }
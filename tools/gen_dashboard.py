@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+"""
+gen_dashboard.py
+
+SER486 Final Project
+Author: Jesse Baker (student jjbaker4)
+
+Compresses the web dashboard (tools/dashboard.html) with gzip and writes
+it as a program memory array to dashboard.c, which is served at GET /
+(see httpparser.c).  Leading indentation and blank lines are removed
+before compressing.  The gzip header timestamp is zeroed so that the
+output only changes when the page does.  Run it after editing the page:
+
+    tools/gen_dashboard.py
+"""
+
+import gzip
+import os
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SOURCE = os.path.join(ROOT, 'tools', 'dashboard.html')
+OUTPUT = os.path.join(ROOT, 'dashboard.c')
+
+HEADER = '''/********************************************************
+ * dashboard.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * Generated by tools/gen_dashboard.py from tools/dashboard.html - do not
+ * edit.  The gzip compressed web dashboard ({raw} bytes, {size} compressed).
+ */
+
+ #include <avr/pgmspace.h>
+ #include "dashboard.h"
+
+ #if DASHBOARD_ENABLE
+
+ const unsigned char dashboard_gz[DASHBOARD_GZ_SIZE] PROGMEM = {{
+'''
+
+
+def minify(html):
+    lines = (line.strip() for line in html.splitlines())
+    return '\n'.join(line for line in lines if line) + '\n'
+
+
+def main():
+    with open(SOURCE, encoding='utf-8') as f:
+        page = minify(f.read()).encode('utf-8')
+    data = gzip.compress(page, compresslevel=9, mtime=0)
+
+    out = [HEADER.format(raw=len(page), size=len(data))]
+    for i in range(0, len(data), 12):
+        row = ', '.join('0x%02X' % b for b in data[i:i + 12])
+        out.append('    ' + row + (',\n' if i + 12 < len(data) else '\n'))
+    out.append(' };\n\n #endif // DASHBOARD_ENABLE\n')
+    with open(OUTPUT, 'w', newline='\n') as f:
+        f.write(''.join(out))
+
+    header = os.path.join(ROOT, 'dashboard.h')
+    with open(header, encoding='utf-8') as f:
+        text = f.read()
+    define = '#define DASHBOARD_GZ_SIZE'
+    start = text.index(define)
+    end = text.index('\n', start)
+    text = text[:start] + '%s   %d' % (define, len(data)) + text[end:]
+    with open(header, 'w', newline='\n') as f:
+        f.write(text)
+
+    print('%s: %d bytes, %d gzipped' % (os.path.basename(OUTPUT), len(page), len(data)))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,22 @@
+/********************************************************
+ * avr/interrupt.h
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * Host stand-in for the avr-libc interrupt header, used when the
+ * firmware modules are compiled into the host test tools.  The host
+ * tools are single threaded and have no interrupts, so enabling and
+ * disabling them does nothing.  An interrupt routine becomes a plain
+ * function, which the tool calls where the interrupt would occur.
+ */
+
+#ifndef HOST_INTERRUPT_H_INCLUDED
+#define HOST_INTERRUPT_H_INCLUDED
+
+#define sei()
+#define cli()
+
+#define ISR(vector)     void vector(void)
+
+#endif // HOST_INTERRUPT_H_INCLUDED
@@ -0,0 +1,39 @@
+/********************************************************
+ * avr/io.h
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * Host stand-in for the avr-libc io header, used when the firmware
+ * modules are compiled into the host test tools.  Only the registers
+ * the host tools need are declared; the tool that uses them defines
+ * them and sets them as the hardware would.
+ */
+
+#ifndef HOST_IO_H_INCLUDED
+#define HOST_IO_H_INCLUDED
+
+extern volatile unsigned char SREG;
+extern volatile unsigned int TCNT1;
+
+/* ADC data and control registers (stream.c) */
+extern volatile unsigned int ADC;
+extern volatile unsigned char ADCSRA;
+extern volatile unsigned char ADCSRB;
+
+/* ADCSRA bits */
+#define ADEN                7
+#define ADSC                6
+#define ADATE               5
+#define ADIF                4
+#define ADIE                3
+#define ADPS2               2
+#define ADPS1               1
+#define ADPS0               0
+
+/* ADCSRB bits */
+#define ADTS2               2
+#define ADTS1               1
+#define ADTS0               0
+
+#endif // HOST_IO_H_INCLUDED
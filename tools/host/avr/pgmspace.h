@@ -0,0 +1,31 @@
+/********************************************************
+ * avr/pgmspace.h
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * Host stand-in for the avr-libc program memory header, used when the
+ * firmware modules are compiled into the host test tools.  Flash and
+ * SRAM are the same address space on the host, so the flash accessors
+ * are plain reads.
+ */
+
+#ifndef HOST_PGMSPACE_H_INCLUDED
+#define HOST_PGMSPACE_H_INCLUDED
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PGM_P                   const char *
+#define PSTR(s)                 (s)
+
+#define pgm_read_byte(p)        (*(const uint8_t *)(p))
+#define pgm_read_word(p)        ((uint16_t)*(p))
+
+#define strlen_P(s)             strlen(s)
+#define strcmp_P(a, b)          strcmp(a, b)
+#define strncmp_P(a, b, n)      strncmp(a, b, n)
+#define memcpy_P(d, s, n)       memcpy(d, s, n)
+
+#endif // HOST_PGMSPACE_H_INCLUDED
@@ -0,0 +1,22 @@
+/********************************************************
+ * avr/sleep.h
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * Host stand-in for the avr-libc sleep header, used when the firmware
+ * modules are compiled into the host test tools.  The cpu does not
+ * sleep - the tool advances its own clock between scheduler passes.
+ */
+
+#ifndef HOST_SLEEP_H_INCLUDED
+#define HOST_SLEEP_H_INCLUDED
+
+#define SLEEP_MODE_IDLE         0
+
+#define set_sleep_mode(mode)
+#define sleep_enable()
+#define sleep_disable()
+#define sleep_cpu()
+
+#endif // HOST_SLEEP_H_INCLUDED
@@ -0,0 +1,372 @@
+/********************************************************
+ * w5emu.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * Host emulation of the W5100 udp sockets, used to run the firmware
+ * socket layer (socket.c) and the udp protocol modules on the host.  Each
+ * W5100 socket opened in udp mode is backed by a non-blocking host udp
+ * socket.  The transmit and receive buffers and their pointers behave as
+ * on the W5100 (a receive buffer holds one datagram at a time, behind the
+ * 8 byte W5100 header), and a send completes at once with SEND_OK.
+ *
+ * Addresses are mapped onto the loopback network: a socket binds to
+ * w5emu_bind_ip, datagrams to a 127.x.x.x address go to that address and
+ * all others (the network, broadcast and multicast addresses) go to
+ * 127.0.0.1, and datagrams received from 127.0.0.1 are reported as coming
+ * from w5emu_loopback_source.  w5emu_port_offset is added to every local
+ * and destination port, so that privileged ports (dhcp) can be tested
+ * without root.  An optional receive loss percentage drops incoming
+ * datagrams.
+ *
+ * RMSR and TMSR are kept apart from the layout the socket layer computes
+ * its buffer bases from (w5burst_set_layout()).  W5x_config() resets them
+ * to 2K per socket as the library does, and a socket buffer access while
+ * they differ from the layout stops the program, so a W5x_config() call
+ * that is not followed by the layout (w5burst_config()) fails the test.
+ *
+ * The rest of the W5100 api (W5x_read/write and friends) is not emulated.
+ *
+ * Functions:
+ *
+ * W5x_getRXReceivedSize()
+ *  Loads the next host datagram into an empty receive buffer
+ *
+ * W5x_execCmdSn()
+ *  Executes the open, close, send and recv socket commands
+ *
+ * W5x_config()
+ *  Records the addresses and resets RMSR and TMSR
+ *
+ * w5burst_set_layout()
+ *  Sets RMSR, TMSR and the socket layer buffer layout
+ *
+ * w5burst_config()
+ *  Configures the addresses and restores the layout
+ *
+ * check_layout()
+ *  Stops the program if RMSR and TMSR differ from the layout
+ *
+ * w5emu_get_dest()
+ *  Returns the destination of the last datagram sent on a socket
+ *
+ * (register and buffer accessors - see w51.h and w5burst.h)
+ */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <unistd.h>
+ #include <fcntl.h>
+ #include <sys/socket.h>
+ #include <netinet/in.h>
+ #include "w51.h"
+ #include "w5burst.h"
+ #include "w5emu.h"
+
+ #define EMU_SOCKETS     4
+ #define EMU_BUF_SIZE    2048U
+ #define EMU_BUF_MASK    (EMU_BUF_SIZE - 1)
+
+ typedef struct {
+    int           fd;
+    unsigned char mr;
+    unsigned char sr;
+    unsigned char ir;
+    unsigned int  port;
+    unsigned char dip[4];
+    unsigned int  dport;
+    unsigned char last_dip[4];
+    unsigned int  last_dport;
+    unsigned int  tx_rd, tx_wr;
+    unsigned int  rx_rd, rx_wr;
+    unsigned char tx[EMU_BUF_SIZE];
+    unsigned char rx[EMU_BUF_SIZE];
+ } emu_socket;
+
+ static emu_socket sockets[EMU_SOCKETS] = {{-1}, {-1}, {-1}, {-1}};
+
+ unsigned long w5emu_bind_ip = 0x7F000001UL;
+ unsigned char w5emu_loopback_source[4] = {127, 0, 0, 1};
+ unsigned int  w5emu_port_offset;
+ unsigned int  w5emu_rx_loss;
+ unsigned long w5emu_sends;
+ unsigned long w5emu_tx_bytes;
+ unsigned long w5emu_configs;
+ unsigned char w5emu_ip[4];
+ unsigned char w5emu_gateway[4];
+ unsigned char w5emu_subnet[4];
+
+ /* memory size registers and the layout of the socket layer (2K each) */
+ static unsigned char reg_rmsr = 0x55, reg_tmsr = 0x55;
+ static unsigned char layout_rmsr = 0x55, layout_tmsr = 0x55;
+
+ /**********************************
+ * check_layout()
+ *
+ * Stops the program when a socket buffer is used while RMSR and TMSR
+ * differ from the layout the socket layer computed its buffer bases and
+ * sizes from - on the W5100 the data would go to the wrong addresses
+ *
+ * arguments:
+ *  s - the socket whose buffer is used
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  none
+ */
+ static void check_layout(SOCKET s){
+    if(reg_rmsr != layout_rmsr || reg_tmsr != layout_tmsr){
+        fprintf(stderr, "w5emu: socket %d buffer used with RMSR/TMSR %02X/%02X but layout %02X/%02X "
+                "(W5x_config() without w5burst_config()?)\n", s, reg_rmsr, reg_tmsr, layout_rmsr, layout_tmsr);
+        exit(1);
+    }
+ }
+
+ /* register and buffer accessors */
+ unsigned int w5burst_get_tx_size(SOCKET s){ return EMU_BUF_SIZE; }
+ void w5burst_write_tx(SOCKET s, unsigned int ptr, const unsigned char *buf, unsigned int len){
+    check_layout(s);
+    while(len--) sockets[s].tx[ptr++ & EMU_BUF_MASK] = *buf++;
+ }
+ void w5burst_read_rx(SOCKET s, unsigned int ptr, unsigned char *buf, unsigned int len){
+    check_layout(s);
+    while(len--) *buf++ = sockets[s].rx[ptr++ & EMU_BUF_MASK];
+ }
+ unsigned int W5x_readSnTX_RD(unsigned char s){ return sockets[s].tx_rd; }
+ unsigned int W5x_readSnTX_WR(unsigned char s){ return sockets[s].tx_wr; }
+ void W5x_writeSnTX_WR(unsigned char s, unsigned int ptr){ sockets[s].tx_wr = ptr & 0xFFFF; }
+ unsigned int W5x_readSnRX_RD(unsigned char s){ return sockets[s].rx_rd; }
+ void W5x_writeSnRX_RD(unsigned char s, unsigned int ptr){ sockets[s].rx_rd = ptr & 0xFFFF; }
+ unsigned int W5x_getTXFreeSize(unsigned char s){ return EMU_BUF_SIZE - (unsigned short)(sockets[s].tx_wr - sockets[s].tx_rd); }
+ unsigned char W5x_readSnSR(unsigned char s){ return sockets[s].sr; }
+ unsigned char W5x_readSnMR(unsigned char s){ return sockets[s].mr; }
+ void W5x_writeSnMR(unsigned char s, unsigned char data){ sockets[s].mr = data; }
+ void W5x_writeSnPORT(unsigned char s, unsigned int port){ sockets[s].port = port; }
+ void W5x_writeSnDIPR(unsigned char s, unsigned char *addr){ memcpy(sockets[s].dip, addr, 4); }
+ void W5x_writeSnDPORT(unsigned char s, unsigned int port){ sockets[s].dport = port; }
+ void W5x_writeSnDHAR(unsigned char s, unsigned char *addr){}
+ unsigned char W5x_readSnIR(unsigned char s){ return sockets[s].ir; }
+ void W5x_writeSnIR(unsigned char s, unsigned char data){ sockets[s].ir &= ~data; }
+
+ /**********************************
+ * W5x_getRXReceivedSize()
+ *
+ * Returns the number of bytes in the receive buffer.  When the buffer is
+ * empty the next datagram waiting on the host socket is stored in it,
+ * behind the W5100 header (source address, source port and length).
+ *
+ * arguments:
+ *  s - the socket
+ *
+ * returns:
+ *  the number of bytes
+ *
+ * changes:
+ *  the socket receive buffer
+ */
+ unsigned int W5x_getRXReceivedSize(unsigned char s){
+    emu_socket *e = &sockets[s];
+    unsigned char buf[EMU_BUF_SIZE - 8];
+    struct sockaddr_in from;
+    socklen_t fromlen = sizeof(from);
+    unsigned long ip;
+    unsigned int port;
+    int n, i;
+
+    if(e->rx_wr == e->rx_rd && e->fd >= 0){
+        n = recvfrom(e->fd, buf, sizeof(buf), 0, (struct sockaddr*)&from, &fromlen);
+        if(n >= 0 && rand() % 100 < (int)w5emu_rx_loss){
+            n = -1;
+        }
+        if(n >= 0){
+            ip = ntohl(from.sin_addr.s_addr);
+            if(ip == 0x7F000001UL){
+                ip = (unsigned long)w5emu_loopback_source[0] << 24 | (unsigned long)w5emu_loopback_source[1] << 16 |
+                     (unsigned long)w5emu_loopback_source[2] << 8 | w5emu_loopback_source[3];
+            }
+            port = ntohs(from.sin_port) - w5emu_port_offset;
+            e->rx[e->rx_wr++ & EMU_BUF_MASK] = ip >> 24;
+            e->rx[e->rx_wr++ & EMU_BUF_MASK] = ip >> 16;
+            e->rx[e->rx_wr++ & EMU_BUF_MASK] = ip >> 8;
+            e->rx[e->rx_wr++ & EMU_BUF_MASK] = ip;
+            e->rx[e->rx_wr++ & EMU_BUF_MASK] = port >> 8;
+            e->rx[e->rx_wr++ & EMU_BUF_MASK] = port;
+            e->rx[e->rx_wr++ & EMU_BUF_MASK] = n >> 8;
+            e->rx[e->rx_wr++ & EMU_BUF_MASK] = n;
+            for(i = 0; i < n; i++){
+                e->rx[e->rx_wr++ & EMU_BUF_MASK] = buf[i];
+            }
+            e->rx_wr &= 0xFFFF;
+        }
+    }
+    return (unsigned short)(e->rx_wr - e->rx_rd);
+ }
+
+ /**********************************
+ * W5x_execCmdSn()
+ *
+ * Executes a socket command: OPEN binds a host udp socket, CLOSE closes
+ * it and SEND sends the data between the transmit pointers
+ *
+ * arguments:
+ *  s - the socket
+ *  cmd - the command
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the socket state
+ */
+ void W5x_execCmdSn(unsigned char s, unsigned char cmd){
+    emu_socket *e = &sockets[s];
+    unsigned char buf[EMU_BUF_SIZE];
+    struct sockaddr_in addr;
+    unsigned int n, i;
+    int one = 1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    switch(cmd){
+    case 0x01:  /* OPEN */
+        if(e->fd >= 0){
+            close(e->fd);
+        }
+        e->fd = socket(AF_INET, SOCK_DGRAM, 0);
+        setsockopt(e->fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        addr.sin_port = htons(e->port + w5emu_port_offset);
+        addr.sin_addr.s_addr = htonl(w5emu_bind_ip);
+        if(bind(e->fd, (struct sockaddr*)&addr, sizeof(addr)) != 0){
+            perror("w5emu bind");
+        }
+        fcntl(e->fd, F_SETFL, O_NONBLOCK);
+        e->sr = 0x22;
+        e->tx_rd = e->tx_wr = 0;
+        e->rx_rd = e->rx_wr = 0;
+        break;
+    case 0x10:  /* CLOSE */
+        if(e->fd >= 0){
+            close(e->fd);
+        }
+        e->fd = -1;
+        e->sr = 0;
+        break;
+    case 0x20:  /* SEND */
+        n = (unsigned short)(e->tx_wr - e->tx_rd);
+        for(i = 0; i < n; i++){
+            buf[i] = e->tx[(e->tx_rd + i) & EMU_BUF_MASK];
+        }
+        e->tx_rd = e->tx_wr;
+        addr.sin_port = htons(e->dport + w5emu_port_offset);
+        addr.sin_addr.s_addr = htonl((e->dip[0] == 127) ?
+            ((unsigned long)e->dip[0] << 24 | (unsigned long)e->dip[1] << 16 | e->dip[2] << 8 | e->dip[3]) :
+            0x7F000001UL);
+        sendto(e->fd, buf, n, 0, (struct sockaddr*)&addr, sizeof(addr));
+        memcpy(e->last_dip, e->dip, 4);
+        e->last_dport = e->dport;
+        w5emu_sends++;
+        w5emu_tx_bytes += n;
+        e->ir |= 0x10;
+        break;
+    }
+ }
+
+ /**********************************
+ * W5x_config()
+ *
+ * Records the addresses and, as the library W5x_config() does, writes 2K
+ * per socket to RMSR and TMSR
+ *
+ * arguments:
+ *  mac - mac address
+ *  ip - ip address
+ *  gateway - gateway address
+ *  subnet - subnet mask
+ *
+ * returns:
+ *  1
+ *
+ * changes:
+ *  w5emu_configs, w5emu_ip, w5emu_gateway, w5emu_subnet, reg_rmsr, reg_tmsr
+ */
+ unsigned char W5x_config(unsigned char *mac, unsigned char *ip, unsigned char *gateway, unsigned char *subnet){
+    memcpy(w5emu_ip, ip, 4);
+    memcpy(w5emu_gateway, gateway, 4);
+    memcpy(w5emu_subnet, subnet, 4);
+    w5emu_configs++;
+    reg_rmsr = 0x55;
+    reg_tmsr = 0x55;
+    return 1;
+ }
+
+ /**********************************
+ * w5burst_set_layout()
+ *
+ * Writes RMSR and TMSR and sets the layout the socket layer uses, as
+ * w5burst.c does
+ *
+ * arguments:
+ *  rmsr - receive memory size register value
+ *  tmsr - transmit memory size register value
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  reg_rmsr, reg_tmsr, layout_rmsr, layout_tmsr
+ */
+ void w5burst_set_layout(unsigned char rmsr, unsigned char tmsr){
+    reg_rmsr = layout_rmsr = rmsr;
+    reg_tmsr = layout_tmsr = tmsr;
+ }
+
+ /**********************************
+ * w5burst_config()
+ *
+ * Configures the addresses with W5x_config() and writes the layout back,
+ * as w5burst.c does
+ *
+ * arguments:
+ *  mac - mac address
+ *  ip - ip address
+ *  gateway - gateway address
+ *  subnet - subnet mask
+ *
+ * returns:
+ *  the W5x_config() result
+ *
+ * changes:
+ *  see W5x_config() and w5burst_set_layout()
+ */
+ unsigned char w5burst_config(unsigned char *mac, unsigned char *ip, unsigned char *gateway, unsigned char *subnet){
+    unsigned char result;
+
+    result = W5x_config(mac, ip, gateway, subnet);
+    w5burst_set_layout(layout_rmsr, layout_tmsr);
+    return result;
+ }
+
+ /**********************************
+ * w5emu_get_dest()
+ *
+ * Returns the destination (before the loopback mapping) of the last
+ * datagram sent on a socket
+ *
+ * arguments:
+ *  s - the socket
+ *  port - where the destination port is placed
+ *
+ * returns:
+ *  the destination ip address
+ *
+ * changes:
+ *  port
+ */
+ const unsigned char *w5emu_get_dest(unsigned char s, unsigned int *port){
+    *port = sockets[s].last_dport;
+    return sockets[s].last_dip;
+ }
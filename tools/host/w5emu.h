@@ -0,0 +1,46 @@
+/********************************************************
+ * w5emu.h
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file provides declarations for the host emulation of the W5100
+ * udp sockets used by the host test tools.
+ */
+
+#ifndef W5EMU_H_INCLUDED
+#define W5EMU_H_INCLUDED
+
+/* loopback address the sockets bind to (host byte order) */
+extern unsigned long w5emu_bind_ip;
+
+/* source address reported for datagrams from 127.0.0.1 - set it to the
+ * address a module expects its server at (127.0.0.1 by default)
+ */
+extern unsigned char w5emu_loopback_source[4];
+
+/* added to every local and destination port */
+extern unsigned int w5emu_port_offset;
+
+/* percentage of received datagrams that are dropped */
+extern unsigned int w5emu_rx_loss;
+
+/* datagrams and bytes sent */
+extern unsigned long w5emu_sends;
+extern unsigned long w5emu_tx_bytes;
+
+/* W5x_config() calls and the addresses of the last one */
+extern unsigned long w5emu_configs;
+extern unsigned char w5emu_ip[4];
+extern unsigned char w5emu_gateway[4];
+extern unsigned char w5emu_subnet[4];
+
+/**********************************
+ * w5emu_get_dest()
+ *
+ * Returns the destination ip address (before the loopback mapping) and
+ * port of the last datagram sent on a socket
+ */
+const unsigned char *w5emu_get_dest(unsigned char s, unsigned int *port);
+
+#endif // W5EMU_H_INCLUDED
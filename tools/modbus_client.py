@@ -0,0 +1,229 @@
+#!/usr/bin/env python3
+"""
+modbus_client.py
+
+SER486 Final Project
+Author: Jesse Baker (student jjbaker4)
+
+Modbus/TCP test client for the Modbus server (modbus.h), run against
+tools/modbus_host.c or a device.  Checks the input and holding register
+reads, the exception responses (illegal function, address and value),
+single and multiple threshold writes - a multiple write must be applied
+completely or not at all - the alarm state register as the thresholds
+move around the temperature, pipelined requests in one segment, a request
+split over two segments and a frame with a bad protocol id (the server
+closes the connection).
+
+    modbus_client.py                      (tools/modbus_host.c)
+    modbus_client.py --host 192.168.1.60 --port 502 --temperature 72
+
+The fixed register values of the host harness are only checked with
+--harness (the default when the host is 127.0.0.1).
+"""
+
+import argparse
+import random
+import socket
+import struct
+import sys
+import time
+
+MBAP = struct.Struct('>HHHB')
+UNIT = 1
+
+checks = 0
+failures = 0
+
+
+def check(cond, what):
+    """Counts a check and reports it if it failed."""
+    global checks, failures
+    checks += 1
+    if not cond:
+        failures += 1
+        print('FAIL', what)
+
+
+def signed(x):
+    """Converts a register value to a signed 16-bit value."""
+    return x - 0x10000 if x & 0x8000 else x
+
+
+class ModbusError(Exception):
+    """An exception response (the exception code is in code)."""
+
+    def __init__(self, code):
+        Exception.__init__(self, 'exception %d' % code)
+        self.code = code
+
+
+class Client:
+    """Minimal Modbus/TCP client - one request at a time."""
+
+    def __init__(self, host, port):
+        self.sock = socket.create_connection((host, port), timeout=2)
+        self.tid = 0
+
+    def close(self):
+        self.sock.close()
+
+    def recv_exact(self, n):
+        """Reads exactly n bytes."""
+        data = b''
+        while len(data) < n:
+            part = self.sock.recv(n - len(data))
+            if not part:
+                raise EOFError('connection closed')
+            data += part
+        return data
+
+    def request(self, pdu):
+        """Sends a request pdu and returns the response pdu."""
+        self.tid = (self.tid + 1) & 0xFFFF
+        self.sock.sendall(MBAP.pack(self.tid, 0, len(pdu) + 1, UNIT) + pdu)
+        tid, proto, length, unit = MBAP.unpack(self.recv_exact(MBAP.size))
+        if (tid, proto, unit) != (self.tid, 0, UNIT):
+            raise ValueError('bad response header')
+        pdu_rx = self.recv_exact(length - 1)
+        if pdu_rx[0] == pdu[0] | 0x80:
+            raise ModbusError(pdu_rx[1])
+        if pdu_rx[0] != pdu[0]:
+            raise ValueError('bad function code')
+        return pdu_rx
+
+    def read(self, function, address, count):
+        """Reads input (function 4) or holding (function 3) registers."""
+        r = self.request(struct.pack('>BHH', function, address, count))
+        if r[1] != 2 * count or len(r) != 2 + 2 * count:
+            raise ValueError('bad byte count')
+        return list(struct.unpack('>%dH' % count, r[2:]))
+
+    def write(self, address, value):
+        """Writes a single holding register (function 6)."""
+        pdu = struct.pack('>BHH', 6, address, value & 0xFFFF)
+        if self.request(pdu) != pdu:
+            raise ValueError('bad echo')
+
+    def write_multiple(self, address, values):
+        """Writes holding registers (function 16)."""
+        pdu = struct.pack('>BHHB', 16, address, len(values), 2 * len(values))
+        pdu += struct.pack('>%dH' % len(values), *[v & 0xFFFF for v in values])
+        if self.request(pdu) != pdu[:5]:
+            raise ValueError('bad echo')
+
+
+def exception_code(fn, *args):
+    """Returns the exception code raised by a request, or None."""
+    try:
+        fn(*args)
+    except ModbusError as e:
+        return e.code
+    return None
+
+
+def thresholds(c):
+    """Returns the holding registers as signed values."""
+    return [signed(x) for x in c.read(3, 0, 4)]
+
+
+def run_requests(c, harness, temperature):
+    """Register reads, exceptions, writes and the state register."""
+    ir = c.read(4, 0, 14)
+    print('input registers  ', ir)
+    print('holding registers', thresholds(c))
+    if harness:
+        check(ir == [77, 0, 7] + [3 * i for i in range(11)], 'harness input registers')
+    check(c.read(4, 13, 1) == ir[13:14], 'read of the last input register')
+    check(exception_code(c.read, 4, 0, 15) == 2, 'input read past the end')
+    check(exception_code(c.read, 3, 4, 1) == 2, 'holding read past the end')
+    check(exception_code(c.read, 3, 1, 4) == 2, 'holding read overlapping the end')
+    check(exception_code(c.request, struct.pack('>BHH', 1, 0, 1)) == 1, 'read coils')
+    check(exception_code(c.write, 4, 1) == 2, 'write past the end')
+
+    # (tcrit_hi, twarn_hi, tcrit_lo, twarn_lo) around the temperature
+    t = temperature
+    c.write_multiple(0, [t + 100, t + 30, t - 100, t - 50])
+    c.write(0, t + 40)
+    check(thresholds(c)[0] == t + 40, 'single write')
+    check(exception_code(c.write, 0, t + 20) == 3, 'tcrit_hi below twarn_hi')
+    c.write(0, t + 40)
+    check(thresholds(c)[0] == t + 40, 'write of the same value')
+    c.write(2, t - 90)
+    check(thresholds(c)[2] == t - 90, 'tcrit_lo write (negative below 90)')
+
+    for _ in range(300):
+        v = sorted(random.sample(range(-200, 1024), 4))
+        want = [v[3], v[2], v[0], v[1]]
+        c.write_multiple(0, want)
+        check(thresholds(c) == want, 'multiple write %s' % want)
+    before = thresholds(c)
+    check(exception_code(c.write_multiple, 0, [50, 60, 70, 80]) == 3, 'invalid multiple write')
+    check(exception_code(c.write_multiple, 1, [1, 2]) == 3, 'partly invalid multiple write')
+    check(thresholds(c) == before, 'rejected writes leave the thresholds')
+
+    states = [([t + 100, t + 50, t - 100, t - 50], 0),
+              ([t + 100, t - 5, t - 100, t - 50], 1),
+              ([t, t - 5, t - 100, t - 50], 2),
+              ([t + 100, t + 50, t - 100, t + 5], 3),
+              ([t + 100, t + 50, t, t + 5], 4)]
+    for values, state in states:
+        c.write_multiple(0, values)
+        check(c.read(4, 1, 1) == [state], 'state %d for %s' % (state, values))
+    c.write_multiple(0, before)
+
+
+def run_framing(host, port):
+    """Pipelined, split and malformed frames on a raw connection."""
+    def frame(tid, pdu):
+        return MBAP.pack(tid, 0, len(pdu) + 1, UNIT) + pdu
+
+    s = socket.create_connection((host, port), timeout=2)
+    s.sendall(frame(1, b'\x04\x00\x00\x00\x01') + frame(2, b'\x03\x00\x00\x00\x02')
+              + frame(3, b'\x2b\x0e\x01\x00'))
+    time.sleep(0.2)
+    data = s.recv(1000)
+    tids = []
+    while len(data) >= MBAP.size:
+        tid, _, length, _ = MBAP.unpack(data[:MBAP.size])
+        tids.append((tid, data[MBAP.size]))
+        data = data[MBAP.size - 1 + length:]
+    check(tids == [(1, 0x04), (2, 0x03), (3, 0xAB)], 'pipelined responses %s' % tids)
+
+    f = frame(4, b'\x04\x00\x01\x00\x01')
+    s.sendall(f[:5])
+    time.sleep(0.05)
+    s.sendall(f[5:])
+    time.sleep(0.2)
+    r = s.recv(100)
+    check(len(r) == 11 and r[:2] == b'\x00\x04', 'split request')
+
+    s.sendall(b'\x00\x05\x00\x05\x00\x02\x01\x04')
+    time.sleep(0.2)
+    try:
+        closed = s.recv(100) == b''
+    except ConnectionResetError:
+        closed = True
+    check(closed, 'bad protocol id closes the connection')
+    s.close()
+
+
+def main():
+    ap = argparse.ArgumentParser(description='Modbus/TCP server test client')
+    ap.add_argument('--host', default='127.0.0.1')
+    ap.add_argument('--port', type=int, default=10502)
+    ap.add_argument('--temperature', type=int, default=77)
+    ap.add_argument('--harness', action='store_true')
+    args = ap.parse_args()
+    harness = args.harness or args.host == '127.0.0.1'
+
+    c = Client(args.host, args.port)
+    run_requests(c, harness, args.temperature)
+    c.close()
+    run_framing(args.host, args.port)
+
+    print('%d checks, %d failures' % (checks, failures))
+    sys.exit(1 if failures else 0)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,172 @@
+/********************************************************
+ * modbus_host.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * Host harness for the Modbus/TCP server in modbus.c.  The firmware
+ * modbus.c, util.c, devstate.c and devapi.c run unchanged (the devapi
+ * writers that are not used are dropped by the linker).  The TCP socket
+ * calls that modbus.c makes are served here by a host TCP listener on
+ * port 10502 (MODBUS_PORT offset by 10000) holding one connection, with
+ * the receive cursor working over a copy of the received bytes as it
+ * does over the W5100 receive buffer.  modbus_update() is called every
+ * millisecond, as from the scheduler.  The temperature is 77 and the
+ * log counters are fixed (7 entries, 3 * n records of event n).
+ *
+ * Run it against the client tools/modbus_client.py:
+ *
+ *    gcc -O2 -DMODBUS_ENABLE=1 -ffunction-sections -Wl,--gc-sections -I tools/host -I . \
+ *        -o modbus_host tools/modbus_host.c modbus.c util.c devstate.c devapi.c
+ *    ./modbus_host & python3 tools/modbus_client.py
+ *
+ * Functions:
+ *
+ * main()
+ *  Calls modbus_update() every millisecond
+ *
+ * pump()
+ *  Reads the bytes waiting on the host connection
+ *
+ * (stand-ins for the TCP socket api, clock, eeprom and log functions)
+ */
+
+ #include <stdio.h>
+ #include <string.h>
+ #include <time.h>
+ #include <unistd.h>
+ #include <fcntl.h>
+ #include <sys/socket.h>
+ #include <netinet/in.h>
+ #include "socket.h"
+ #include "config.h"
+ #include "modbus.h"
+
+ #define HOST_PORT_OFFSET    10000
+
+ config_struct config = {"ASU", 100, 90, 40, 50, 0, {0}, 0};
+ int current_temperature = 77;
+
+ static int listen_fd = -1;
+ static int conn_fd = -1;
+ static unsigned char rx_buf[4096];
+ static unsigned int rx_len;
+
+ unsigned long clock_ms(){
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000UL + t.tv_nsec / 1000000;
+ }
+ void eecrc_config_changed(unsigned int offset, unsigned char *old, unsigned int len){}
+ void config_set_modified(){}
+ unsigned char log_get_num_entries(){ return 7; }
+ unsigned char logindex_get_count(unsigned char event){ return event * 3; }
+
+ /**********************************
+ * pump()
+ *
+ * Appends the bytes waiting on the host connection to the receive
+ * buffer, and closes the connection if the client has closed it
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  conn_fd, rx_buf, rx_len
+ */
+ static void pump(){
+    int n;
+
+    if(conn_fd < 0){
+        return;
+    }
+    n = recv(conn_fd, rx_buf + rx_len, sizeof(rx_buf) - rx_len, MSG_DONTWAIT);
+    if(n == 0){
+        close(conn_fd);
+        conn_fd = -1;
+        rx_len = 0;
+    }
+    else if(n > 0){
+        rx_len += n;
+    }
+ }
+
+ /* TCP socket api (socket.h) over the host listener and connection */
+ unsigned char socket_is_closed(SOCKET s){ return listen_fd < 0; }
+ unsigned char socket_open(SOCKET s, unsigned int port){
+    struct sockaddr_in addr;
+    int one = 1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port + HOST_PORT_OFFSET);
+    addr.sin_addr.s_addr = htonl(0x7F000001UL);
+    listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if(bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0){
+        perror("modbus_host bind");
+    }
+    return 1;
+ }
+ unsigned char socket_listen(SOCKET s){
+    listen(listen_fd, 1);
+    fcntl(listen_fd, F_SETFL, O_NONBLOCK);
+    return 1;
+ }
+ unsigned char socket_is_established(SOCKET s){
+    if(conn_fd < 0){
+        conn_fd = accept(listen_fd, NULL, NULL);
+        rx_len = 0;
+    }
+    pump();
+    return conn_fd >= 0;
+ }
+ unsigned char socket_is_listening(SOCKET s){ return conn_fd < 0; }
+ unsigned char socket_is_active(SOCKET s){ return 1; }
+ void socket_disconnect(SOCKET s){
+    if(conn_fd >= 0){
+        close(conn_fd);
+        printf("disconnect\n");
+        fflush(stdout);
+    }
+    conn_fd = -1;
+    rx_len = 0;
+ }
+ int socket_recv_available(SOCKET s){ return rx_len; }
+ unsigned int socket_send(SOCKET s, const unsigned char *buf, unsigned int len){ return send(conn_fd, buf, len, 0); }
+ void socket_cursor_open(socket_cursor *c, SOCKET s){
+    memset(c, 0, sizeof(*c));
+    c->s = s;
+    c->avail = rx_len;
+ }
+ int socket_cursor_get(socket_cursor *c){ return (c->pos < c->avail) ? rx_buf[c->pos++] : -1; }
+ void socket_cursor_commit(socket_cursor *c){
+    memmove(rx_buf, rx_buf + c->pos, rx_len - c->pos);
+    rx_len -= c->pos;
+ }
+ void socket_cursor_flush(socket_cursor *c){ rx_len = 0; }
+
+ /**********************************
+ * main()
+ *
+ * Calls modbus_update() every millisecond until killed
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  never
+ *
+ * changes:
+ *  none
+ */
+ int main(){
+    while(1){
+        modbus_update();
+        usleep(1000);
+    }
+ }
@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+"""
+mqttsn_gateway.py
+
+SER486 Final Project
+Author: Jesse Baker (student jjbaker4)
+
+MQTT-SN gateway stand-in for tools/mqttsn_host.c.  Listens on
+127.0.0.1:20000 (MQTTSN_GATEWAY_PORT offset by 10000), answers CONNECT,
+PUBLISH (QoS 1) and PINGREQ, and checks every message it receives.  To
+exercise the publisher it:
+
+    ignores the CONNECTs of the first 3 s      (reconnect back off)
+    drops the first PUBACK of an event          (retransmission with DUP)
+    stops answering from 35 s to 55 s           (gateway lost, reconnect,
+                                                 records added meanwhile)
+
+After the run time the acknowledged event records and states are checked
+against the test profile of mqttsn_host.c and a summary is printed.
+
+    mqttsn_gateway.py [run time (s)]
+"""
+
+import socket
+import struct
+import sys
+import time
+
+CLIENT_ID = b'SN12345'
+KEEPALIVE = 60
+IGNORE_CONNECTS_S = 3
+SILENT = (35, 55)
+
+TOPIC_TEMPERATURE, TOPIC_STATE, TOPIC_EVENT = 1, 2, 3
+FLAGS = {TOPIC_TEMPERATURE: 0x01, TOPIC_STATE: 0x31, TOPIC_EVENT: 0x21}
+FLAG_DUP = 0x80
+
+EXPECT_EVENTS = ['3,1000', '0,1000', '6,2012.250', '5,2015.500', '7,2041.750']
+# CRIT_LO is published during the silent period and stays in flight until
+# it is acknowledged after the reconnect, followed by the current state
+EXPECT_STATES = ['NORMAL', 'WARN_HI', 'CRIT_HI', 'NORMAL', 'CRIT_LO', 'NORMAL']
+
+errors = []
+
+
+def error(rel, what):
+    """Records a protocol error."""
+    errors.append(what)
+    print('%7.3f ERROR %s' % (rel, what))
+
+
+def main():
+    run_time = float(sys.argv[1]) if len(sys.argv) > 1 else 80
+    s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    s.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    s.bind(('127.0.0.1', 20000))
+    s.settimeout(0.5)
+
+    t0 = None
+    connects = []
+    accepted = 0
+    temperatures = 0
+    events = []
+    states = []
+    dropped = None
+    dup_seen = False
+    inflight = {}
+    start = time.time()
+    while time.time() - start < run_time:
+        try:
+            d, addr = s.recvfrom(512)
+        except socket.timeout:
+            continue
+        now = time.time()
+        if t0 is None:
+            t0 = now
+        rel = now - t0
+        if len(d) < 2 or d[0] != len(d):
+            error(rel, 'bad length %s' % d.hex())
+            continue
+        mtype = d[1]
+        silent = SILENT[0] <= rel < SILENT[1]
+
+        if mtype == 0x04:
+            flags, protocol, duration = d[2], d[3], struct.unpack('>H', d[4:6])[0]
+            if protocol != 1 or duration != KEEPALIVE or d[6:] != CLIENT_ID or not flags & 0x04:
+                error(rel, 'bad CONNECT %s' % d.hex())
+            connects.append(rel)
+            print('%7.3f CONNECT%s' % (rel, ' (ignored)' if rel < IGNORE_CONNECTS_S or silent else ''))
+            if rel >= IGNORE_CONNECTS_S and not silent:
+                s.sendto(bytes([3, 0x05, 0]), addr)
+                accepted += 1
+        elif mtype == 0x0C:
+            flags = d[2]
+            topic, msg_id = struct.unpack('>HH', d[3:7])
+            payload = d[7:].decode()
+            if topic not in FLAGS or flags & ~FLAG_DUP != FLAGS[topic]:
+                error(rel, 'bad PUBLISH flags %02x topic %d' % (flags, topic))
+                continue
+            if topic == TOPIC_TEMPERATURE:
+                temperatures += 1
+                continue
+            print('%7.3f PUBLISH topic %d id %d%s %s%s' % (rel, topic, msg_id, ' dup' if flags & FLAG_DUP else '',
+                                                          payload, ' (ignored)' if silent else ''))
+            if flags & FLAG_DUP:
+                if inflight.get(msg_id) != (topic, payload):
+                    error(rel, 'DUP of an unknown message %d' % msg_id)
+                if msg_id == dropped:
+                    dup_seen = True
+            inflight[msg_id] = (topic, payload)
+            if silent:
+                continue
+            if topic == TOPIC_EVENT and dropped is None:
+                dropped = msg_id
+                print('%7.3f   PUBACK dropped' % rel)
+                continue
+            s.sendto(bytes([7, 0x0D]) + d[3:7] + bytes([0]), addr)
+            target = events if topic == TOPIC_EVENT else states
+            if not (flags & FLAG_DUP and target and target[-1] == payload):
+                target.append(payload)
+        elif mtype == 0x16:
+            print('%7.3f PINGREQ' % rel)
+            if not silent:
+                s.sendto(bytes([2, 0x17]), addr)
+        else:
+            error(rel, 'unexpected message type %02x' % mtype)
+
+    if len(connects) < 2 or connects[1] - connects[0] < 1.9:
+        error(0, 'no back off between the first CONNECTs %s' % connects)
+    if not any(c >= SILENT[0] for c in connects):
+        error(0, 'no reconnect after the silent period')
+    if not dup_seen:
+        error(0, 'the event with the dropped PUBACK was not retransmitted with DUP')
+    if events != EXPECT_EVENTS:
+        error(0, 'events %s, expected %s' % (events, EXPECT_EVENTS))
+    if states != EXPECT_STATES:
+        error(0, 'states %s, expected %s' % (states, EXPECT_STATES))
+    print('connects %d (accepted %d), temperatures %d, events %s, states %s' %
+          (len(connects), accepted, temperatures, events, states))
+    print('%d errors' % len(errors))
+    sys.exit(1 if errors else 0)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,202 @@
+/********************************************************
+ * mqttsn_host.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * Host harness for the MQTT-SN publisher in mqttsn.c.  The firmware
+ * mqttsn.c, udpmux.c, socket.c, devstate.c and fmt.c run unchanged over
+ * the W5100 emulation in tools/host, with ports offset by 10000 (the
+ * gateway is reached on 127.0.0.1:20000).  A temperature sample is
+ * queued every second and udpmux_update()/mqttsn_update() are called
+ * every 50 ms, as from the scheduler.  The temperature profile takes the
+ * device through WARN_HI, CRIT_HI, NORMAL and CRIT_LO, and log records
+ * are added on the way (the two startup records without milliseconds).
+ * The publisher statistics are printed at the end.
+ *
+ * Run it against the gateway stand-in tools/mqttsn_gateway.py, which
+ * checks the messages it receives:
+ *
+ *    gcc -O2 -DMQTTSN_ENABLE=1 -I tools/host -I . -o mqttsn_host tools/mqttsn_host.c \
+ *        tools/host/w5emu.c mqttsn.c udpmux.c socket.c devstate.c fmt.c
+ *    python3 tools/mqttsn_gateway.py 80 & ./mqttsn_host 75
+ *
+ * Functions:
+ *
+ * main()
+ *  Queues the samples and runs the publisher for the run time
+ *
+ * log_add()
+ *  Adds a record to the emulated log
+ *
+ * sample_temperature()
+ *  Returns the temperature of a sample
+ *
+ * (stand-ins for the log, clock, uart and the other udpmux clients)
+ */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <time.h>
+ #include <unistd.h>
+ #include "config.h"
+ #include "vpd.h"
+ #include "log.h"
+ #include "logindex.h"
+ #include "udpmux.h"
+ #include "mqttsn.h"
+ #include "w5emu.h"
+
+ #define LOG_SIZE    16
+
+ config_struct config = {"ASU", 100, 90, 40, 50, 0, {0}, 0};
+ vpd_struct vpd = {"SER", "IIoT", "ASU", "SN12345", 0, {0x00, 0x08, 0xDC, 0x00, 0x00, 0x64}, "USA", 0};
+ volatile unsigned char crash_last_sockop;
+
+ static unsigned long log_time[LOG_SIZE];
+ static unsigned char log_event[LOG_SIZE];
+ static unsigned int log_ms[LOG_SIZE];
+ static unsigned char log_entries;
+ static unsigned int log_added;
+
+ unsigned long clock_ms(){
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000UL + t.tv_nsec / 1000000;
+ }
+ unsigned char ulog_begin(unsigned char level){ printf("%8lu ", clock_ms() % 100000000UL); return 1; }
+ void ulog_end(){ fflush(stdout); }
+ void uart_writestr(char *str){ fputs(str, stdout); }
+ void serial_writestr_P(const char *str){ uart_writestr((char*)str); }
+ unsigned char log_get_num_entries(){ return log_entries; }
+ int log_get_record(unsigned long index, unsigned long *time, unsigned char *eventnum){
+    if(index >= log_entries){
+        return 0;
+    }
+    *time = log_time[index];
+    *eventnum = log_event[index];
+    return 1;
+ }
+ unsigned int logindex_get_ms(unsigned char index){ return log_ms[index]; }
+ unsigned int logindex_get_added(){ return log_added; }
+ char *rtc_num2datestr(unsigned long num){ return ""; }
+ void ntpclient_receive(const unsigned char *msg, unsigned int len, const unsigned char *addr){}
+ void coap_receive(const unsigned char *msg, unsigned int len, const unsigned char *addr, unsigned int port){}
+ void fleet_receive(const unsigned char *msg, unsigned int len, const unsigned char *addr){}
+
+ /**********************************
+ * log_add()
+ *
+ * Adds a record to the emulated log, dropping the oldest when it is full
+ *
+ * arguments:
+ *  eventnum - the event
+ *  time - the rtc time
+ *  ms - milliseconds of the timestamp (LOGINDEX_NO_MS if not known)
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the emulated log
+ */
+ static void log_add(unsigned char eventnum, unsigned long time, unsigned int ms){
+    if(log_entries == LOG_SIZE){
+        memmove(log_time, log_time + 1, sizeof(log_time) - sizeof(log_time[0]));
+        memmove(log_event, log_event + 1, sizeof(log_event) - sizeof(log_event[0]));
+        memmove(log_ms, log_ms + 1, sizeof(log_ms) - sizeof(log_ms[0]));
+        log_entries--;
+    }
+    log_time[log_entries] = time;
+    log_event[log_entries] = eventnum;
+    log_ms[log_entries] = ms;
+    log_entries++;
+    log_added++;
+ }
+
+ /**********************************
+ * sample_temperature()
+ *
+ * Returns the temperature of a sample of the test profile, and adds the
+ * log records that the temperature state machine would add
+ *
+ * arguments:
+ *  n - the sample number (one per second)
+ *
+ * returns:
+ *  the temperature
+ *
+ * changes:
+ *  the emulated log
+ */
+ static int sample_temperature(unsigned int n){
+    if(n == 12){
+        log_add(EVENT_HI_WARN, 2000 + n, 250);
+    }
+    else if(n == 15){
+        log_add(EVENT_HI_ALARM, 2000 + n, 500);
+    }
+    else if(n == 41){
+        log_add(EVENT_LO_ALARM, 2000 + n, 750);
+    }
+    if(n >= 10 && n < 15){
+        return 95;
+    }
+    if(n >= 15 && n < 18){
+        return 105;
+    }
+    if(n >= 40 && n < 44){
+        return 35;
+    }
+    return 75;
+ }
+
+ /**********************************
+ * main()
+ *
+ * Queues a sample every second and runs the publisher every 50 ms for
+ * the run time, then prints the publisher statistics
+ *
+ * arguments:
+ *  argv[1] - run time (s)
+ *
+ * returns:
+ *  0
+ *
+ * changes:
+ *  none
+ */
+ int main(int argc, char **argv){
+    unsigned int seconds = (argc > 1) ? atoi(argv[1]) : 75;
+    unsigned long start = clock_ms();
+    unsigned long next_sample = start + 1000;
+    unsigned long next_update = start;
+    unsigned int n = 0;
+
+    w5emu_port_offset = 10000;
+    w5emu_loopback_source[0] = 192;
+    w5emu_loopback_source[1] = 168;
+    w5emu_loopback_source[2] = 1;
+    w5emu_loopback_source[3] = 2;
+    log_add(EVENT_TIMESET, 1000, LOGINDEX_NO_MS);
+    log_add(EVENT_STARTUP, 1000, LOGINDEX_NO_MS);
+
+    while(clock_ms() - start < seconds * 1000UL){
+        if((long)(clock_ms() - next_sample) >= 0){
+            next_sample += 1000;
+            mqttsn_sample(sample_temperature(++n));
+        }
+        if((long)(clock_ms() - next_update) >= 0){
+            next_update += 50;
+            udpmux_update();
+            mqttsn_update();
+        }
+        usleep(200);
+    }
+    printf("connects %u lost %u published %lu acked %u rejected %u retries %u bytes %lu\n",
+           mqttsn_stats.connects, mqttsn_stats.lost, mqttsn_stats.published, mqttsn_stats.acked,
+           mqttsn_stats.rejected, mqttsn_stats.retries, mqttsn_stats.bytes_sent);
+    return 0;
+ }
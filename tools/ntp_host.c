@@ -0,0 +1,238 @@
+/********************************************************
+ * ntp_host.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * Host harness for the ntp client in ntpclient.c.  The firmware
+ * ntpclient.c, udpmux.c and socket.c run unchanged over the W5100
+ * emulation in tools/host, with ports offset by 10000 (the time server is
+ * reached on 127.0.0.1:10123, and replies from 127.0.0.1 are reported as
+ * coming from the server address 192.168.1.1).
+ *
+ * Time runs faster than the host clock by a speed factor, so that the
+ * hourly resynchronizations and the slews can be followed in a short
+ * run.  The true time is the host CLOCK_MONOTONIC since a start time,
+ * times the speed - the server stand-in computes it the same way.  The
+ * device runs from a crystal that is DRIFT_PPM fast: the millisecond
+ * count (clock_ms()) and the timer1 count (62500 per second) follow it,
+ * and the rtc counts the timer1 seconds from 0 (1/1/2000).  A write to
+ * TCNT1 by the client (a slew) moves the rtc phase as on the device.
+ * udpmux_update() and ntpclient_update() are called in a loop.
+ *
+ * Every second of true time a status line is printed on stdout:
+ *
+ *    <true ms> <rtc ms> <syncs> <steps> <failures> <offset ms> <delay ms>
+ *
+ * with both times counted from TRUE_BASE_SEC on the rtc scale, and every
+ * log record added as "log <event>".  The server stand-in
+ * tools/ntp_server.py starts this program, answers its requests according
+ * to a script and checks the lines:
+ *
+ *    gcc -O2 -ffunction-sections -Wl,--gc-sections -I tools/host -I . \
+ *        -o ntp_host tools/ntp_host.c tools/host/w5emu.c ntpclient.c udpmux.c socket.c
+ *    python3 tools/ntp_server.py --host ./ntp_host
+ *    ntp_host <start (monotonic s)> <speed> <run time (true s)>
+ *
+ * Functions:
+ *
+ * main()
+ *  Runs the client for the run time
+ *
+ * true_us()
+ *  Returns the true time since the start
+ *
+ * timer_counts()
+ *  Returns the device timer1 count since the start
+ *
+ * timer_load()
+ *  Sets TCNT1 and the rtc for a call into the client
+ *
+ * timer_store()
+ *  Applies a TCNT1 write made by the client
+ *
+ * (stand-ins for the delay library, rtc, log index, boot time, uart and
+ * log functions)
+ */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <time.h>
+ #include <unistd.h>
+ #include "ntpclient.h"
+ #include "udpmux.h"
+ #include "clock.h"
+ #include "w5emu.h"
+
+ /* rtc time of the true time 0 (1/1/2022) */
+ #define TRUE_BASE_SEC       694310400UL
+
+ #define DRIFT_PPM           100
+ #define TIMER1_COUNTS       62500ULL
+
+ volatile unsigned char SREG;
+ volatile unsigned int TCNT1;
+ volatile unsigned char crash_last_sockop;
+
+ static double start_s;
+ static double speed;
+ static long long timer_adjust;      /* counts added by slews */
+ static long long rtc_base;          /* rtc seconds at timer1 count 0 */
+ static double loaded_us;           /* true time of the current call */
+ static unsigned long long counts;   /* timer1 count of the current call */
+ static unsigned int tcnt_loaded;
+
+ /**********************************
+ * true_us()
+ *
+ * Returns the true time since the start: the host monotonic time since
+ * the start time, times the speed
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  the true time in us
+ *
+ * changes:
+ *  none
+ */
+ static double true_us(){
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (t.tv_sec + t.tv_nsec / 1e9 - start_s) * speed * 1e6;
+ }
+
+ /**********************************
+ * timer_counts()
+ *
+ * Returns the timer1 counts of the (fast) device crystal since the start
+ *
+ * arguments:
+ *  us - true time
+ *
+ * returns:
+ *  the counts
+ *
+ * changes:
+ *  none
+ */
+ static unsigned long long timer_counts(double us){
+    return (unsigned long long)(us * (1 + DRIFT_PPM * 1e-6) * TIMER1_COUNTS / 1e6) + timer_adjust;
+ }
+
+ /**********************************
+ * timer_load()
+ *
+ * Samples the device timer for a call into the client: TCNT1 and the
+ * rtc keep these values for the whole call
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  loaded_us, counts, TCNT1, tcnt_loaded
+ */
+ static void timer_load(){
+    loaded_us = true_us();
+    counts = timer_counts(loaded_us);
+    tcnt_loaded = counts % TIMER1_COUNTS;
+    TCNT1 = tcnt_loaded;
+ }
+
+ /**********************************
+ * timer_store()
+ *
+ * Applies a write to TCNT1 made during the call: the timer (and the
+ * rtc seconds it counts) moves by the difference
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  timer_adjust
+ */
+ static void timer_store(){
+    timer_adjust += (long long)TCNT1 - tcnt_loaded;
+ }
+
+ unsigned long clock_ms(){ return (unsigned long)(loaded_us * (1 + DRIFT_PPM * 1e-6) / 1000); }
+ void clock_read_rtc(unsigned long *sec, unsigned int *ms){
+    *sec = rtc_base + counts / TIMER1_COUNTS;
+    *ms = ((unsigned long)TCNT1 * 2) / 125;
+ }
+ unsigned long rtc_get_date(){ return rtc_base + counts / TIMER1_COUNTS; }
+ void rtc_set_date(unsigned long datenum){ rtc_base = (long long)datenum - (long long)(counts / TIMER1_COUNTS); }
+ char *rtc_get_date_string(){ return ""; }
+ unsigned char log_get_num_entries(){ return 0; }
+ int log_get_record(unsigned long index, unsigned long *time, unsigned char *eventnum){ return 0; }
+ void logindex_add_record(unsigned char eventnum){ printf("log %u\n", eventnum); }
+ void boottime_mark(unsigned char phase){}
+ void ulog_str(unsigned char level, const char *msg, const char *str){ fprintf(stderr, "%s%s\n", msg, str); }
+
+ /**********************************
+ * main()
+ *
+ * Calls udpmux_update() and ntpclient_update() in a loop for the run
+ * time, printing a status line every second of true time
+ *
+ * arguments:
+ *  argv[1] - start time (host CLOCK_MONOTONIC seconds)
+ *  argv[2] - speed of the true time
+ *  argv[3] - run time (true seconds)
+ *
+ * returns:
+ *  0, or 1 if the arguments are missing
+ *
+ * changes:
+ *  none
+ */
+ int main(int argc, char **argv){
+    double run_us;
+    double next_status = 0;
+    unsigned long sec;
+    unsigned int ms;
+
+    if(argc < 4){
+        fprintf(stderr, "usage: ntp_host <start (monotonic s)> <speed> <run time (true s)>\n");
+        return 1;
+    }
+    start_s = atof(argv[1]);
+    speed = atof(argv[2]);
+    run_us = atof(argv[3]) * 1e6;
+    w5emu_port_offset = 10000;
+    w5emu_loopback_source[0] = 192;
+    w5emu_loopback_source[1] = 168;
+    w5emu_loopback_source[2] = 1;
+    w5emu_loopback_source[3] = 1;
+
+    timer_load();
+    ntpclient_init();
+    while(loaded_us < run_us){
+        timer_load();
+        udpmux_update();
+        timer_store();
+        timer_load();
+        ntpclient_update();
+        timer_store();
+
+        if(loaded_us >= next_status){
+            timer_load();
+            clock_read_rtc(&sec, &ms);
+            printf("%.0f %lld %u %u %u %ld %u\n", loaded_us / 1000,
+                   ((long long)sec - (long long)TRUE_BASE_SEC) * 1000 + ms, ntp_stats.syncs,
+                   ntp_stats.steps, ntp_stats.failures, ntp_stats.offset_ms, ntp_stats.delay_ms);
+            fflush(stdout);
+            next_status += 1e6;
+        }
+        usleep(50);
+    }
+    return 0;
+ }
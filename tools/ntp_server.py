@@ -0,0 +1,217 @@
+#!/usr/bin/env python3
+"""
+ntp_server.py
+
+SER486 Final Project
+Author: Jesse Baker (student jjbaker4)
+
+Scripted (S)NTP server stand-in for tools/ntp_host.c.  Starts the host
+program, listens on 127.0.0.1:10123 (NTP_PORT offset by 10000) and
+answers the client requests according to a script that takes the client
+through the step, slew and threshold cases of handle_reply() and
+slew_update():
+
+    1  first sync, server on true time   step (every offset steps at first)
+    2  follow-up, server 20 s ahead       slew (below STEP_THRESHOLD_MS)
+    3  resync after an hour               only invalid replies: a
+                                          kiss-of-death (stratum 0), a client
+                                          mode reply, a short reply and one
+                                          from another address - the request
+                                          times out and is retried in 60 s
+    4  retry, server 110 s ahead          step (90 s, above the threshold)
+    5  follow-up, server 80 s ahead       slew of -30 s
+
+Both programs take the true time from the host CLOCK_MONOTONIC since the
+start, times the speed.  The status lines of the host are then checked:
+the outcome of every reply, the request times, the log records, that the
+rtc never goes backwards except at a step, that a slew moves the rtc by
+at most 5% (50 ms per second) and that once a slew is complete the rtc
+is on the server time, apart from the drift of the device crystal.
+
+    ntp_server.py [--host ./ntp_host] [--speed 100]
+"""
+
+import argparse
+import socket
+import struct
+import subprocess
+import sys
+import threading
+import time
+
+NTP_TO_RTC = 3155673600
+TRUE_BASE_SEC = 694310400       # 1/1/2022 on the rtc scale, as ntp_host.c
+DRIFT_PPM = 100                 # device crystal, as ntp_host.c
+SERVER_PORT = 123 + 10000
+RUN_S = 4400
+
+SLEW_MAX_MS = 50
+EVENT_TIMESET, EVENT_NEWTIME = 3, 4
+
+# server clock offset (ms) for each request, None for only invalid replies
+SCRIPT = [0, 20000, None, 110000, 80000]
+
+# expected outcome of each request and the time (s) to the next one
+OUTCOMES = ['step', 'slew', 'timeout', 'step', 'slew']
+INTERVALS = [10, 3600, 61, 10]
+
+# tolerances: rtc after a completed slew, rtc after a step, request times,
+# time taken by a slew
+SLEWED_TOLERANCE_MS = 40
+STEPPED_TOLERANCE_MS = 600
+INTERVAL_TOLERANCE_S = 1.0
+SLEW_TIME_MARGIN = 1.1
+
+checks = 0
+failures = 0
+
+
+def check(cond, what):
+    """Counts a check and reports it if it failed."""
+    global checks, failures
+    checks += 1
+    if not cond:
+        failures += 1
+        print('FAIL', what)
+
+
+def reply(true_ms, offset_ms, mode=4, stratum=2, size=48):
+    """Builds a server reply with the transmit time true_ms + offset_ms."""
+    ms = int(true_ms + offset_ms)
+    sec = NTP_TO_RTC + TRUE_BASE_SEC + ms // 1000
+    frac = (ms % 1000) * (1 << 32) // 1000
+    m = bytes([0x20 | mode, stratum, 6, 0xEC]) + bytes(36) + struct.pack('>II', sec, frac)
+    return m[:size]
+
+
+class Server(threading.Thread):
+    """Answers the client requests according to SCRIPT."""
+
+    def __init__(self, start, speed):
+        super().__init__(daemon=True)
+        self.start_s = start
+        self.speed = speed
+        self.requests = []      # true time (ms) of each request
+        self.offsets = []       # (true time (ms), server offset (ms)) changes
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.bind(('127.0.0.1', SERVER_PORT))
+        self.other = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.other.bind(('127.0.0.2', SERVER_PORT))
+
+    def true_ms(self):
+        return (time.monotonic() - self.start_s) * self.speed * 1000
+
+    def run(self):
+        while True:
+            d, client = self.sock.recvfrom(256)
+            now = self.true_ms()
+            n = len(self.requests)
+            self.requests.append(now)
+            check(len(d) == 48 and d[0] & 0x07 == 3, 'request %d is a client mode request' % (n + 1))
+            offset = SCRIPT[n] if n < len(SCRIPT) else SCRIPT[-1]
+            if offset is None:
+                self.sock.sendto(reply(now, 1000000, stratum=0), client)
+                self.sock.sendto(reply(now, 1000000, mode=3), client)
+                self.sock.sendto(reply(now, 1000000, size=47), client)
+                self.other.sendto(reply(now, 1000000), client)
+                continue
+            if not self.offsets or self.offsets[-1][1] != offset:
+                self.offsets.append((now, offset))
+            self.sock.sendto(reply(self.true_ms(), offset), client)
+
+    def offset_at(self, t):
+        """Returns the server clock offset at true time t."""
+        offset = 0
+        for when, o in self.offsets:
+            if when <= t:
+                offset = o
+        return offset
+
+
+def main():
+    ap = argparse.ArgumentParser(description='scripted ntp server for tools/ntp_host.c')
+    ap.add_argument('--host', default='./ntp_host', help='client program')
+    ap.add_argument('--speed', type=float, default=100, help='true time per host time')
+    args = ap.parse_args()
+
+    start = time.monotonic()
+    server = Server(start, args.speed)
+    server.start()
+    proc = subprocess.Popen([args.host, repr(start), str(args.speed), str(RUN_S)], stdout=subprocess.PIPE,
+                            universal_newlines=True)
+    status = []
+    logs = []
+    for line in proc.stdout:
+        f = line.split()
+        if f[0] == 'log':
+            logs.append(int(f[1]))
+        else:
+            status.append([float(f[0])] + [int(x) for x in f[1:]])
+    proc.wait()
+
+    # requests: count and spacing
+    req = server.requests
+    print('requests at %s s' % ', '.join('%.1f' % (t / 1000) for t in req))
+    check(len(req) == len(SCRIPT), '%d requests' % len(req))
+    check(req and req[0] < 1000, 'first request at startup')
+    for i, gap in enumerate(INTERVALS):
+        if i + 1 < len(req):
+            check(abs((req[i + 1] - req[i]) / 1000 - gap) < INTERVAL_TOLERANCE_S,
+                  'request %d %.1f s after the previous, expected %d' % (i + 2, (req[i + 1] - req[i]) / 1000, gap))
+
+    # outcome of each request, from the counters of the first line after the next request
+    prev = [0, 0, 0]
+    for i, expected in enumerate(OUTCOMES):
+        end = req[i + 1] if i + 1 < len(req) else RUN_S * 1000
+        lines = [s for s in status if s[0] < end]
+        cur = lines[-1][2:5] if lines else prev
+        got = ('step' if cur[1] > prev[1] else 'slew') if cur[0] == prev[0] + 1 else \
+              'timeout' if cur[0] == prev[0] and cur[2] == prev[2] + 1 else 'counters %s -> %s' % (prev, cur)
+        check(got == expected, 'request %d: %s, expected %s' % (i + 1, got, expected))
+        prev = cur
+    check(logs == [EVENT_NEWTIME, EVENT_TIMESET, EVENT_NEWTIME], 'log records %s' % logs)
+
+    # the rtc: monotonic, slew rate, error against the server
+    drift = DRIFT_PPM * 1e-6
+    worst = {'step': 0, 'slew': 0}
+    for a, b in zip(status, status[1:]):
+        if b[3] == a[3]:
+            check(b[1] >= a[1], 'rtc went back %d ms at %.0f s' % (a[1] - b[1], b[0] / 1000))
+    # a window of dt ms holds at most dt / 1000 + 1 slews
+    for a, b in zip(status, status[10:]):
+        dt = b[0] - a[0]
+        dr = b[1] - a[1]
+        if b[3] == a[3]:
+            check(abs(dr - dt * (1 + drift)) <= (dt / 1000 + 1) * SLEW_MAX_MS + 2,
+                  'rtc moved %d ms in %.0f ms at %.0f s' % (dr, dt, b[0] / 1000))
+    for i, t_req in enumerate(req):
+        if SCRIPT[i] is None:
+            continue
+        end = req[i + 1] if i + 1 < len(req) else RUN_S * 1000
+        after = [s for s in status if t_req + 1000 < s[0] < end]
+        if not after:
+            continue
+        err = after[0][1] - (after[0][0] + server.offset_at(after[0][0]))
+        if OUTCOMES[i] == 'step':
+            worst['step'] = max(worst['step'], abs(err))
+            check(abs(err) <= STEPPED_TOLERANCE_MS, 'request %d: rtc %d ms off after the step' % (i + 1, err))
+            continue
+        # complete once the offset has been slewed at SLEW_MAX_MS per second (the
+        # host loop runs each slew a few ms late, which SLEW_TIME_MARGIN allows for)
+        done = t_req + abs(after[0][5]) / SLEW_MAX_MS * 1000 * SLEW_TIME_MARGIN + 3000
+        settled = [s for s in after if s[0] > done]
+        check(settled, 'request %d: the slew completes before the next request' % (i + 1))
+        for s in settled:
+            err = s[1] - (s[0] + server.offset_at(s[0])) - drift * (s[0] - t_req)
+            worst['slew'] = max(worst['slew'], abs(err))
+            check(abs(err) <= SLEWED_TOLERANCE_MS,
+                  'request %d: rtc %.0f ms off at %.0f s after the slew' % (i + 1, err, s[0] / 1000))
+    last = status[-1]
+    print('syncs %d steps %d failures %d last offset %d ms delay %d ms' % tuple(last[2:7]))
+    print('largest rtc error: %d ms after a step, %.0f ms after a slew' % (worst['step'], worst['slew']))
+    print('%d checks, %d failures' % (checks, failures))
+    sys.exit(1 if failures else 0)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,166 @@
+#!/usr/bin/env python3
+"""
+stream_decode.py
+
+SER486 Final Project
+Author: Jesse Baker (student jjbaker4)
+
+Host side decoder for the binary sample stream (see stream.h).  Reads
+COBS frames from a serial port (sending the stream key to start and stop
+the stream) or from a capture file, checks the crc and prints one line
+per sample: tick (ms, unwrapped), raw ADC value and filtered value.  A
+summary of the throughput, crc errors and sample gaps is printed at the
+end.
+
+    stream_decode.py --port /dev/ttyUSB0
+    stream_decode.py --file capture.bin --quiet
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+STREAM_KEY = b'S'
+TYPE_SAMPLES = 0x01
+HEADER = struct.Struct('<BBBB')
+SAMPLE = struct.Struct('<HHH')
+FILTER_SCALE = 16.0
+
+
+def crc16(data):
+    """CRC-16 as crc16.c: polynomial 0x1021, initial value 0xFFFF."""
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(data):
+    """Decodes one COBS frame (without the zero delimiter)."""
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            raise ValueError('bad cobs code')
+        out += data[i + 1:i + code]
+        i += code
+        if code != 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+class Decoder:
+    def __init__(self, quiet):
+        self.quiet = quiet
+        self.buf = bytearray()
+        self.frames = 0
+        self.samples = 0
+        self.bytes = 0
+        self.bad = 0
+        self.lost = 0
+        self.gaps = 0
+        self.seq = None
+        self.tick = None
+        self.base = 0
+
+    def feed(self, data):
+        self.bytes += len(data)
+        self.buf += data
+        while True:
+            end = self.buf.find(0)
+            if end < 0:
+                return
+            raw = bytes(self.buf[:end])
+            del self.buf[:end + 1]
+            if raw:
+                self.frame(raw)
+
+    def frame(self, raw):
+        try:
+            frame = cobs_decode(raw)
+        except ValueError:
+            self.bad += 1
+            return
+        if len(frame) < HEADER.size + 2 or crc16(frame[:-2]) != struct.unpack('<H', frame[-2:])[0]:
+            self.bad += 1
+            return
+        ftype, seq, lost, count = HEADER.unpack_from(frame)
+        if ftype != TYPE_SAMPLES or len(frame) != HEADER.size + count * SAMPLE.size + 2:
+            self.bad += 1
+            return
+        if self.seq is not None and seq != (self.seq + 1) & 0xFF:
+            self.gaps += 1
+        self.seq = seq
+        self.lost += lost
+        self.frames += 1
+        for i in range(count):
+            tick, value, filtered = SAMPLE.unpack_from(frame, HEADER.size + i * SAMPLE.size)
+            if self.tick is not None:
+                if tick < self.tick:
+                    self.base += 0x10000
+                if (tick - self.tick) & 0xFFFF != 1:
+                    self.gaps += 1
+            self.tick = tick
+            self.samples += 1
+            if not self.quiet:
+                print('%d %d %.2f' % (self.base + tick, value, filtered / FILTER_SCALE))
+
+    def summary(self, seconds):
+        rate = lambda n: n / seconds if seconds > 0 else 0.0
+        sys.stderr.write('%d frames, %d samples (%.0f/s), %d bytes (%.0f B/s), '
+                         '%d bad frames, %d lost samples, %d gaps\n' %
+                         (self.frames, self.samples, rate(self.samples), self.bytes,
+                          rate(self.bytes), self.bad, self.lost, self.gaps))
+
+
+def run_port(args, decoder):
+    import serial
+    port = serial.Serial(args.port, 9600, timeout=0.1)
+    port.write(STREAM_KEY)
+    port.flush()
+    time.sleep(0.05)
+    port.baudrate = 115200
+    port.reset_input_buffer()
+    start = time.time()
+    try:
+        while args.seconds <= 0 or time.time() - start < args.seconds:
+            decoder.feed(port.read(4096))
+    except KeyboardInterrupt:
+        pass
+    seconds = time.time() - start
+    port.write(STREAM_KEY)
+    port.flush()
+    time.sleep(0.05)
+    port.baudrate = 9600
+    port.close()
+    return seconds
+
+
+def run_file(args, decoder):
+    with open(args.file, 'rb') as f:
+        decoder.feed(f.read())
+    # one sample per ms
+    return decoder.samples / 1000.0
+
+
+def main():
+    parser = argparse.ArgumentParser(description='decode the binary sample stream')
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument('--port', help='serial port of the device')
+    source.add_argument('--file', help='capture of the stream (115200 baud)')
+    parser.add_argument('--seconds', type=float, default=0, help='stop after this long (port)')
+    parser.add_argument('--quiet', action='store_true', help='only print the summary')
+    args = parser.parse_args()
+
+    decoder = Decoder(args.quiet)
+    seconds = run_port(args, decoder) if args.port else run_file(args, decoder)
+    decoder.summary(seconds)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,221 @@
+/********************************************************
+ * stream_host.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * Host harness for the binary sample stream (stream.c).  The firmware
+ * stream.c and crc16.c run unchanged over stand-ins for the serial
+ * driver, the log level, the clock and the ADC registers.  The harness
+ * presses the stream key, lets the line drain, then plays the ADC
+ * interrupt once per millisecond and calls stream_update() every 4 ms,
+ * as the "stream" task does.  Every STALL_PERIOD ms the updates stop for
+ * STALL_MS plus 0 to 7 ms and the task then runs late, so the sample ring
+ * overflows, samples are lost and the ticks move to another position in
+ * the frames.  The
+ * conversions follow a pattern with many zero bytes (zero and multiple
+ * of 256 values, ticks crossing 256 and 65536), so the COBS encoding
+ * replaces zeros in every position of the frames.  At the end the key is
+ * pressed again and the harness checks that the baud rate, the log level
+ * and the ADC registers are restored.
+ *
+ * The bytes written to the uart go to stdout.  The expected values go to
+ * the file named by the second argument, one per line: the ADC value the
+ * filter was seeded with, the value of every conversion (tick 1, 2, ...),
+ * the number of stalls and the samples lost (stream_get_lost()).
+ * tools/stream_test.py runs this program, decodes the output with
+ * tools/stream_decode.py and checks it:
+ *
+ *    gcc -O2 -DSTREAM_ENABLE=1 -I tools/host -I . -o stream_host \
+ *        tools/stream_host.c stream.c crc16.c
+ *    python3 tools/stream_test.py --host ./stream_host
+ *    stream_host <frames> <expected file>
+ *
+ * Functions:
+ *
+ * main()
+ *  Streams the specified number of frames
+ *
+ * next_value()
+ *  Returns the next ADC conversion of the pattern
+ *
+ * run_ms()
+ *  Advances the clock one millisecond with a conversion
+ *
+ * (stand-ins for the serial driver, log level and clock)
+ */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <avr/io.h>
+ #include "stream.h"
+ #include "serial.h"
+ #include "ulog.h"
+
+ #define UPDATE_MS           4
+ #define STALL_PERIOD        997
+ #define STALL_MS            20
+ #define SEED_VALUE          612
+
+ #define CHECK(cond) do{ \
+        if(!(cond)){ \
+            failures++; \
+            fprintf(stderr, "FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        } \
+    }while(0)
+
+ volatile unsigned char SREG;
+ volatile unsigned int ADC;
+ volatile unsigned char ADCSRA;
+ volatile unsigned char ADCSRB;
+
+ void ADC_vect(void);
+
+ static unsigned long failures;
+ static unsigned long now_ms;
+ static unsigned char key;
+ static unsigned char baud = SERIAL_BAUD_9600;
+ static unsigned char level = ULOG_INFO;
+ static FILE *expected;
+
+ unsigned long clock_ms(){ return now_ms; }
+ void serial_writechar(char c){ putchar(c); }
+ unsigned char serial_get_tx_free(){ return SERIAL_TX_SIZE - 1; }
+ void serial_set_baud(unsigned char rate){ baud = rate; }
+ unsigned char serial_is_socket_mode(){ return 0; }
+ unsigned char serial_rxchars(){ return key; }
+ char serial_popchar(){ key = 0; return STREAM_KEY; }
+ void ulog_set_level(unsigned char new_level){ level = new_level; }
+ unsigned char ulog_get_level(){ return level; }
+
+ /**********************************
+ * next_value()
+ *
+ * Returns the next ADC conversion: runs of zero, of multiples of 256 and
+ * of random 10-bit values
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  the conversion
+ *
+ * changes:
+ *  none
+ */
+ static unsigned int next_value(){
+    switch((now_ms / 50) % 4){
+    case 0:
+        return 0;
+    case 1:
+        return (rand() % 4) << 8;
+    default:
+        return rand() & 0x3FF;
+    }
+ }
+
+ /**********************************
+ * run_ms()
+ *
+ * Advances the clock one millisecond: the conversion completes (the ADC
+ * interrupt) and the stream task runs at the end of a stall and then on
+ * its period
+ *
+ * arguments:
+ *  stall_end - time the current (or last) stall ends
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  now_ms, ADC, expected
+ */
+ static void run_ms(unsigned long stall_end){
+    now_ms++;
+    ADC = next_value();
+    fprintf(expected, "%u\n", ADC);
+    ADC_vect();
+    if(now_ms == stall_end || (now_ms > stall_end && now_ms % UPDATE_MS == 0)){
+        stream_update();
+    }
+ }
+
+ /**********************************
+ * main()
+ *
+ * Starts the stream, runs until the specified number of frames has been
+ * sent and stops the stream
+ *
+ * arguments:
+ *  argv[1] - number of frames
+ *  argv[2] - file for the expected values
+ *
+ * returns:
+ *  0 if every check passed, otherwise 1
+ *
+ * changes:
+ *  none
+ */
+ int main(int argc, char **argv){
+    unsigned long frames;
+    unsigned long stalls = 0;
+    unsigned long stall_end = 0;
+
+    if(argc < 3){
+        fprintf(stderr, "usage: stream_host <frames> <expected file>\n");
+        return 1;
+    }
+    frames = atol(argv[1]);
+    expected = fopen(argv[2], "w");
+    if(!expected){
+        perror(argv[2]);
+        return 1;
+    }
+    srand(486);
+
+    /* start: the baud rate changes once the line has drained */
+    ADC = SEED_VALUE;
+    ADCSRA = (1<<ADEN) | (1<<ADPS2) | (1<<ADPS1);
+    key = 1;
+    stream_update();
+    CHECK(level == ULOG_NONE);
+    CHECK(!stream_is_active());
+    now_ms += STREAM_DRAIN_MS;
+    stream_update();
+    CHECK(stream_is_active());
+    CHECK(baud == SERIAL_BAUD_115200);
+    CHECK(ADCSRA & (1<<ADATE));
+    CHECK(ADCSRA & (1<<ADIE));
+    CHECK(ADCSRB == ((1<<ADTS1) | (1<<ADTS0)));
+    fprintf(expected, "seed %u\n", SEED_VALUE);
+
+    while(stream_get_frames() < frames){
+        if(now_ms % STALL_PERIOD == 0){
+            stall_end = now_ms + STALL_MS + rand() % STREAM_FRAME_SAMPLES;
+            stalls++;
+        }
+        run_ms(stall_end);
+    }
+    fprintf(expected, "stalls %lu\n", stalls);
+    fprintf(expected, "lost %lu\n", stream_get_lost());
+    CHECK(stream_get_lost() > 0);
+
+    /* stop: the ADC returns to single conversions at once, the baud rate
+    * and log level once the line has drained
+    */
+    key = 1;
+    stream_update();
+    CHECK(!stream_is_active());
+    CHECK(!(ADCSRA & ((1<<ADATE) | (1<<ADIE))));
+    CHECK(ADCSRB == 0);
+    CHECK(baud == SERIAL_BAUD_115200);
+    now_ms += STREAM_DRAIN_MS;
+    stream_update();
+    CHECK(baud == SERIAL_BAUD_9600);
+    CHECK(level == ULOG_INFO);
+
+    fclose(expected);
+    fprintf(stderr, "%lu frames, %lu samples lost, %lu stalls, %lu failures\n", stream_get_frames(),
+            stream_get_lost(), stalls, failures);
+    return failures ? 1 : 0;
+ }
@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+"""
+stream_test.py
+
+SER486 Final Project
+Author: Jesse Baker (student jjbaker4)
+
+Checks the frames of the binary sample stream (stream.c) against the
+host decoder tools/stream_decode.py.  Runs tools/stream_host.c, which
+streams a pattern of ADC conversions through the firmware stream.c, and
+checks its uart output:
+
+    - every frame is COBS encoded as a reference encoder would (one
+      overhead byte, no zero before the delimiter)
+    - stream_decode.py decodes every frame with a good crc, and rejects
+      each frame once a byte of it is corrupted
+    - the decoded samples are the conversions of their ticks, with the
+      filtered values of a reference filter, and the lost samples and
+      tick gaps match the stalls of the stream task
+    - a zero byte was sent at every frame offset but the type and count
+
+    stream_test.py [--host ./stream_host] [--frames 12000]
+"""
+
+import argparse
+import contextlib
+import io
+import os
+import random
+import subprocess
+import sys
+import tempfile
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import stream_decode  # noqa: E402
+
+FRAME_SAMPLES = 8
+FRAME_SIZE = stream_decode.HEADER.size + FRAME_SAMPLES * stream_decode.SAMPLE.size + 2
+FILTER_Q = 4
+FILTER_SHIFT = 3
+
+checks = 0
+failures = 0
+
+
+def check(cond, what):
+    """Counts a check and reports it if it failed."""
+    global checks, failures
+    checks += 1
+    if not cond:
+        failures += 1
+        print('FAIL', what)
+
+
+def cobs_encode(data):
+    """Reference COBS encoder (without the zero delimiter)."""
+    out = bytearray()
+    run = bytearray()
+    for b in data:
+        if b == 0:
+            out += bytes([len(run) + 1]) + run
+            run = bytearray()
+        else:
+            run.append(b)
+            if len(run) == 254:
+                out += bytes([255]) + run
+                run = bytearray()
+    out += bytes([len(run) + 1]) + run
+    return bytes(out)
+
+
+def decode(data):
+    """Runs stream_decode.py on data, returns the decoder and its sample lines."""
+    decoder = stream_decode.Decoder(quiet=False)
+    out = io.StringIO()
+    with contextlib.redirect_stdout(out):
+        decoder.feed(data)
+    return decoder, [line.split() for line in out.getvalue().splitlines()]
+
+
+def main():
+    ap = argparse.ArgumentParser(description='checks the stream frames against stream_decode.py')
+    ap.add_argument('--host', default='./stream_host', help='stream harness')
+    ap.add_argument('--frames', type=int, default=12000, help='frames to stream')
+    args = ap.parse_args()
+
+    with tempfile.NamedTemporaryFile('r') as f:
+        proc = subprocess.run([args.host, str(args.frames), f.name], stdout=subprocess.PIPE)
+        lines = f.read().split('\n')
+    check(proc.returncode == 0, 'stream_host exit code %d' % proc.returncode)
+    seed = int(lines[0].split()[1])
+    stalls = int(lines[-3].split()[1])
+    lost = int(lines[-2].split()[1])
+    values = [int(v) for v in lines[1:-3]]
+    wire = proc.stdout
+
+    # encoding: canonical COBS, a frame of FRAME_SIZE bytes per delimiter
+    check(wire.endswith(b'\0'), 'the stream ends with a delimiter')
+    encoded = wire.split(b'\0')[:-1]
+    check(len(encoded) == args.frames, '%d frames, expected %d' % (len(encoded), args.frames))
+    zeros = set()
+    zero_crc = 0
+    for i, raw in enumerate(encoded):
+        frame = stream_decode.cobs_decode(raw)
+        check(len(frame) == FRAME_SIZE and len(raw) == FRAME_SIZE + 1,
+              'frame %d: %d bytes, %d encoded' % (i, len(frame), len(raw)))
+        check(cobs_encode(frame) == raw, 'frame %d: not encoded as the reference' % i)
+        zeros.update(j for j, b in enumerate(frame) if b == 0)
+        zero_crc += 0 in frame[-2:]
+    # all but the type and sample count, which are never zero
+    missing = set(range(1, FRAME_SIZE)) - {3} - zeros
+    check(not missing, 'no zero byte at frame offsets %s' % sorted(missing))
+    check(zero_crc > 0, 'zero bytes in the crc of %d frames' % zero_crc)
+
+    # crc: every frame decodes, a corrupted byte is always rejected
+    decoder, samples = decode(wire)
+    check(decoder.frames == args.frames and decoder.bad == 0,
+          'decoded %d frames, %d bad' % (decoder.frames, decoder.bad))
+    rng = random.Random(486)
+    rejected = 0
+    for raw in encoded:
+        pos = rng.randrange(len(raw))
+        bad = bytearray(raw)
+        while bad[pos] == raw[pos] or bad[pos] == 0:
+            bad[pos] = rng.randrange(256)
+        d, _ = decode(bytes(bad) + b'\0')
+        rejected += d.bad == 1 and d.frames == 0
+    check(rejected == len(encoded), '%d of %d corrupted frames rejected' % (rejected, len(encoded)))
+
+    # samples: conversion of the tick, reference filter, losses
+    filtered = seed << FILTER_Q
+    wrong = 0
+    for tick, value, value_filtered in samples:
+        tick = int(tick)
+        raw = values[tick - 1] if 0 < tick <= len(values) else -1
+        filtered = (filtered + (raw << (FILTER_Q - FILTER_SHIFT)) - (filtered >> FILTER_SHIFT)) & 0xFFFF
+        if int(value) != raw or value_filtered != '%.2f' % (filtered / 16.0):
+            if wrong < 5:
+                print('FAIL tick %d: %s %s, expected %d %.4f' % (tick, value, value_filtered, raw, filtered / 16.0))
+            wrong += 1
+    check(wrong == 0, '%d wrong samples' % wrong)
+    check(len(samples) == args.frames * FRAME_SAMPLES, '%d samples' % len(samples))
+    # a frame reports the samples lost until it was built, which may be
+    # later than its last tick
+    last = int(samples[-1][0]) if samples else 0
+    check(decoder.lost == lost, 'frames report %d lost samples, stream_get_lost() %d' % (decoder.lost, lost))
+    check(last - len(samples) <= lost <= len(values) - len(samples), '%d lost samples' % lost)
+    check(decoder.gaps == stalls, '%d gaps, %d stalls' % (decoder.gaps, stalls))
+    check(last > 0x10000, 'the tick wrapped')
+
+    print('%d frames, %d samples, %d lost, %d with a zero in the crc' %
+          (decoder.frames, len(samples), decoder.lost, zero_crc))
+    print('%d checks, %d failures' % (checks, failures))
+    sys.exit(1 if failures else 0)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,203 @@
+/********************************************************
+ * sync_sim.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * Simulation of one device of the fleet sample synchronization.  The
+ * firmware sched.c and fleet.c run unchanged on a simulated clock: the
+ * device clock (clock_ms()) runs from a random boot time with a random
+ * drift of up to +-100 ppm against the true time, and the main loop
+ * calls sched_run() every 100 us of true time for 10 minutes.  The
+ * tasks are those of main.c that matter here:
+ *
+ *    sample  1000 ms  takes the sample (fleet_mark_sample())
+ *    udp        5 ms  delivers a pending sync beacon to fleet_receive()
+ *    busy      50 ms  (with load) runs for up to 19 ms a quarter of the
+ *                     time, delaying the other tasks
+ *
+ * The master sends a beacon with the true time every 10 s, and it
+ * arrives 1 to 3 ms later.  The true time (us) and alignment error of
+ * every sample after the first 2 minutes are printed on stdout, and the
+ * sync statistics on stderr.  tools/sync_sim.py runs a fleet of these
+ * and compares the sample times across the devices:
+ *
+ *    gcc -O2 -DFLEET_ENABLE=1 -I tools/host -I . -o sync_sim \
+ *        tools/sync_sim.c sched.c fleet.c crc16.c
+ *    sync_sim <device number> [sync (0/1)] [load (0/1)]
+ *
+ * Functions:
+ *
+ * main()
+ *  Runs the device for 10 minutes of true time
+ *
+ * task_sample()
+ *  Marks and prints a sample
+ *
+ * task_udp()
+ *  Delivers a beacon that has arrived
+ *
+ * task_busy()
+ *  Adds execution time
+ *
+ * (stand-ins for the watchdog, uart, shared udp socket, dhcp address,
+ * alarm state, config crc and thresholds)
+ */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include "sched.h"
+ #include "fleet.h"
+ #include "vpd.h"
+
+ #define RUN_US              600e6
+ #define SETTLE_US           120e6
+ #define LOOP_US             100
+ #define BEACON_PERIOD_US    10e6
+
+ vpd_struct vpd;
+ int current_temperature;
+
+ static double true_us;             /* true time */
+ static double drift;               /* device clock drift (fraction) */
+ static double boot_us;             /* device clock at true time 0 */
+ static double beacon_arrival = -1; /* true time the pending beacon arrives */
+ static unsigned long beacon_time;  /* master clock in the pending beacon */
+ static unsigned char load;
+
+ static unsigned char master_addr[4] = {10, 0, 0, 1};
+ static unsigned char ip[4] = {10, 0, 0, 2};
+
+ unsigned long clock_ms(){ return (unsigned long)((true_us * (1 + drift) + boot_us) / 1000); }
+ void wdt_reset(){}
+ void uart_writestr(char *str){}
+ void uart_writedec32(signed long num){}
+ void serial_writestr_P(const char *str){}
+ unsigned int udpmux_sendto(const unsigned char *buf, unsigned int len, const unsigned char *addr, unsigned int port){ return len; }
+ const unsigned char *netboot_get_ip(){ return ip; }
+ unsigned char devstate_classify(int temperature){ return 0; }
+ unsigned int eecrc_get_config_crc(){ return 0; }
+ void devapi_get_thresholds(int *value){}
+ unsigned char devapi_set_thresholds(const int *value){ return 0; }
+
+ /**********************************
+ * task_sample()
+ *
+ * Takes a sample: records its alignment error and, once the fleet has
+ * settled, prints its true time and the error
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  fleet_sync_stats
+ */
+ static void task_sample(){
+    fleet_mark_sample();
+    if(true_us > SETTLE_US){
+        printf("%.0f %d\n", true_us, fleet_sync_stats.sample_error);
+    }
+ }
+
+ /**********************************
+ * task_udp()
+ *
+ * Delivers the pending sync beacon if it has arrived, as udpmux_update()
+ * would
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  beacon_arrival
+ */
+ static void task_udp(){
+    unsigned char msg[8] = {FLEET_MAGIC, FLEET_MSG_SYNC, 0, 0};
+
+    if(beacon_arrival >= 0 && true_us >= beacon_arrival){
+        msg[4] = beacon_time >> 24;
+        msg[5] = beacon_time >> 16;
+        msg[6] = beacon_time >> 8;
+        msg[7] = beacon_time;
+        fleet_receive(msg, sizeof(msg), master_addr);
+        beacon_arrival = -1;
+    }
+ }
+
+ /**********************************
+ * task_busy()
+ *
+ * With load, runs for 0 to 19 ms a quarter of the time
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  true_us
+ */
+ static void task_busy(){
+    if(load && rand() % 4 == 0){
+        true_us += (rand() % 20) * 1000.0;
+    }
+ }
+
+ /**********************************
+ * main()
+ *
+ * Sets up the device clock and the tasks, then runs the scheduler and
+ * the master beacons for 10 minutes of true time
+ *
+ * arguments:
+ *  argv[1] - device number (seeds the clock drift, boot time and phase)
+ *  argv[2] - 1 to synchronize the sample task (default), 0 not to
+ *  argv[3] - 1 to run the busy task, 0 not to (default)
+ *
+ * returns:
+ *  0, or 1 if the device number is missing
+ *
+ * changes:
+ *  none
+ */
+ int main(int argc, char **argv){
+    unsigned char sample_task;
+    double next_beacon = BEACON_PERIOD_US;
+
+    if(argc < 2){
+        fprintf(stderr, "usage: sync_sim <device number> [sync (0/1)] [load (0/1)]\n");
+        return 1;
+    }
+    srand(atoi(argv[1]));
+    drift = ((rand() % 201) - 100) * 1e-6;
+    boot_us = (rand() % 100000) * 1000.0 + rand() % 1000;
+    true_us = (rand() % 3000) * 1000.0;
+    load = (argc > 3) && atoi(argv[3]);
+
+    sample_task = sched_add("sample", task_sample, 1000, 5000, 0, 2);
+    sched_add("udp", task_udp, 5, 0, 100, 50);
+    sched_add("busy", task_busy, 50, 0, 1800, 1600);
+    if(argc < 3 || atoi(argv[2])){
+        fleet_sync_init(sample_task, 1000);
+    }
+
+    while(true_us < RUN_US){
+        if(true_us >= next_beacon){
+            beacon_time = (unsigned long)(next_beacon / 1000);
+            beacon_arrival = next_beacon + 1000 + rand() % 2000;
+            next_beacon += BEACON_PERIOD_US;
+        }
+        sched_run();
+        true_us += LOOP_US;
+    }
+    fprintf(stderr, "device %s drift %.0f ppm beacons %u steps %u last beacon error %d ms\n", argv[1],
+            drift * 1e6, fleet_sync_stats.beacons, fleet_sync_stats.steps, fleet_sync_stats.beacon_error);
+    return 0;
+ }
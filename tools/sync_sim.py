@@ -0,0 +1,61 @@
+#!/usr/bin/env python3
+"""
+sync_sim.py
+
+SER486 Final Project
+Author: Jesse Baker (student jjbaker4)
+
+Runs a fleet of tools/sync_sim.c devices (each with its own clock drift,
+boot time and phase) without synchronization, synchronized, and
+synchronized with the load task, and reports the spread of the sample
+times across the fleet: for each second of true time, the latest minus
+the earliest sample of the devices.
+
+    sync_sim.py [--devices N] [--sim ./sync_sim]
+"""
+
+import argparse
+import statistics
+import subprocess
+import sys
+
+# the synchronized spread must stay below this (ms)
+MAX_SYNCED_SPREAD_MS = 30
+
+
+def run(args, sync, load):
+    """Runs the fleet and returns the sample times (us) of every device."""
+    procs = [subprocess.Popen([args.sim, str(n), str(sync), str(load)], stdout=subprocess.PIPE,
+                              stderr=subprocess.DEVNULL, universal_newlines=True)
+             for n in range(1, args.devices + 1)]
+    return [[float(line.split()[0]) for line in p.communicate()[0].splitlines()] for p in procs]
+
+
+def spreads(times):
+    """Returns the spread (ms) of the samples of each second."""
+    seconds = {}
+    for device in times:
+        for t in device:
+            seconds.setdefault(round(t / 1e6), []).append(t)
+    return [(max(s) - min(s)) / 1000 for s in seconds.values() if len(s) == len(times)]
+
+
+def main():
+    ap = argparse.ArgumentParser(description='fleet sample synchronization simulation')
+    ap.add_argument('--devices', type=int, default=20)
+    ap.add_argument('--sim', default='./sync_sim', help='device simulation program')
+    args = ap.parse_args()
+
+    failed = False
+    for name, sync, load in (('unsynced', 0, 0), ('synced, idle', 1, 0), ('synced, with load', 1, 1)):
+        s = spreads(run(args, sync, load))
+        print('%-18s spread of %d seconds: median %.1f ms, max %.1f ms' %
+              (name, len(s), statistics.median(s), max(s)))
+        if sync and max(s) > MAX_SYNCED_SPREAD_MS:
+            print('FAIL spread above %d ms' % MAX_SYNCED_SPREAD_MS)
+            failed = True
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,293 @@
+/********************************************************
+ * uart.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file implements the uart functions declared in uart.h,
+ * replacing the library implementation so that numbers are formatted
+ * by fmt.h (the library divided the whole 32-bit value twice per
+ * digit).  The functions otherwise behave as in the library and pass
+ * characters to the interrupt driven serial port (serial.h).  The
+ * simulavr device information that the library object carried is
+ * defined here as well.
+ *
+ * Functions:
+ *
+ * uart_init()
+ *  Initializes the serial port and enables interrupts
+ *
+ * uart_writechar()
+ *  Writes a character
+ *
+ * uart_writestr()
+ *  Writes a null terminated string
+ *
+ * uart_writehex8()
+ *  Writes an 8-bit value as hexadecimal text
+ *
+ * uart_writehex16()
+ *  Writes a 16-bit value as hexadecimal text
+ *
+ * uart_writedec32()
+ *  Writes a 32-bit signed value as decimal text
+ *
+ * uart_writeip()
+ *  Writes an ip address followed by a line end
+ *
+ * uart_is_connected()
+ *  Returns whether the test host is connected
+ *
+ * uart_is_packet_available()
+ *  Returns the number of complete lines received
+ *
+ * uart_readpacket()
+ *  Reads a received line
+ */
+
+ #include <avr/interrupt.h>
+ #include "uart.h"
+ #include "serial.h"
+ #include "fmt.h"
+
+ /* simulavr device information, byte for byte as in the library object
+ * (records of tag, length, data) - serial pins D1 and D0 at 9600 baud,
+ * 16MHz cpu, atmega328
+ */
+ #define SIMINFO            __attribute__((section(".siminfo"), used))
+
+ static const unsigned char siminfo_serial_out[] SIMINFO = {
+    0x03, 11, 'D', '1', 0, 0x80, 0x25, 0x00, 0x00, '-', 0
+ };
+ static const unsigned char siminfo_serial_in[] SIMINFO = {
+    0x04, 11, 'D', '0', 0, 0x80, 0x25, 0x00, 0x00, '-', 0
+ };
+ static const unsigned char siminfo_cpufrequency[] SIMINFO = {
+    0x02, 6, 0x00, 0x24, 0xF4, 0x00
+ };
+ static const unsigned char siminfo_device[] SIMINFO = {
+    0x01, 12, 'a', 't', 'm', 'e', 'g', 'a', '3', '2', '8', 0
+ };
+
+ /**********************************
+ * uart_init()
+ *
+ * Initializes the serial port (9600 baud, interrupt driven) and enables
+ * interrupts
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the uart registers, the global interrupt enable
+ */
+ void uart_init(void){
+    serial_init();
+    sei();
+ }
+
+ /**********************************
+ * uart_writechar()
+ *
+ * Writes a character
+ *
+ * arguments:
+ *  ch - the character
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the serial tx ring
+ */
+ void uart_writechar(char ch){
+    serial_writechar(ch);
+ }
+
+ /**********************************
+ * uart_writestr()
+ *
+ * Writes a null terminated string
+ *
+ * arguments:
+ *  str - the string
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the serial tx ring
+ */
+ void uart_writestr(char *str){
+    serial_writestr(str);
+ }
+
+ /**********************************
+ * uart_writehex8()
+ *
+ * Writes an 8-bit value as two uppercase hexadecimal digits
+ *
+ * arguments:
+ *  num - the value
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the serial tx ring
+ */
+ void uart_writehex8(unsigned char num){
+    char text[FMT_HEX8_SIZE];
+
+    fmt_hex8(text, num);
+    serial_writestr(text);
+ }
+
+ /**********************************
+ * uart_writehex16()
+ *
+ * Writes a 16-bit value as four uppercase hexadecimal digits
+ *
+ * arguments:
+ *  num - the value
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the serial tx ring
+ */
+ void uart_writehex16(unsigned int num){
+    char text[FMT_HEX16_SIZE];
+
+    fmt_hex16(text, num);
+    serial_writestr(text);
+ }
+
+ /**********************************
+ * uart_writedec32()
+ *
+ * Writes a 32-bit signed value as decimal text
+ *
+ * arguments:
+ *  num - the value
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the serial tx ring
+ */
+ void uart_writedec32(signed long num){
+    char text[FMT_S32_SIZE];
+
+    fmt_s32(text, num);
+    serial_writestr(text);
+ }
+
+ /**********************************
+ * uart_writeip()
+ *
+ * Writes an ip address as dotted decimal text followed by a line end
+ *
+ * arguments:
+ *  ip - the 4 bytes of the address
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the serial tx ring
+ */
+ void uart_writeip(unsigned char *ip){
+    char text[FMT_IP_SIZE];
+
+    fmt_ip(text, ip);
+    serial_writestr(text);
+    serial_writestr("\r\n");
+ }
+
+ /**********************************
+ * uart_is_connected()
+ *
+ * Switches the receiver to socket mode and returns whether the test
+ * host is connected
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  1 if connected, 0 otherwise
+ *
+ * changes:
+ *  the serial socket mode
+ */
+ unsigned char uart_is_connected(void){
+    return serial_isconnected();
+ }
+
+ /**********************************
+ * uart_is_packet_available()
+ *
+ * Returns the number of complete lines received from the test host
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  the number of lines
+ *
+ * changes:
+ *  none
+ */
+ unsigned char uart_is_packet_available(void){
+    return serial_is_packet_ready();
+ }
+
+ /**********************************
+ * uart_readpacket()
+ *
+ * Reads a line from the test host into buf, up to a carriage return or
+ * one of the delimiter characters.  Control characters are not stored.
+ * Waits for the rest of the line if only part has been received.
+ *
+ * arguments:
+ *  buf - the buffer (null terminated on return)
+ *  delims - null terminated string of delimiter characters
+ *
+ * returns:
+ *  the number of characters stored
+ *
+ * changes:
+ *  the buffer, the serial rx ring
+ */
+ unsigned char uart_readpacket(char *buf, char *delims){
+    unsigned char count = 0;
+    char *d;
+    char c;
+
+    *buf = 0;
+    if(!serial_isconnected() || !serial_rxchars()){
+        return 0;
+    }
+    while(1){
+        c = serial_popchar();
+        if((unsigned char)c >= ' '){
+            *buf++ = c;
+            count++;
+        }
+        for(d = delims; *d; d++){
+            if(c == *d){
+                break;
+            }
+        }
+        if(*d || c == '\r'){
+            break;
+        }
+    }
+    *buf = 0;
+    return count;
+ }
@@ -0,0 +1,149 @@
+/********************************************************
+ * udpmux.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file implements the udp socket shared by the ntp and MQTT-SN
+ * clients, the fleet protocol and the CoAP server.  The clients and the
+ * fleet protocol only talk to one peer each, so datagrams are routed by
+ * source port: NTP_PORT to the ntp client, the gateway port to the
+ * MQTT-SN client, the master port to the fleet protocol and any other
+ * port to the CoAP server.  The clients validate the source address
+ * themselves.
+ *
+ * Functions:
+ *
+ * udpmux_sendto()
+ *  Sends a datagram from the shared socket
+ *
+ * udpmux_is_closed()
+ *  Returns 1 if the shared socket is closed
+ *
+ * udpmux_update()
+ *  Reads the received datagrams and passes them to the clients and server
+ *
+ * open_socket()
+ *  Opens the shared socket if it is closed
+ */
+
+ #include "udpmux.h"
+ #include "socket.h"
+ #include "ntpclient.h"
+ #include "mqttsn.h"
+ #include "coap.h"
+ #include "fleet.h"
+ #include "crash.h"
+
+ /**********************************
+ * open_socket()
+ *
+ * Opens the shared socket if it is closed
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  socket registers
+ */
+ static void open_socket(){
+    if(udpsocket_is_closed(UDPMUX_SOCKET)){
+        CRASH_SOCKOP(UDPMUX_SOCKET, SOCKOP_OPEN);
+        udpsocket_open(UDPMUX_SOCKET, UDPMUX_PORT);
+    }
+ }
+
+ /**********************************
+ * udpmux_sendto()
+ *
+ * Sends a datagram from the shared socket, opening the socket if needed
+ *
+ * arguments:
+ *  buf - the data
+ *  len - number of bytes
+ *  addr - destination ip address
+ *  port - destination port
+ *
+ * returns:
+ *  the number of bytes sent (0 on failure)
+ *
+ * changes:
+ *  socket registers
+ */
+ unsigned int udpmux_sendto(const unsigned char *buf, unsigned int len,
+                            const unsigned char *addr, unsigned int port){
+    open_socket();
+    CRASH_SOCKOP(UDPMUX_SOCKET, SOCKOP_SEND);
+    return udpsocket_sendto(UDPMUX_SOCKET, buf, len, (unsigned char*)addr, port);
+ }
+
+ /**********************************
+ * udpmux_is_closed()
+ *
+ * Returns 1 if the shared socket is closed
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  1 if closed, otherwise 0
+ *
+ * changes:
+ *  none
+ */
+ unsigned char udpmux_is_closed(){
+    return udpsocket_is_closed(UDPMUX_SOCKET);
+ }
+
+ /**********************************
+ * udpmux_update()
+ *
+ * Reads up to UDPMUX_MAX_PER_UPDATE received datagrams and passes each
+ * one to the client that owns its source port, or else to the CoAP
+ * server (dropping those for a service that is not built)
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  socket registers
+ */
+ void udpmux_update(){
+    unsigned char buf[UDPMUX_BUFFER_SIZE];
+    unsigned char addr[4];
+    unsigned int port;
+    unsigned int len;
+    unsigned char count;
+
+    for(count = 0; count < UDPMUX_MAX_PER_UPDATE; count++){
+        if(udpsocket_is_closed(UDPMUX_SOCKET) || udpsocket_recv_available(UDPMUX_SOCKET) <= 0){
+            return;
+        }
+        CRASH_SOCKOP(UDPMUX_SOCKET, SOCKOP_RECV);
+        len = udpsocket_recvfrom(UDPMUX_SOCKET, buf, UDPMUX_BUFFER_SIZE, addr, &port);
+        if(port == NTP_PORT){
+            ntpclient_receive(buf, len, addr);
+        }
+ #if MQTTSN_ENABLE
+        else if(port == MQTTSN_GATEWAY_PORT){
+            mqttsn_receive(buf, len, addr);
+        }
+ #endif
+ #if FLEET_ENABLE
+        else if(port == FLEET_MASTER_PORT){
+            fleet_receive(buf, len, addr);
+        }
+ #endif
+ #if COAP_ENABLE
+        else{
+            coap_receive(buf, len, addr, port);
+        }
+ #endif
+    }
+ }
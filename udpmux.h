@@ -0,0 +1,60 @@
+/********************************************************
+ * udpmux.h
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file provides declarations for the shared udp socket.  The
+ * W5100 only has four sockets - 0 http, 1 this shared socket, 2 dhcp
+ * (and the alarms between dhcp exchanges) and 3 Modbus - so the ntp and
+ * MQTT-SN clients, the fleet protocol and the CoAP server share one udp
+ * socket, bound to the CoAP port.  Received datagrams are read
+ * once and handed to the client that owns the source port, or else to
+ * the server.  Datagrams for a service that is not built (see the
+ * *_ENABLE flags) are read and dropped.
+ */
+
+#ifndef UDPMUX_H_INCLUDED
+#define UDPMUX_H_INCLUDED
+
+#include "coap.h"
+
+/* the shared udp socket and its local port */
+#define UDPMUX_SOCKET       1
+#define UDPMUX_PORT         COAP_PORT
+
+/* largest datagram that is delivered complete (longer ones are cut) */
+#define UDPMUX_BUFFER_SIZE  80
+
+/* datagrams handled per call of udpmux_update() */
+#define UDPMUX_MAX_PER_UPDATE   4
+
+/**********************************
+ * udpmux_sendto()
+ *
+ * Sends a datagram from the shared socket, opening the socket if
+ * needed.  Returns the number of bytes sent (0 on failure).
+ */
+unsigned int udpmux_sendto(const unsigned char *buf, unsigned int len,
+                           const unsigned char *addr, unsigned int port);
+
+/**********************************
+ * udpmux_is_closed()
+ *
+ * Returns 1 if the shared socket is closed (replies can not arrive),
+ * otherwise 0
+ */
+unsigned char udpmux_is_closed();
+
+/**********************************
+ * udpmux_update()
+ *
+ * Reads the received datagrams and passes each one to the ntp or
+ * MQTT-SN client or the fleet protocol by source port, and the others
+ * to the CoAP server.  Never waits for data.  Call from the main loop
+ * every few ms (the fleet protocol times sync beacons by their arrival)
+ * and before the clients are updated.
+ */
+void udpmux_update();
+
+#endif // UDPMUX_H_INCLUDED
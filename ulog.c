@@ -0,0 +1,140 @@
+/********************************************************
+ * ulog.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file implements the runtime log level filter declared in
+ * ulog.h.
+ *
+ * Functions:
+ *
+ * ulog_begin()
+ *  Starts a message of the given level
+ *
+ * ulog_end()
+ *  Ends a message
+ *
+ * ulog_str()
+ *  Writes a message made of a text and a string
+ *
+ * ulog_set_level()
+ *  Sets the runtime log level
+ *
+ * ulog_get_level()
+ *  Returns the runtime log level
+ */
+
+ #include <avr/pgmspace.h>
+ #include "ulog.h"
+ #include "serial.h"
+
+ static unsigned char level_now = ULOG_DEFAULT_LEVEL;
+
+ /**********************************
+ * ulog_begin()
+ *
+ * Starts a message.  Info and debug messages select the drop policy so
+ * that they are cut short rather than waiting for a full uart tx ring.
+ *
+ * arguments:
+ *  level - the level of the message
+ *
+ * returns:
+ *  1 if the message should be written, 0 if it is filtered out
+ *
+ * changes:
+ *  the uart overflow policy
+ */
+ unsigned char ulog_begin(unsigned char level){
+    if(level > level_now){
+        return 0;
+    }
+    serial_set_policy(level >= ULOG_DROP_LEVEL ? SERIAL_DROP : SERIAL_BLOCK);
+    return 1;
+ }
+
+ /**********************************
+ * ulog_end()
+ *
+ * Ends a message and restores the blocking policy used by all other
+ * uart output
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the uart overflow policy
+ */
+ void ulog_end(){
+    serial_set_policy(SERIAL_BLOCK);
+ }
+
+ /**********************************
+ * ulog_str()
+ *
+ * Writes a one line message of the given level, for messages that would
+ * otherwise need several statements in a ULOG()
+ *
+ * arguments:
+ *  level - the level of the message
+ *  msg - the start of the message (in program memory)
+ *  str - the string that follows it
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the serial tx ring
+ */
+ void ulog_str(unsigned char level, const char *msg, const char *str){
+    if(level <= ULOG_LEVEL && ulog_begin(level)){
+        serial_writestr_P(msg);
+        serial_writestr((char*)str);
+        serial_writestr_P(PSTR("\r\n"));
+        ulog_end();
+    }
+ }
+
+ /**********************************
+ * ulog_set_level()
+ *
+ * Sets the runtime log level.  Levels above ULOG_DEBUG are limited to
+ * ULOG_DEBUG.
+ *
+ * arguments:
+ *  level - ULOG_NONE to ULOG_DEBUG
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the runtime log level
+ */
+ void ulog_set_level(unsigned char level){
+    if(level > ULOG_DEBUG){
+        level = ULOG_DEBUG;
+    }
+    level_now = level;
+ }
+
+ /**********************************
+ * ulog_get_level()
+ *
+ * Returns the runtime log level
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  the level
+ *
+ * changes:
+ *  none
+ */
+ unsigned char ulog_get_level(){
+    return level_now;
+ }
@@ -0,0 +1,84 @@
+/********************************************************
+ * ulog.h
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file provides the log levels for the diagnostic output on
+ * the uart.  A message is written with ULOG(level, statements) and
+ * is compiled in if its level is at most ULOG_LEVEL and written if
+ * it is at most the runtime level (ulog_set_level()).  Errors and
+ * warnings wait for room in the uart tx ring; info and debug
+ * messages are dropped when the ring is full, so that they never
+ * stall the main loop.
+ */
+
+#ifndef ULOG_H_INCLUDED
+#define ULOG_H_INCLUDED
+
+/* log levels */
+#define ULOG_NONE           0
+#define ULOG_ERROR          1
+#define ULOG_WARN           2
+#define ULOG_INFO           3
+#define ULOG_DEBUG          4
+
+/* highest level compiled in */
+#ifndef ULOG_LEVEL
+#define ULOG_LEVEL          ULOG_DEBUG
+#endif
+
+/* runtime level at startup */
+#ifndef ULOG_DEFAULT_LEVEL
+#define ULOG_DEFAULT_LEVEL  ULOG_INFO
+#endif
+
+/* lowest level that is dropped (rather than waited for) on a full ring */
+#define ULOG_DROP_LEVEL     ULOG_INFO
+
+/* writes the statements as a message of the given level */
+#define ULOG(level, stmts) do{ \
+        if((level) <= ULOG_LEVEL && ulog_begin(level)){ \
+            stmts; \
+            ulog_end(); \
+        } \
+    }while(0)
+
+/**********************************
+ * ulog_begin()
+ *
+ * Starts a message - returns 0 if the level is filtered out at runtime,
+ * otherwise selects the uart overflow policy for the level and returns 1
+ */
+unsigned char ulog_begin(unsigned char level);
+
+/**********************************
+ * ulog_end()
+ *
+ * Ends a message and restores the blocking overflow policy
+ */
+void ulog_end();
+
+/**********************************
+ * ulog_str()
+ *
+ * Writes a one line message of the given level: a text in program
+ * memory, a string and a line end
+ */
+void ulog_str(unsigned char level, const char *msg, const char *str);
+
+/**********************************
+ * ulog_set_level()
+ *
+ * Sets the runtime log level (ULOG_NONE to ULOG_DEBUG)
+ */
+void ulog_set_level(unsigned char level);
+
+/**********************************
+ * ulog_get_level()
+ *
+ * Returns the runtime log level
+ */
+unsigned char ulog_get_level();
+
+#endif // ULOG_H_INCLUDED
@@ -27,9 +27,41 @@
  * update_twarn_lo()
  *  Update the configuration twarn_lo limit with the specified value
  *  This function is called by the packet command parser.
+ *
+ * set_threshold()
+ *  Changes a threshold and incrementally updates the config crc
  */
 
+ #include <stddef.h>
+ #include <string.h>
  #include "config.h"
+ #include "eecrc.h"
+
+ /**********************************
+ * set_threshold()
+ *
+ * Changes a configuration threshold and incrementally updates the config
+ * crc, so the rest of the config structure does not need to be rescanned.
+ * The threshold is selected by its offset and copied bytewise, since the
+ * members of the packed config structure may not be aligned.
+ *
+ * arguments:
+ *  offset - offset of the threshold within the config structure
+ *  value - the new value of the threshold
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the threshold
+ */
+ static void set_threshold(unsigned char offset, int value){
+    int old;
+
+    memcpy(&old, (unsigned char*)&config + offset, sizeof(int));
+    memcpy((unsigned char*)&config + offset, &value, sizeof(int));
+    eecrc_config_changed(offset, (unsigned char*)&old, sizeof(int));
+ }
 
 
  /**********************************
@@ -51,7 +83,7 @@
  */
  int update_tcrit_hi(int value){
      if(value > config.hi_warn && value <= 0x3FF && value != config.hi_alarm){
-        config.hi_alarm = value;
+        set_threshold(offsetof(config_struct, hi_alarm), value);
         return 1;
      }
     return 0;
@@ -76,7 +108,7 @@
  */
  int update_twarn_hi(int value){
     if(value > config.lo_warn && value < config.hi_alarm && value != config.hi_warn){
-        config.hi_warn = value;
+        set_threshold(offsetof(config_struct, hi_warn), value);
         return 1;
      }
     return 0;
@@ -101,7 +133,7 @@
  */
  int update_tcrit_lo(int value){
      if(value < config.lo_warn && value != config.lo_alarm){
-        config.lo_alarm = value;
+        set_threshold(offsetof(config_struct, lo_alarm), value);
         return 1;
      }
     return 0;
@@ -126,7 +158,7 @@
  */
  int update_twarn_lo(int value){
     if(value < config.hi_warn && value > config.lo_alarm && value != config.lo_warn){
-        config.lo_warn = value;
+        set_threshold(offsetof(config_struct, lo_warn), value);
         config_set_modified();
         return 1;
      }
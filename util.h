@@ -18,7 +18,9 @@
    extern "C" {
 #endif
 /* update the checksum (last byte) of the specifed data so
-* that the sum of all the bytes will be zero
+* that the sum of all the bytes will be zero.  The vpd and config
+* images are also protected by a CRC-16 (see eecrc.h), since the
+* additive checksum misses transposed or compensating corruptions.
 */
 void update_checksum(unsigned char *data, unsigned int dsize);
 
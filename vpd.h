@@ -31,6 +31,11 @@
     /* initialize the in-memory vpd structure from the EEPROM */
     void vpd_init();
 
+    /* write the default vpd to the EEPROM.  The in-memory vpd is not changed,
+    * so it must be read back from the EEPROM once the write completes.
+    */
+    void vpd_write_defaults();
+
     /* debug code */
     void vpd_dump();
 #endif // VPD_H_INCLUDED
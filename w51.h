@@ -24,4 +24,37 @@ void           W5x_init(void);
 */
 unsigned char  W5x_config(unsigned char*mac_addr, unsigned char *ip_addr, unsigned char *gtw_addr, unsigned char *sub_mask);
 
+/* read/write a single byte of a common register */
+unsigned char  W5x_read(unsigned int addr);
+void           W5x_write(unsigned int addr, unsigned char data);
+
+/* read/write the interrupt register of socket s (write 1s to clear bits) */
+unsigned char  W5x_readSnIR(unsigned char s);
+void           W5x_writeSnIR(unsigned char s, unsigned char data);
+
+/* read/write a block of W5100 memory, one spi transaction per byte */
+void           W5x_readbuf(unsigned int addr, unsigned char *buf, unsigned int len);
+void           W5x_writebuf(unsigned int addr, const unsigned char *buf, unsigned int len);
+
+/* socket register access used by the socket layer */
+unsigned char  W5x_readSnSR(unsigned char s);
+unsigned char  W5x_readSnMR(unsigned char s);
+void           W5x_writeSnMR(unsigned char s, unsigned char data);
+void           W5x_writeSnPORT(unsigned char s, unsigned int port);
+void           W5x_writeSnDHAR(unsigned char s, unsigned char *addr);
+void           W5x_writeSnDIPR(unsigned char s, unsigned char *addr);
+void           W5x_writeSnDPORT(unsigned char s, unsigned int port);
+unsigned int   W5x_readSnTX_RD(unsigned char s);
+unsigned int   W5x_readSnTX_WR(unsigned char s);
+void           W5x_writeSnTX_WR(unsigned char s, unsigned int ptr);
+unsigned int   W5x_readSnRX_RD(unsigned char s);
+void           W5x_writeSnRX_RD(unsigned char s, unsigned int ptr);
+
+/* issue a socket command and wait for the W5100 to accept it */
+void           W5x_execCmdSn(unsigned char s, unsigned char cmd);
+
+/* free space in the transmit buffer / data in the receive buffer of socket s */
+unsigned int   W5x_getTXFreeSize(unsigned char s);
+unsigned int   W5x_getRXReceivedSize(unsigned char s);
+
 #endif
@@ -0,0 +1,509 @@
+/********************************************************
+ * w5burst.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file implements the W5100 block transfer routines.  The
+ * library driver starts a separate spi bus transaction (with the
+ * interrupt masking and register setup that goes with it) for every
+ * byte it moves, at single speed.  The W5100 has no burst mode - each
+ * byte is still its own 4 byte frame (opcode, address high, address
+ * low, data) with slave select raised between frames - but here the
+ * bus is acquired once per block, the frames are written inline and
+ * slave select is toggled directly, with the spi clock at fosc/2.
+ *
+ * The socket buffer bases and sizes follow the layout written to the
+ * W5100 by w5burst_set_layout() (2K per socket until it is called).  The
+ * library W5x_config() ends by writing 2K per socket to RMSR and TMSR, so
+ * w5burst_config() writes the layout again after it.
+ *
+ * Functions:
+ *
+ * w5burst_set_layout()
+ *  Sets the socket buffer sizes
+ *
+ * w5burst_config()
+ *  Configures the W5100 addresses and restores the buffer layout
+ *
+ * w5burst_get_tx_size()
+ *  Returns the transmit buffer size of a socket
+ *
+ * w5burst_get_rx_size()
+ *  Returns the receive buffer size of a socket
+ *
+ * w5burst_read()
+ *  Reads a block of W5100 memory
+ *
+ * w5burst_write()
+ *  Writes a block of W5100 memory
+ *
+ * w5burst_read_rx()
+ *  Reads from a socket receive buffer (in at most two blocks)
+ *
+ * w5burst_write_tx()
+ *  Writes to a socket transmit buffer (in at most two blocks)
+ *
+ * w5burst_get_bytes()
+ *  Returns the number of bytes moved by block transfers
+ *
+ * w5burst_benchmark()
+ *  Measures the block and single byte transfer rates
+ *
+ * w5burst_get_rate()
+ *  Returns the measured block transfer rate
+ *
+ * w5burst_get_byte_rate()
+ *  Returns the measured single byte transfer rate
+ *
+ * burst_xfer()
+ *  Exchanges one byte on the bus
+ *
+ * set_sizes()
+ *  Computes the socket buffer bases and sizes of a layout
+ */
+
+ #include <avr/io.h>
+ #include <avr/pgmspace.h>
+ #include "w5burst.h"
+ #include "w51.h"
+ #include "spi.h"
+ #include "clock.h"
+ #include "uart.h"
+ #include "serial.h"
+ #include "ulog.h"
+
+ /* W5100 spi opcodes */
+ #define W5_OP_WRITE     0xF0
+ #define W5_OP_READ      0x0F
+
+ /* slave select of the W5100 (PB2) */
+ #define W5_SELECT()     (PORTB &= ~(1<<PB2))
+ #define W5_DESELECT()   (PORTB |= (1<<PB2))
+
+ /* size of the blocks moved by the benchmark */
+ #define BENCH_BLOCK     64
+
+ static unsigned int tx_base[W5_NUM_SOCKETS] = {0x4000, 0x4800, 0x5000, 0x5800};
+ static unsigned int tx_size[W5_NUM_SOCKETS] = {0x0800, 0x0800, 0x0800, 0x0800};
+ static unsigned int rx_base[W5_NUM_SOCKETS] = {0x6000, 0x6800, 0x7000, 0x7800};
+ static unsigned int rx_size[W5_NUM_SOCKETS] = {0x0800, 0x0800, 0x0800, 0x0800};
+ static unsigned char layout_rmsr = 0x55;
+ static unsigned char layout_tmsr = 0x55;
+ static unsigned long bytes;
+ static unsigned long burst_rate;
+ static unsigned long byte_rate;
+
+ /**********************************
+ * burst_xfer()
+ *
+ * Writes a byte to the bus and waits for the byte received at the same time
+ *
+ * arguments:
+ *  data - the byte to send
+ *
+ * returns:
+ *  the received byte
+ *
+ * changes:
+ *  SPDR
+ */
+ static inline unsigned char burst_xfer(unsigned char data){
+    SPDR = data;
+    while(!(SPSR & (1<<SPIF))){}
+    return SPDR;
+ }
+
+ /**********************************
+ * set_sizes()
+ *
+ * Computes the socket buffer bases and sizes of a memory size register
+ * value the way the W5100 allocates them: in socket order, with no memory
+ * for a socket that does not fit in the remainder
+ *
+ * arguments:
+ *  msr - RMSR or TMSR value
+ *  mem - start address of the memory
+ *  base - where the buffer bases are placed
+ *  size - where the buffer sizes are placed
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  base, size
+ */
+ static void set_sizes(unsigned char msr, unsigned int mem, unsigned int *base, unsigned int *size){
+    unsigned int used = 0;
+    unsigned int len;
+    unsigned char s;
+
+    for(s = 0; s < W5_NUM_SOCKETS; s++){
+        len = 0x0400 << ((msr >> (2 * s)) & 0x03);
+        if(used + len > W5_MEM_SIZE){
+            len = 0;
+        }
+        base[s] = mem + used;
+        size[s] = len;
+        used += len;
+    }
+ }
+
+ /**********************************
+ * w5burst_set_layout()
+ *
+ * Writes the socket buffer sizes to the W5100 and computes the buffer
+ * bases and sizes used by the socket buffer routines
+ *
+ * arguments:
+ *  rmsr - receive memory size register value (W5_MEM_LAYOUT())
+ *  tmsr - transmit memory size register value (W5_MEM_LAYOUT())
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  RMSR, TMSR, layout_rmsr, layout_tmsr, tx_base, tx_size, rx_base, rx_size
+ */
+ void w5burst_set_layout(unsigned char rmsr, unsigned char tmsr){
+    W5x_write(W5_RMSR, rmsr);
+    W5x_write(W5_TMSR, tmsr);
+    layout_rmsr = rmsr;
+    layout_tmsr = tmsr;
+    set_sizes(rmsr, W5_RX_BASE, rx_base, rx_size);
+    set_sizes(tmsr, W5_TX_BASE, tx_base, tx_size);
+ }
+
+ /**********************************
+ * w5burst_config()
+ *
+ * Configures the W5100 mac, ip, gateway and subnet addresses with the
+ * library W5x_config(), which also writes 2K per socket to RMSR and TMSR,
+ * then writes the layout set with w5burst_set_layout() back to the W5100
+ * so that it matches the buffer bases and sizes used by the socket layer
+ *
+ * arguments:
+ *  mac - mac address
+ *  ip - ip address
+ *  gateway - gateway address
+ *  subnet - subnet mask
+ *
+ * returns:
+ *  the W5x_config() result
+ *
+ * changes:
+ *  the W5100 address registers, RMSR, TMSR
+ */
+ unsigned char w5burst_config(unsigned char *mac, unsigned char *ip, unsigned char *gateway, unsigned char *subnet){
+    unsigned char result;
+
+    result = W5x_config(mac, ip, gateway, subnet);
+    w5burst_set_layout(layout_rmsr, layout_tmsr);
+    return result;
+ }
+
+ /**********************************
+ * w5burst_get_tx_size()
+ *
+ * Returns the transmit buffer size of a socket
+ *
+ * arguments:
+ *  s - the socket
+ *
+ * returns:
+ *  the size in bytes (0 if the socket has no transmit memory)
+ *
+ * changes:
+ *  none
+ */
+ unsigned int w5burst_get_tx_size(SOCKET s){
+    return tx_size[s];
+ }
+
+ /**********************************
+ * w5burst_get_rx_size()
+ *
+ * Returns the receive buffer size of a socket
+ *
+ * arguments:
+ *  s - the socket
+ *
+ * returns:
+ *  the size in bytes (0 if the socket has no receive memory)
+ *
+ * changes:
+ *  none
+ */
+ unsigned int w5burst_get_rx_size(SOCKET s){
+    return rx_size[s];
+ }
+
+ /**********************************
+ * w5burst_read()
+ *
+ * Reads a block of W5100 memory with a single acquisition of the spi bus
+ *
+ * arguments:
+ *  addr - W5100 address of the first byte
+ *  buf - where the bytes are placed
+ *  len - number of bytes to read
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  buf, bytes
+ */
+ void w5burst_read(unsigned int addr, unsigned char *buf, unsigned int len){
+    unsigned char *end = buf + len;
+
+    if(len == 0){
+        return;
+    }
+    spi_begin_transfer(W5_SPCR, W5_SPSR);
+    while(buf != end){
+        W5_SELECT();
+        burst_xfer(W5_OP_READ);
+        burst_xfer(addr >> 8);
+        burst_xfer(addr & 0xFF);
+        *buf++ = burst_xfer(0);
+        W5_DESELECT();
+        addr++;
+    }
+    spi_end_transfer();
+    bytes += len;
+ }
+
+ /**********************************
+ * w5burst_write()
+ *
+ * Writes a block of W5100 memory with a single acquisition of the spi bus
+ *
+ * arguments:
+ *  addr - W5100 address of the first byte
+ *  buf - the bytes to write
+ *  len - number of bytes to write
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  W5100 memory, bytes
+ */
+ void w5burst_write(unsigned int addr, const unsigned char *buf, unsigned int len){
+    const unsigned char *end = buf + len;
+
+    if(len == 0){
+        return;
+    }
+    spi_begin_transfer(W5_SPCR, W5_SPSR);
+    while(buf != end){
+        W5_SELECT();
+        burst_xfer(W5_OP_WRITE);
+        burst_xfer(addr >> 8);
+        burst_xfer(addr & 0xFF);
+        burst_xfer(*buf++);
+        W5_DESELECT();
+        addr++;
+    }
+    spi_end_transfer();
+    bytes += len;
+ }
+
+ /**********************************
+ * w5burst_read_rx()
+ *
+ * Reads from the receive buffer of a socket.  The part of the data past
+ * the end of the ring buffer is read from its start as a second block.
+ *
+ * arguments:
+ *  s - the socket
+ *  ptr - receive buffer pointer of the first byte (Sn_RX_RD based)
+ *  buf - where the bytes are placed
+ *  len - number of bytes to read
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  buf
+ */
+ void w5burst_read_rx(SOCKET s, unsigned int ptr, unsigned char *buf, unsigned int len){
+    unsigned int base = rx_base[s];
+    unsigned int size = rx_size[s];
+    unsigned int offset = ptr & (size - 1);
+    unsigned int first;
+
+    if(size == 0){
+        return;
+    }
+    if(offset + len > size){
+        first = size - offset;
+        w5burst_read(base + offset, buf, first);
+        w5burst_read(base, buf + first, len - first);
+    }
+    else{
+        w5burst_read(base + offset, buf, len);
+    }
+ }
+
+ /**********************************
+ * w5burst_write_tx()
+ *
+ * Writes to the transmit buffer of a socket.  The part of the data past
+ * the end of the ring buffer is written to its start as a second block.
+ *
+ * arguments:
+ *  s - the socket
+ *  ptr - transmit buffer pointer of the first byte (Sn_TX_WR based)
+ *  buf - the bytes to write
+ *  len - number of bytes to write
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the socket transmit buffer
+ */
+ void w5burst_write_tx(SOCKET s, unsigned int ptr, const unsigned char *buf, unsigned int len){
+    unsigned int base = tx_base[s];
+    unsigned int size = tx_size[s];
+    unsigned int offset = ptr & (size - 1);
+    unsigned int first;
+
+    if(size == 0){
+        return;
+    }
+    if(offset + len > size){
+        first = size - offset;
+        w5burst_write(base + offset, buf, first);
+        w5burst_write(base, buf + first, len - first);
+    }
+    else{
+        w5burst_write(base + offset, buf, len);
+    }
+ }
+
+ /**********************************
+ * w5burst_get_bytes()
+ *
+ * Returns the number of bytes moved by block transfers since startup
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  the byte count
+ *
+ * changes:
+ *  none
+ */
+ unsigned long w5burst_get_bytes(){
+    return bytes;
+ }
+
+ #if W5_BENCH_ENABLE
+ /**********************************
+ * w5burst_benchmark()
+ *
+ * Writes and reads back a pattern over the whole tx buffer of an unused
+ * socket, first with block transfers and then with the library single
+ * byte transfers, and reports both rates (bytes per second) to the uart.
+ * A block rate of 0 is reported if the pattern does not read back (or
+ * the socket has no transmit memory).
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  burst_rate, byte_rate, the tx buffer of W5_BENCH_SOCKET
+ */
+ void w5burst_benchmark(){
+    unsigned char pattern[BENCH_BLOCK];
+    unsigned char check[BENCH_BLOCK];
+    unsigned int base = tx_base[W5_BENCH_SOCKET];
+    unsigned int size = tx_size[W5_BENCH_SOCKET];
+    unsigned long total = 2UL * W5_BENCH_PASSES * size;
+    unsigned long start;
+    unsigned long elapsed;
+    unsigned char ok = (size != 0);
+    unsigned char pass;
+    unsigned int offset;
+    unsigned int i;
+
+    for(i = 0; i < BENCH_BLOCK; i++){
+        pattern[i] = i * 37 + 11;
+    }
+
+    start = clock_ms();
+    for(pass = 0; pass < W5_BENCH_PASSES; pass++){
+        for(offset = 0; offset < size; offset += BENCH_BLOCK){
+            w5burst_write(base + offset, pattern, BENCH_BLOCK);
+            w5burst_read(base + offset, check, BENCH_BLOCK);
+            for(i = 0; i < BENCH_BLOCK; i++){
+                if(check[i] != pattern[i]){
+                    ok = 0;
+                }
+            }
+        }
+    }
+    elapsed = clock_ms() - start;
+    burst_rate = ok ? total * 1000UL / (elapsed ? elapsed : 1) : 0;
+
+    start = clock_ms();
+    for(pass = 0; pass < W5_BENCH_PASSES; pass++){
+        for(offset = 0; offset < size; offset += BENCH_BLOCK){
+            W5x_writebuf(base + offset, pattern, BENCH_BLOCK);
+            W5x_readbuf(base + offset, check, BENCH_BLOCK);
+        }
+    }
+    elapsed = clock_ms() - start;
+    byte_rate = total * 1000UL / (elapsed ? elapsed : 1);
+
+    ULOG(ULOG_INFO,
+        serial_writestr_P(PSTR("W5100 block "));
+        uart_writedec32(burst_rate);
+        serial_writestr_P(PSTR(" B/s, byte "));
+        uart_writedec32(byte_rate);
+        serial_writestr_P(PSTR(" B/s\r\n")));
+ }
+ #endif // W5_BENCH_ENABLE
+
+ /**********************************
+ * w5burst_get_rate()
+ *
+ * Returns the block transfer rate measured at startup
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  bytes per second (0 if the benchmark failed or has not run)
+ *
+ * changes:
+ *  none
+ */
+ unsigned long w5burst_get_rate(){
+    return burst_rate;
+ }
+
+ /**********************************
+ * w5burst_get_byte_rate()
+ *
+ * Returns the library single byte transfer rate measured at startup
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  bytes per second
+ *
+ * changes:
+ *  none
+ */
+ unsigned long w5burst_get_byte_rate(){
+    return byte_rate;
+ }
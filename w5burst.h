@@ -0,0 +1,168 @@
+/********************************************************
+ * w5burst.h
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file provides declarations for the W5100 block transfer
+ * routines.  A block of bytes is moved with a single acquisition
+ * of the spi bus at double speed (SPI2X), rather than one bus
+ * transaction per byte as in the library driver.  The socket
+ * buffer routines handle the ring buffer wrap in at most two
+ * blocks, using the buffer layout set with w5burst_set_layout().
+ * The library W5x_config() writes the 2K per socket layout back to the
+ * W5100, so the addresses are always configured through w5burst_config().
+ */
+
+#ifndef W5BURST_H_INCLUDED
+#define W5BURST_H_INCLUDED
+
+#include "socket.h"
+
+/* spi settings for block transfers - master, mode 0, fosc/2 */
+#define W5_SPCR             0x50
+#define W5_SPSR             0x01
+
+/* socket buffer memory of the W5100 (8K each for tx and rx) */
+#define W5_TX_BASE          0x4000
+#define W5_RX_BASE          0x6000
+#define W5_MEM_SIZE         0x2000
+#define W5_NUM_SOCKETS      4
+
+/* rx/tx memory size registers */
+#define W5_RMSR             0x001A
+#define W5_TMSR             0x001B
+
+/* socket buffer sizes for W5_MEM_LAYOUT() */
+#define W5_MEM_1K           0
+#define W5_MEM_2K           1
+#define W5_MEM_4K           2
+#define W5_MEM_8K           3
+
+/* RMSR/TMSR value for the buffer sizes of sockets 0 to 3.  Memory is
+ * allocated in socket order - a socket that does not fit gets none.
+ */
+#define W5_MEM_LAYOUT(s0, s1, s2, s3) \
+    ((s0) | ((s1) << 2) | ((s2) << 4) | ((s3) << 6))
+
+/* buffer layout profile: http server 4K, shared udp socket 1K (ntp,
+ * MQTT-SN, CoAP and fleet through udpmux), dhcp 2K (also used between
+ * exchanges to send alarms) and Modbus 1K.  The http server sends the large
+ * json responses, the largest udpmux datagram is a 512 byte CoAP block,
+ * dhcp messages are up to 576 bytes and Modbus/TCP frames up to 260.
+ */
+#define W5_TX_PROFILE       W5_MEM_LAYOUT(W5_MEM_4K, W5_MEM_1K, W5_MEM_2K, W5_MEM_1K)
+#define W5_RX_PROFILE       W5_MEM_LAYOUT(W5_MEM_4K, W5_MEM_1K, W5_MEM_2K, W5_MEM_1K)
+
+/* The startup transfer benchmark is a diagnostic - it takes the tx buffer
+ * of W5_BENCH_SOCKET (the Modbus socket) and delays the boot.  Build with
+ * W5_BENCH_ENABLE defined as 1 to run it - otherwise w5burst_get_rate()
+ * and w5burst_get_byte_rate() return 0.
+ */
+#ifndef W5_BENCH_ENABLE
+#define W5_BENCH_ENABLE 0
+#endif
+
+/* socket whose tx buffer is used by the startup benchmark, and the number
+ * of write/read passes over the buffer
+ */
+#define W5_BENCH_SOCKET     3
+#define W5_BENCH_PASSES     2
+
+/**********************************
+ * w5burst_set_layout()
+ *
+ * Sets the socket buffer sizes of the W5100 (RMSR and TMSR values built
+ * with W5_MEM_LAYOUT()).  Must be called after W5x_init(), which resets
+ * the W5100 to 2K per socket, and before any socket is opened.
+ */
+void w5burst_set_layout(unsigned char rmsr, unsigned char tmsr);
+
+/**********************************
+ * w5burst_config()
+ *
+ * Configures the W5100 addresses with the library W5x_config(), then
+ * writes back the layout set with w5burst_set_layout(), which
+ * W5x_config() resets to 2K per socket.  Returns the W5x_config() result.
+ */
+unsigned char w5burst_config(unsigned char *mac, unsigned char *ip, unsigned char *gateway, unsigned char *subnet);
+
+/**********************************
+ * w5burst_get_tx_size()
+ *
+ * Returns the transmit buffer size of socket s (0 if it has none)
+ */
+unsigned int w5burst_get_tx_size(SOCKET s);
+
+/**********************************
+ * w5burst_get_rx_size()
+ *
+ * Returns the receive buffer size of socket s (0 if it has none)
+ */
+unsigned int w5burst_get_rx_size(SOCKET s);
+
+/**********************************
+ * w5burst_read()
+ *
+ * Reads a block of W5100 memory starting at addr
+ */
+void w5burst_read(unsigned int addr, unsigned char *buf, unsigned int len);
+
+/**********************************
+ * w5burst_write()
+ *
+ * Writes a block of W5100 memory starting at addr
+ */
+void w5burst_write(unsigned int addr, const unsigned char *buf, unsigned int len);
+
+/**********************************
+ * w5burst_read_rx()
+ *
+ * Reads len bytes of the receive buffer of socket s, starting at the
+ * buffer pointer ptr (wrapping at the end of the buffer)
+ */
+void w5burst_read_rx(SOCKET s, unsigned int ptr, unsigned char *buf, unsigned int len);
+
+/**********************************
+ * w5burst_write_tx()
+ *
+ * Writes len bytes to the transmit buffer of socket s, starting at the
+ * buffer pointer ptr (wrapping at the end of the buffer)
+ */
+void w5burst_write_tx(SOCKET s, unsigned int ptr, const unsigned char *buf, unsigned int len);
+
+/**********************************
+ * w5burst_get_bytes()
+ *
+ * Returns the number of bytes moved by block transfers since startup
+ */
+unsigned long w5burst_get_bytes();
+
+/**********************************
+ * w5burst_benchmark()
+ *
+ * Measures the block and single byte transfer rates (bytes per second)
+ * through the tx buffer of an unused socket.  Must be called before the
+ * socket is opened.  Only built when W5_BENCH_ENABLE is 1.
+ */
+#if W5_BENCH_ENABLE
+void w5burst_benchmark();
+#endif
+
+/**********************************
+ * w5burst_get_rate()
+ *
+ * Returns the block transfer rate measured by w5burst_benchmark()
+ * (bytes per second)
+ */
+unsigned long w5burst_get_rate();
+
+/**********************************
+ * w5burst_get_byte_rate()
+ *
+ * Returns the single byte (library) transfer rate measured by
+ * w5burst_benchmark() (bytes per second)
+ */
+unsigned long w5burst_get_byte_rate();
+
+#endif // W5BURST_H_INCLUDED
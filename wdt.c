@@ -0,0 +1,110 @@
+/********************************************************
+ * wdt.c
+ *
+ * SER486 Final Project
+ * Author: Jesse Baker (student jjbaker4)
+ *
+ * This file implements the watchdog timer functions declared in
+ * wdt.h, replacing the library implementation so that the watchdog
+ * interrupt can capture a crash record before the reset.  As in the
+ * library, the watchdog runs in interrupt+reset mode with a 2 second
+ * timeout.  The interrupt lights the LED, writes the crash record,
+ * logs EVENT_WDT and then writes back the log and configuration
+ * (without interrupts) until the reset occurs.
+ *
+ * Functions:
+ *
+ * wdt_init()
+ *  Starts the watchdog in interrupt+reset mode (2 second timeout)
+ *
+ * wdt_reset()
+ *  Resets the watchdog timer
+ *
+ * wdt_force_restart()
+ *  Forces a restart through a watchdog reset (no interrupt)
+ */
+
+ #include <avr/io.h>
+ #include <avr/interrupt.h>
+ #include "wdt.h"
+ #include "led.h"
+ #include "log.h"
+ #include "config.h"
+ #include "crash.h"
+
+ /**********************************
+ * WDT_vect
+ *
+ * Watchdog interrupt - fires one timeout before the watchdog reset
+ */
+ ISR(WDT_vect){
+    led_on();
+    crash_capture(SP);
+    log_add_record(EVENT_WDT);
+    while(1){
+        log_update_noisr();
+        config_update_noisr();
+    }
+ }
+
+ /**********************************
+ * wdt_init()
+ *
+ * Starts the watchdog in interrupt+reset mode with a 2 second timeout
+ * using the timed change sequence
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  WDTCSR
+ */
+ void wdt_init(){
+    unsigned char sreg = SREG;
+
+    cli();
+    __asm__ __volatile__ ("wdr");
+    WDTCSR |= (1<<WDCE) | (1<<WDE);
+    WDTCSR = (1<<WDIE) | (1<<WDE) | (1<<WDP2) | (1<<WDP1) | (1<<WDP0);
+    SREG = sreg;
+ }
+
+ /**********************************
+ * wdt_reset()
+ *
+ * Resets the watchdog timer so that it does not time out
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  none
+ *
+ * changes:
+ *  the watchdog timer
+ */
+ void wdt_reset(){
+    __asm__ __volatile__ ("wdr");
+ }
+
+ /**********************************
+ * wdt_force_restart()
+ *
+ * Disables the watchdog interrupt and waits for the watchdog reset
+ *
+ * arguments:
+ *  none
+ *
+ * returns:
+ *  does not return
+ *
+ * changes:
+ *  WDTCSR
+ */
+ void wdt_force_restart(){
+    WDTCSR &= ~(1<<WDIE);
+    while(1){}
+ }